@@ -815,6 +815,14 @@ AcaGlobalAssembler<BasisFunctionType, ResultType>::assembleDetachedWeakForm(
 #endif // DUMP_DENSE_BLOCKS
           );
 
+  if (verbosityAtLeastHigh)
+    for (size_t i = 0; i < localAssemblers.size(); ++i) {
+      localAssemblers[i]->printStatistics(std::cout);
+      if (i < localAssemblersForAdmissibleBlocks.size() &&
+          localAssemblersForAdmissibleBlocks[i] != localAssemblers[i])
+        localAssemblersForAdmissibleBlocks[i]->printStatistics(std::cout);
+    }
+
   std::unique_ptr<DiscreteBndOp> result;
   result = acaOp;
   return result;
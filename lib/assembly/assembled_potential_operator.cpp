@@ -105,6 +105,20 @@ AssembledPotentialOperator<BasisFunctionType, ResultType>::apply(
   return result;
 }
 
+template <typename BasisFunctionType, typename ResultType>
+arma::Mat<ResultType>
+AssembledPotentialOperator<BasisFunctionType, ResultType>::apply(
+    const arma::Mat<ResultType> &coefficients) const {
+  if (coefficients.n_rows != m_op->columnCount())
+    throw std::invalid_argument(
+        "AssembledPotentialOperator::apply(): "
+        "the number of rows of 'coefficients' must match the number of "
+        "columns of the discrete operator");
+  arma::Mat<ResultType> result(m_op->rowCount(), coefficients.n_cols);
+  m_op->apply(NO_TRANSPOSE, coefficients, result, 1., 0.);
+  return result;
+}
+
 FIBER_INSTANTIATE_CLASS_TEMPLATED_ON_BASIS_AND_RESULT(
     AssembledPotentialOperator);
 
@@ -108,6 +108,25 @@ public:
   arma::Mat<ResultType>
   apply(const GridFunction<BasisFunctionType, ResultType> &argument) const;
 
+  /** \brief Apply the operator to a batch of charge distributions.
+   *
+   *  \param[in] coefficients A matrix whose <em>j</em>th column contains the
+   *  expansion coefficients, in the space returned by space(), of the
+   *  <em>j</em>th charge distribution.
+   *
+   *  \returns A matrix whose (<em>c</em> + <em>k</em> * <em>i</em>,
+   *  <em>j</em>)th element, with <em>k</em> equal to componentCount(),
+   *  contains the value of the <em>c</em>th component of the potential
+   *  generated by the <em>j</em>th charge distribution at the <em>i</em>th
+   *  point from the array returned by evaluationPoints().
+   *
+   *  All charge distributions are processed together, e.g. by a single
+   *  matrix-matrix product if the operator is stored as a dense matrix. This
+   *  is much faster than calling apply() for each of them when the
+   *  potentials of many densities (e.g. different excitations) are needed at
+   *  the same points. */
+  arma::Mat<ResultType> apply(const arma::Mat<ResultType> &coefficients) const;
+
 private:
   /** \cond PRIVATE */
   shared_ptr<const Space<BasisFunctionType>> m_space;
@@ -38,7 +38,8 @@ Context<BasisFunctionType, ResultType>::Context(
     const AssemblyOptions &assemblyOptions,
     const ParameterList &globalParameterList)
     : m_quadStrategy(quadStrategy), m_assemblyOptions(assemblyOptions),
-      m_globalParameterList(globalParameterList) {
+      m_globalParameterList(globalParameterList),
+      m_massMatrixCache(new MassMatrixCache<BasisFunctionType, ResultType>) {
   if (quadStrategy.get() == 0)
     throw std::invalid_argument("Context::Context(): "
                                 "quadStrategy must not be null");
@@ -51,7 +52,8 @@ Context<BasisFunctionType, ResultType>::Context() :
 
 template <typename BasisFunctionType, typename ResultType>
 Context<BasisFunctionType, ResultType>::Context(
-    const ParameterList &globalParameterList) {
+    const ParameterList &globalParameterList)
+    : m_massMatrixCache(new MassMatrixCache<BasisFunctionType, ResultType>) {
 
   ParameterList parameters(globalParameterList);
   parameters.setParametersNotAlreadySet(GlobalParameters::parameterList());
@@ -120,6 +122,9 @@ Context<BasisFunctionType, ResultType>::Context(
       quadOps.get<int>("doubleSingular"),
       quadOps.get<bool>("quadratureOrdersAreRelative"));
 
+  accuracyOptions.setDoubleRegularTolerance(
+      quadOps.get<double>("doubleRegularTolerance"));
+
   m_quadStrategy.reset(
       new NumericalQuadratureStrategy<BasisFunctionType, ResultType>(
           accuracyOptions));
@@ -8,6 +8,7 @@
 #include "../common/types.hpp"
 #include "assembly_options.hpp"
 #include "discrete_boundary_operator_cache.hpp"
+#include "mass_matrix_cache.hpp"
 
 namespace Bempp {
 
@@ -93,10 +94,19 @@ public:
     return m_globalParameterList;
   }
 
+  /** \brief Return the cache of mass matrices shared by all copies of this
+   *  Context. */
+  const MassMatrixCache<BasisFunctionType, ResultType> &
+  massMatrixCache() const {
+    return *m_massMatrixCache;
+  }
+
 private:
   shared_ptr<const QuadratureStrategy> m_quadStrategy;
   AssemblyOptions m_assemblyOptions;
   ParameterList m_globalParameterList;
+  shared_ptr<const MassMatrixCache<BasisFunctionType, ResultType>>
+  m_massMatrixCache;
 };
 
 } // namespace Bempp
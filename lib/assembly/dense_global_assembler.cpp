@@ -43,9 +43,11 @@
 
 #include "../common/armadillo_fwd.hpp"
 #include "../common/complex_aux.hpp"
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
 
+#include <tbb/enumerable_thread_specific.h>
 #include <tbb/parallel_for.h>
 #include <tbb/spin_mutex.h>
 #include <tbb/task_scheduler_init.h>
@@ -59,73 +61,99 @@ namespace Bempp
 namespace
 {
 
-// Body of parallel loop
+// Body of parallel loop over the trial elements of a single color (see
+// colorElements()). No two of these elements share a global DOF, so each
+// task owns the matrix columns of its elements and writes them without
+// locking.
 
 template <typename BasisFunctionType, typename ResultType>
 class DenseWeakFormAssemblerLoopBody
 {
 public:
-    typedef tbb::spin_mutex MutexType;
+    // Buffers reused by all tiles handled by a thread
+    struct TileWorkspace
+    {
+        Fiber::LocalWeakFormTile<ResultType> tile;
+        std::vector<int> testIndices;
+        std::vector<int> trialIndices;
+    };
+    typedef tbb::enumerable_thread_specific<TileWorkspace> TileStorage;
+
+    // Tile dimensions (in elements)
+    enum { TEST_TILE_SIZE = 256, TRIAL_TILE_SIZE = 16 };
 
     DenseWeakFormAssemblerLoopBody(
             const std::vector<int>& testIndices,
+            const std::vector<int>& trialIndices,
             const std::vector<std::vector<GlobalDofIndex> >& testGlobalDofs,
             const std::vector<std::vector<GlobalDofIndex> >& trialGlobalDofs,
             const std::vector<std::vector<BasisFunctionType> >& testLocalDofWeights,
             const std::vector<std::vector<BasisFunctionType> >& trialLocalDofWeights,
             Fiber::LocalAssemblerForIntegralOperators<ResultType>& assembler,
-            arma::Mat<ResultType>& result, MutexType& mutex) :
-        m_testIndices(testIndices),
+            arma::Mat<ResultType>& result, TileStorage& tiles) :
+        m_testIndices(testIndices), m_trialIndices(trialIndices),
         m_testGlobalDofs(testGlobalDofs), m_trialGlobalDofs(trialGlobalDofs),
         m_testLocalDofWeights(testLocalDofWeights),
         m_trialLocalDofWeights(trialLocalDofWeights),
-        m_assembler(assembler), m_result(result), m_mutex(mutex) {
+        m_assembler(assembler), m_result(result), m_tiles(tiles) {
     }
 
-    void operator() (const tbb::blocked_range<int>& r) const {
+    void operator() (const tbb::blocked_range<size_t>& r) const {
         const int testElementCount = m_testIndices.size();
-        std::vector<arma::Mat<ResultType> > localResult;
-        for (int trialIndex = r.begin(); trialIndex != r.end(); ++trialIndex) {
-            // Handle this trial element only if it contributes to any global DOFs.
-            bool skipTrialElement = true;
-            const int trialDofCount = m_trialGlobalDofs[trialIndex].size();
-            for (int trialDof = 0; trialDof < trialDofCount; ++trialDof) {
-                int trialGlobalDof = m_trialGlobalDofs[trialIndex][trialDof];
-                if (trialGlobalDof >= 0) {
-                    skipTrialElement = false;
-                    break;
-                }
-            }
-            if (skipTrialElement)
-                continue;
-
-            // Evaluate integrals over pairs of the current trial element and
-            // all the test elements
-            m_assembler.evaluateLocalWeakForms(TEST_TRIAL, m_testIndices, trialIndex,
-                                               ALL_DOFS, localResult);
-
-            // Global assembly
-            {
-                MutexType::scoped_lock lock(m_mutex);
-                // Loop over test indices
-                for (int row = 0; row < testElementCount; ++row) {
-                    const int testIndex = m_testIndices[row];
-                    const int testDofCount = m_testGlobalDofs[testIndex].size();
-                    // Add the integrals to appropriate entries in the operator's matrix
-                    for (int trialDof = 0; trialDof < trialDofCount; ++trialDof) {
-                        int trialGlobalDof = m_trialGlobalDofs[trialIndex][trialDof];
-                        if (trialGlobalDof < 0)
-                            continue;
-                        for (int testDof = 0; testDof < testDofCount; ++testDof) {
-                            int testGlobalDof = m_testGlobalDofs[testIndex][testDof];
-                            if (testGlobalDof < 0)
+        // Local weak forms are evaluated in tiles of at most
+        // TEST_TILE_SIZE x TRIAL_TILE_SIZE element pairs, written into a
+        // buffer reused by all tiles handled by the current thread
+        TileWorkspace& workspace = m_tiles.local();
+        Fiber::LocalWeakFormTile<ResultType>& tile = workspace.tile;
+        std::vector<int>& tileTestIndices = workspace.testIndices;
+        std::vector<int>& tileTrialIndices = workspace.trialIndices;
+
+        for (size_t trialBegin = r.begin(); trialBegin < r.end();
+             trialBegin += TRIAL_TILE_SIZE) {
+            const size_t trialEnd =
+                    std::min<size_t>(trialBegin + TRIAL_TILE_SIZE, r.end());
+            tileTrialIndices.assign(m_trialIndices.begin() + trialBegin,
+                                    m_trialIndices.begin() + trialEnd);
+
+            for (int testBegin = 0; testBegin < testElementCount;
+                 testBegin += TEST_TILE_SIZE) {
+                const int testEnd =
+                        std::min<int>(testBegin + TEST_TILE_SIZE, testElementCount);
+                tileTestIndices.assign(m_testIndices.begin() + testBegin,
+                                       m_testIndices.begin() + testEnd);
+
+                // Evaluate integrals over all pairs of test and trial
+                // elements of the tile
+                m_assembler.evaluateLocalWeakFormTile(
+                            tileTestIndices, tileTrialIndices, tile);
+
+                // Global assembly
+                for (size_t col = 0; col < tileTrialIndices.size(); ++col) {
+                    const int trialIndex = tileTrialIndices[col];
+                    const int trialDofCount = m_trialGlobalDofs[trialIndex].size();
+                    // Loop over test indices
+                    for (size_t row = 0; row < tileTestIndices.size(); ++row) {
+                        const int testIndex = tileTestIndices[row];
+                        const int testDofCount = m_testGlobalDofs[testIndex].size();
+                        const arma::Mat<ResultType>& localResult =
+                                tile.localWeakForm(row, col);
+                        // Add the integrals to appropriate entries in the
+                        // operator's matrix
+                        for (int trialDof = 0; trialDof < trialDofCount; ++trialDof) {
+                            int trialGlobalDof = m_trialGlobalDofs[trialIndex][trialDof];
+                            if (trialGlobalDof < 0)
                                 continue;
-                            assert(std::abs(m_testLocalDofWeights[testIndex][testDof]) > 0.);
-                            assert(std::abs(m_trialLocalDofWeights[trialIndex][trialDof]) > 0.);
-                            m_result(testGlobalDof, trialGlobalDof) +=
-                                    conj(m_testLocalDofWeights[testIndex][testDof]) *
-                                    m_trialLocalDofWeights[trialIndex][trialDof] *
-                                    localResult[row](testDof, trialDof);
+                            for (int testDof = 0; testDof < testDofCount; ++testDof) {
+                                int testGlobalDof = m_testGlobalDofs[testIndex][testDof];
+                                if (testGlobalDof < 0)
+                                    continue;
+                                assert(std::abs(m_testLocalDofWeights[testIndex][testDof]) > 0.);
+                                assert(std::abs(m_trialLocalDofWeights[trialIndex][trialDof]) > 0.);
+                                m_result(testGlobalDof, trialGlobalDof) +=
+                                        conj(m_testLocalDofWeights[testIndex][testDof]) *
+                                        m_trialLocalDofWeights[trialIndex][trialDof] *
+                                        localResult(testDof, trialDof);
+                            }
                         }
                     }
                 }
@@ -135,6 +163,7 @@ public:
 
 private:
     const std::vector<int>& m_testIndices;
+    const std::vector<int>& m_trialIndices;
     const std::vector<std::vector<GlobalDofIndex> >& m_testGlobalDofs;
     const std::vector<std::vector<GlobalDofIndex> >& m_trialGlobalDofs;
     const std::vector<std::vector<BasisFunctionType> >& m_testLocalDofWeights;
@@ -142,11 +171,10 @@ private:
     // mutable OK because Assembler is thread-safe. (Alternative to "mutable" here:
     // make assembler's internal integrator map mutable)
     typename Fiber::LocalAssemblerForIntegralOperators<ResultType>& m_assembler;
-    // mutable OK because write access to this matrix is protected by a mutex
+    // mutable OK because concurrent tasks write to disjoint columns
     arma::Mat<ResultType>& m_result;
-
-    // mutex must be mutable because we need to lock and unlock it
-    MutexType& m_mutex;
+    // one tile workspace per thread
+    TileStorage& m_tiles;
 };
 
 template <typename BasisFunctionType, typename ResultType>
@@ -263,6 +291,52 @@ void gatherGlobalDofs(
     }
 }
 
+/** Partition the elements contributing to at least one global DOF into
+ *  groups ("colors") such that no two elements of the same group share a
+ *  global DOF. Elements are colored greedily in order of increasing index.
+ *  For spaces with DOFs attached to single elements there is only one
+ *  color. */
+void colorElements(
+    const std::vector<std::vector<GlobalDofIndex> >& globalDofs,
+    std::vector<std::vector<int> >& elementsByColor)
+{
+    elementsByColor.clear();
+    const int elementCount = globalDofs.size();
+    GlobalDofIndex globalDofCount = 0;
+    for (int element = 0; element < elementCount; ++element)
+        for (size_t dof = 0; dof < globalDofs[element].size(); ++dof)
+            globalDofCount = std::max(globalDofCount, globalDofs[element][dof] + 1);
+
+    // Colors of the elements sharing each global DOF
+    std::vector<std::vector<int> > dofColors(globalDofCount);
+    // colorMarks[c] == element iff color c is taken by a neighbour of element
+    std::vector<int> colorMarks;
+    for (int element = 0; element < elementCount; ++element) {
+        const std::vector<GlobalDofIndex>& dofs = globalDofs[element];
+        bool contributes = false;
+        for (size_t dof = 0; dof < dofs.size(); ++dof)
+            if (dofs[dof] >= 0) {
+                contributes = true;
+                const std::vector<int>& colors = dofColors[dofs[dof]];
+                for (size_t i = 0; i < colors.size(); ++i)
+                    colorMarks[colors[i]] = element;
+            }
+        if (!contributes)
+            continue;
+        int color = 0;
+        while (color < int(colorMarks.size()) && colorMarks[color] == element)
+            ++color;
+        if (color == int(colorMarks.size())) {
+            colorMarks.push_back(-1);
+            elementsByColor.push_back(std::vector<int>());
+        }
+        elementsByColor[color].push_back(element);
+        for (size_t dof = 0; dof < dofs.size(); ++dof)
+            if (dofs[dof] >= 0)
+                dofColors[dofs[dof]].push_back(color);
+    }
+}
+
 } // namespace
 
 template <typename BasisFunctionType, typename ResultType>
@@ -287,7 +361,6 @@ assembleDetachedWeakForm(
     } else
         gatherGlobalDofs(trialSpace, trialGlobalDofs, trialLocalDofWeights);
     const int testElementCount = testGlobalDofs.size();
-    const int trialElementCount = trialGlobalDofs.size();
 
     // Enumerate the test elements that contribute to at least one global DOF
     std::vector<int> testIndices;
@@ -308,8 +381,13 @@ assembleDetachedWeakForm(
                                  trialSpace.globalDofCount());
     result.fill(0.);
 
+    // Group the trial elements so that elements assembled concurrently
+    // contribute to disjoint columns
+    std::vector<std::vector<int> > trialIndicesByColor;
+    colorElements(trialGlobalDofs, trialIndicesByColor);
+
     typedef DenseWeakFormAssemblerLoopBody<BasisFunctionType, ResultType> Body;
-    typename Body::MutexType mutex;
+    typename Body::TileStorage tiles;
 
     const ParallelizationOptions& parallelOptions =
             options.parallelizationOptions();
@@ -323,12 +401,20 @@ assembleDetachedWeakForm(
     tbb::task_scheduler_init scheduler(maxThreadCount);
     {
         Fiber::SerialBlasRegion region;
-        tbb::parallel_for(tbb::blocked_range<int>(0, trialElementCount),
-                          Body(testIndices, testGlobalDofs, trialGlobalDofs,
-                               testLocalDofWeights, trialLocalDofWeights,
-                               assembler, result, mutex));
+        for (size_t color = 0; color < trialIndicesByColor.size(); ++color) {
+            const std::vector<int>& trialIndices = trialIndicesByColor[color];
+            tbb::parallel_for(tbb::blocked_range<size_t>(
+                                  0, trialIndices.size(), Body::TRIAL_TILE_SIZE),
+                              Body(testIndices, trialIndices,
+                                   testGlobalDofs, trialGlobalDofs,
+                                   testLocalDofWeights, trialLocalDofWeights,
+                                   assembler, result, tiles));
+        }
     }
 
+    if (options.verbosityLevel() >= VerbosityLevel::HIGH)
+        assembler.printStatistics(std::cout);
+
     //// Old serial code (TODO: decide whether to keep it behind e.g. #ifndef PARALLEL)
     //    std::vector<arma::Mat<ValueType> > localResult;
     //    // Loop over trial elements
@@ -74,6 +74,14 @@ void DiscreteBoundaryOperator<ValueType>::apply(
                                 "vectors x_in and y_inout must have "
                                 "the same number of columns");
 
+  applyBuiltInMultiVectorImpl(trans, x_in, y_inout, alpha, beta);
+}
+
+template <typename ValueType>
+void DiscreteBoundaryOperator<ValueType>::applyBuiltInMultiVectorImpl(
+    const TranspositionMode trans, const arma::Mat<ValueType> &x_in,
+    arma::Mat<ValueType> &y_inout, const ValueType alpha,
+    const ValueType beta) const {
   for (size_t i = 0; i < x_in.n_cols; ++i) {
     const arma::Col<ValueType> x_in_col = x_in.unsafe_col(i);
     arma::Col<ValueType> y_inout_col = y_inout.unsafe_col(i);
@@ -234,6 +234,18 @@ private:
                                 arma::Col<ValueType> &y_inout,
                                 const ValueType alpha,
                                 const ValueType beta) const = 0;
+
+  /** \brief Apply the operator to all columns of \p x_in at once.
+   *
+   *  The arguments have already been checked by apply(). The default
+   *  implementation calls applyBuiltInImpl() for each column; subclasses that
+   *  can process a block of columns more efficiently (e.g. by a single
+   *  matrix-matrix product) should override it. */
+  virtual void applyBuiltInMultiVectorImpl(const TranspositionMode trans,
+                                           const arma::Mat<ValueType> &x_in,
+                                           arma::Mat<ValueType> &y_inout,
+                                           const ValueType alpha,
+                                           const ValueType beta) const;
 };
 
 /** \relates DiscreteBoundaryOperator
@@ -52,6 +52,9 @@ public:
 
   virtual arma::Mat<ValueType> asMatrix() const;
 
+  /** \brief Return a reference to the stored matrix. */
+  const arma::Mat<ValueType> &matrix() const { return m_mat; }
+
   virtual unsigned int rowCount() const;
   virtual unsigned int columnCount() const;
 
@@ -77,6 +80,12 @@ private:
                                 const ValueType alpha,
                                 const ValueType beta) const;
 
+  virtual void applyBuiltInMultiVectorImpl(const TranspositionMode trans,
+                                           const arma::Mat<ValueType> &x_in,
+                                           arma::Mat<ValueType> &y_inout,
+                                           const ValueType alpha,
+                                           const ValueType beta) const;
+
 private:
   /** \cond PRIVATE */
 mutable  arma::Mat<ValueType> m_mat;
@@ -23,8 +23,26 @@
 #include <boost/numeric/conversion/converter.hpp>
 #include "../hmat/compressed_matrix.hpp"
 
+#include <Thyra_DetachedSpmdVectorView.hpp>
+
+#include <algorithm>
+
 namespace Bempp {
 
+namespace {
+
+hmat::TransposeMode toHMatTransposeMode(TranspositionMode trans) {
+  if (trans == TranspositionMode::NO_TRANSPOSE)
+    return hmat::NOTRANS;
+  else if (trans == TranspositionMode::TRANSPOSE)
+    return hmat::TRANS;
+  else if (trans == TranspositionMode::CONJUGATE)
+    return hmat::CONJ;
+  else
+    return hmat::CONJTRANS;
+}
+}
+
 template <typename ValueType>
 DiscreteHMatBoundaryOperator<ValueType>::DiscreteHMatBoundaryOperator(
     const shared_ptr<hmat::CompressedMatrix<ValueType>> &compressedMatrix)
@@ -59,16 +77,60 @@ void DiscreteHMatBoundaryOperator<ValueType>::applyBuiltInImpl(
     arma::Col<ValueType> &y_inout, const ValueType alpha,
     const ValueType beta) const {
 
-  hmat::TransposeMode hmatTrans;
-  if (trans == TranspositionMode::NO_TRANSPOSE)
-    hmatTrans = hmat::NOTRANS;
-  else if (trans == TranspositionMode::TRANSPOSE)
-    hmatTrans = hmat::TRANS;
-  else if (trans == TranspositionMode::CONJUGATE)
-    hmatTrans = hmat::CONJ;
-  else
-    hmatTrans = hmat::CONJTRANS;
-  m_compressedMatrix->apply(x_in, y_inout, hmatTrans, alpha, beta);
+  m_compressedMatrix->apply(x_in, y_inout, toHMatTransposeMode(trans), alpha,
+                            beta);
+}
+
+template <typename ValueType>
+void DiscreteHMatBoundaryOperator<ValueType>::applyBuiltInMultiVectorImpl(
+    const TranspositionMode trans, const arma::Mat<ValueType> &x_in,
+    arma::Mat<ValueType> &y_inout, const ValueType alpha,
+    const ValueType beta) const {
+
+  m_compressedMatrix->apply(x_in, y_inout, toHMatTransposeMode(trans), alpha,
+                            beta);
+}
+
+template <typename ValueType>
+void DiscreteHMatBoundaryOperator<ValueType>::applyImpl(
+    const Thyra::EOpTransp M_trans,
+    const Thyra::MultiVectorBase<ValueType> &X_in,
+    const Teuchos::Ptr<Thyra::MultiVectorBase<ValueType>> &Y_inout,
+    const ValueType alpha, const ValueType beta) const {
+  typedef Thyra::Ordinal Ordinal;
+
+  TEUCHOS_ASSERT(this->opSupported(M_trans));
+  TEUCHOS_ASSERT(X_in.range()->isCompatible(*this->domain()));
+  TEUCHOS_ASSERT(Y_inout->range()->isCompatible(*this->range()));
+  TEUCHOS_ASSERT(Y_inout->domain()->isCompatible(*X_in.domain()));
+
+  const Ordinal colCount = X_in.domain()->dim();
+  const Ordinal xRowCount = X_in.range()->dim();
+  const Ordinal yRowCount = Y_inout->range()->dim();
+
+  // Gather the columns into contiguous matrices
+  arma::Mat<ValueType> x(xRowCount, colCount);
+  arma::Mat<ValueType> y(yRowCount, colCount);
+  for (Ordinal col = 0; col < colCount; ++col) {
+    Thyra::ConstDetachedSpmdVectorView<ValueType> xVec(X_in.col(col));
+    const Teuchos::ArrayRCP<const ValueType> xArray(xVec.sv().values());
+    std::copy(xArray.get(), xArray.get() + xRowCount, x.colptr(col));
+    if (beta != ValueType(0)) {
+      Thyra::ConstDetachedSpmdVectorView<ValueType> yVec(Y_inout->col(col));
+      const Teuchos::ArrayRCP<const ValueType> yArray(yVec.sv().values());
+      std::copy(yArray.get(), yArray.get() + yRowCount, y.colptr(col));
+    }
+  }
+
+  m_compressedMatrix->apply(x, y, toHMatTransposeMode(
+                                      static_cast<TranspositionMode>(M_trans)),
+                            alpha, beta);
+
+  for (Ordinal col = 0; col < colCount; ++col) {
+    Thyra::DetachedSpmdVectorView<ValueType> yVec(Y_inout->col(col));
+    const Teuchos::ArrayRCP<ValueType> yArray(yVec.sv().values());
+    std::copy(y.colptr(col), y.colptr(col) + yRowCount, yArray.get());
+  }
 }
 
 template <typename ValueType>
@@ -83,6 +145,12 @@ DiscreteHMatBoundaryOperator<ValueType>::range() const {
   return m_rangeSpace;
 }
 
+template <typename ValueType>
+shared_ptr<const hmat::CompressedMatrix<ValueType>>
+DiscreteHMatBoundaryOperator<ValueType>::compressedMatrix() const {
+  return m_compressedMatrix;
+}
+
 template <typename ValueType>
 bool DiscreteHMatBoundaryOperator<ValueType>::opSupportedImpl(
     Thyra::EOpTransp M_trans) const {
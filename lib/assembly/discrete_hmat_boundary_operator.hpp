@@ -54,15 +54,35 @@ public:
   Teuchos::RCP<const Thyra::VectorSpaceBase<ValueType>> domain() const;
   Teuchos::RCP<const Thyra::VectorSpaceBase<ValueType>> range() const;
 
+  /** \brief Return the compressed matrix representing the operator. */
+  shared_ptr<const hmat::CompressedMatrix<ValueType>> compressedMatrix() const;
+
 protected:
   bool opSupportedImpl(Thyra::EOpTransp M_trans) const;
 
+  /** \brief Apply the operator to all columns of \p X_in at once.
+   *
+   *  In contrast to the default implementation, which processes one column
+   *  at a time, the whole multivector is passed to the H-matrix so that
+   *  each leaf block is applied with a single matrix-matrix product. */
+  void
+  applyImpl(const Thyra::EOpTransp M_trans,
+            const Thyra::MultiVectorBase<ValueType> &X_in,
+            const Teuchos::Ptr<Thyra::MultiVectorBase<ValueType>> &Y_inout,
+            const ValueType alpha, const ValueType beta) const override;
+
 private:
   void applyBuiltInImpl(const TranspositionMode trans,
                         const arma::Col<ValueType> &x_in,
                         arma::Col<ValueType> &y_inout, const ValueType alpha,
                         const ValueType beta) const override;
 
+  void applyBuiltInMultiVectorImpl(const TranspositionMode trans,
+                                   const arma::Mat<ValueType> &x_in,
+                                   arma::Mat<ValueType> &y_inout,
+                                   const ValueType alpha,
+                                   const ValueType beta) const override;
+
   shared_ptr<hmat::CompressedMatrix<ValueType>> m_compressedMatrix;
 
   Teuchos::RCP<const Thyra::SpmdVectorSpaceBase<ValueType>> m_domainSpace;
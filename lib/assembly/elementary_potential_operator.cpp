@@ -28,6 +28,7 @@
 #include "local_assembler_construction_helper.hpp"
 #include "discrete_null_boundary_operator.hpp"
 #include "dense_global_assembler.hpp"
+#include "hmat_global_assembler.hpp"
 
 #include "../common/shared_ptr.hpp"
 
@@ -132,7 +133,8 @@ ElementaryPotentialOperator<BasisFunctionType, KernelType, ResultType>::
     arma::Mat<ResultType> result;
     evaluator->evaluate(Evaluator::FAR_FIELD, evaluationPoints, result);
     return result;
-  } else if (options.evaluationMode() == EvaluationOptions::ACA) {
+  } else if (options.evaluationMode() == EvaluationOptions::ACA ||
+             options.evaluationMode() == EvaluationOptions::HMAT) {
     AssembledPotentialOperator<BasisFunctionType, ResultType> assembledOp =
         assemble(argument.space(), make_shared_from_ref(evaluationPoints),
                  quadStrategy, options);
@@ -280,6 +282,10 @@ ElementaryPotentialOperator<BasisFunctionType, KernelType, ResultType>::
     return shared_ptr<DiscreteBoundaryOperator<ResultType>>(
         assembleOperatorInAcaMode(space, evaluationPoints, assembler, options)
             .release());
+  case EvaluationOptions::HMAT:
+    return shared_ptr<DiscreteBoundaryOperator<ResultType>>(
+        assembleOperatorInHMatMode(space, evaluationPoints, assembler, options)
+            .release());
   default:
     throw std::runtime_error(
         "ElementaryPotentialOperator::assembleWeakFormInternalImpl(): "
@@ -310,6 +316,17 @@ ElementaryPotentialOperator<BasisFunctionType, KernelType, ResultType>::
       assemblePotentialOperator(evaluationPoints, space, assembler, options);
 }
 
+template <typename BasisFunctionType, typename KernelType, typename ResultType>
+std::unique_ptr<DiscreteBoundaryOperator<ResultType>>
+ElementaryPotentialOperator<BasisFunctionType, KernelType, ResultType>::
+    assembleOperatorInHMatMode(
+        const Space<BasisFunctionType> &space,
+        const arma::Mat<CoordinateType> &evaluationPoints,
+        LocalAssembler &assembler, const EvaluationOptions &options) const {
+  return HMatGlobalAssembler<BasisFunctionType, ResultType>::
+      assemblePotentialOperator(evaluationPoints, space, assembler, options);
+}
+
 /** \endcond */
 
 FIBER_INSTANTIATE_CLASS_TEMPLATED_ON_BASIS_KERNEL_AND_RESULT(
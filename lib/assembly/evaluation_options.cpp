@@ -29,10 +29,12 @@ EvaluationOptions::EvaluationOptions()
 EvaluationOptions::EvaluationOptions(const ParameterList &parameters)
     : m_parameterList(parameters) {
 
+  m_parameterList.setParametersNotAlreadySet(GlobalParameters::parameterList());
+
   std::string assemblyType =
-      parameters.get<std::string>("potentialOperatorAssemblyType");
-  int maxThreadCount = parameters.get<int>("maxThreadCount");
-  int verbosityLevel = parameters.get<int>("verbosityLevel");
+      m_parameterList.get<std::string>("potentialOperatorAssemblyType");
+  int maxThreadCount = m_parameterList.get<int>("maxThreadCount");
+  int verbosityLevel = m_parameterList.get<int>("verbosityLevel");
 
   m_parallelizationOptions.setMaxThreadCount(maxThreadCount);
 
@@ -56,12 +58,18 @@ EvaluationOptions::EvaluationOptions(const ParameterList &parameters)
         "Context::Context(): verbosityLevel has unsupported value");
 }
 
+void EvaluationOptions::switchToHMatMode() { m_evaluationMode = HMAT; }
+
 EvaluationOptions::Mode EvaluationOptions::evaluationMode() const {
   return m_evaluationMode;
 }
 
 const AcaOptions &EvaluationOptions::acaOptions() const { return m_acaOptions; }
 
+const ParameterList &EvaluationOptions::parameterList() const {
+  return m_parameterList;
+}
+
 // void EvaluationOptions::switchToOpenCl(const OpenClOptions& openClOptions)
 //{
 //    m_parallelizationOptions.switchToOpenCl(openClOptions);
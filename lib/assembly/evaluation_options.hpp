@@ -49,7 +49,10 @@ public:
   /** \brief Constructor. */
   EvaluationOptions();
 
-  /** \brief Constructor. */
+  /** \brief Constructor.
+   *
+   *  Parameters missing from \p parameters are taken from
+   *  GlobalParameters::parameterList(). */
   EvaluationOptions(const ParameterList& parameters);
 
   /** @name Evaluation mode
@@ -63,7 +66,7 @@ public:
        (ACA). */
     ACA,
     /** \brief Assemble hierarchical matrices using HMat. */
-    HMAT    
+    HMAT
   };
 
   /** \brief Use dense-matrix representations of elementary potential operators.
@@ -123,10 +126,23 @@ public:
    */
   void switchToAcaMode(const AcaOptions &acaOptions);
 
+  /** \brief Use the HMat library to obtain hierarchical-matrix
+   *  representations of potential operators.
+   *
+   *  As in the ACA mode, evaluation of potentials entails the construction
+   *  of a hierarchical-matrix representation of the potential operator. The
+   *  evaluation points and the DOFs of the charge distribution are clustered
+   *  with the cluster trees of the HMat library and the admissible blocks
+   *  are compressed by ACA, so that the cost of assembly and evaluation
+   *  grows almost linearly with the number of points. The H-matrix is
+   *  controlled by the "HMatParameters" sublist of the parameter list
+   *  passed to the constructor. */
+  void switchToHMatMode();
+
   /** \brief Return current evaluation mode.
    *
-   *  The evaluation mode can be changed by calling switchToDenseMode() or
-   *  switchToAcaMode(). */
+   *  The evaluation mode can be changed by calling switchToDenseMode(),
+   *  switchToAcaMode() or switchToHMatMode(). */
   Mode evaluationMode() const;
 
   /** \brief Return the current adaptive cross approximation (ACA) settings.
@@ -135,6 +151,9 @@ public:
    *  evaluationMode() returns ACA. */
   const AcaOptions &acaOptions() const;
 
+  /** \brief Return the parameter list these options were created from. */
+  const ParameterList &parameterList() const;
+
   /** @}
     @name Parallelization
     @{ */
@@ -27,6 +27,7 @@
 #include "discrete_boundary_operator.hpp"
 #include "identity_operator.hpp"
 #include "local_assembler_construction_helper.hpp"
+#include "mass_matrix_cache.hpp"
 
 #include "../common/complex_aux.hpp"
 #include "../common/deprecated.hpp"
@@ -40,6 +41,7 @@
 #include "../fiber/opencl_handler.hpp"
 #include "../fiber/quadrature_strategy.hpp"
 #include "../fiber/raw_grid_geometry.hpp"
+#include "../fiber/serial_blas_region.hpp"
 #include "../grid/geometry_factory.hpp"
 #include "../grid/grid.hpp"
 #include "../grid/grid_view.hpp"
@@ -51,84 +53,143 @@
 #include "identity_operator.hpp"
 #include "../io/gmsh.hpp"
 
+#include <algorithm>
 #include <boost/array.hpp>
 #include <fstream>
 #include <set>
 #include <sstream>
 
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_scheduler_init.h>
+
 namespace Bempp {
 
 // Internal routines
 
 namespace {
 
-template <typename BasisFunctionType, typename ResultType>
-shared_ptr<arma::Col<ResultType>> reallyCalculateProjections(
-    const Space<BasisFunctionType> &dualSpace,
-    Fiber::LocalAssemblerForGridFunctions<ResultType> &assembler,
-    const AssemblyOptions &options) {
-  // TODO: parallelise using TBB (the parameter options will then start be used)
+// Number of elements per task and number of functions per pass in the
+// assembly of projections
+const int PROJECTION_CHUNK_SIZE = 64;
+const size_t PROJECTION_BLOCK_SIZE = 16;
 
-  // Get the grid's leaf view so that we can iterate over elements
-  const GridView &view = dualSpace.gridView();
-  const size_t elementCount = view.entityCount(0);
+// Body of parallel loop over chunks of elements. The local weak forms of each
+// function are scattered into a thread-local matrix with one column per
+// function; these matrices are summed after the loop.
 
-  // Global DOF indices corresponding to local DOFs on elements
-  std::vector<std::vector<GlobalDofIndex>> testGlobalDofs(elementCount);
-  std::vector<std::vector<BasisFunctionType>> testLocalDofWeights(elementCount);
-
-  // Gather global DOF lists
-  const Mapper &mapper = view.elementMapper();
-  std::unique_ptr<EntityIterator<0>> it = view.entityIterator<0>();
-  while (!it->finished()) {
-    const Entity<0> &element = it->entity();
-    const int elementIndex = mapper.entityIndex(element);
-    dualSpace.getGlobalDofs(element, testGlobalDofs[elementIndex],
-                            testLocalDofWeights[elementIndex]);
-    it->next();
+template <typename BasisFunctionType, typename ResultType>
+class ProjectionAssemblerLoopBody {
+public:
+  typedef Fiber::LocalAssemblerForGridFunctions<ResultType> LocalAssembler;
+  typedef tbb::enumerable_thread_specific<arma::Mat<ResultType>> Accumulators;
+
+  ProjectionAssemblerLoopBody(
+      const std::vector<std::vector<GlobalDofIndex>> &testGlobalDofs,
+      const std::vector<std::vector<BasisFunctionType>> &testLocalDofWeights,
+      const std::vector<LocalAssembler *> &assemblers, size_t globalDofCount,
+      Accumulators &accumulators)
+      : m_testGlobalDofs(testGlobalDofs),
+        m_testLocalDofWeights(testLocalDofWeights), m_assemblers(assemblers),
+        m_globalDofCount(globalDofCount), m_accumulators(accumulators) {}
+
+  void operator()(const tbb::blocked_range<int> &r) const {
+    bool exists;
+    arma::Mat<ResultType> &accumulator = m_accumulators.local(exists);
+    if (!exists)
+      accumulator.zeros(m_globalDofCount, m_assemblers.size());
+
+    std::vector<int> testIndices(r.size());
+    for (size_t i = 0; i < testIndices.size(); ++i)
+      testIndices[i] = r.begin() + i;
+
+    std::vector<arma::Col<ResultType>> localResult;
+    for (size_t f = 0; f < m_assemblers.size(); ++f) {
+      // Evaluate local weak forms
+      m_assemblers[f]->evaluateLocalWeakForms(testIndices, localResult);
+
+      // Loop over test indices
+      for (size_t i = 0; i < testIndices.size(); ++i) {
+        const int testIndex = testIndices[i];
+        // Add the integrals to appropriate entries in the global weak form
+        for (size_t testDof = 0; testDof < m_testGlobalDofs[testIndex].size();
+             ++testDof) {
+          int testGlobalDof = m_testGlobalDofs[testIndex][testDof];
+          if (testGlobalDof >= 0) // if it's negative, it means that this
+                                  // local dof is constrained (not used)
+            accumulator(testGlobalDof, f) +=
+                conj(m_testLocalDofWeights[testIndex][testDof]) *
+                localResult[i](testDof);
+        }
+      }
+    }
   }
 
-  // Make a vector of all element indices
-  std::vector<int> testIndices(elementCount);
-  for (size_t i = 0; i < elementCount; ++i)
-    testIndices[i] = i;
-
-  // Create the weak form's column vector
-  shared_ptr<arma::Col<ResultType>> result(
-      new arma::Col<ResultType>(dualSpace.globalDofCount()));
-  result->fill(0.);
-
-  std::vector<arma::Col<ResultType>> localResult;
-  // Evaluate local weak forms
-  assembler.evaluateLocalWeakForms(testIndices, localResult);
-
-  // Loop over test indices
-  for (size_t testIndex = 0; testIndex < elementCount; ++testIndex)
-    // Add the integrals to appropriate entries in the global weak form
-    for (size_t testDof = 0; testDof < testGlobalDofs[testIndex].size();
-         ++testDof) {
-      int testGlobalDof = testGlobalDofs[testIndex][testDof];
-      if (testGlobalDof >= 0) // if it's negative, it means that this
-                              // local dof is constrained (not used)
-        (*result)(testGlobalDof) +=
-            conj(testLocalDofWeights[testIndex][testDof]) *
-            localResult[testIndex](testDof);
-    }
+private:
+  const std::vector<std::vector<GlobalDofIndex>> &m_testGlobalDofs;
+  const std::vector<std::vector<BasisFunctionType>> &m_testLocalDofWeights;
+  const std::vector<LocalAssembler *> &m_assemblers;
+  size_t m_globalDofCount;
+  Accumulators &m_accumulators;
+};
+
+/** \brief Add the projections of the functions whose local weak forms are
+  evaluated by \p assemblers to the consecutive columns of \p result,
+  starting from \p firstColumn. The elements are processed in parallel
+  unless \p threadSafe is false. */
+template <typename BasisFunctionType, typename ResultType>
+void reallyCalculateProjections(
+    const Space<BasisFunctionType> &dualSpace,
+    const std::vector<Fiber::LocalAssemblerForGridFunctions<ResultType> *> &
+        assemblers,
+    const AssemblyOptions &options, bool threadSafe,
+    arma::Mat<ResultType> &result, size_t firstColumn) {
+  // Global DOF indices corresponding to local DOFs on elements
+  shared_ptr<const std::vector<std::vector<GlobalDofIndex>>> testGlobalDofs;
+  shared_ptr<const std::vector<std::vector<BasisFunctionType>>>
+  testLocalDofWeights;
+  dualSpace.getGlobalDofsOfAllElements(testGlobalDofs, testLocalDofWeights);
+  const int elementCount = testGlobalDofs->size();
+
+  typedef ProjectionAssemblerLoopBody<BasisFunctionType, ResultType> Body;
+  typename Body::Accumulators accumulators;
+
+  const ParallelizationOptions &parallelOptions =
+      options.parallelizationOptions();
+  int maxThreadCount = 1;
+  if (!parallelOptions.isOpenClEnabled() && threadSafe) {
+    if (parallelOptions.maxThreadCount() == ParallelizationOptions::AUTO)
+      maxThreadCount = tbb::task_scheduler_init::automatic;
+    else
+      maxThreadCount = parallelOptions.maxThreadCount();
+  }
+  tbb::task_scheduler_init scheduler(maxThreadCount);
+  {
+    Fiber::SerialBlasRegion region;
+    tbb::parallel_for(tbb::blocked_range<int>(0, elementCount,
+                                              PROJECTION_CHUNK_SIZE),
+                      Body(*testGlobalDofs, *testLocalDofWeights, assemblers,
+                           dualSpace.globalDofCount(), accumulators));
+  }
 
-  // Return the vector of projections <phi_i, f>
-  return result;
+  for (typename Body::Accumulators::const_iterator it = accumulators.begin();
+       it != accumulators.end(); ++it)
+    result.cols(firstColumn, firstColumn + assemblers.size() - 1) += *it;
 }
 
-/** \brief Calculate projections of the function on the basis functions of
-  the given dual space. */
+/** \brief Calculate projections of the functions on the basis functions of
+  the given dual space.
+
+  The <em>j</em>th column of the returned matrix contains the projections of
+  <tt>*functions[j]</tt>. */
 template <typename BasisFunctionType, typename ResultType>
-shared_ptr<arma::Col<ResultType>>
+shared_ptr<arma::Mat<ResultType>>
 calculateProjections(const Context<BasisFunctionType, ResultType> &context,
-                     const Function<ResultType> &globalFunction,
+                     const std::vector<const Function<ResultType> *> &functions,
                      const Space<BasisFunctionType> &dualSpace) {
   const AssemblyOptions &options = context.assemblyOptions();
 
-  // Prepare local assembler
+  // Prepare local assemblers
   typedef typename Fiber::ScalarTraits<ResultType>::RealType CoordinateType;
   typedef Fiber::RawGridGeometry<CoordinateType> RawGridGeometry;
   typedef std::vector<const Fiber::Shapeset<BasisFunctionType> *>
@@ -149,14 +210,52 @@ calculateProjections(const Context<BasisFunctionType, ResultType> &context,
   const Fiber::CollectionOfShapesetTransformations<CoordinateType> &
   testTransformations = dualSpace.basisFunctionValue();
 
+  // Create the weak forms' matrix
+  shared_ptr<arma::Mat<ResultType>> result(
+      new arma::Mat<ResultType>(dualSpace.globalDofCount(), functions.size()));
+  result->fill(0.);
+
+  // The functions are processed in blocks, which bounds the size of the
+  // thread-local accumulators
   typedef Fiber::LocalAssemblerForGridFunctions<ResultType> LocalAssembler;
-  std::unique_ptr<LocalAssembler> assembler =
-      context.quadStrategy()->makeAssemblerForGridFunctions(
-          geometryFactory, rawGeometry, testShapesets,
-          make_shared_from_ref(testTransformations),
-          make_shared_from_ref(globalFunction), openClHandler);
+  for (size_t blockStart = 0; blockStart < functions.size();
+       blockStart += PROJECTION_BLOCK_SIZE) {
+    const size_t blockEnd =
+        std::min(blockStart + PROJECTION_BLOCK_SIZE, functions.size());
+    std::vector<std::unique_ptr<LocalAssembler>> assemblers;
+    std::vector<LocalAssembler *> assemblerPtrs;
+    bool threadSafe = true;
+    for (size_t f = blockStart; f < blockEnd; ++f) {
+      if (!functions[f])
+        throw std::invalid_argument("calculateProjections(): "
+                                    "functions must not be null pointers");
+      threadSafe = threadSafe && functions[f]->isThreadSafe();
+      assemblers.push_back(
+          context.quadStrategy()->makeAssemblerForGridFunctions(
+              geometryFactory, rawGeometry, testShapesets,
+              make_shared_from_ref(testTransformations),
+              make_shared_from_ref(*functions[f]), openClHandler));
+      assemblerPtrs.push_back(assemblers.back().get());
+    }
+    reallyCalculateProjections(dualSpace, assemblerPtrs, options, threadSafe,
+                               *result, blockStart);
+  }
+  return result;
+}
 
-  return reallyCalculateProjections(dualSpace, *assembler, options);
+/** \brief Calculate projections of the function on the basis functions of
+  the given dual space. */
+template <typename BasisFunctionType, typename ResultType>
+shared_ptr<arma::Col<ResultType>>
+calculateProjections(const Context<BasisFunctionType, ResultType> &context,
+                     const Function<ResultType> &globalFunction,
+                     const Space<BasisFunctionType> &dualSpace) {
+  std::vector<const Function<ResultType> *> functions(1, &globalFunction);
+  shared_ptr<arma::Mat<ResultType>> projections =
+      calculateProjections(context, functions, dualSpace);
+  // Return the vector of projections <phi_i, f>
+  return shared_ptr<arma::Col<ResultType>>(
+      new arma::Col<ResultType>(projections->col(0)));
 }
 
 /** \brief Evaluate the function at the interpolation points of the chosen
@@ -681,13 +780,14 @@ GridFunction<BasisFunctionType, ResultType>::updateProjectionsFromCoefficients(
   assert(dualSpace_);
   assert(m_coefficients);
 
-  // Calculate the mass matrix
-  typedef BoundaryOperator<BasisFunctionType, ResultType> BoundaryOp;
-  BoundaryOp id = identityOperator(m_context, m_space, m_space, dualSpace_);
+  // Get the mass matrix
+  shared_ptr<const DiscreteBoundaryOperator<ResultType>> massMatrix =
+      m_context->massMatrixCache().massMatrix(m_context, m_space, m_space,
+                                              dualSpace_);
 
   shared_ptr<arma::Col<ResultType>> newProjections(
       new arma::Col<ResultType>(dualSpace_->globalDofCount()));
-  id.weakForm()->apply(NO_TRANSPOSE, *m_coefficients, *newProjections,
+  massMatrix->apply(NO_TRANSPOSE, *m_coefficients, *newProjections,
                        static_cast<ResultType>(1.),
                        static_cast<ResultType>(0.));
   m_projections = newProjections;
@@ -704,14 +804,14 @@ GridFunction<BasisFunctionType, ResultType>::updateCoefficientsFromProjections()
   assert(m_projections);
   assert(m_dualSpace);
 
-  // Calculate the (pseudo)inverse mass matrix
-  typedef BoundaryOperator<BasisFunctionType, ResultType> BoundaryOp;
-  BoundaryOp id = identityOperator(m_context, m_space, m_space, m_dualSpace);
-  BoundaryOp pinvId = pseudoinverse(id);
+  // Get the (pseudo)inverse mass matrix
+  shared_ptr<const DiscreteBoundaryOperator<ResultType>> inverseMassMatrix =
+      m_context->massMatrixCache().inverseMassMatrix(m_context, m_space,
+                                                     m_space, m_dualSpace);
 
   shared_ptr<arma::Col<ResultType>> newCoefficients(
       new arma::Col<ResultType>(m_space->globalDofCount()));
-  pinvId.weakForm()->apply(NO_TRANSPOSE, *m_projections, *newCoefficients,
+  inverseMassMatrix->apply(NO_TRANSPOSE, *m_projections, *newCoefficients,
                            static_cast<ResultType>(1.),
                            static_cast<ResultType>(0.));
   m_coefficients = newCoefficients;
@@ -727,15 +827,14 @@ GridFunction<BasisFunctionType, ResultType>::L2Norm() const {
   if (!m_space)
     throw std::runtime_error("GridFunction::L2_Norm() must not be called "
                              "on an uninitialized GridFunction object");
-  typedef BoundaryOperator<BasisFunctionType, ResultType> BoundaryOp;
 
   // Get the vector of coefficients
   const arma::Col<ResultType> &coeffs = coefficients();
 
-  // Calculate the mass matrix
-  BoundaryOp id = identityOperator(m_context, m_space, m_space, m_space);
+  // Get the mass matrix
   shared_ptr<const DiscreteBoundaryOperator<ResultType>> massMatrix =
-      id.weakForm();
+      m_context->massMatrixCache().massMatrix(m_context, m_space, m_space,
+                                              m_space);
 
   arma::Col<ResultType> product(coeffs.n_rows);
   massMatrix->apply(NO_TRANSPOSE, coeffs, product, 1., 0.);
@@ -1196,6 +1295,30 @@ operator*(const GridFunction<BasisFunctionType, ResultType> &g1,
   }
 }
 
+template <typename BasisFunctionType, typename ResultType>
+arma::Mat<ResultType> calculateProjections(
+    const shared_ptr<const Context<BasisFunctionType, ResultType>> &context,
+    const std::vector<const Function<ResultType> *> &functions,
+    const shared_ptr<const Space<BasisFunctionType>> &space,
+    const shared_ptr<const Space<BasisFunctionType>> &dualSpace) {
+  if (!context)
+    throw std::invalid_argument("calculateProjections(): "
+                                "context must not be null");
+  if (!space)
+    throw std::invalid_argument("calculateProjections(): "
+                                "space must not be null");
+  if (!dualSpace)
+    throw std::invalid_argument("calculateProjections(): "
+                                "dualSpace must not be null");
+  // Follow the GridFunction constructors, which assemble projections on
+  // the barycentric refinement of the dual space if either space is
+  // barycentric
+  shared_ptr<const Space<BasisFunctionType>> actualDualSpace = dualSpace;
+  if (space->isBarycentric() || dualSpace->isBarycentric())
+    actualDualSpace = dualSpace->barycentricSpace(dualSpace);
+  return *calculateProjections(*context, functions, *actualDualSpace);
+}
+
 BEMPP_GCC_DIAG_ON(deprecated - declarations);
 
 FIBER_INSTANTIATE_CLASS_TEMPLATED_ON_BASIS_AND_RESULT(GridFunction);
@@ -1211,6 +1334,11 @@ FIBER_INSTANTIATE_CLASS_TEMPLATED_ON_BASIS_AND_RESULT(GridFunction);
   template GridFunction<BASIS, RESULT> operator-(                              \
       const GridFunction<BASIS, RESULT> &op1,                                  \
       const GridFunction<BASIS, RESULT> &op2);                                 \
+  template arma::Mat<RESULT> calculateProjections(                             \
+      const shared_ptr<const Context<BASIS, RESULT>> &context,                 \
+      const std::vector<const Function<RESULT> *> &functions,                  \
+      const shared_ptr<const Space<BASIS>> &space,                             \
+      const shared_ptr<const Space<BASIS>> &dualSpace);                        \
   template void exportToVtk(const GridFunction<BASIS, RESULT> &gridFunction,   \
                             VtkWriter::DataType dataType,                      \
                             const char *dataLabel, const char *fileNamesBase,  \
@@ -36,6 +36,7 @@
 #include <boost/mpl/has_key.hpp>
 #include <boost/utility/enable_if.hpp>
 #include <memory>
+#include <vector>
 
 namespace Fiber {
 
@@ -613,6 +614,28 @@ GridFunction<BasisFunctionType, ResultType>
 operator/(const GridFunction<BasisFunctionType, ResultType> &g1,
           const ScalarType &scalar);
 
+/** \relates GridFunction
+  \brief Calculate the projections of several functions on the basis
+  functions of a space.
+
+  Returns a matrix whose <em>j</em>th column is the vector of projections of
+  <tt>*functions[j]</tt> on the basis functions of \p dualSpace, i.e. the
+  vector that GridFunction::projections() would return for a GridFunction
+  constructed from that function, \p space and \p dualSpace in the
+  #APPROXIMATE mode. The columns can thus be used to create many grid
+  functions, e.g. incident fields for different directions of incidence, in a
+  single parallel pass over the grid.
+
+  As in the GridFunction constructors, if \p space or \p dualSpace is
+  barycentric, the projections are calculated on the barycentric counterpart
+  of \p dualSpace. */
+template <typename BasisFunctionType, typename ResultType>
+arma::Mat<ResultType> calculateProjections(
+    const shared_ptr<const Context<BasisFunctionType, ResultType>> &context,
+    const std::vector<const Function<ResultType> *> &functions,
+    const shared_ptr<const Space<BasisFunctionType>> &space,
+    const shared_ptr<const Space<BasisFunctionType>> &dualSpace);
+
 // Export
 
 /** \relates GridFunction
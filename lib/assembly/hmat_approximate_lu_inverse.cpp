@@ -0,0 +1,180 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "hmat_approximate_lu_inverse.hpp"
+#include "discrete_hmat_boundary_operator.hpp"
+
+#include "../fiber/explicit_instantiation.hpp"
+#include "../fiber/serial_blas_region.hpp"
+#include "../hmat/hmatrix.hpp"
+#include "../hmat/hmatrix_lu.hpp"
+
+#include <boost/numeric/conversion/converter.hpp>
+
+#include <tbb/tick_count.h>
+
+#include <iostream>
+#include <stdexcept>
+
+namespace Bempp {
+
+template <typename ValueType>
+HMatApproximateLuInverse<ValueType>::HMatApproximateLuInverse(
+    const DiscreteHMatBoundaryOperator<ValueType> &fwdOp, MagnitudeType delta,
+    bool cholesky, VerbosityLevel::Level verbosityLevel) {
+
+  shared_ptr<const hmat::DefaultHMatrixType<ValueType>> hMatrix =
+      dynamic_pointer_cast<const hmat::DefaultHMatrixType<ValueType>>(
+          fwdOp.compressedMatrix());
+  if (!hMatrix)
+    throw std::invalid_argument(
+        "HMatApproximateLuInverse::HMatApproximateLuInverse(): "
+        "operator is not represented by an H-matrix");
+
+  const bool verbosityAtLeastDefault =
+      (verbosityLevel >= VerbosityLevel::DEFAULT);
+  if (verbosityAtLeastDefault)
+    std::cout << "Starting H-" << (cholesky ? "Cholesky" : "LU")
+              << " decomposition..." << std::endl;
+  tbb::tick_count start = tbb::tick_count::now();
+  {
+    Fiber::SerialBlasRegion region; // if possible, ensure that BLAS is
+                                    // single-threaded
+    m_lu.reset(new hmat::HMatrixLu<ValueType, 2>(*hMatrix, delta, cholesky));
+  }
+  tbb::tick_count end = tbb::tick_count::now();
+
+  // All range-domain swaps intended!
+  m_domainSpace = Thyra::defaultSpmdVectorSpace<ValueType>(m_lu->rows());
+  m_rangeSpace = Thyra::defaultSpmdVectorSpace<ValueType>(m_lu->columns());
+
+  if (verbosityAtLeastDefault)
+    std::cout << "H-" << (cholesky ? "Cholesky" : "LU") << " decomposition took "
+              << (end - start).seconds() << " s\n"
+              << "Needed storage: " << m_lu->memSizeKb() / 1024. << " MB.\n"
+              << "Storage of the H-matrix: " << hMatrix->memSizeKb() / 1024.
+              << " MB." << std::endl;
+}
+
+template <typename ValueType>
+unsigned int HMatApproximateLuInverse<ValueType>::rowCount() const {
+  return boost::numeric::converter<unsigned int, std::size_t>::convert(
+      m_lu->columns());
+}
+
+template <typename ValueType>
+unsigned int HMatApproximateLuInverse<ValueType>::columnCount() const {
+  return boost::numeric::converter<unsigned int, std::size_t>::convert(
+      m_lu->rows());
+}
+
+template <typename ValueType>
+void HMatApproximateLuInverse<ValueType>::addBlock(
+    const std::vector<int> &rows, const std::vector<int> &cols,
+    const ValueType alpha, arma::Mat<ValueType> &block) const {
+  throw std::runtime_error("HMatApproximateLuInverse::addBlock(): "
+                           "not implemented");
+}
+
+template <typename ValueType>
+Teuchos::RCP<const Thyra::VectorSpaceBase<ValueType>>
+HMatApproximateLuInverse<ValueType>::domain() const {
+  return m_domainSpace;
+}
+
+template <typename ValueType>
+Teuchos::RCP<const Thyra::VectorSpaceBase<ValueType>>
+HMatApproximateLuInverse<ValueType>::range() const {
+  return m_rangeSpace;
+}
+
+template <typename ValueType>
+bool HMatApproximateLuInverse<ValueType>::opSupportedImpl(
+    Thyra::EOpTransp M_trans) const {
+  return (M_trans == Thyra::NOTRANS);
+}
+
+template <typename ValueType>
+void HMatApproximateLuInverse<ValueType>::applyBuiltInImpl(
+    const TranspositionMode trans, const arma::Col<ValueType> &x_in,
+    arma::Col<ValueType> &y_inout, const ValueType alpha,
+    const ValueType beta) const {
+  if (trans != NO_TRANSPOSE)
+    throw std::runtime_error(
+        "HMatApproximateLuInverse::applyBuiltInImpl(): "
+        "transposition modes other than NO_TRANSPOSE are not supported");
+  if (columnCount() != x_in.n_rows || rowCount() != y_inout.n_rows)
+    throw std::invalid_argument("HMatApproximateLuInverse::applyBuiltInImpl(): "
+                                "incorrect vector length");
+
+  if (beta == static_cast<ValueType>(0.))
+    y_inout.fill(static_cast<ValueType>(0.));
+  else
+    y_inout *= beta;
+
+  arma::Mat<ValueType> solution = x_in;
+  m_lu->solve(solution);
+  y_inout += alpha * solution;
+}
+
+template <typename ValueType>
+shared_ptr<const DiscreteBoundaryOperator<ValueType>>
+hMatOperatorApproximateLuInverse(
+    const shared_ptr<const DiscreteBoundaryOperator<ValueType>> &op,
+    double delta, bool cholesky) {
+  shared_ptr<const DiscreteHMatBoundaryOperator<ValueType>> hMatOp =
+      dynamic_pointer_cast<const DiscreteHMatBoundaryOperator<ValueType>>(op);
+  if (!hMatOp)
+    throw std::invalid_argument("hMatOperatorApproximateLuInverse(): "
+                                "operator is not an HMat operator");
+  shared_ptr<const DiscreteBoundaryOperator<ValueType>> result(
+      new HMatApproximateLuInverse<ValueType>(*hMatOp, delta, cholesky));
+  return result;
+}
+
+FIBER_INSTANTIATE_CLASS_TEMPLATED_ON_RESULT(HMatApproximateLuInverse);
+
+#define INSTANTIATE_FREE_FUNCTIONS(RESULT)                                     \
+  template shared_ptr<const DiscreteBoundaryOperator<RESULT>>                  \
+  hMatOperatorApproximateLuInverse(                                            \
+      const shared_ptr<const DiscreteBoundaryOperator<RESULT>> &op,            \
+      double delta, bool cholesky)
+
+#if defined(ENABLE_SINGLE_PRECISION)
+INSTANTIATE_FREE_FUNCTIONS(float);
+#endif
+
+#if defined(ENABLE_SINGLE_PRECISION) &&                                        \
+    (defined(ENABLE_COMPLEX_BASIS_FUNCTIONS) ||                                \
+     defined(ENABLE_COMPLEX_KERNELS))
+INSTANTIATE_FREE_FUNCTIONS(std::complex<float>);
+#endif
+
+#if defined(ENABLE_DOUBLE_PRECISION)
+INSTANTIATE_FREE_FUNCTIONS(double);
+#endif
+
+#if defined(ENABLE_DOUBLE_PRECISION) &&                                        \
+    (defined(ENABLE_COMPLEX_BASIS_FUNCTIONS) ||                                \
+     defined(ENABLE_COMPLEX_KERNELS))
+INSTANTIATE_FREE_FUNCTIONS(std::complex<double>);
+#endif
+
+} // namespace Bempp
@@ -0,0 +1,114 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef bempp_hmat_approximate_lu_inverse_hpp
+#define bempp_hmat_approximate_lu_inverse_hpp
+
+#include "bempp/common/config_trilinos.hpp"
+#include "../common/common.hpp"
+#include "../common/shared_ptr.hpp"
+#include "discrete_boundary_operator.hpp"
+#include "../common/armadillo_fwd.hpp"
+#include "../fiber/scalar_traits.hpp"
+#include "../fiber/verbosity_level.hpp"
+#include <Thyra_DefaultSpmdVectorSpace_decl.hpp>
+
+using Fiber::VerbosityLevel;
+
+namespace hmat {
+
+template <typename ValueType, int N> class HMatrixLu;
+
+}
+
+namespace Bempp {
+
+/** \cond FORWARD_DECL */
+template <typename ValueType> class DiscreteHMatBoundaryOperator;
+/** \endcond */
+
+/** \ingroup composite_discrete_operators
+ *  \brief Approximate LU (or Cholesky) decomposition of an H-matrix
+ *  assembled by the native HMat backend.
+ */
+template <typename ValueType>
+class HMatApproximateLuInverse : public DiscreteBoundaryOperator<ValueType> {
+public:
+  typedef typename Fiber::ScalarTraits<ValueType>::RealType MagnitudeType;
+
+  /** \brief Construct an approximate LU decomposition of an H-matrix.
+
+  \param[in] fwdOp     Operator represented internally as an H-matrix with
+                       identical row and column cluster trees.
+  \param[in] delta     Relative accuracy of the low-rank blocks of the
+                       factors.
+  \param[in] cholesky  If true, compute the symmetric factorization
+                       L * L^T instead of L * U. This requires \p fwdOp to
+                       be symmetric (and positive definite if it is real). */
+  HMatApproximateLuInverse(const DiscreteHMatBoundaryOperator<ValueType> &fwdOp,
+                           MagnitudeType delta, bool cholesky = false,
+                           VerbosityLevel::Level verbosityLevel =
+                               VerbosityLevel::DEFAULT);
+
+  unsigned int rowCount() const override;
+  unsigned int columnCount() const override;
+
+  void addBlock(const std::vector<int> &rows, const std::vector<int> &cols,
+                const ValueType alpha, arma::Mat<ValueType> &block) const
+      override;
+
+  Teuchos::RCP<const Thyra::VectorSpaceBase<ValueType>> domain() const;
+  Teuchos::RCP<const Thyra::VectorSpaceBase<ValueType>> range() const;
+
+protected:
+  bool opSupportedImpl(Thyra::EOpTransp M_trans) const;
+
+private:
+  void applyBuiltInImpl(const TranspositionMode trans,
+                        const arma::Col<ValueType> &x_in,
+                        arma::Col<ValueType> &y_inout, const ValueType alpha,
+                        const ValueType beta) const override;
+
+  shared_ptr<const hmat::HMatrixLu<ValueType, 2>> m_lu;
+
+  Teuchos::RCP<const Thyra::SpmdVectorSpaceBase<ValueType>> m_domainSpace;
+  Teuchos::RCP<const Thyra::SpmdVectorSpaceBase<ValueType>> m_rangeSpace;
+};
+
+/** \relates HMatApproximateLuInverse
+ *  \brief LU inverse of a discrete boundary operator stored as an H-matrix
+ *  by the native HMat backend.
+ *
+ *  \param[in] op Discrete boundary operator for which to compute the LU
+ *  inverse.
+ *  \param[in] delta Approximation accuracy of the inverse.
+ *  \param[in] cholesky If true, a symmetric L * L^T factorization is used.
+ *
+ *  \return A shared pointer to a newly allocated discrete boundary operator
+ *  representing the (approximate) LU inverse of \p op. */
+template <typename ValueType>
+shared_ptr<const DiscreteBoundaryOperator<ValueType>>
+hMatOperatorApproximateLuInverse(
+    const shared_ptr<const DiscreteBoundaryOperator<ValueType>> &op,
+    double delta, bool cholesky = false);
+
+} // namespace Bempp
+
+#endif
@@ -29,7 +29,9 @@
 #include "discrete_boundary_operator_composition.hpp"
 #include "discrete_sparse_boundary_operator.hpp"
 #include "weak_form_hmat_assembly_helper.hpp"
+#include "potential_operator_hmat_assembly_helper.hpp"
 #include "discrete_hmat_boundary_operator.hpp"
+#include "symmetry.hpp"
 
 #include "../common/armadillo_fwd.hpp"
 #include "../common/auto_timer.hpp"
@@ -37,7 +39,9 @@
 #include "../common/to_string.hpp"
 #include "../fiber/explicit_instantiation.hpp"
 #include "../fiber/local_assembler_for_integral_operators.hpp"
+#include "../fiber/local_assembler_for_potential_operators.hpp"
 #include "../fiber/scalar_traits.hpp"
+#include "../fiber/serial_blas_region.hpp"
 #include "../fiber/shared_ptr.hpp"
 #include "../space/space.hpp"
 #include "../common/bounding_box.hpp"
@@ -50,17 +54,26 @@
 #include "../hmat/data_accessor.hpp"
 #include "../hmat/hmatrix_dense_compressor.hpp"
 #include "../hmat/hmatrix_aca_compressor.hpp"
+#include "../hmat/hmatrix_aca_plus_compressor.hpp"
+#include "../hmat/hmatrix_data.hpp"
+#include "../hmat/hmatrix_serialization.hpp"
 
 #include <stdexcept>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <typeinfo>
 
+#include <boost/functional/hash.hpp>
 #include <boost/type_traits/is_complex.hpp>
 
 #include <tbb/atomic.h>
 #include <tbb/parallel_for.h>
 #include <tbb/task_scheduler_init.h>
 #include <tbb/concurrent_queue.h>
+#include <tbb/concurrent_vector.h>
+#include <tbb/tick_count.h>
 
 #include <Teuchos_ParameterList.hpp>
 
@@ -103,29 +116,107 @@ private:
   std::vector<BoundingBox<CoordinateType>> m_bemppBoundingBoxes;
 };
 
+// One entity per row of a potential operator, i.e. per component of the
+// potential at an evaluation point
+template <typename CoordinateType>
+class PointsHMatGeometryInterface : public hmat::GeometryInterface {
+
+public:
+  PointsHMatGeometryInterface(const arma::Mat<CoordinateType> &points,
+                              int componentCount)
+      : m_points(points), m_componentCount(componentCount), m_counter(0) {}
+  shared_ptr<const hmat::GeometryDataType> next() override {
+
+    if (m_counter == numberOfEntities())
+      return shared_ptr<hmat::GeometryDataType>();
+
+    const std::size_t point = m_counter / m_componentCount;
+    const double x = m_points(0, point);
+    const double y = m_points(1, point);
+    const double z = m_points(2, point);
+    m_counter++;
+    return shared_ptr<hmat::GeometryDataType>(new hmat::GeometryDataType(
+        hmat::BoundingBox(x, x, y, y, z, z),
+        std::array<double, 3>({{x, y, z}})));
+  }
+
+  std::size_t numberOfEntities() const override {
+    return m_points.n_cols * m_componentCount;
+  }
+  void reset() override { m_counter = 0; }
+
+private:
+  const arma::Mat<CoordinateType> &m_points;
+  std::size_t m_componentCount;
+  std::size_t m_counter;
+};
+
+// Forwards the compression of a leaf block and records its timing
+template <typename ResultType>
+class TimedHMatrixCompressor : public hmat::HMatrixCompressor<ResultType, 2> {
+
+public:
+  TimedHMatrixCompressor(
+      const hmat::HMatrixCompressor<ResultType, 2> &compressor,
+      tbb::concurrent_vector<std::pair<bool, ChunkStatistics>> &stats)
+      : m_compressor(compressor), m_stats(stats) {}
+
+  void compressBlock(
+      const hmat::DefaultBlockClusterTreeNodeType &blockClusterTreeNode,
+      shared_ptr<hmat::HMatrixData<ResultType>> &hMatrixData) const override {
+
+    ChunkStatistics stats;
+    stats.valid = true;
+    stats.chunkStart = blockClusterTreeNode.data()
+                           .rowClusterTreeNode->data()
+                           .indexRange[0];
+    stats.chunkSize = hmat::blockClusterTreeNodeSize(blockClusterTreeNode);
+    stats.startTime = tbb::tick_count::now();
+    m_compressor.compressBlock(blockClusterTreeNode, hMatrixData);
+    stats.endTime = tbb::tick_count::now();
+    m_stats.push_back(
+        std::make_pair(blockClusterTreeNode.data().admissible, stats));
+  }
+
+private:
+  const hmat::HMatrixCompressor<ResultType, 2> &m_compressor;
+  tbb::concurrent_vector<std::pair<bool, ChunkStatistics>> &m_stats;
+};
+
 template <typename BasisFunctionType>
 shared_ptr<hmat::DefaultBlockClusterTreeType>
 generateBlockClusterTree(const Space<BasisFunctionType> &testSpace,
                          const Space<BasisFunctionType> &trialSpace,
-                         int minBlockSize, int maxBlockSize, double eta) {
+                         int minBlockSize, int maxBlockSize, double eta,
+                         hmat::ClusterSplitting clusterSplitting,
+                         bool identicalSpaces) {
 
   hmat::Geometry testGeometry;
-  hmat::Geometry trialGeometry;
 
   auto testSpaceGeometryInterface = shared_ptr<hmat::GeometryInterface>(
       new SpaceHMatGeometryInterface<BasisFunctionType>(testSpace));
 
-  auto trialSpaceGeometryInterface = shared_ptr<hmat::GeometryInterface>(
-      new SpaceHMatGeometryInterface<BasisFunctionType>(trialSpace));
-
   hmat::fillGeometry(testGeometry, *testSpaceGeometryInterface);
-  hmat::fillGeometry(trialGeometry, *trialSpaceGeometryInterface);
 
   auto testClusterTree = shared_ptr<hmat::DefaultClusterTreeType>(
-      new hmat::DefaultClusterTreeType(testGeometry, minBlockSize));
+      new hmat::DefaultClusterTreeType(testGeometry, minBlockSize,
+                                      clusterSplitting));
 
-  auto trialClusterTree = shared_ptr<hmat::DefaultClusterTreeType>(
-      new hmat::DefaultClusterTreeType(trialGeometry, minBlockSize));
+  shared_ptr<hmat::DefaultClusterTreeType> trialClusterTree;
+  if (identicalSpaces)
+    trialClusterTree = testClusterTree;
+  else {
+    hmat::Geometry trialGeometry;
+
+    auto trialSpaceGeometryInterface = shared_ptr<hmat::GeometryInterface>(
+        new SpaceHMatGeometryInterface<BasisFunctionType>(trialSpace));
+
+    hmat::fillGeometry(trialGeometry, *trialSpaceGeometryInterface);
+
+    trialClusterTree = shared_ptr<hmat::DefaultClusterTreeType>(
+        new hmat::DefaultClusterTreeType(trialGeometry, minBlockSize,
+                                        clusterSplitting));
+  }
 
   shared_ptr<hmat::DefaultBlockClusterTreeType> blockClusterTree(
       new hmat::DefaultBlockClusterTreeType(testClusterTree, trialClusterTree,
@@ -134,6 +225,259 @@ generateBlockClusterTree(const Space<BasisFunctionType> &testSpace,
 
   return blockClusterTree;
 }
+
+template <typename BasisFunctionType>
+void hashSpace(std::size_t &seed, const Space<BasisFunctionType> &space) {
+
+  boost::hash_combine(seed, std::string(typeid(space).name()));
+  boost::hash_combine(seed, space.globalDofCount());
+
+  std::vector<BoundingBox<
+      typename Fiber::ScalarTraits<BasisFunctionType>::RealType>> boxes;
+  space.getGlobalDofBoundingBoxes(boxes);
+  for (const auto &box : boxes)
+    for (const auto &point : {box.lbound, box.ubound, box.reference}) {
+      boost::hash_combine(seed, point.x);
+      boost::hash_combine(seed, point.y);
+      boost::hash_combine(seed, point.z);
+    }
+}
+
+void hashParameterList(std::size_t &seed,
+                       const Teuchos::ParameterList &parameterList) {
+  for (auto it = parameterList.begin(); it != parameterList.end(); ++it) {
+    const std::string &name = parameterList.name(it);
+    if (name == "cacheDirectory")
+      continue;
+    boost::hash_combine(seed, name);
+    if (parameterList.isSublist(name)) {
+      hashParameterList(seed, parameterList.sublist(name));
+      continue;
+    }
+    std::ostringstream value;
+    value << parameterList.entry(it).getAny(false);
+    boost::hash_combine(seed, value.str());
+  }
+}
+
+// H-matrix parameters shared by the assembly of weak forms and of potential
+// operators. The constructor throws std::invalid_argument, prefixed with
+// \p caller, if a parameter has an unsupported value.
+struct HMatParameters {
+  HMatParameters(const Teuchos::ParameterList &hMatParameterList,
+                 const std::string &caller) {
+    indexWithGlobalDofs =
+        (hMatParameterList.get<std::string>("HMatAssemblyMode") ==
+         "GlobalAssembly");
+    minBlockSize = hMatParameterList.get<int>("minBlockSize");
+    maxBlockSize = hMatParameterList.get<int>("maxBlockSize");
+    eta = hMatParameterList.get<double>("eta");
+    eps = hMatParameterList.get<double>("eps");
+    maxRank = hMatParameterList.get<int>("maxRank");
+    resizeThreshold = hMatParameterList.get<int>("resizeThreshold");
+    recompress = hMatParameterList.get<bool>("recompress");
+    coarsen = hMatParameterList.get<bool>("coarsen");
+    cacheDirectory = hMatParameterList.get<std::string>("cacheDirectory");
+
+    const auto rankMode = hMatParameterList.get<std::string>("rankMode");
+    if (rankMode != "adaptive" && rankMode != "fixed")
+      throw std::invalid_argument(caller +
+                                  ": rankMode has unsupported value.");
+    adaptiveRank = (rankMode == "adaptive");
+
+    const auto splitting =
+        hMatParameterList.get<std::string>("clusterSplitting");
+    if (splitting != "boundingBox" && splitting != "pca")
+      throw std::invalid_argument(caller +
+                                  ": clusterSplitting has unsupported value.");
+    clusterSplitting = (splitting == "pca") ? hmat::PCA_SPLITTING
+                                            : hmat::BOUNDING_BOX_SPLITTING;
+
+    const auto compressionAlgorithm =
+        hMatParameterList.get<std::string>("compressionAlgorithm");
+    if (compressionAlgorithm != "acaPlus" && compressionAlgorithm != "aca")
+      throw std::invalid_argument(
+          caller + ": compressionAlgorithm has unsupported value.");
+    useAcaPlus = (compressionAlgorithm == "acaPlus");
+  }
+
+  bool indexWithGlobalDofs;
+  int minBlockSize;
+  int maxBlockSize;
+  double eta;
+  hmat::ClusterSplitting clusterSplitting;
+  double eps;
+  int maxRank;
+  int resizeThreshold;
+  bool adaptiveRank;
+  bool useAcaPlus;
+  bool recompress;
+  bool coarsen;
+  std::string cacheDirectory;
+};
+
+// Compresses the leaf blocks with the algorithm selected by the parameters
+template <typename ResultType>
+class ParameterizedHMatrixCompressor
+    : public hmat::HMatrixCompressor<ResultType, 2> {
+
+public:
+  ParameterizedHMatrixCompressor(
+      const hmat::DataAccessor<ResultType, 2> &dataAccessor,
+      const HMatParameters &parameters)
+      : m_acaCompressor(dataAccessor, parameters.eps, parameters.maxRank,
+                        parameters.resizeThreshold, parameters.adaptiveRank),
+        m_acaPlusCompressor(dataAccessor, parameters.eps, parameters.maxRank,
+                            parameters.adaptiveRank),
+        m_useAcaPlus(parameters.useAcaPlus) {}
+
+  void compressBlock(
+      const hmat::DefaultBlockClusterTreeNodeType &blockClusterTreeNode,
+      shared_ptr<hmat::HMatrixData<ResultType>> &hMatrixData) const override {
+    if (m_useAcaPlus)
+      m_acaPlusCompressor.compressBlock(blockClusterTreeNode, hMatrixData);
+    else
+      m_acaCompressor.compressBlock(blockClusterTreeNode, hMatrixData);
+  }
+
+private:
+  hmat::HMatrixAcaCompressor<ResultType, 2> m_acaCompressor;
+  hmat::HMatrixAcaPlusCompressor<ResultType, 2> m_acaPlusCompressor;
+  bool m_useAcaPlus;
+};
+
+// Key of an assembled H-matrix in the cache. The caller seeds it with a hash
+// of the geometry of the rows and columns and of the operator as seen by its
+// local assemblers (kernel type and parameters, shapeset transformations,
+// integral and term multipliers); added to it are the value types, the
+// H-matrix parameters, including the optional cacheKey, the quadrature orders
+// and a sample of matrix entries. What the local assemblers do not expose,
+// e.g. a custom quadrature strategy, must be identified by the cacheKey. The
+// sample of entries is only a safeguard against a stale key.
+template <typename BasisFunctionType, typename ResultType>
+std::string hMatCacheKey(std::size_t seed,
+                         const Teuchos::ParameterList &parameterList,
+                         const hmat::DataAccessor<ResultType, 2> &dataAccessor,
+                         const hmat::DefaultBlockClusterTreeType &
+                             blockClusterTree) {
+
+  boost::hash_combine(seed, hmat::HMATRIX_FILE_VERSION);
+  boost::hash_combine(seed, std::string(typeid(BasisFunctionType).name()));
+  boost::hash_combine(seed, std::string(typeid(ResultType).name()));
+
+  hashParameterList(seed, parameterList.sublist("HMatParameters"));
+  if (parameterList.isSublist("QuadratureOrders"))
+    hashParameterList(seed, parameterList.sublist("QuadratureOrders"));
+
+  // Entries on the diagonal (singular integrals of weak forms) and on the
+  // antidiagonal (regular integrals)
+  const std::size_t sampleCount = 8;
+  const std::size_t rows = blockClusterTree.rows();
+  const std::size_t columns = blockClusterTree.columns();
+  arma::Mat<ResultType> entry;
+  for (std::size_t k = 0; k < sampleCount; ++k) {
+    const std::size_t row = k * rows / sampleCount;
+    const std::size_t diagonalColumn = k * columns / sampleCount;
+    for (std::size_t column : {diagonalColumn, columns - 1 - diagonalColumn}) {
+      dataAccessor.computeMatrixBlock(
+          hmat::IndexRangeType({{row, row + 1}}),
+          hmat::IndexRangeType({{column, column + 1}}),
+          *blockClusterTree.root(), entry);
+      boost::hash_combine(seed, entry(0, 0));
+    }
+  }
+
+  std::ostringstream key;
+  key << std::hex << std::setw(2 * sizeof(seed)) << std::setfill('0') << seed;
+  return key.str();
+}
+
+// Returns a null pointer if the file does not exist or cannot be read
+template <typename ResultType>
+shared_ptr<hmat::DefaultHMatrixType<ResultType>>
+loadCachedHMatrix(const std::string &cacheFileName, bool verbose) {
+
+  shared_ptr<hmat::DefaultHMatrixType<ResultType>> hMatrix;
+  if (!std::ifstream(cacheFileName.c_str()).good())
+    return hMatrix;
+  try {
+    tbb::tick_count loadStart = tbb::tick_count::now();
+    hMatrix = hmat::loadHMatrix<ResultType, 2>(cacheFileName);
+    tbb::tick_count loadEnd = tbb::tick_count::now();
+    if (verbose)
+      std::cout << "Loaded HMat from cache file " << cacheFileName << " in "
+                << (loadEnd - loadStart).seconds() << " s" << std::endl;
+  } catch (std::exception &e) {
+    if (verbose)
+      std::cout << "Warning: cache file " << cacheFileName
+                << " could not be read and the HMat will be reassembled: "
+                << e.what() << std::endl;
+  }
+  return hMatrix;
+}
+
+template <typename ResultType>
+void saveCachedHMatrix(const hmat::DefaultHMatrixType<ResultType> &hMatrix,
+                       const std::string &cacheFileName, bool verbose) {
+  try {
+    hmat::saveHMatrix(hMatrix, cacheFileName);
+  } catch (std::exception &e) {
+    if (verbose)
+      std::cout << "Warning: the HMat could not be written to the cache: "
+                << e.what() << std::endl;
+  }
+}
+
+template <typename ResultType>
+void recompressAndCoarsen(hmat::DefaultHMatrixType<ResultType> &hMatrix,
+                          const HMatParameters &parameters, bool verbose) {
+
+  if (parameters.recompress) {
+    const double memSizeKb = hMatrix.memSizeKb();
+    tbb::tick_count recompressionStart = tbb::tick_count::now();
+    double savedKb;
+    {
+      Fiber::SerialBlasRegion region;
+      savedKb = hMatrix.recompress(parameters.eps);
+    }
+    tbb::tick_count recompressionEnd = tbb::tick_count::now();
+    if (verbose)
+      std::cout << "HMat recompression took "
+                << (recompressionEnd - recompressionStart).seconds()
+                << " s and reduced the storage from " << memSizeKb
+                << " kB to " << memSizeKb - savedKb << " kB" << std::endl;
+  }
+
+  if (parameters.coarsen) {
+    const double memSizeKb = hMatrix.memSizeKb();
+    const std::size_t numberOfLeafs = hMatrix.numberOfLeafs();
+    tbb::tick_count coarseningStart = tbb::tick_count::now();
+    double savedKb;
+    {
+      Fiber::SerialBlasRegion region;
+      savedKb = hMatrix.coarsen(parameters.eps);
+    }
+    tbb::tick_count coarseningEnd = tbb::tick_count::now();
+    if (verbose)
+      std::cout << "HMat coarsening took "
+                << (coarseningEnd - coarseningStart).seconds()
+                << " s and reduced the number of leafs from " << numberOfLeafs
+                << " to " << hMatrix.numberOfLeafs() << " and the storage "
+                << "from " << memSizeKb << " kB to " << memSizeKb - savedKb
+                << " kB" << std::endl;
+  }
+}
+
+int schedulerThreadCount(const ParallelizationOptions &parallelOptions) {
+  int maxThreadCount = 1;
+  if (!parallelOptions.isOpenClEnabled()) {
+    if (parallelOptions.maxThreadCount() == ParallelizationOptions::AUTO)
+      maxThreadCount = tbb::task_scheduler_init::automatic;
+    else
+      maxThreadCount = parallelOptions.maxThreadCount();
+  }
+  return maxThreadCount;
+}
 } // end anonymous namespace
 template <typename BasisFunctionType, typename ResultType>
 std::unique_ptr<DiscreteBoundaryOperator<ResultType>>
@@ -149,11 +493,9 @@ HMatGlobalAssembler<BasisFunctionType, ResultType>::assembleDetachedWeakForm(
     const Context<BasisFunctionType, ResultType> &context, int symmetry) {
 
   const AssemblyOptions &options = context.assemblyOptions();
-  const auto hMatParameterList =
-      context.globalParameterList().sublist("HMatParameters");
-  const bool indexWithGlobalDofs =
-      (hMatParameterList.template get<std::string>("HMatAssemblyMode") ==
-       "GlobalAssembly");
+  const HMatParameters parameters(
+      context.globalParameterList().sublist("HMatParameters"),
+      "HMatGlobalAssembler::assembleDetachedWeakForm()");
   const bool verbosityAtLeastDefault =
       (options.verbosityLevel() >= VerbosityLevel::DEFAULT);
   const bool verbosityAtLeastHigh =
@@ -164,7 +506,7 @@ HMatGlobalAssembler<BasisFunctionType, ResultType>::assembleDetachedWeakForm(
 
   shared_ptr<const Space<BasisFunctionType>> actualTestSpace;
   shared_ptr<const Space<BasisFunctionType>> actualTrialSpace;
-  if (indexWithGlobalDofs) {
+  if (parameters.indexWithGlobalDofs) {
     actualTestSpace = testSpacePointer->discontinuousSpace(testSpacePointer);
     actualTrialSpace = trialSpacePointer->discontinuousSpace(trialSpacePointer);
   } else {
@@ -172,14 +514,30 @@ HMatGlobalAssembler<BasisFunctionType, ResultType>::assembleDetachedWeakForm(
     actualTrialSpace = trialSpacePointer;
   }
 
-  auto minBlockSize =
-      hMatParameterList.template get<unsigned int>("minBlockSize");
-  auto maxBlockSize =
-      hMatParameterList.template get<unsigned int>("maxBlockSize");
-  auto eta = hMatParameterList.template get<double>("eta");
+  // As in ACA mode, only symmetric (not Hermitian) H-matrices are supported
+  const bool symmetric = symmetry & SYMMETRIC;
+  if (symmetry & HERMITIAN && !(symmetry & SYMMETRIC) &&
+      verbosityAtLeastDefault)
+    std::cout << "Warning: assembly of non-symmetric Hermitian H-matrices "
+                 "is not supported yet. A general H-matrix will be assembled"
+              << std::endl;
+
+  if (symmetric &&
+      actualTestSpace->globalDofCount() != actualTrialSpace->globalDofCount())
+    throw std::invalid_argument(
+        "HMatGlobalAssembler::assembleDetachedWeakForm(): "
+        "you cannot generate a symmetric weak form "
+        "using test and trial spaces with different "
+        "numbers of DOFs");
+
+  // The cluster trees are built in parallel as well
+  tbb::task_scheduler_init scheduler(
+      schedulerThreadCount(options.parallelizationOptions()));
 
   auto blockClusterTree = generateBlockClusterTree(
-      *actualTestSpace, *actualTrialSpace, minBlockSize, maxBlockSize, eta);
+      *actualTestSpace, *actualTrialSpace, parameters.minBlockSize,
+      parameters.maxBlockSize, parameters.eta, parameters.clusterSplitting,
+      symmetric || &testSpace == &trialSpace);
 
   // blockClusterTree->writeToPdfFile("tree.pdf", 1024, 1024);
 
@@ -187,13 +545,76 @@ HMatGlobalAssembler<BasisFunctionType, ResultType>::assembleDetachedWeakForm(
       *actualTestSpace, *actualTrialSpace, blockClusterTree, localAssemblers,
       sparseTermsToAdd, denseTermMultipliers, sparseTermMultipliers);
 
+  std::string cacheFileName;
+  if (!parameters.cacheDirectory.empty()) {
+    std::size_t seed = 0;
+    boost::hash_combine(seed, symmetry);
+    hashSpace(seed, *actualTestSpace);
+    hashSpace(seed, *actualTrialSpace);
+    for (const auto localAssembler : localAssemblers)
+      localAssembler->hashParameters(seed);
+    for (const auto &multiplier : denseTermMultipliers)
+      boost::hash_combine(seed, multiplier);
+    for (const auto sparseTerm : sparseTermsToAdd)
+      boost::hash_combine(seed, std::string(typeid(*sparseTerm).name()));
+    for (const auto &multiplier : sparseTermMultipliers)
+      boost::hash_combine(seed, multiplier);
+    cacheFileName =
+        parameters.cacheDirectory + "/hmat_" +
+        hMatCacheKey<BasisFunctionType>(seed, context.globalParameterList(),
+                                        helper, *blockClusterTree) +
+        ".bin";
+    auto cachedHMatrix =
+        loadCachedHMatrix<ResultType>(cacheFileName, verbosityAtLeastDefault);
+    if (cachedHMatrix)
+      return std::unique_ptr<DiscreteBoundaryOperator<ResultType>>(
+          new DiscreteHMatBoundaryOperator<ResultType>(cachedHMatrix));
+  }
+
   // hmat::HMatrixDenseCompressor<ResultType, 2> compressor(helper);
   // shared_ptr<hmat::CompressedMatrix<ResultType>> hMatrix(
   //    new hmat::DefaultHMatrixType<ResultType>(blockClusterTree, compressor));
 
-  hmat::HMatrixAcaCompressor<ResultType, 2> compressor(helper, 1E-3, 30);
-  shared_ptr<hmat::CompressedMatrix<ResultType>> hMatrix(
-      new hmat::DefaultHMatrixType<ResultType>(blockClusterTree, compressor));
+  ParameterizedHMatrixCompressor<ResultType> compressor(helper, parameters);
+
+  tbb::concurrent_vector<std::pair<bool, ChunkStatistics>> chunkStats;
+  TimedHMatrixCompressor<ResultType> timedCompressor(compressor, chunkStats);
+
+  if (verbosityAtLeastDefault)
+    std::cout << "About to start the HMat assembly loop" << std::endl;
+  tbb::tick_count loopStart = tbb::tick_count::now();
+  shared_ptr<hmat::DefaultHMatrixType<ResultType>> hMatrix;
+  {
+    Fiber::SerialBlasRegion region; // if possible, ensure that BLAS is
+                                    // single-threaded
+    hMatrix.reset(new hmat::DefaultHMatrixType<ResultType>(
+        blockClusterTree, timedCompressor, symmetric));
+  }
+  tbb::tick_count loopEnd = tbb::tick_count::now();
+
+  if (verbosityAtLeastDefault) {
+    std::cout << "HMat assembly loop took " << (loopEnd - loopStart).seconds()
+              << " s" << std::endl;
+    if (verbosityAtLeastHigh) {
+      tbb::tick_count::interval_t admTime, inadmTime;
+      for (const auto &stats : chunkStats)
+        if (stats.first)
+          admTime += stats.second.endTime - stats.second.startTime;
+        else
+          inadmTime += stats.second.endTime - stats.second.startTime;
+      std::cout << "CPU time spent on assembly of admissible blocks: "
+                << admTime.seconds() << " s\n";
+      std::cout << "CPU time spent on assembly of inadmissible blocks: "
+                << inadmTime.seconds() << " s" << std::endl;
+      for (const auto &localAssembler : localAssemblers)
+        localAssembler->printStatistics(std::cout);
+    }
+  }
+
+  recompressAndCoarsen(*hMatrix, parameters, verbosityAtLeastDefault);
+
+  if (!cacheFileName.empty())
+    saveCachedHMatrix(*hMatrix, cacheFileName, verbosityAtLeastDefault);
 
   return std::unique_ptr<DiscreteBoundaryOperator<ResultType>>(
       new DiscreteHMatBoundaryOperator<ResultType>(hMatrix));
@@ -223,6 +644,126 @@ HMatGlobalAssembler<BasisFunctionType, ResultType>::assembleDetachedWeakForm(
                                   sparseTermsMultipliers, context, symmetry);
 }
 
+template <typename BasisFunctionType, typename ResultType>
+std::unique_ptr<DiscreteBoundaryOperator<ResultType>>
+HMatGlobalAssembler<BasisFunctionType, ResultType>::assemblePotentialOperator(
+    const arma::Mat<CoordinateType> &points,
+    const Space<BasisFunctionType> &trialSpace,
+    const std::vector<LocalAssemblerForPotentialOperators *> &localAssemblers,
+    const std::vector<ResultType> &termMultipliers,
+    const EvaluationOptions &options) {
+
+  if (localAssemblers.empty())
+    throw std::invalid_argument(
+        "HMatGlobalAssembler::assemblePotentialOperator(): "
+        "the 'localAssemblers' vector must not be empty");
+  if (points.n_rows != 3)
+    throw std::invalid_argument(
+        "HMatGlobalAssembler::assemblePotentialOperator(): "
+        "the evaluation points must have three coordinates");
+
+  const HMatParameters parameters(
+      options.parameterList().sublist("HMatParameters"),
+      "HMatGlobalAssembler::assemblePotentialOperator()");
+  const bool verbosityAtLeastDefault =
+      (options.verbosityLevel() >= VerbosityLevel::DEFAULT);
+
+  tbb::task_scheduler_init scheduler(
+      schedulerThreadCount(options.parallelizationOptions()));
+
+  const int componentCount = localAssemblers[0]->resultDimension();
+
+  // Rows: components of the potential at the evaluation points
+  hmat::Geometry pointGeometry;
+  PointsHMatGeometryInterface<CoordinateType> pointGeometryInterface(
+      points, componentCount);
+  hmat::fillGeometry(pointGeometry, pointGeometryInterface);
+  auto pointClusterTree = shared_ptr<hmat::DefaultClusterTreeType>(
+      new hmat::DefaultClusterTreeType(pointGeometry, parameters.minBlockSize,
+                                       parameters.clusterSplitting));
+
+  // Columns: global DOFs of the trial space
+  hmat::Geometry trialGeometry;
+  SpaceHMatGeometryInterface<BasisFunctionType> trialGeometryInterface(
+      trialSpace);
+  hmat::fillGeometry(trialGeometry, trialGeometryInterface);
+  auto trialClusterTree = shared_ptr<hmat::DefaultClusterTreeType>(
+      new hmat::DefaultClusterTreeType(trialGeometry, parameters.minBlockSize,
+                                       parameters.clusterSplitting));
+
+  shared_ptr<hmat::DefaultBlockClusterTreeType> blockClusterTree(
+      new hmat::DefaultBlockClusterTreeType(
+          pointClusterTree, trialClusterTree, parameters.maxBlockSize,
+          hmat::StandardAdmissibility(parameters.eta)));
+
+  PotentialOperatorHMatAssemblyHelper<BasisFunctionType, ResultType> helper(
+      trialSpace, blockClusterTree, localAssemblers, termMultipliers);
+
+  std::string cacheFileName;
+  if (!parameters.cacheDirectory.empty()) {
+    std::size_t seed = 0;
+    boost::hash_combine(seed, std::string("potential"));
+    boost::hash_combine(seed, componentCount);
+    for (std::size_t i = 0; i < points.n_elem; ++i)
+      boost::hash_combine(seed, points[i]);
+    for (const auto localAssembler : localAssemblers)
+      localAssembler->hashParameters(seed);
+    for (const auto &multiplier : termMultipliers)
+      boost::hash_combine(seed, multiplier);
+    hashSpace(seed, trialSpace);
+    cacheFileName =
+        parameters.cacheDirectory + "/hmat_" +
+        hMatCacheKey<BasisFunctionType>(seed, options.parameterList(), helper,
+                                        *blockClusterTree) +
+        ".bin";
+    auto cachedHMatrix =
+        loadCachedHMatrix<ResultType>(cacheFileName, verbosityAtLeastDefault);
+    if (cachedHMatrix)
+      return std::unique_ptr<DiscreteBoundaryOperator<ResultType>>(
+          new DiscreteHMatBoundaryOperator<ResultType>(cachedHMatrix));
+  }
+
+  ParameterizedHMatrixCompressor<ResultType> compressor(helper, parameters);
+
+  tbb::tick_count loopStart = tbb::tick_count::now();
+  shared_ptr<hmat::DefaultHMatrixType<ResultType>> hMatrix;
+  {
+    Fiber::SerialBlasRegion region;
+    hMatrix.reset(
+        new hmat::DefaultHMatrixType<ResultType>(blockClusterTree, compressor));
+  }
+  tbb::tick_count loopEnd = tbb::tick_count::now();
+
+  if (verbosityAtLeastDefault)
+    std::cout << "HMat assembly of the potential operator at "
+              << points.n_cols << " points took "
+              << (loopEnd - loopStart).seconds() << " s and needs "
+              << hMatrix->memSizeKb() << " kB" << std::endl;
+
+  recompressAndCoarsen(*hMatrix, parameters, verbosityAtLeastDefault);
+
+  if (!cacheFileName.empty())
+    saveCachedHMatrix(*hMatrix, cacheFileName, verbosityAtLeastDefault);
+
+  return std::unique_ptr<DiscreteBoundaryOperator<ResultType>>(
+      new DiscreteHMatBoundaryOperator<ResultType>(hMatrix));
+}
+
+template <typename BasisFunctionType, typename ResultType>
+std::unique_ptr<DiscreteBoundaryOperator<ResultType>>
+HMatGlobalAssembler<BasisFunctionType, ResultType>::assemblePotentialOperator(
+    const arma::Mat<CoordinateType> &points,
+    const Space<BasisFunctionType> &trialSpace,
+    LocalAssemblerForPotentialOperators &localAssembler,
+    const EvaluationOptions &options) {
+  std::vector<LocalAssemblerForPotentialOperators *> localAssemblers(
+      1, &localAssembler);
+  std::vector<ResultType> termMultipliers(1, 1.0);
+
+  return assemblePotentialOperator(points, trialSpace, localAssemblers,
+                                   termMultipliers, options);
+}
+
 FIBER_INSTANTIATE_CLASS_TEMPLATED_ON_BASIS_AND_RESULT(HMatGlobalAssembler);
 
 } // namespace Bempp
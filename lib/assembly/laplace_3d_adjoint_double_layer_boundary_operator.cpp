@@ -64,10 +64,10 @@ laplace3dAdjointDoubleLayerBoundaryOperator(
                                             ResultType>> integral;
   if (shouldUseBlasInQuadrature(assemblyOptions, *domain, *dualToRange))
     integral.reset(new Fiber::TypicalTestScalarKernelTrialIntegral<
-        BasisFunctionType, KernelType, ResultType>());
+        BasisFunctionType, KernelType, ResultType>(true));
   else
     integral.reset(new Fiber::DefaultTestKernelTrialIntegral<IntegrandFunctor>(
-        IntegrandFunctor()));
+        IntegrandFunctor(true)));
 
   typedef GeneralElementarySingularIntegralOperator<BasisFunctionType,
                                                     KernelType, ResultType> Op;
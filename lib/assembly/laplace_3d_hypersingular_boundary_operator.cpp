@@ -191,14 +191,14 @@ laplace3dHypersingularBoundaryOperator(
       offDiagonalIntegral;
   if (shouldUseBlasInQuadrature(assemblyOptions, *domain, *dualToRange)) {
     integral.reset(new Fiber::TypicalTestScalarKernelTrialIntegral<
-        BasisFunctionType, KernelType, ResultType>());
+        BasisFunctionType, KernelType, ResultType>(true));
     offDiagonalIntegral = integral;
   } else {
     integral.reset(new Fiber::DefaultTestKernelTrialIntegral<IntegrandFunctor>(
-        IntegrandFunctor()));
+        IntegrandFunctor(true)));
     offDiagonalIntegral.reset(
         new Fiber::DefaultTestKernelTrialIntegral<OffDiagonalIntegrandFunctor>(
-            OffDiagonalIntegrandFunctor()));
+            OffDiagonalIntegrandFunctor(true)));
   }
 
   shared_ptr<Op> newOp(
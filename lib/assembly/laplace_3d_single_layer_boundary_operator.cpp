@@ -72,10 +72,10 @@ laplace3dSingleLayerBoundaryOperator(
                                             ResultType>> integral;
   if (shouldUseBlasInQuadrature(assemblyOptions, *domain, *dualToRange))
     integral.reset(new Fiber::TypicalTestScalarKernelTrialIntegral<
-        BasisFunctionType, KernelType, ResultType>());
+        BasisFunctionType, KernelType, ResultType>(true));
   else
     integral.reset(new Fiber::DefaultTestKernelTrialIntegral<IntegrandFunctor>(
-        IntegrandFunctor()));
+        IntegrandFunctor(true)));
   shared_ptr<Op> newOp(new Op(domain, range, dualToRange, label, symmetry,
                               KernelFunctor(), TransformationFunctor(),
                               TransformationFunctor(), integral));
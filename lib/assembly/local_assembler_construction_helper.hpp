@@ -35,6 +35,11 @@
 
 #include "../common/boost_make_shared_fwd.hpp"
 
+#include <vector>
+
+#include <boost/weak_ptr.hpp>
+#include <tbb/mutex.h>
+
 namespace Bempp {
 
 /** \ingroup weak_form_assembly_internal
@@ -46,15 +51,55 @@ struct LocalAssemblerConstructionHelper {
       const Space<BasisFunctionType> &space,
       shared_ptr<Fiber::RawGridGeometry<CoordinateType>> &rawGeometry,
       shared_ptr<GeometryFactory> &geometryFactory) {
+    rawGeometry = sharedRawGeometry<CoordinateType>(space);
+    geometryFactory = space.elementGeometryFactory();
+  }
+
+  /** \brief Return the raw geometry of the grid view of \p space.
+   *
+   *  The raw geometry, and hence the geometrical data cached in it, is shared
+   *  by all operators on spaces defined on the same grid view for as long as
+   *  any of them is alive. Grids are immutable, so a view is identified by
+   *  its grid and its numbers of elements and vertices; the element data
+   *  themselves are not compared. */
+  template <typename CoordinateType, typename BasisFunctionType>
+  static shared_ptr<Fiber::RawGridGeometry<CoordinateType>>
+  sharedRawGeometry(const Space<BasisFunctionType> &space) {
     typedef Fiber::RawGridGeometry<CoordinateType> RawGridGeometry;
+    typedef std::vector<RawGeometryRegistryEntry<CoordinateType>> Registry;
+    static tbb::mutex mutex;
+    static Registry registry;
 
-    rawGeometry = boost::make_shared<RawGridGeometry>(space.gridDimension(),
-                                                      space.worldDimension());
+    const shared_ptr<const Grid> grid = space.grid();
     const GridView &view = space.gridView();
+    RawGeometryRegistryEntry<CoordinateType> entry;
+    entry.grid = grid;
+    entry.elementCount = view.entityCount(0);
+    entry.vertexCount = view.entityCount(space.gridDimension());
+
+    {
+      tbb::mutex::scoped_lock lock(mutex);
+      shared_ptr<RawGridGeometry> existing =
+          findRawGeometry(registry, *grid, entry);
+      if (existing)
+        return existing;
+    }
+
+    // Collect the element data without holding the lock
+    shared_ptr<RawGridGeometry> rawGeometry = boost::make_shared<
+        RawGridGeometry>(space.gridDimension(), space.worldDimension());
     view.getRawElementData(
         rawGeometry->vertices(), rawGeometry->elementCornerIndices(),
         rawGeometry->auxData(), rawGeometry->domainIndices());
-    geometryFactory = space.elementGeometryFactory();
+
+    tbb::mutex::scoped_lock lock(mutex);
+    shared_ptr<RawGridGeometry> existing =
+        findRawGeometry(registry, *grid, entry);
+    if (existing)
+      return existing; // another thread got there first
+    entry.geometry = rawGeometry;
+    registry.push_back(entry);
+    return rawGeometry;
   }
 
   template <typename BasisFunctionType>
@@ -100,6 +145,40 @@ struct LocalAssemblerConstructionHelper {
             "spaces defined on different grids is not currently supported");
     }
   }
+
+private:
+  template <typename CoordinateType> struct RawGeometryRegistryEntry {
+    boost::weak_ptr<const Grid> grid;
+    size_t elementCount;
+    size_t vertexCount;
+    boost::weak_ptr<Fiber::RawGridGeometry<CoordinateType>> geometry;
+  };
+
+  // Must be called with the registry mutex held. Expired entries are
+  // removed on the way.
+  template <typename CoordinateType>
+  static shared_ptr<Fiber::RawGridGeometry<CoordinateType>>
+  findRawGeometry(std::vector<RawGeometryRegistryEntry<CoordinateType>> &
+                      registry,
+                  const Grid &grid,
+                  const RawGeometryRegistryEntry<CoordinateType> &key) {
+    typedef std::vector<RawGeometryRegistryEntry<CoordinateType>> Registry;
+    for (typename Registry::iterator it = registry.begin();
+         it != registry.end();) {
+      shared_ptr<const Grid> entryGrid = it->grid.lock();
+      shared_ptr<Fiber::RawGridGeometry<CoordinateType>> geometry =
+          it->geometry.lock();
+      if (!entryGrid || !geometry) {
+        it = registry.erase(it);
+        continue;
+      }
+      if (entryGrid.get() == &grid && it->elementCount == key.elementCount &&
+          it->vertexCount == key.vertexCount)
+        return geometry;
+      ++it;
+    }
+    return shared_ptr<Fiber::RawGridGeometry<CoordinateType>>();
+  }
 };
 
 } // namespace Bempp
@@ -0,0 +1,153 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "mass_matrix_cache.hpp"
+
+#include "abstract_boundary_operator_pseudoinverse.hpp"
+#include "boundary_operator.hpp"
+#include "context.hpp"
+#include "discrete_boundary_operator.hpp"
+#include "identity_operator.hpp"
+
+#include "../fiber/explicit_instantiation.hpp"
+
+#include <boost/weak_ptr.hpp>
+#include <tbb/mutex.h>
+#include <vector>
+
+namespace Bempp {
+
+/** \cond PRIVATE */
+template <typename BasisFunctionType, typename ResultType>
+struct MassMatrixCache<BasisFunctionType, ResultType>::Impl {
+  typedef Space<BasisFunctionType> SpaceType;
+  typedef DiscreteBoundaryOperator<ResultType> DiscreteOp;
+
+  struct Entry {
+    boost::weak_ptr<const SpaceType> domain;
+    boost::weak_ptr<const SpaceType> range;
+    boost::weak_ptr<const SpaceType> dualToRange;
+    shared_ptr<const DiscreteOp> massMatrix;
+    shared_ptr<const DiscreteOp> inverseMassMatrix;
+  };
+
+  // Return the entry for the given spaces, creating it if necessary, and
+  // evict the entries of destroyed spaces. Must be called with the mutex
+  // locked; the reference is invalidated once the mutex is released.
+  Entry &entry(const shared_ptr<const SpaceType> &domain,
+               const shared_ptr<const SpaceType> &range,
+               const shared_ptr<const SpaceType> &dualToRange) {
+    Entry *result = 0;
+    for (size_t i = 0; i < entries.size();) {
+      if (entries[i].domain.expired() || entries[i].range.expired() ||
+          entries[i].dualToRange.expired()) {
+        entries[i] = entries.back();
+        entries.pop_back();
+        continue;
+      }
+      if (entries[i].domain.lock() == domain &&
+          entries[i].range.lock() == range &&
+          entries[i].dualToRange.lock() == dualToRange)
+        result = &entries[i];
+      ++i;
+    }
+    if (result)
+      return *result;
+    Entry newEntry;
+    newEntry.domain = domain;
+    newEntry.range = range;
+    newEntry.dualToRange = dualToRange;
+    entries.push_back(newEntry);
+    return entries.back();
+  }
+
+  std::vector<Entry> entries;
+  tbb::mutex mutex;
+};
+/** \endcond */
+
+template <typename BasisFunctionType, typename ResultType>
+MassMatrixCache<BasisFunctionType, ResultType>::MassMatrixCache()
+    : m_impl(new Impl) {}
+
+template <typename BasisFunctionType, typename ResultType>
+MassMatrixCache<BasisFunctionType, ResultType>::~MassMatrixCache() {}
+
+// The operators are assembled without holding the mutex, so that threads
+// working on other spaces are not blocked in the meantime. If two threads
+// assemble the same operator simultaneously, the one stored first is kept.
+
+template <typename BasisFunctionType, typename ResultType>
+shared_ptr<const DiscreteBoundaryOperator<ResultType>>
+MassMatrixCache<BasisFunctionType, ResultType>::massMatrix(
+    const shared_ptr<const Context<BasisFunctionType, ResultType>> &context,
+    const shared_ptr<const Space<BasisFunctionType>> &domain,
+    const shared_ptr<const Space<BasisFunctionType>> &range,
+    const shared_ptr<const Space<BasisFunctionType>> &dualToRange) const {
+  {
+    tbb::mutex::scoped_lock lock(m_impl->mutex);
+    typename Impl::Entry &entry = m_impl->entry(domain, range, dualToRange);
+    if (entry.massMatrix)
+      return entry.massMatrix;
+  }
+
+  shared_ptr<const DiscreteBoundaryOperator<ResultType>> massMatrix =
+      identityOperator(context, domain, range, dualToRange).weakForm();
+
+  tbb::mutex::scoped_lock lock(m_impl->mutex);
+  typename Impl::Entry &entry = m_impl->entry(domain, range, dualToRange);
+  if (!entry.massMatrix)
+    entry.massMatrix = massMatrix;
+  return entry.massMatrix;
+}
+
+template <typename BasisFunctionType, typename ResultType>
+shared_ptr<const DiscreteBoundaryOperator<ResultType>>
+MassMatrixCache<BasisFunctionType, ResultType>::inverseMassMatrix(
+    const shared_ptr<const Context<BasisFunctionType, ResultType>> &context,
+    const shared_ptr<const Space<BasisFunctionType>> &domain,
+    const shared_ptr<const Space<BasisFunctionType>> &range,
+    const shared_ptr<const Space<BasisFunctionType>> &dualToRange) const {
+  {
+    tbb::mutex::scoped_lock lock(m_impl->mutex);
+    typename Impl::Entry &entry = m_impl->entry(domain, range, dualToRange);
+    if (entry.inverseMassMatrix)
+      return entry.inverseMassMatrix;
+  }
+
+  BoundaryOperator<BasisFunctionType, ResultType> id =
+      identityOperator(context, domain, range, dualToRange);
+  shared_ptr<const DiscreteBoundaryOperator<ResultType>> inverseMassMatrix =
+      pseudoinverse(id).weakForm();
+
+  tbb::mutex::scoped_lock lock(m_impl->mutex);
+  typename Impl::Entry &entry = m_impl->entry(domain, range, dualToRange);
+  if (!entry.inverseMassMatrix)
+    entry.inverseMassMatrix = inverseMassMatrix;
+  // The pseudoinverse shares the weak form of id, which has just been
+  // assembled
+  if (!entry.massMatrix)
+    entry.massMatrix = id.weakForm();
+  return entry.inverseMassMatrix;
+}
+
+FIBER_INSTANTIATE_CLASS_TEMPLATED_ON_BASIS_AND_RESULT(MassMatrixCache);
+
+} // namespace Bempp
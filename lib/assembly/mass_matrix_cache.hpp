@@ -0,0 +1,90 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef bempp_mass_matrix_cache_hpp
+#define bempp_mass_matrix_cache_hpp
+
+#include "../common/common.hpp"
+
+#include "../common/shared_ptr.hpp"
+
+#include <boost/scoped_ptr.hpp>
+
+namespace Bempp {
+
+/** \cond FORWARD_DECL */
+template <typename ValueType> class DiscreteBoundaryOperator;
+template <typename BasisFunctionType> class Space;
+template <typename BasisFunctionType, typename ResultType> class Context;
+/** \endcond */
+
+/** \ingroup weak_form_assembly
+ *  \brief Cache of mass matrices and their pseudoinverses.
+ *
+ *  GridFunction uses this cache to convert between coefficient and
+ *  projection vectors and to evaluate norms. The cache is owned by a Context
+ *  and shared by all its copies, so that e.g. the mass matrix of a space is
+ *  assembled and factorized once for all grid functions expanded in it.
+ *
+ *  Entries are identified by the domain, range and dual-to-range spaces of
+ *  the identity operator. The cache stores only weak pointers to these
+ *  spaces; an entry is evicted as soon as any of them is destroyed.
+ *
+ *  This class is thread-safe. */
+template <typename BasisFunctionType, typename ResultType>
+class MassMatrixCache {
+public:
+  /** \brief Constructor. */
+  MassMatrixCache();
+
+  /** \brief Destructor. */
+  ~MassMatrixCache();
+
+  /** \brief Return the weak form of the identity operator from \p domain
+   *  to \p range, tested with the functions from \p dualToRange. */
+  shared_ptr<const DiscreteBoundaryOperator<ResultType>> massMatrix(
+      const shared_ptr<const Context<BasisFunctionType, ResultType>> &context,
+      const shared_ptr<const Space<BasisFunctionType>> &domain,
+      const shared_ptr<const Space<BasisFunctionType>> &range,
+      const shared_ptr<const Space<BasisFunctionType>> &dualToRange) const;
+
+  /** \brief Return the weak form of the pseudoinverse of the identity
+   *  operator from \p domain to \p range, tested with the functions from
+   *  \p dualToRange.
+   *
+   *  The mass matrix is factorized on the first call only. If several
+   *  threads make the first call simultaneously, each of them may factorize
+   *  it, but all of them return the same result. */
+  shared_ptr<const DiscreteBoundaryOperator<ResultType>> inverseMassMatrix(
+      const shared_ptr<const Context<BasisFunctionType, ResultType>> &context,
+      const shared_ptr<const Space<BasisFunctionType>> &domain,
+      const shared_ptr<const Space<BasisFunctionType>> &range,
+      const shared_ptr<const Space<BasisFunctionType>> &dualToRange) const;
+
+private:
+  /** \cond PRIVATE */
+  struct Impl;
+  boost::scoped_ptr<Impl> m_impl;
+  /** \endcond */
+};
+
+} // namespace Bempp
+
+#endif
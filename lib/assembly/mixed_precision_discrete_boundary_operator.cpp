@@ -0,0 +1,174 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "mixed_precision_discrete_boundary_operator.hpp"
+#include "discrete_dense_boundary_operator.hpp"
+
+#include "../fiber/explicit_instantiation.hpp"
+
+#ifdef WITH_TRILINOS
+#include <Thyra_DefaultSpmdVectorSpace_decl.hpp>
+#endif
+
+#include <algorithm>
+
+namespace Bempp {
+
+template <typename ValueType>
+MixedPrecisionDiscreteBoundaryOperator<ValueType>::
+    MixedPrecisionDiscreteBoundaryOperator(
+        const shared_ptr<const DiscreteBoundaryOperator<SingleValueType>> &op)
+    : m_operator(op), m_denseOperator(0)
+#ifdef WITH_TRILINOS
+      ,
+      m_domainSpace(
+          Thyra::defaultSpmdVectorSpace<ValueType>(op->columnCount())),
+      m_rangeSpace(Thyra::defaultSpmdVectorSpace<ValueType>(op->rowCount()))
+#endif
+{
+  if (!m_operator.get())
+    throw std::invalid_argument("MixedPrecisionDiscreteBoundaryOperator::"
+                                "MixedPrecisionDiscreteBoundaryOperator(): "
+                                "the wrapped operator must not be NULL");
+  m_denseOperator =
+      dynamic_cast<const DiscreteDenseBoundaryOperator<SingleValueType> *>(
+          m_operator.get());
+}
+
+template <typename ValueType>
+arma::Mat<ValueType>
+MixedPrecisionDiscreteBoundaryOperator<ValueType>::asMatrix() const {
+  return arma::conv_to<arma::Mat<ValueType>>::from(m_operator->asMatrix());
+}
+
+template <typename ValueType>
+unsigned int
+MixedPrecisionDiscreteBoundaryOperator<ValueType>::rowCount() const {
+  return m_operator->rowCount();
+}
+
+template <typename ValueType>
+unsigned int
+MixedPrecisionDiscreteBoundaryOperator<ValueType>::columnCount() const {
+  return m_operator->columnCount();
+}
+
+template <typename ValueType>
+void MixedPrecisionDiscreteBoundaryOperator<ValueType>::addBlock(
+    const std::vector<int> &rows, const std::vector<int> &cols,
+    const ValueType alpha, arma::Mat<ValueType> &block) const {
+  arma::Mat<SingleValueType> singleBlock(block.n_rows, block.n_cols);
+  singleBlock.fill(static_cast<SingleValueType>(0.));
+  m_operator->addBlock(rows, cols, static_cast<SingleValueType>(1.),
+                       singleBlock);
+  block += alpha * arma::conv_to<arma::Mat<ValueType>>::from(singleBlock);
+}
+
+template <typename ValueType>
+shared_ptr<const DiscreteBoundaryOperator<
+    typename MixedPrecisionDiscreteBoundaryOperator<ValueType>::
+        SingleValueType>>
+MixedPrecisionDiscreteBoundaryOperator<ValueType>::singlePrecisionOperator()
+    const {
+  return m_operator;
+}
+
+#ifdef WITH_TRILINOS
+template <typename ValueType>
+Teuchos::RCP<const Thyra::VectorSpaceBase<ValueType>>
+MixedPrecisionDiscreteBoundaryOperator<ValueType>::domain() const {
+  return m_domainSpace;
+}
+
+template <typename ValueType>
+Teuchos::RCP<const Thyra::VectorSpaceBase<ValueType>>
+MixedPrecisionDiscreteBoundaryOperator<ValueType>::range() const {
+  return m_rangeSpace;
+}
+
+template <typename ValueType>
+bool MixedPrecisionDiscreteBoundaryOperator<ValueType>::opSupportedImpl(
+    Thyra::EOpTransp M_trans) const {
+  return m_operator->opSupported(M_trans);
+}
+#endif
+
+template <typename ValueType>
+void MixedPrecisionDiscreteBoundaryOperator<ValueType>::applyBuiltInImpl(
+    const TranspositionMode trans, const arma::Col<ValueType> &x_in,
+    arma::Col<ValueType> &y_inout, const ValueType alpha,
+    const ValueType beta) const {
+  if (beta == static_cast<ValueType>(0.))
+    y_inout.fill(static_cast<ValueType>(0.));
+  else
+    y_inout *= beta;
+
+  if (m_denseOperator) {
+    applyDenseImpl(trans, x_in, y_inout, alpha);
+    return;
+  }
+
+  arma::Col<SingleValueType> x =
+      arma::conv_to<arma::Col<SingleValueType>>::from(x_in);
+  arma::Col<SingleValueType> y(y_inout.n_rows);
+  m_operator->apply(trans, x, y, static_cast<SingleValueType>(1.),
+                    static_cast<SingleValueType>(0.));
+  y_inout += alpha * arma::conv_to<arma::Col<ValueType>>::from(y);
+}
+
+template <typename ValueType>
+void MixedPrecisionDiscreteBoundaryOperator<ValueType>::applyDenseImpl(
+    const TranspositionMode trans, const arma::Col<ValueType> &x_in,
+    arma::Col<ValueType> &y_inout, const ValueType alpha) const {
+  const arma::Mat<SingleValueType> &mat = m_denseOperator->matrix();
+  const size_t columnCount = mat.n_cols;
+  for (size_t first = 0; first < columnCount; first += panelWidth) {
+    const size_t last = std::min<size_t>(first + panelWidth, columnCount) - 1;
+    const arma::Mat<ValueType> panel =
+        arma::conv_to<arma::Mat<ValueType>>::from(mat.cols(first, last));
+    switch (trans) {
+    case NO_TRANSPOSE:
+      y_inout += alpha * (panel * x_in.rows(first, last));
+      break;
+    case CONJUGATE:
+      y_inout += alpha * (arma::conj(panel) * x_in.rows(first, last));
+      break;
+    case TRANSPOSE:
+      y_inout.rows(first, last) += alpha * (panel.st() * x_in);
+      break;
+    case CONJUGATE_TRANSPOSE:
+      y_inout.rows(first, last) += alpha * (panel.t() * x_in);
+      break;
+    default:
+      throw std::invalid_argument(
+          "MixedPrecisionDiscreteBoundaryOperator::applyDenseImpl(): "
+          "invalid transposition mode");
+    }
+  }
+}
+
+#if defined(ENABLE_SINGLE_PRECISION)
+FIBER_INSTANTIATE_CLASS_TEMPLATED_ON_RESULT_DP_REAL(
+    MixedPrecisionDiscreteBoundaryOperator);
+FIBER_INSTANTIATE_CLASS_TEMPLATED_ON_RESULT_DP_COMPLEX(
+    MixedPrecisionDiscreteBoundaryOperator);
+#endif
+
+} // namespace Bempp
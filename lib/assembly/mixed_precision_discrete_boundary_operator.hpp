@@ -0,0 +1,130 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "bempp/common/config_trilinos.hpp"
+
+#ifndef bempp_mixed_precision_discrete_boundary_operator_hpp
+#define bempp_mixed_precision_discrete_boundary_operator_hpp
+
+#include "../common/common.hpp"
+
+#include "discrete_boundary_operator.hpp"
+
+#include "../common/scalar_traits.hpp"
+#include "../common/shared_ptr.hpp"
+
+#ifdef WITH_TRILINOS
+#include <Teuchos_RCP.hpp>
+#include <Thyra_SpmdVectorSpaceBase_decl.hpp>
+#endif
+
+namespace Bempp {
+
+/** \cond FORWARD_DECL */
+template <typename ValueType> class DiscreteDenseBoundaryOperator;
+/** \endcond */
+
+/** \ingroup composite_discrete_boundary_operators
+ *  \brief Double-precision view of a single-precision discrete boundary
+ *  operator.
+ *
+ *  This class wraps a discrete boundary operator stored in single precision
+ *  (\c float or <tt>std::complex<float></tt>) so that it can act on
+ *  double-precision vectors. It makes it possible to keep the operator in
+ *  half the memory while the vectors of an iterative solver (see
+ *  MixedPrecisionIterativeSolver) are kept in double precision.
+ *
+ *  If the wrapped operator is a DiscreteDenseBoundaryOperator, its matrix is
+ *  converted to double precision panel by panel during each application and
+ *  the products are accumulated in double precision, so that the result is
+ *  accurate to double precision with respect to the stored (rounded)
+ *  matrix. Other operators (e.g. H-matrices) are applied in single precision
+ *  to the input vector rounded to single precision and the result is
+ *  accumulated into the output vector in double precision. */
+template <typename ValueType>
+class MixedPrecisionDiscreteBoundaryOperator
+    : public DiscreteBoundaryOperator<ValueType> {
+public:
+  typedef DiscreteBoundaryOperator<ValueType> Base;
+  typedef typename ScalarTraits<ValueType>::SinglePrecisionType
+  SingleValueType;
+
+  /** \brief Constructor.
+   *
+   *  \param[in] op
+   *    The single-precision operator to wrap. */
+  explicit MixedPrecisionDiscreteBoundaryOperator(
+      const shared_ptr<const DiscreteBoundaryOperator<SingleValueType>> &op);
+
+  virtual arma::Mat<ValueType> asMatrix() const;
+
+  virtual unsigned int rowCount() const;
+  virtual unsigned int columnCount() const;
+
+  virtual void addBlock(const std::vector<int> &rows,
+                        const std::vector<int> &cols, const ValueType alpha,
+                        arma::Mat<ValueType> &block) const;
+
+  /** \brief Return the wrapped single-precision operator. */
+  shared_ptr<const DiscreteBoundaryOperator<SingleValueType>>
+  singlePrecisionOperator() const;
+
+#ifdef WITH_TRILINOS
+public:
+  virtual Teuchos::RCP<const Thyra::VectorSpaceBase<ValueType>> domain() const;
+  virtual Teuchos::RCP<const Thyra::VectorSpaceBase<ValueType>> range() const;
+
+protected:
+  virtual bool opSupportedImpl(Thyra::EOpTransp M_trans) const;
+#endif
+
+private:
+  virtual void applyBuiltInImpl(const TranspositionMode trans,
+                                const arma::Col<ValueType> &x_in,
+                                arma::Col<ValueType> &y_inout,
+                                const ValueType alpha,
+                                const ValueType beta) const;
+
+  void applyDenseImpl(const TranspositionMode trans,
+                      const arma::Col<ValueType> &x_in,
+                      arma::Col<ValueType> &y_inout,
+                      const ValueType alpha) const;
+
+private:
+  /** \cond PRIVATE */
+  enum {
+    // Number of columns of the dense matrix converted to double precision
+    // at a time
+    panelWidth = 64
+  };
+
+  shared_ptr<const DiscreteBoundaryOperator<SingleValueType>> m_operator;
+  // Non-null if m_operator is dense
+  const DiscreteDenseBoundaryOperator<SingleValueType> *m_denseOperator;
+#ifdef WITH_TRILINOS
+  Teuchos::RCP<const Thyra::VectorSpaceBase<ValueType>> m_domainSpace;
+  Teuchos::RCP<const Thyra::VectorSpaceBase<ValueType>> m_rangeSpace;
+#endif
+  /** \endcond */
+};
+
+} // namespace Bempp
+
+#endif
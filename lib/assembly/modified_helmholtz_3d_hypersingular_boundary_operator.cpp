@@ -235,14 +235,14 @@ modifiedHelmholtz3dHypersingularBoundaryOperator(
       offDiagonalIntegral;
   if (shouldUseBlasInQuadrature(assemblyOptions, *domain, *dualToRange)) {
     integral.reset(new Fiber::TypicalTestScalarKernelTrialIntegral<
-        BasisFunctionType, KernelType, ResultType>());
+        BasisFunctionType, KernelType, ResultType>(true));
     offDiagonalIntegral = integral;
   } else {
     integral.reset(new Fiber::DefaultTestKernelTrialIntegral<IntegrandFunctor>(
         IntegrandFunctor()));
     offDiagonalIntegral.reset(
         new Fiber::DefaultTestKernelTrialIntegral<OffDiagonalIntegrandFunctor>(
-            OffDiagonalIntegrandFunctor()));
+            OffDiagonalIntegrandFunctor(true)));
   }
 
   typedef GeneralHypersingularIntegralOperator<BasisFunctionType, KernelType,
@@ -253,7 +253,7 @@ modifiedHelmholtz3dHypersingularBoundaryOperator(
                                               ResultType>> integral,
         offDiagonalIntegral;
     integral.reset(new Fiber::TypicalTestScalarKernelTrialIntegral<
-        BasisFunctionType, KernelType, ResultType>());
+        BasisFunctionType, KernelType, ResultType>(true));
     offDiagonalIntegral = integral;
     if (useInterpolation)
       newOp.reset(new Op(
@@ -283,7 +283,8 @@ modifiedHelmholtz3dHypersingularBoundaryOperator(
           OffDiagonalInterpolatedKernelFunctor(waveNumber, maxDistance_,
                                                interpPtsPerWavelength),
           OffDiagonalTransformationFunctor(),
-          OffDiagonalTransformationFunctor(), OffDiagonalIntegrandFunctor()));
+          OffDiagonalTransformationFunctor(),
+          OffDiagonalIntegrandFunctor(true)));
     else
       newOp.reset(new Op(
           domain, range, dualToRange, label, symmetry,
@@ -291,7 +292,8 @@ modifiedHelmholtz3dHypersingularBoundaryOperator(
           TransformationFunctor(), IntegrandFunctor(),
           OffDiagonalNoninterpolatedKernelFunctor(waveNumber),
           OffDiagonalTransformationFunctor(),
-          OffDiagonalTransformationFunctor(), OffDiagonalIntegrandFunctor()));
+          OffDiagonalTransformationFunctor(),
+          OffDiagonalIntegrandFunctor(true)));
   }
   return BoundaryOperator<BasisFunctionType, ResultType>(context, newOp);
 }
@@ -180,7 +180,9 @@ public:
    *  evaluationPoints by the charge distributions equal to the individual
    *  basis functions of the space \p space. The object can afterwards be used
    *  to evaluate efficiently the potentials generated by multiple
-   *  GridFunctions expanded in the space \p space.
+   *  GridFunctions expanded in the space \p space. The coefficients of many
+   *  such functions can be processed in a single call to
+   *  AssembledPotentialOperator::apply(const arma::Mat<ResultType>&).
    *
    * \param[in] space
    *   The space whose basis functions will be taken as the charge distributions
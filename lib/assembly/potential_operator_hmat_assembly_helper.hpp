@@ -0,0 +1,101 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef bempp_potential_operator_hmat_assembly_helper_hpp
+#define bempp_potential_operator_hmat_assembly_helper_hpp
+
+#include "../common/common.hpp"
+
+#include "../common/armadillo_fwd.hpp"
+#include "../common/shared_ptr.hpp"
+#include "../common/types.hpp"
+#include "../fiber/scalar_traits.hpp"
+#include "../hmat/common.hpp"
+#include "../hmat/block_cluster_tree.hpp"
+#include "../hmat/data_accessor.hpp"
+
+#include <vector>
+
+namespace Fiber {
+
+/** \cond FORWARD_DECL */
+template <typename ResultType> class LocalAssemblerForPotentialOperators;
+/** \endcond */
+
+} // namespace Fiber
+
+namespace Bempp {
+
+/** \cond FORWARD_DECL */
+class ComponentListsCache;
+template <typename BasisFunctionType> class LocalDofListsCache;
+template <typename BasisFunctionType> class Space;
+/** \endcond */
+
+/** \ingroup potential_assembly_internal
+ *  \brief Class whose methods are called by the HMat compressors during
+ *  assembly of potential operators in the HMAT mode.
+ *
+ *  The rows of the matrix correspond to the components of the potential at
+ *  the evaluation points (row <tt>componentCount * point + component</tt>)
+ *  and its columns to the global DOFs of the trial space.
+ */
+template <typename BasisFunctionType, typename ResultType>
+class PotentialOperatorHMatAssemblyHelper
+    : public hmat::DataAccessor<ResultType, 2> {
+public:
+  typedef Fiber::LocalAssemblerForPotentialOperators<ResultType> LocalAssembler;
+  typedef typename Fiber::ScalarTraits<ResultType>::RealType CoordinateType;
+  typedef typename Fiber::ScalarTraits<ResultType>::RealType MagnitudeType;
+
+  PotentialOperatorHMatAssemblyHelper(
+      const Space<BasisFunctionType> &trialSpace,
+      const shared_ptr<hmat::DefaultBlockClusterTreeType> blockClusterTree,
+      const std::vector<LocalAssembler *> &assemblers,
+      const std::vector<ResultType> &termMultipliers);
+
+  /** \brief Evaluate entries of a general block. */
+  void computeMatrixBlock(
+      const hmat::IndexRangeType &pointIndexRange,
+      const hmat::IndexRangeType &trialIndexRange,
+      const hmat::DefaultBlockClusterTreeNodeType &blockClusterTreeNode,
+      arma::Mat<ResultType> &data) const override;
+
+private:
+  MagnitudeType estimateMinimumDistance(
+      const hmat::DefaultBlockClusterTreeNodeType &blockClusterTreeNode) const;
+
+private:
+  /** \cond PRIVATE */
+  const Space<BasisFunctionType> &m_trialSpace;
+  const shared_ptr<const hmat::DefaultBlockClusterTreeType> m_blockClusterTree;
+  const std::vector<LocalAssembler *> &m_assemblers;
+  const std::vector<ResultType> &m_termMultipliers;
+
+  // ComponentListsCache indexes the rows with unsigned ints
+  std::vector<unsigned int> m_p2oPoints;
+  shared_ptr<ComponentListsCache> m_componentListsCache;
+  shared_ptr<LocalDofListsCache<BasisFunctionType>> m_trialDofListsCache;
+  /** \endcond */
+};
+
+} // namespace Bempp
+
+#endif
@@ -77,7 +77,7 @@ template <typename ValueType> inline ValueType expm(const ValueType &x) {
 template <typename ValueType>
 inline std::complex<ValueType> expm(const std::complex<ValueType> &x) {
   ValueType emx = std::exp(-x.real());
-  return std::complex<ValueType>(cos(x.imag()) * emx, -sin(x.imag() * emx));
+  return std::complex<ValueType>(cos(x.imag()) * emx, -sin(x.imag()) * emx);
 }
 
 } // namespace Fiber
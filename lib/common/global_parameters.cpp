@@ -69,6 +69,12 @@ ParameterList GlobalParameters::parameterList() {
   quadratureOrders.set("doubleSingular",static_cast<int>(0),
           "(int) Order for singular double integrals.");
 
+  quadratureOrders.set("doubleRegularTolerance",static_cast<double>(0),
+          "(double) If positive, the orders of regular double integrals are "
+          "the lowest ones whose estimated relative quadrature error does not "
+          "exceed this value. The doubleOrder entries are then only used "
+          "for element pairs too close for the error estimate to apply.");
+
   auto createQuadratureOptions = [&quadratureOrders](const std::string name,
           double relDist, int singleOrder, int doubleOrder) {
 
@@ -95,7 +101,7 @@ ParameterList GlobalParameters::parameterList() {
 
   quadratureOrders.sublist("far").remove("maxRelDist");
 
-  ParameterList& hmatParameters = parameters.sublist("HMat");
+  ParameterList& hmatParameters = parameters.sublist("HMatParameters");
 
   hmatParameters.set("HMatAssemblyMode", std::string("GlobalAssembly"),
                      "(string) Specifies assembly mode. Allowed values are "
@@ -113,6 +119,69 @@ ParameterList GlobalParameters::parameterList() {
   hmatParameters.set("eta", static_cast<double>(1.2),
                      "(double) Specifies the block separation parameter eta");
 
+  hmatParameters.set(
+      "clusterSplitting", std::string("boundingBox"),
+      "(string) Specifies how clusters are split. Allowed values are "
+      "boundingBox (halve the bounding box along its longest side) and pca "
+      "(split orthogonally to the principal axis of the DOF positions, "
+      "better suited to thin or curved surfaces).");
+
+  hmatParameters.set("eps", static_cast<double>(1E-3),
+                     "(double) Relative tolerance of the ACA compression of "
+                     "admissible blocks");
+
+  hmatParameters.set(
+      "maxRank", static_cast<int>(30),
+      "(int) Specifies the maximum rank of an admissible block.");
+
+  hmatParameters.set(
+      "compressionAlgorithm", std::string("acaPlus"),
+      "(string) Specifies the low-rank compression of admissible blocks. "
+      "Allowed values are acaPlus (partially pivoted ACA+ with deterministic "
+      "pivots) and aca (ACA with randomly chosen rows).");
+
+  hmatParameters.set(
+      "recompress", false,
+      "(bool) If true the low-rank blocks are recompressed to the tolerance "
+      "eps by a truncated SVD after the assembly.");
+
+  hmatParameters.set(
+      "coarsen", false,
+      "(bool) If true sibling low-rank blocks are merged into a single "
+      "low-rank block after the assembly whenever this saves memory.");
+
+  hmatParameters.set(
+      "resizeThreshold", static_cast<int>(10),
+      "(int) Number of columns by which the low-rank factors are enlarged "
+      "whenever the ACA runs out of space. Only used by the aca "
+      "compression algorithm.");
+
+  hmatParameters.set(
+      "rankMode", std::string("adaptive"),
+      "(string) Specifies how the rank of admissible blocks is chosen. "
+      "Allowed values are adaptive and fixed. adaptive uses the usual ACA "
+      "stopping rule (stop once the norm of the latest rank-one update is "
+      "below eps times the estimated block norm, or at maxRank) and in "
+      "addition stores a block dense as soon as the low-rank factors would "
+      "need more memory than the dense block. fixed always computes maxRank "
+      "terms.");
+
+  hmatParameters.set(
+      "cacheDirectory", std::string(""),
+      "(string) Directory in which assembled H-matrices of weak forms and "
+      "potential operators are cached. The key of a cached H-matrix is a "
+      "hash of the spaces or evaluation points, the type and parameters of "
+      "the kernels, the term multipliers, the H-matrix parameters (including "
+      "cacheKey), the quadrature orders and a sample of the matrix entries. "
+      "An empty string disables the cache.");
+
+  hmatParameters.set(
+      "cacheKey", std::string(""),
+      "(string) Optional identifier added to the key of cached H-matrices. "
+      "Set it to distinguish operators that differ only in ways not visible "
+      "to the cache, e.g. in a custom quadrature strategy or in parameters "
+      "of the integrand.");
+
   return parameters;
 }
 }
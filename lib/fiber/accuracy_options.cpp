@@ -44,14 +44,15 @@ struct Equal {
 
 } // namespace
 
-AccuracyOptionsEx::AccuracyOptionsEx() {
+AccuracyOptionsEx::AccuracyOptionsEx() : m_doubleRegularTolerance(0.) {
   m_singleRegular.push_back(std::make_pair(
       std::numeric_limits<double>::infinity(), QuadratureOptions()));
   m_doubleRegular.push_back(std::make_pair(
       std::numeric_limits<double>::infinity(), QuadratureOptions()));
 }
 
-AccuracyOptionsEx::AccuracyOptionsEx(const AccuracyOptions &oldStyleOpts) {
+AccuracyOptionsEx::AccuracyOptionsEx(const AccuracyOptions &oldStyleOpts)
+    : m_doubleRegularTolerance(0.) {
   m_singleRegular.push_back(std::make_pair(
       std::numeric_limits<double>::infinity(), oldStyleOpts.singleRegular));
   m_doubleRegular.push_back(std::make_pair(
@@ -321,6 +322,14 @@ void AccuracyOptionsEx::setDoubleRegular(const t_range& input)
 void AccuracyOptionsEx::setSingleRegular(const t_range& input)
     { implementation::setRegular(m_singleRegular, input); }
 
+double AccuracyOptionsEx::doubleRegularTolerance() const {
+  return m_doubleRegularTolerance;
+}
+
+void AccuracyOptionsEx::setDoubleRegularTolerance(double relativeTolerance) {
+  m_doubleRegularTolerance = relativeTolerance;
+}
+
 const QuadratureOptions& AccuracyOptionsEx::doubleSingular() const
 {
     return m_doubleSingular;
@@ -333,6 +333,27 @@ public:
                           bool relativeToDefault = true);
     void setDoubleRegular(const t_range& options);
 
+  /** \brief Return the relative tolerance used to select the orders of
+   *  quadrature rules for regular integrals on pairs of elements.
+   *
+   *  A non-positive value (the default) means that the orders are taken from
+   *  the table set with setDoubleRegular(). */
+  double doubleRegularTolerance() const;
+
+  /** \brief Select the orders of regular quadrature rules on pairs of
+   *  elements from an error estimate instead of a distance table.
+   *
+   *  If \p relativeTolerance is positive, the order of accuracy of the
+   *  quadrature rule used on each of the two elements of a pair is set to
+   *  the lowest order for which the estimated relative quadrature error,
+   *  which depends on the size of the element, its distance from the other
+   *  element and the decay of the kernel with distance, does not exceed
+   *  \p relativeTolerance. The options set with setDoubleRegular() are then
+   *  only used for pairs of elements too close to each other for the
+   *  estimate to apply. A non-positive \p relativeTolerance restores the
+   *  table-based selection. */
+  void setDoubleRegularTolerance(double relativeTolerance);
+
   /** \brief Return the options controlling integration of singular functions
    *  on pairs of elements. */
   const QuadratureOptions &doubleSingular() const;
@@ -352,6 +373,7 @@ private:
     t_range m_singleRegular;
     t_range m_doubleRegular;
     QuadratureOptions m_doubleSingular;
+    double m_doubleRegularTolerance;
     /** \endcond */
 };
 
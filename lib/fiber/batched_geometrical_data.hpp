@@ -0,0 +1,103 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef fiber_batched_geometrical_data_hpp
+#define fiber_batched_geometrical_data_hpp
+
+#include "../common/common.hpp"
+
+#include "geometrical_data.hpp"
+
+#include <cassert>
+#include <vector>
+
+#include <tbb/cache_aligned_allocator.h>
+
+namespace Fiber {
+
+/** \brief Global coordinates and normals of a set of points stored as a
+ *  structure of arrays.
+ *
+ *  Each component is stored in a separate contiguous, cache-line aligned
+ *  array, so that loops over the points of a batch can be vectorized. Used by
+ *  the batched evaluation of kernel functors (see DefaultCollectionOfKernels).
+ */
+template <typename CoordinateType> class BatchedGeometricalData {
+public:
+  BatchedGeometricalData()
+      : m_pointCount(0), m_stride(0), m_hasGlobals(false),
+        m_hasNormals(false) {}
+
+  explicit BatchedGeometricalData(
+      const GeometricalData<CoordinateType> &geomData) {
+    assign(geomData);
+  }
+
+  /** \brief Copy the global coordinates and normals of \p geomData.
+   *
+   *  Memory allocated by previous calls is reused. */
+  void assign(const GeometricalData<CoordinateType> &geomData) {
+    assert(geomData.dimWorld() == coordCount);
+    m_pointCount = geomData.pointCount();
+    m_hasGlobals = !geomData.globals.is_empty();
+    m_hasNormals = !geomData.normals.is_empty();
+    // Arrays are padded to a multiple of the cache line size
+    m_stride = (m_pointCount + paddingSize - 1) / paddingSize * paddingSize;
+    m_data.assign(2 * coordCount * m_stride, CoordinateType(0));
+    for (size_t point = 0; point < m_pointCount; ++point)
+      for (int coordIndex = 0; coordIndex < coordCount; ++coordIndex) {
+        if (m_hasGlobals)
+          m_data[coordIndex * m_stride + point] =
+              geomData.globals(coordIndex, point);
+        if (m_hasNormals)
+          m_data[(coordCount + coordIndex) * m_stride + point] =
+              geomData.normals(coordIndex, point);
+      }
+  }
+
+  size_t pointCount() const { return m_pointCount; }
+
+  const CoordinateType *global(int dim) const {
+    assert(m_hasGlobals);
+    return &m_data[dim * m_stride];
+  }
+
+  const CoordinateType *normal(int dim) const {
+    assert(m_hasNormals);
+    return &m_data[(coordCount + dim) * m_stride];
+  }
+
+private:
+  enum {
+    coordCount = 3,
+    paddingSize = 64 / sizeof(CoordinateType)
+  };
+
+  size_t m_pointCount;
+  size_t m_stride;
+  bool m_hasGlobals;
+  bool m_hasNormals;
+  std::vector<CoordinateType, tbb::cache_aligned_allocator<CoordinateType>>
+      m_data;
+};
+
+} // namespace Fiber
+
+#endif
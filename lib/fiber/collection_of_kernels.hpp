@@ -25,6 +25,9 @@
 
 #include "scalar_traits.hpp"
 
+#include <boost/functional/hash.hpp>
+#include <string>
+#include <typeinfo>
 #include <utility>
 
 namespace Fiber {
@@ -147,6 +150,26 @@ public:
 
   virtual CoordinateType
   estimateRelativeScale(CoordinateType distance) const = 0;
+
+  /** \brief Return true if the kernels are invariant under rigid motions.
+   *
+   *  The kernels are invariant under rigid motions (translations and proper
+   *  rotations) if moving the test and trial points together with their
+   *  elements leaves the values of the scalar kernels unchanged and rotates
+   *  vector-valued kernels together with the points. Singular integrals over
+   *  congruent element pairs are then evaluated only once. The default
+   *  implementation returns false. */
+  virtual bool isInvariantUnderRigidMotions() const { return false; }
+
+  /** \brief Combine the type and the parameters of the kernels into \p seed.
+   *
+   *  Collections of kernels that differ in their parameters (e.g. the wave
+   *  number) should give different hashes; the hash is used to identify
+   *  cached operator matrices on disk. The default implementation hashes
+   *  only the dynamic type of the collection. */
+  virtual void hashParameters(std::size_t &seed) const {
+    boost::hash_combine(seed, std::string(typeid(*this).name()));
+  }
 };
 
 } // namespace Fiber
@@ -23,6 +23,10 @@
 
 #include "collection_of_kernels.hpp"
 
+#include "batched_geometrical_data.hpp"
+
+#include <tbb/enumerable_thread_specific.h>
+
 namespace Fiber {
 
 /** \ingroup weak_form_elements
@@ -78,6 +82,22 @@ namespace Fiber {
         // defined, the kernel behaves as if its estimated magnitude was 1
         // everywhere.
         CoordinateType estimateRelativeScale(CoordinateType distance) const;
+
+        // (Optional)
+        // Return true if the kernels depend only on the relative position of
+        // the test and trial points and on vectors attached to the elements
+        // (such as normals) in a way that commutes with rigid motions (see
+        // CollectionOfKernels::isInvariantUnderRigidMotions()). If this
+        // function is not defined, the kernels are treated as not invariant.
+        bool isInvariantUnderRigidMotions() const;
+
+        // (Optional, only for functors with a single scalar kernel)
+        // Batched variant of evaluate() used by evaluateOnGrid(); see
+        // FunctorHasEvaluateBatch for its contract.
+        void evaluateBatch(
+                const BatchedGeometricalData<CoordinateType>& testGeomData,
+                const ConstGeometricalDataSlice<CoordinateType>& trialGeomData,
+                ValueType* result) const;
     };
     \endcode
 
@@ -117,8 +137,15 @@ public:
 
   virtual CoordinateType estimateRelativeScale(CoordinateType distance) const;
 
+  virtual bool isInvariantUnderRigidMotions() const;
+
+  virtual void hashParameters(std::size_t &seed) const;
+
 private:
   Functor m_functor;
+  // Test point data of evaluateOnGrid() for functors with evaluateBatch()
+  mutable tbb::enumerable_thread_specific<
+      BatchedGeometricalData<CoordinateType>> m_batchedTestGeomData;
 };
 
 } // namespace Fiber
@@ -23,26 +23,44 @@
 
 #include "default_collection_of_kernels.hpp"
 
+#include "batched_geometrical_data.hpp"
 #include "collection_of_3d_arrays.hpp"
 #include "collection_of_4d_arrays.hpp"
 #include "geometrical_data.hpp"
+#include "has_mem_func.hpp"
 
+#include <boost/functional/hash.hpp>
 #include <boost/utility/enable_if.hpp>
 #include <stdexcept>
-
-#define FIBER_HAS_MEM_FUNC(func, name)                                         \
-  template <typename T, typename Sign> struct name {                           \
-    typedef char yes[1];                                                       \
-    typedef char no[2];                                                        \
-    template <typename U, U> struct type_check;                                \
-    template <typename _1> static yes &chk(type_check<Sign, &_1::func> *);     \
-    template <typename> static no &chk(...);                                   \
-    static bool const value = sizeof(chk<T>(0)) == sizeof(yes);                \
-  }
+#include <string>
+#include <typeinfo>
 
 namespace Fiber {
 
 FIBER_HAS_MEM_FUNC(estimateRelativeScale, hasEstimateRelativeScale);
+FIBER_HAS_MEM_FUNC(evaluateBatch, hasEvaluateBatch);
+FIBER_HAS_MEM_FUNC(isInvariantUnderRigidMotions,
+                   hasIsInvariantUnderRigidMotions);
+
+// A functor with a single scalar kernel may provide
+//
+//   void evaluateBatch(
+//       const BatchedGeometricalData<CoordinateType> &testGeomData,
+//       const ConstGeometricalDataSlice<CoordinateType> &trialGeomData,
+//       ValueType *result) const;
+//
+// evaluating the kernel at the pairs made of each point of testGeomData and
+// the single point of trialGeomData and writing the value for the i'th test
+// point to result[i]. The values must agree with evaluate() up to rounding.
+// evaluateOnGrid() then uses it instead of evaluate().
+template <typename Functor> struct FunctorHasEvaluateBatch {
+  typedef typename Functor::CoordinateType CoordinateType;
+  static bool const value = hasEvaluateBatch<
+      Functor,
+      void (Functor::*)(const BatchedGeometricalData<CoordinateType> &,
+                        const ConstGeometricalDataSlice<CoordinateType> &,
+                        typename Functor::ValueType *) const>::value;
+};
 
 // template <class Type>
 // class TypeHasEstimateRelativeScale
@@ -97,6 +115,22 @@ estimateRelativeScaleInternal(const Functor &functor,
   return 1.;
 }
 
+template <typename Functor>
+typename boost::enable_if<
+    hasIsInvariantUnderRigidMotions<Functor, bool (Functor::*)() const>,
+    bool>::type
+isInvariantUnderRigidMotionsInternal(const Functor &functor) {
+  return functor.isInvariantUnderRigidMotions();
+}
+
+template <typename Functor>
+typename boost::disable_if<
+    hasIsInvariantUnderRigidMotions<Functor, bool (Functor::*)() const>,
+    bool>::type
+isInvariantUnderRigidMotionsInternal(const Functor &functor) {
+  return false;
+}
+
 // template<typename Functor>
 // typename boost::enable_if<TypeHasEstimateRelativeScale<Functor>,
 //                          typename Functor::CoordinateType>::type
@@ -116,6 +150,43 @@ estimateRelativeScaleInternal(const Functor &functor,
 //   return 1.;
 //}
 
+// Evaluate a scalar kernel on a grid with the batched entry point of its
+// functor. The values for all test points and a fixed trial point are
+// contiguous in the result. batchedTestGeomData is overwritten with the test
+// point data. Returns false if the functor has no batched entry point.
+template <typename Functor>
+typename boost::enable_if<FunctorHasEvaluateBatch<Functor>, bool>::type
+evaluateOnGridInBatches(
+    const Functor &functor,
+    const GeometricalData<typename Functor::CoordinateType> &testGeomData,
+    const GeometricalData<typename Functor::CoordinateType> &trialGeomData,
+    BatchedGeometricalData<typename Functor::CoordinateType> &
+        batchedTestGeomData,
+    CollectionOf4dArrays<typename Functor::ValueType> &result) {
+  assert(functor.kernelCount() == 1);
+  assert(functor.kernelRowCount(0) == 1 && functor.kernelColCount(0) == 1);
+
+  batchedTestGeomData.assign(testGeomData);
+  const size_t trialPointCount = trialGeomData.pointCount();
+  for (size_t trialIndex = 0; trialIndex < trialPointCount; ++trialIndex)
+    functor.evaluateBatch(batchedTestGeomData,
+                          trialGeomData.const_slice(trialIndex),
+                          &result[0](0, 0, 0, trialIndex));
+  return true;
+}
+
+template <typename Functor>
+typename boost::disable_if<FunctorHasEvaluateBatch<Functor>, bool>::type
+evaluateOnGridInBatches(
+    const Functor &functor,
+    const GeometricalData<typename Functor::CoordinateType> &testGeomData,
+    const GeometricalData<typename Functor::CoordinateType> &trialGeomData,
+    BatchedGeometricalData<typename Functor::CoordinateType> &
+        batchedTestGeomData,
+    CollectionOf4dArrays<typename Functor::ValueType> &result) {
+  return false;
+}
+
 template <typename Functor>
 void DefaultCollectionOfKernels<Functor>::addGeometricalDependencies(
     size_t &testGeomDeps, size_t &trialGeomDeps) const {
@@ -154,6 +225,10 @@ void DefaultCollectionOfKernels<Functor>::evaluateOnGrid(
     result[k].set_size(m_functor.kernelRowCount(k), m_functor.kernelColCount(k),
                        testPointCount, trialPointCount);
 
+  if (evaluateOnGridInBatches(m_functor, testGeomData, trialGeomData,
+                              m_batchedTestGeomData.local(), result))
+    return;
+
 #pragma ivdep
   for (size_t trialIndex = 0; trialIndex < trialPointCount; ++trialIndex)
     for (size_t testIndex = 0; testIndex < testPointCount; ++testIndex)
@@ -176,6 +251,54 @@ DefaultCollectionOfKernels<Functor>::estimateRelativeScale(
   return estimateRelativeScaleInternal(m_functor, distance);
 }
 
+template <typename Functor>
+bool DefaultCollectionOfKernels<Functor>::isInvariantUnderRigidMotions() const {
+  return isInvariantUnderRigidMotionsInternal(m_functor);
+}
+
+// Parameters of a functor, such as the wave number, are not accessible
+// through a common interface, so they are captured by the values of the
+// kernels at a few fixed pairs of points in 3D space
+template <typename Functor>
+void DefaultCollectionOfKernels<Functor>::hashParameters(
+    std::size_t &seed) const {
+  boost::hash_combine(seed, std::string(typeid(m_functor).name()));
+
+  size_t testGeomDeps = 0, trialGeomDeps = 0;
+  m_functor.addGeometricalDependencies(testGeomDeps, trialGeomDeps);
+  if ((testGeomDeps | trialGeomDeps) & ~size_t(GLOBALS | NORMALS))
+    return; // other data would have to be consistent with the points
+
+  const int dimWorld = 3;
+  const int pointCount = 4;
+  const CoordinateType testPoints[pointCount][dimWorld] = {
+      {0., 0., 0.}, {0.3, -0.2, 0.1}, {1., 0.5, -0.7}, {-2., 1.5, 0.25}};
+  const CoordinateType trialPoints[pointCount][dimWorld] = {
+      {0.7, 0.1, 0.2}, {-0.4, 0.9, 1.3}, {2.5, -1., 0.5}, {0.1, 0.2, 3.}};
+  const CoordinateType testNormals[pointCount][dimWorld] = {
+      {0., 0., 1.}, {0.6, 0.8, 0.}, {0., -0.6, 0.8}, {-0.8, 0., 0.6}};
+  const CoordinateType trialNormals[pointCount][dimWorld] = {
+      {1., 0., 0.}, {0., 0.8, -0.6}, {0.6, 0., 0.8}, {0., 1., 0.}};
+
+  GeometricalData<CoordinateType> testGeomData, trialGeomData;
+  testGeomData.globals.set_size(dimWorld, pointCount);
+  testGeomData.normals.set_size(dimWorld, pointCount);
+  trialGeomData.globals.set_size(dimWorld, pointCount);
+  trialGeomData.normals.set_size(dimWorld, pointCount);
+  for (int p = 0; p < pointCount; ++p)
+    for (int d = 0; d < dimWorld; ++d) {
+      testGeomData.globals(d, p) = testPoints[p][d];
+      testGeomData.normals(d, p) = testNormals[p][d];
+      trialGeomData.globals(d, p) = trialPoints[p][d];
+      trialGeomData.normals(d, p) = trialNormals[p][d];
+    }
+
+  CollectionOf3dArrays<ValueType> values;
+  evaluateAtPointPairs(testGeomData, trialGeomData, values);
+  for (size_t k = 0; k < values.size(); ++k)
+    boost::hash_range(seed, values[k].begin(), values[k].end());
+}
+
 } // namespace Fiber
 
 #endif
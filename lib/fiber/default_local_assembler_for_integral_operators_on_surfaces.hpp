@@ -38,6 +38,7 @@
 #include <boost/static_assert.hpp>
 #include <boost/tuple/tuple_comparison.hpp>
 #include <tbb/concurrent_unordered_map.h>
+#include <tbb/enumerable_thread_specific.h>
 #include <tbb/mutex.h>
 #include <cstring>
 #include <climits>
@@ -107,8 +108,18 @@ public:
                          Fiber::_2dArray<arma::Mat<ResultType>> &result,
                          CoordinateType nominalDistance = -1.);
 
+  virtual void
+  evaluateLocalWeakFormTile(const std::vector<int> &testElementIndices,
+                            const std::vector<int> &trialElementIndices,
+                            LocalWeakFormTile<ResultType> &tile,
+                            CoordinateType nominalDistance = -1.);
+
   virtual CoordinateType estimateRelativeScale(CoordinateType minDist) const;
 
+  virtual void hashParameters(std::size_t &seed) const;
+
+  virtual void printStatistics(std::ostream &out) const;
+
 private:
   /** \cond PRIVATE */
   typedef TestKernelTrialIntegrator<BasisFunctionType, KernelType, ResultType>
@@ -116,44 +127,26 @@ private:
   typedef typename Integrator::ElementIndexPair ElementIndexPair;
   typedef DefaultLocalAssemblerForOperatorsOnSurfacesUtilities<
       BasisFunctionType> Utilities;
-
-  /** \brief Alternative comparison functor for pairs.
-   *
-   *  This functor can be used to sort pairs according to the second member
-   *  and then, in case of equality, according to the first member. */
-  template <typename T1, typename T2> struct alternative_less {
-    bool operator()(const std::pair<T1, T2> &a,
-                    const std::pair<T1, T2> &b) const {
-      return a.second < b.second ||
-             (!(b.second < a.second) && a.first < b.first);
-    }
+  typedef std::pair<const Integrator *, const Shapeset<BasisFunctionType> *>
+  QuadVariant;
+
+  /** \brief Per-thread work arrays of evaluateLocalWeakFormTile(). */
+  struct TileScratch {
+    std::vector<QuadVariant> quadVariants;
+    std::vector<int> order;
+    std::vector<arma::Mat<ResultType> *> localResults;
+    std::vector<int> activeTestElementIndices;
+    std::vector<arma::Mat<ResultType> *> activeLocalResults;
   };
 
-  /** \brief Comparison functor for element-index pairs.
-   *
-   *  This functor sorts element index pairs first after the trial element
-   *  index (second member) and then, in case of equality, after the test
-   *  element index (first member) */
-  typedef alternative_less<typename ElementIndexPair::first_type,
-                           typename ElementIndexPair::second_type>
-  ElementIndexPairCompare;
-
-  /** \brief Set of element index pairs.
-   *
-   *  The alternative sorting (first after the trial element index) is used
-   *  because profiling has shown that evaluateLocalWeakForms is called more
-   *  often in the TEST_TRIAL mode (with a single trial element index) than
-   *  in the TRIAL_TEST mode. Therefore the singular integral cache is
-   *  indexed with trial element index, and this sorting mode makes it easier
-   *  to construct such cache. */
-  typedef std::set<ElementIndexPair, ElementIndexPairCompare>
-  ElementIndexPairSet;
-
   bool testAndTrialGridsAreIdentical() const;
 
   void cacheSingularLocalWeakForms();
-  void findPairsOfAdjacentElements(ElementIndexPairSet &pairs) const;
-  void cacheLocalWeakForms(const ElementIndexPairSet &elementIndexPairs);
+  void findPairsOfAdjacentElements(std::vector<size_t> &rowOffsets,
+                                   std::vector<int> &testElementIndices) const;
+  void cacheLocalWeakForms();
+  const ResultType *findCachedLocalWeakForm(int testElementIndex,
+                                            int trialElementIndex) const;
 
   const Integrator &selectIntegrator(int testElementIndex,
                                      int trialElementIndex,
@@ -189,21 +182,28 @@ private:
   IntegratorMap m_testKernelTrialIntegrators;
   mutable tbb::mutex m_integratorCreationMutex;
 
-  enum {
-    INVALID_INDEX = INT_MAX
-  };
-  typedef _2dArray<std::pair<int, arma::Mat<ResultType>>> Cache;
   /** \brief Singular integral cache.
    *
    *  This cache stores the preevaluated local weak forms expressed by
-   *  singular integrals. A particular item it stored in r'th row and c'th
-   *  column stores, in its second member, the local weak form calculated for
-   *  the test element with index it.first and the trial element with index
-   *  c. In each column, the items are sorted after increasing test element
-   *  index. At the end of each column there can be unused items with test
-   *  element index set to INVALID_INDEX (= INT_MAX, so that the sorting is
-   *  preserved). */
-  Cache m_cache;
+   *  singular integrals in the compressed sparse row format, with one row per
+   *  trial element. The row of the trial element with index c occupies
+   *  positions m_cacheRowOffsets[c] to m_cacheRowOffsets[c + 1] - 1 of
+   *  m_cacheTestElementIndices, which stores the test element indices sorted
+   *  in increasing order. The local weak form of the pair at position n is
+   *  stored column by column at the beginning of the block of
+   *  m_cacheBlockSize entries of m_cacheLocalWeakForms starting at
+   *  n * m_cacheBlockSize. Its dimensions are given by the sizes of the
+   *  test and trial shapesets.
+   *
+   *  The cache is indexed with the trial element index because profiling has
+   *  shown that evaluateLocalWeakForms is called more often in the TEST_TRIAL
+   *  mode (with a single trial element index) than in the TRIAL_TEST mode. */
+  std::vector<size_t> m_cacheRowOffsets;
+  std::vector<int> m_cacheTestElementIndices;
+  size_t m_cacheBlockSize;
+  std::vector<ResultType> m_cacheLocalWeakForms;
+
+  tbb::enumerable_thread_specific<TileScratch> m_tileScratch;
   /** \endcond */
 };
 
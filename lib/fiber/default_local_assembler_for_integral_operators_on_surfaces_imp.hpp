@@ -29,6 +29,12 @@
 #include "separable_numerical_test_kernel_trial_integrator.hpp"
 #include "serial_blas_region.hpp"
 
+#include <algorithm>
+#include <boost/unordered_map.hpp>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <numeric>
 #include <tbb/parallel_for.h>
 #include <tbb/task_scheduler_init.h>
 
@@ -75,6 +81,134 @@ private:
   const std::vector<arma::Mat<ResultType> *> &m_localResult;
 };
 
+// Find the elements sharing at least one vertex with each element of a range.
+// If adjacentElements is null, only their number is stored in
+// rowOffsets[element + 1]; otherwise they are stored, sorted, in
+// adjacentElements starting at position rowOffsets[element].
+class AdjacentElementsLoopBody {
+public:
+  AdjacentElementsLoopBody(const arma::Mat<int> &elementCornerIndices,
+                           const std::vector<size_t> &vertexOffsets,
+                           const std::vector<int> &vertexElements,
+                           std::vector<size_t> &rowOffsets,
+                           std::vector<int> *adjacentElements)
+      : m_elementCornerIndices(elementCornerIndices),
+        m_vertexOffsets(vertexOffsets), m_vertexElements(vertexElements),
+        m_rowOffsets(rowOffsets), m_adjacentElements(adjacentElements) {}
+
+  void operator()(const tbb::blocked_range<int> &r) const {
+    const int maxCornerCount = m_elementCornerIndices.n_rows;
+    std::vector<int> neighbours;
+    for (int e = r.begin(); e != r.end(); ++e) {
+      neighbours.clear();
+      for (int corner = 0; corner < maxCornerCount; ++corner) {
+        const int v = m_elementCornerIndices(corner, e);
+        if (v >= 0)
+          neighbours.insert(neighbours.end(),
+                            m_vertexElements.begin() + m_vertexOffsets[v],
+                            m_vertexElements.begin() + m_vertexOffsets[v + 1]);
+      }
+      std::sort(neighbours.begin(), neighbours.end());
+      neighbours.erase(std::unique(neighbours.begin(), neighbours.end()),
+                       neighbours.end());
+      if (m_adjacentElements)
+        std::copy(neighbours.begin(), neighbours.end(),
+                  m_adjacentElements->begin() + m_rowOffsets[e]);
+      else
+        m_rowOffsets[e + 1] = neighbours.size();
+    }
+  }
+
+private:
+  const arma::Mat<int> &m_elementCornerIndices;
+  const std::vector<size_t> &m_vertexOffsets;
+  const std::vector<int> &m_vertexElements;
+  std::vector<size_t> &m_rowOffsets;
+  std::vector<int> *m_adjacentElements;
+};
+
+// Compute a key identifying a pair of elements up to the rigid motions that
+// preserve the local numbering of their corners: the numbers of corners, the
+// pattern of shared vertices and the coordinates of the corners in a frame
+// attached to the test element, rounded to multiples of quantum. Returns
+// false if the test element is degenerate.
+template <typename CoordinateType>
+bool elementPairCongruenceKey(const arma::Mat<CoordinateType> &vertices,
+                              const arma::Mat<int> &elementCornerIndices,
+                              int testElementIndex, int trialElementIndex,
+                              CoordinateType quantum,
+                              std::vector<long long> &key) {
+  const int maxCornerCount = elementCornerIndices.n_rows;
+  int testCornerCount = 0, trialCornerCount = 0;
+  long long sharedVertices = 0;
+  for (int i = 0; i < maxCornerCount; ++i) {
+    const int testVertex = elementCornerIndices(i, testElementIndex);
+    const int trialVertex = elementCornerIndices(i, trialElementIndex);
+    if (testVertex >= 0)
+      ++testCornerCount;
+    if (trialVertex >= 0)
+      ++trialCornerCount;
+    for (int j = 0; j < maxCornerCount; ++j)
+      if (testVertex >= 0 &&
+          elementCornerIndices(j, trialElementIndex) == testVertex)
+        sharedVertices |= 1LL << (i * maxCornerCount + j);
+  }
+  key.clear();
+  key.push_back(testCornerCount);
+  key.push_back(trialCornerCount);
+  key.push_back(sharedVertices);
+
+  // Orthonormal frame with the origin at the first corner of the test
+  // element, the first axis along its first edge and the third axis along
+  // its normal
+  const int dimWorld = 3;
+  const CoordinateType *origin =
+      vertices.colptr(elementCornerIndices(0, testElementIndex));
+  const CoordinateType *p1 =
+      vertices.colptr(elementCornerIndices(1, testElementIndex));
+  const CoordinateType *p2 =
+      vertices.colptr(elementCornerIndices(2, testElementIndex));
+  CoordinateType axes[3][3], edge[3];
+  for (int d = 0; d < dimWorld; ++d) {
+    axes[0][d] = p1[d] - origin[d];
+    edge[d] = p2[d] - origin[d];
+  }
+  for (int d = 0; d < dimWorld; ++d)
+    axes[2][d] = axes[0][(d + 1) % 3] * edge[(d + 2) % 3] -
+                 axes[0][(d + 2) % 3] * edge[(d + 1) % 3];
+  for (int axis = 0; axis < 3; axis += 2) {
+    CoordinateType norm = 0;
+    for (int d = 0; d < dimWorld; ++d)
+      norm += axes[axis][d] * axes[axis][d];
+    norm = std::sqrt(norm);
+    if (norm == 0)
+      return false;
+    for (int d = 0; d < dimWorld; ++d)
+      axes[axis][d] /= norm;
+  }
+  for (int d = 0; d < dimWorld; ++d)
+    axes[1][d] = axes[2][(d + 1) % 3] * axes[0][(d + 2) % 3] -
+                 axes[2][(d + 2) % 3] * axes[0][(d + 1) % 3];
+
+  for (int element = 0; element < 2; ++element) {
+    const int elementIndex =
+        element == 0 ? testElementIndex : trialElementIndex;
+    const int cornerCount = element == 0 ? testCornerCount : trialCornerCount;
+    for (int corner = element == 0 ? 1 : 0; corner < cornerCount; ++corner) {
+      const CoordinateType *point =
+          vertices.colptr(elementCornerIndices(corner, elementIndex));
+      for (int axis = 0; axis < 3; ++axis) {
+        CoordinateType coord = 0;
+        for (int d = 0; d < dimWorld; ++d)
+          coord += (point[d] - origin[d]) * axes[axis][d];
+        key.push_back(
+            static_cast<long long>(std::floor(coord / quantum + 0.5)));
+      }
+    }
+  }
+  return true;
+}
+
 } // namespace
 
 template <typename BasisFunctionType, typename KernelType, typename ResultType,
@@ -115,7 +249,7 @@ DefaultLocalAssemblerForIntegralOperatorsOnSurfaces<
       m_openClHandler(openClHandler),
       m_parallelizationOptions(parallelizationOptions),
       m_verbosityLevel(verbosityLevel), m_quadDescSelector(quadDescSelector),
-      m_quadRuleFamily(quadRuleFamily) {
+      m_quadRuleFamily(quadRuleFamily), m_cacheBlockSize(0) {
   Utilities::checkConsistencyOfGeometryAndShapesets(*testRawGeometry,
                                                     *testShapesets);
   Utilities::checkConsistencyOfGeometryAndShapesets(*trialRawGeometry,
@@ -179,34 +313,26 @@ void DefaultLocalAssemblerForIntegralOperatorsOnSurfaces<
   std::vector<QuadVariant> quadVariants(elementACount);
   for (int i = 0; i < elementACount; ++i) {
     // Try to find matrix in cache
-    const arma::Mat<ResultType> *cachedLocalWeakForm = 0;
-    if (callVariant == TEST_TRIAL) {
-      const int testElementIndex = elementIndicesA[i];
-      const int trialElementIndex = elementIndexB;
-      for (size_t n = 0; n < m_cache.extent(0); ++n)
-        if (m_cache(n, trialElementIndex).first == testElementIndex) {
-          cachedLocalWeakForm = &m_cache(n, trialElementIndex).second;
-          break;
-        }
-    } else {
-      const int testElementIndex = elementIndexB;
-      const int trialElementIndex = elementIndicesA[i];
-      for (size_t n = 0; n < m_cache.extent(0); ++n)
-        if (m_cache(n, trialElementIndex).first == testElementIndex) {
-          cachedLocalWeakForm = &m_cache(n, trialElementIndex).second;
-          break;
-        }
-    }
+    const ResultType *cachedData =
+        callVariant == TEST_TRIAL
+            ? findCachedLocalWeakForm(elementIndicesA[i], elementIndexB)
+            : findCachedLocalWeakForm(elementIndexB, elementIndicesA[i]);
 
-    if (cachedLocalWeakForm) { // Matrix found in cache
+    if (cachedData) { // Matrix found in cache
       quadVariants[i] = CACHED;
+      // Read-only view of the cached matrix
+      const arma::Mat<ResultType> cachedLocalWeakForm(
+          const_cast<ResultType *>(cachedData),
+          callVariant == TEST_TRIAL ? basesA[i]->size() : basisB.size(),
+          callVariant == TEST_TRIAL ? basisB.size() : basesA[i]->size(),
+          false /* copy_aux_mem */, true /* strict */);
       if (localDofIndexB == ALL_DOFS)
-        result[i] = *cachedLocalWeakForm;
+        result[i] = cachedLocalWeakForm;
       else {
         if (callVariant == TEST_TRIAL)
-          result[i] = cachedLocalWeakForm->col(localDofIndexB);
+          result[i] = cachedLocalWeakForm.col(localDofIndexB);
         else
-          result[i] = cachedLocalWeakForm->row(localDofIndexB);
+          result[i] = cachedLocalWeakForm.row(localDofIndexB);
       }
     } else {
       const Integrator *integrator =
@@ -265,6 +391,95 @@ void DefaultLocalAssemblerForIntegralOperatorsOnSurfaces<
   }
 }
 
+template <typename BasisFunctionType, typename KernelType, typename ResultType,
+          typename GeometryFactory>
+void DefaultLocalAssemblerForIntegralOperatorsOnSurfaces<
+    BasisFunctionType, KernelType, ResultType, GeometryFactory>::
+    evaluateLocalWeakFormTile(const std::vector<int> &testElementIndices,
+                              const std::vector<int> &trialElementIndices,
+                              LocalWeakFormTile<ResultType> &tile,
+                              CoordinateType nominalDistance) {
+  typedef Shapeset<BasisFunctionType> Shapeset;
+
+  const int testElementCount = testElementIndices.size();
+  const int trialElementCount = trialElementIndices.size();
+
+  int maxTestDofCount = 0, maxTrialDofCount = 0;
+  for (int test = 0; test < testElementCount; ++test)
+    maxTestDofCount = std::max(
+        maxTestDofCount, (*m_testShapesets)[testElementIndices[test]]->size());
+  for (int trial = 0; trial < trialElementCount; ++trial)
+    maxTrialDofCount =
+        std::max(maxTrialDofCount,
+                 (*m_trialShapesets)[trialElementIndices[trial]]->size());
+  tile.resize(testElementCount, trialElementCount, maxTestDofCount,
+              maxTrialDofCount);
+
+  // The work arrays keep their capacity between calls made by the same thread
+  TileScratch &scratch = m_tileScratch.local();
+  std::vector<QuadVariant> &quadVariants = scratch.quadVariants;
+  std::vector<int> &order = scratch.order;
+  std::vector<arma::Mat<ResultType> *> &localResults = scratch.localResults;
+  quadVariants.resize(testElementCount);
+  order.resize(testElementCount);
+  localResults.resize(testElementCount);
+  const QuadVariant CACHED(0, 0);
+
+  for (int trial = 0; trial < trialElementCount; ++trial) {
+    const int trialElementIndex = trialElementIndices[trial];
+    const Shapeset &trialShapeset = *(*m_trialShapesets)[trialElementIndex];
+
+    // Bind the local weak forms to the tile's buffer, copy cached ones and
+    // select integrators to calculate the others
+    for (int test = 0; test < testElementCount; ++test) {
+      const int testElementIndex = testElementIndices[test];
+      const Shapeset *testShapeset = (*m_testShapesets)[testElementIndex];
+      arma::Mat<ResultType> &localWeakForm = tile.bindLocalWeakForm(
+          test, trial, testShapeset->size(), trialShapeset.size());
+      localResults[test] = &localWeakForm;
+      order[test] = test;
+      const ResultType *cachedData =
+          findCachedLocalWeakForm(testElementIndex, trialElementIndex);
+      if (cachedData) {
+        std::copy(cachedData, cachedData + localWeakForm.n_elem,
+                  localWeakForm.memptr());
+        quadVariants[test] = CACHED;
+      } else
+        quadVariants[test] = QuadVariant(
+            &selectIntegrator(testElementIndex, trialElementIndex,
+                              nominalDistance),
+            testShapeset);
+    }
+
+    // Integrate in batches of test elements having the same quadrature
+    // variant. Sorting in place avoids the allocations of a std::set.
+    std::sort(order.begin(), order.end(), [&quadVariants](int a, int b) {
+      return quadVariants[a] < quadVariants[b];
+    });
+    for (int begin = 0; begin < testElementCount;) {
+      const QuadVariant activeQuadVariant = quadVariants[order[begin]];
+      int end = begin + 1;
+      while (end < testElementCount &&
+             quadVariants[order[end]] == activeQuadVariant)
+        ++end;
+      if (activeQuadVariant != CACHED) {
+        scratch.activeTestElementIndices.clear();
+        scratch.activeLocalResults.clear();
+        for (int i = begin; i < end; ++i) {
+          scratch.activeTestElementIndices.push_back(
+              testElementIndices[order[i]]);
+          scratch.activeLocalResults.push_back(localResults[order[i]]);
+        }
+        activeQuadVariant.first->integrate(
+            TEST_TRIAL, scratch.activeTestElementIndices, trialElementIndex,
+            *activeQuadVariant.second, trialShapeset, ALL_DOFS,
+            scratch.activeLocalResults);
+      }
+      begin = end;
+    }
+  }
+}
+
 template <typename BasisFunctionType, typename KernelType, typename ResultType,
           typename GeometryFactory>
 void DefaultLocalAssemblerForIntegralOperatorsOnSurfaces<
@@ -291,17 +506,14 @@ void DefaultLocalAssemblerForIntegralOperatorsOnSurfaces<
       const int activeTestElementIndex = testElementIndices[testIndex];
       const int activeTrialElementIndex = trialElementIndices[trialIndex];
       // Try to find matrix in cache
-      const arma::Mat<ResultType> *cachedLocalWeakForm = 0;
-      for (size_t n = 0; n < m_cache.extent(0); ++n)
-        if (m_cache(n, activeTrialElementIndex).first ==
-            activeTestElementIndex) {
-          cachedLocalWeakForm = &m_cache(n, activeTrialElementIndex).second;
-          break;
-        }
+      const ResultType *cachedData = findCachedLocalWeakForm(
+          activeTestElementIndex, activeTrialElementIndex);
 
-      if (cachedLocalWeakForm) { // Matrix found in cache
+      if (cachedData) { // Matrix found in cache
         quadVariants(testIndex, trialIndex) = CACHED;
-        result(testIndex, trialIndex) = *cachedLocalWeakForm;
+        result(testIndex, trialIndex) = arma::Mat<ResultType>(
+            cachedData, (*m_testShapesets)[activeTestElementIndex]->size(),
+            (*m_trialShapesets)[activeTrialElementIndex]->size());
       } else {
         const Integrator *integrator =
             &selectIntegrator(activeTestElementIndex, activeTrialElementIndex,
@@ -375,21 +587,56 @@ template <typename BasisFunctionType, typename KernelType, typename ResultType,
           typename GeometryFactory>
 void DefaultLocalAssemblerForIntegralOperatorsOnSurfaces<
     BasisFunctionType, KernelType, ResultType,
-    GeometryFactory>::cacheSingularLocalWeakForms() {
-  ElementIndexPairSet elementIndexPairs;
-  findPairsOfAdjacentElements(elementIndexPairs);
-  cacheLocalWeakForms(elementIndexPairs);
+    GeometryFactory>::hashParameters(std::size_t &seed) const {
+  boost::hash_combine(seed, std::string(typeid(*this).name()));
+  m_kernels->hashParameters(seed);
+  boost::hash_combine(seed,
+                      std::string(typeid(*m_testTransformations).name()));
+  boost::hash_combine(seed,
+                      std::string(typeid(*m_trialTransformations).name()));
+  boost::hash_combine(seed, std::string(typeid(*m_integral).name()));
 }
 
-/** \brief Fill \p pairs with the list of pairs of indices of elements
-        sharing at least one vertex. */
 template <typename BasisFunctionType, typename KernelType, typename ResultType,
           typename GeometryFactory>
 void DefaultLocalAssemblerForIntegralOperatorsOnSurfaces<
     BasisFunctionType, KernelType, ResultType,
-    GeometryFactory>::findPairsOfAdjacentElements(ElementIndexPairSet &pairs)
-    const {
-  pairs.clear();
+    GeometryFactory>::printStatistics(std::ostream &out) const {
+  m_quadDescSelector->printStatistics(out);
+}
+
+template <typename BasisFunctionType, typename KernelType, typename ResultType,
+          typename GeometryFactory>
+void DefaultLocalAssemblerForIntegralOperatorsOnSurfaces<
+    BasisFunctionType, KernelType, ResultType,
+    GeometryFactory>::cacheSingularLocalWeakForms() {
+  int maxThreadCount = 1;
+  if (!m_parallelizationOptions.isOpenClEnabled()) {
+    if (m_parallelizationOptions.maxThreadCount() ==
+        ParallelizationOptions::AUTO)
+      maxThreadCount = tbb::task_scheduler_init::automatic;
+    else
+      maxThreadCount = m_parallelizationOptions.maxThreadCount();
+  }
+  tbb::task_scheduler_init scheduler(maxThreadCount);
+
+  findPairsOfAdjacentElements(m_cacheRowOffsets, m_cacheTestElementIndices);
+  cacheLocalWeakForms();
+}
+
+/** \brief Fill \p rowOffsets and \p testElementIndices with the list of
+        pairs of indices of elements sharing at least one vertex.
+
+        The pairs are stored in the compressed sparse row format used by the
+        singular integral cache. */
+template <typename BasisFunctionType, typename KernelType, typename ResultType,
+          typename GeometryFactory>
+void DefaultLocalAssemblerForIntegralOperatorsOnSurfaces<
+    BasisFunctionType, KernelType, ResultType, GeometryFactory>::
+    findPairsOfAdjacentElements(std::vector<size_t> &rowOffsets,
+                                std::vector<int> &testElementIndices) const {
+  rowOffsets.clear();
+  testElementIndices.clear();
 
   if (!testAndTrialGridsAreIdentical())
     return; // we assume that nonidentical grids are always disjoint
@@ -404,154 +651,170 @@ void DefaultLocalAssemblerForIntegralOperatorsOnSurfaces<
   const int elementCount = elementCornerIndices.n_cols;
   const int maxCornerCount = elementCornerIndices.n_rows;
 
-  typedef std::vector<int> ElementIndexVector;
-  // ith entry: set of elements sharing vertex number i
-  std::vector<ElementIndexVector> elementsAdjacentToVertex(vertexCount);
-
+  // Elements sharing vertex number v are stored at positions
+  // vertexOffsets[v] to vertexOffsets[v + 1] - 1 of vertexElements
+  std::vector<size_t> vertexOffsets(vertexCount + 1, 0);
   for (int e = 0; e < elementCount; ++e)
     for (int v = 0; v < maxCornerCount; ++v) {
       const int index = elementCornerIndices(v, e);
       if (index >= 0)
-        elementsAdjacentToVertex[index].push_back(e);
+        ++vertexOffsets[index + 1];
     }
-
-  // Loop over vertex indices
-  for (int v = 0; v < vertexCount; ++v) {
-    const ElementIndexVector &adjacentElements = elementsAdjacentToVertex[v];
-    // Add to pairs each pair of elements adjacent to vertex v
-    const int adjacentElementCount = adjacentElements.size();
-    for (int e1 = 0; e1 < adjacentElementCount; ++e1)
-      for (int e2 = 0; e2 < adjacentElementCount; ++e2)
-        pairs.insert(
-            ElementIndexPair(adjacentElements[e1], adjacentElements[e2]));
+  std::partial_sum(vertexOffsets.begin(), vertexOffsets.end(),
+                   vertexOffsets.begin());
+  std::vector<int> vertexElements(vertexOffsets.back());
+  {
+    std::vector<size_t> positions(vertexOffsets.begin(),
+                                  vertexOffsets.end() - 1);
+    for (int e = 0; e < elementCount; ++e)
+      for (int v = 0; v < maxCornerCount; ++v) {
+        const int index = elementCornerIndices(v, e);
+        if (index >= 0)
+          vertexElements[positions[index]++] = e;
+      }
   }
+
+  // Count the neighbours of each element, then store them. Each element is
+  // adjacent to itself, so the relation is symmetric and the neighbours of a
+  // trial element are the test elements of its row.
+  rowOffsets.resize(elementCount + 1, 0);
+  tbb::parallel_for(tbb::blocked_range<int>(0, elementCount),
+                    AdjacentElementsLoopBody(elementCornerIndices,
+                                             vertexOffsets, vertexElements,
+                                             rowOffsets, 0));
+  std::partial_sum(rowOffsets.begin(), rowOffsets.end(), rowOffsets.begin());
+  testElementIndices.resize(rowOffsets.back());
+  tbb::parallel_for(tbb::blocked_range<int>(0, elementCount),
+                    AdjacentElementsLoopBody(elementCornerIndices,
+                                             vertexOffsets, vertexElements,
+                                             rowOffsets, &testElementIndices));
 }
 
 template <typename BasisFunctionType, typename KernelType, typename ResultType,
           typename GeometryFactory>
 void DefaultLocalAssemblerForIntegralOperatorsOnSurfaces<
     BasisFunctionType, KernelType, ResultType,
-    GeometryFactory>::cacheLocalWeakForms(const ElementIndexPairSet &
-                                              elementIndexPairs) {
+    GeometryFactory>::cacheLocalWeakForms() {
   tbb::tick_count start = tbb::tick_count::now();
 
-  if (elementIndexPairs.empty())
+  const size_t elementPairCount = m_cacheTestElementIndices.size();
+  m_cacheLocalWeakForms.clear();
+  if (elementPairCount == 0)
     return;
 
+  // All local weak forms fit in blocks of the same size
+  size_t maxTestDofCount = 0, maxTrialDofCount = 0;
+  for (size_t e = 0; e < m_testShapesets->size(); ++e)
+    maxTestDofCount =
+        std::max<size_t>(maxTestDofCount, (*m_testShapesets)[e]->size());
+  for (size_t e = 0; e < m_trialShapesets->size(); ++e)
+    maxTrialDofCount =
+        std::max<size_t>(maxTrialDofCount, (*m_trialShapesets)[e]->size());
+  m_cacheBlockSize = maxTestDofCount * maxTrialDofCount;
+  m_cacheLocalWeakForms.resize(elementPairCount * m_cacheBlockSize);
+
   if (m_verbosityLevel >= VerbosityLevel::DEFAULT)
     std::cout << "Precalculating singular integrals..." << std::endl;
 
-  // Get the maximum number of neighbours a trial element can have.
-  // This will be used to allocate a cache of correct size.
-  // This loops assumes that elementIndexPairs are sorted after the trial
-  // element index first.
-  size_t maxNeighbourCount = 0;
-  for (typename ElementIndexPairSet::const_iterator it =
-           elementIndexPairs.begin();
-       it != elementIndexPairs.end(); /* nothing */) {
-    int curTrialElementIndex = it->second;
-    size_t neighbourCount = 1;
-    for (++it;
-         it != elementIndexPairs.end() && it->second == curTrialElementIndex;
-         ++it) {
-      ++neighbourCount;
-    }
-    maxNeighbourCount = std::max(maxNeighbourCount, neighbourCount);
-  }
-
-  // Allocate cache and initialize all test element indices to INVALID_INDEX
-  size_t trialElementCount = m_trialRawGeometry->elementCount();
-  m_cache.set_size(maxNeighbourCount, trialElementCount);
-  for (size_t trialIndex = 0; trialIndex < trialElementCount; ++trialIndex)
-    for (size_t nborIndex = 0; nborIndex < maxNeighbourCount; ++nborIndex)
-      m_cache(nborIndex, trialIndex).first = INVALID_INDEX;
-
-  // Find cached matrices; select integrators to calculate non-cached ones
+  // Select integrators and group the element pairs by "quadrature variant",
+  // i.e. integrator, test shapeset and trial shapeset
   typedef Fiber::Shapeset<BasisFunctionType> Shapeset;
   typedef boost::tuples::tuple<const Integrator *, const Shapeset *,
                                const Shapeset *> QuadVariant;
-  const int elementPairCount = elementIndexPairs.size();
-  std::vector<QuadVariant> quadVariants(elementPairCount);
-
-  typedef typename ElementIndexPairSet::const_iterator ElementIndexPairIterator;
-  typedef typename std::vector<QuadVariant>::iterator QuadVariantIterator;
-  {
-    ElementIndexPairIterator pairIt = elementIndexPairs.begin();
-    QuadVariantIterator qvIt = quadVariants.begin();
-    for (; pairIt != elementIndexPairs.end(); ++pairIt, ++qvIt) {
-      const int testElementIndex = pairIt->first;
-      const int trialElementIndex = pairIt->second;
+  typedef std::map<QuadVariant, std::vector<size_t>> QuadVariantPairMap;
+  QuadVariantPairMap pairsByQuadVariant;
+  std::vector<ElementIndexPair> elementPairs(elementPairCount);
+  const size_t trialElementCount = m_cacheRowOffsets.size() - 1;
+  for (size_t trialElementIndex = 0; trialElementIndex < trialElementCount;
+       ++trialElementIndex)
+    for (size_t n = m_cacheRowOffsets[trialElementIndex];
+         n < m_cacheRowOffsets[trialElementIndex + 1]; ++n) {
+      const int testElementIndex = m_cacheTestElementIndices[n];
+      elementPairs[n] = ElementIndexPair(testElementIndex, trialElementIndex);
       const Integrator *integrator =
           &selectIntegrator(testElementIndex, trialElementIndex);
-      *qvIt = QuadVariant(integrator, (*m_testShapesets)[testElementIndex],
-                          (*m_trialShapesets)[trialElementIndex]);
+      pairsByQuadVariant[QuadVariant(
+                             integrator, (*m_testShapesets)[testElementIndex],
+                             (*m_trialShapesets)[trialElementIndex])]
+          .push_back(n);
     }
-  }
-
-  // Integration will proceed in batches of element pairs having the same
-  // "quadrature variant", i.e. integrator, test shapeset and trial shapeset
-
-  // Find all the unique quadrature variants present
-  typedef std::set<QuadVariant> QuadVariantSet;
-  // Set of unique quadrature variants
-  QuadVariantSet uniqueQuadVariants(quadVariants.begin(), quadVariants.end());
 
+  // If the kernels and the integral are invariant under rigid motions, pairs
+  // congruent to another pair of the same quadrature variant have the same
+  // local weak form, so only one pair of each congruence class is integrated.
+  // representatives[n] is the index of the pair whose local weak form is
+  // copied to pair n. Corners are compared with a tolerance of a few machine
+  // epsilons relative to the largest vertex coordinate, i.e. only pairs equal
+  // up to the rounding of the vertex coordinates are merged; rounding errors
+  // above it merely prevent reuse.
+  const bool reuseCongruentPairs = m_kernels->isInvariantUnderRigidMotions() &&
+                                   m_integral->isInvariantUnderRigidMotions() &&
+                                   m_testRawGeometry->auxData().is_empty();
+  std::vector<size_t> representatives(elementPairCount);
+  for (size_t n = 0; n < elementPairCount; ++n)
+    representatives[n] = n;
+  const arma::Mat<CoordinateType> &vertices = m_testRawGeometry->vertices();
+  const arma::Mat<int> &elementCornerIndices =
+      m_testRawGeometry->elementCornerIndices();
+  CoordinateType quantum = 0;
+  if (reuseCongruentPairs && !vertices.is_empty())
+    quantum = 8 * std::numeric_limits<CoordinateType>::epsilon() *
+              std::max(arma::max(arma::max(arma::abs(vertices))),
+                       std::numeric_limits<CoordinateType>::min());
+  typedef boost::unordered_map<std::vector<long long>, size_t> CongruenceMap;
+  CongruenceMap congruentPairs;
+  std::vector<long long> key;
+
+  // The integrators write into views of the blocks of the cache. The views
+  // must not be reallocated, so their vector gets the capacity needed by
+  // the largest quadrature variant up front.
+  size_t maxActivePairCount = 0;
+  for (typename QuadVariantPairMap::const_iterator it =
+           pairsByQuadVariant.begin();
+       it != pairsByQuadVariant.end(); ++it)
+    maxActivePairCount = std::max(maxActivePairCount, it->second.size());
   std::vector<ElementIndexPair> activeElementPairs;
+  std::vector<arma::Mat<ResultType>> activeLocalResultViews;
   std::vector<arma::Mat<ResultType> *> activeLocalResults;
-  activeElementPairs.reserve(elementPairCount);
-  activeLocalResults.reserve(elementPairCount);
-  // m_cache.rehash(int(elementIndexPairs.size() / m_cache.max_load_factor() +
-  // 1));
-
-  int maxThreadCount = 1;
-  if (!m_parallelizationOptions.isOpenClEnabled()) {
-    if (m_parallelizationOptions.maxThreadCount() ==
-        ParallelizationOptions::AUTO)
-      maxThreadCount = tbb::task_scheduler_init::automatic;
-    else
-      maxThreadCount = m_parallelizationOptions.maxThreadCount();
-  }
-  tbb::task_scheduler_init scheduler(maxThreadCount);
+  activeElementPairs.reserve(maxActivePairCount);
+  activeLocalResultViews.reserve(maxActivePairCount);
+  activeLocalResults.reserve(maxActivePairCount);
 
   // Now loop over unique quadrature variants
-  for (typename QuadVariantSet::const_iterator it = uniqueQuadVariants.begin();
-       it != uniqueQuadVariants.end(); ++it) {
-    const QuadVariant activeQuadVariant = *it;
-    const Integrator &activeIntegrator = *it->template get<0>();
-    const Shapeset &activeTestShapeset = *it->template get<1>();
-    const Shapeset &activeTrialShapeset = *it->template get<2>();
+  for (typename QuadVariantPairMap::const_iterator it =
+           pairsByQuadVariant.begin();
+       it != pairsByQuadVariant.end(); ++it) {
+    const Integrator &activeIntegrator = *it->first.template get<0>();
+    const Shapeset &activeTestShapeset = *it->first.template get<1>();
+    const Shapeset &activeTrialShapeset = *it->first.template get<2>();
+    const std::vector<size_t> &activePairs = it->second;
 
-    // Find all the element pairs for which quadrature should proceed
-    // according to the current quadrature variant
     activeElementPairs.clear();
+    activeLocalResultViews.clear();
     activeLocalResults.clear();
-    {
-      ElementIndexPairIterator pairIt = elementIndexPairs.begin();
-      QuadVariantIterator qvIt = quadVariants.begin();
-      size_t neighbourIndex = 0;                    // Cache row index
-      size_t curTrialElementIndex = pairIt->second; // Cache column index
-      for (; pairIt != elementIndexPairs.end(); ++pairIt, ++qvIt) {
-        if (pairIt->second != curTrialElementIndex) {
-          // Go to the next column of cache
-          curTrialElementIndex = pairIt->second;
-          neighbourIndex = 0;
+    congruentPairs.clear();
+    for (size_t i = 0; i < activePairs.size(); ++i) {
+      const size_t n = activePairs[i];
+      if (reuseCongruentPairs &&
+          elementPairCongruenceKey(vertices, elementCornerIndices,
+                                   elementPairs[n].first,
+                                   elementPairs[n].second, quantum, key)) {
+        std::pair<typename CongruenceMap::iterator, bool> result =
+            congruentPairs.insert(std::make_pair(key, n));
+        if (!result.second) {
+          representatives[n] = result.first->second;
+          continue;
         }
-        if (*qvIt == activeQuadVariant) {
-          activeElementPairs.push_back(*pairIt);
-          m_cache(neighbourIndex, curTrialElementIndex).first = pairIt->first;
-          activeLocalResults.push_back(
-              &m_cache(neighbourIndex, curTrialElementIndex).second);
-        }
-        // Increment cache row index
-        ++neighbourIndex;
       }
+      activeElementPairs.push_back(elementPairs[n]);
+      activeLocalResultViews.emplace_back(
+          &m_cacheLocalWeakForms[n * m_cacheBlockSize],
+          activeTestShapeset.size(), activeTrialShapeset.size(),
+          false /* copy_aux_mem */, true /* strict */);
+      activeLocalResults.push_back(&activeLocalResultViews.back());
     }
 
     // Integrate!
-    // Old serial version
-    // activeIntegrator.integrate(activeElementPairs, activeTestShapeset,
-    //                            activeTrialShapeset, localResult);
-
     typedef SingularIntegralCalculatorLoopBody<BasisFunctionType, KernelType,
                                                ResultType> Body;
     {
@@ -562,12 +825,49 @@ void DefaultLocalAssemblerForIntegralOperatorsOnSurfaces<
                activeTrialShapeset, activeLocalResults));
     }
   }
+
+  size_t reusedCount = 0;
+  for (size_t n = 0; n < elementPairCount; ++n)
+    if (representatives[n] != n) {
+      const typename std::vector<ResultType>::iterator representative =
+          m_cacheLocalWeakForms.begin() + representatives[n] * m_cacheBlockSize;
+      std::copy(representative, representative + m_cacheBlockSize,
+                m_cacheLocalWeakForms.begin() + n * m_cacheBlockSize);
+      ++reusedCount;
+    }
+
   tbb::tick_count end = tbb::tick_count::now();
+  if (m_verbosityLevel >= VerbosityLevel::DEFAULT && reusedCount > 0)
+    std::cout << "Reused singular integrals of " << reusedCount << " of "
+              << elementPairCount << " element pairs congruent to other pairs"
+              << std::endl;
   if (m_verbosityLevel >= VerbosityLevel::DEFAULT)
     std::cout << "Precalculation of singular integrals took "
               << (end - start).seconds() << " s" << std::endl;
 }
 
+template <typename BasisFunctionType, typename KernelType, typename ResultType,
+          typename GeometryFactory>
+const ResultType *
+DefaultLocalAssemblerForIntegralOperatorsOnSurfaces<
+    BasisFunctionType, KernelType, ResultType,
+    GeometryFactory>::findCachedLocalWeakForm(int testElementIndex,
+                                              int trialElementIndex) const {
+  if (m_cacheLocalWeakForms.empty())
+    return 0;
+  const std::vector<int>::const_iterator rowBegin =
+      m_cacheTestElementIndices.begin() + m_cacheRowOffsets[trialElementIndex];
+  const std::vector<int>::const_iterator rowEnd =
+      m_cacheTestElementIndices.begin() +
+      m_cacheRowOffsets[trialElementIndex + 1];
+  const std::vector<int>::const_iterator it =
+      std::lower_bound(rowBegin, rowEnd, testElementIndex);
+  if (it == rowEnd || *it != testElementIndex)
+    return 0;
+  return &m_cacheLocalWeakForms[(it - m_cacheTestElementIndices.begin()) *
+                                m_cacheBlockSize];
+}
+
 template <typename BasisFunctionType, typename KernelType, typename ResultType,
           typename GeometryFactory>
 const TestKernelTrialIntegrator<BasisFunctionType, KernelType, ResultType> &
@@ -591,23 +891,36 @@ DefaultLocalAssemblerForIntegralOperatorsOnSurfaces<
   // Note: as far as I understand TBB's docs, .end() keeps pointing to the
   // same element even if another thread inserts a new element into the map
   if (it == m_testKernelTrialIntegrators.end()) {
+    typedef SeparableNumericalTestKernelTrialIntegrator<
+        BasisFunctionType, KernelType, ResultType, GeometryFactory>
+    SeparableIntegrator;
+    arma::Mat<CoordinateType> testPoints, trialPoints;
+    std::vector<CoordinateType> testWeights, trialWeights;
+    bool isTensor;
+    m_quadRuleFamily->fillQuadraturePointsAndWeights(
+        desc, testPoints, trialPoints, testWeights, trialWeights, isTensor);
+    // The geometrical data are calculated by a parallel loop, which must not
+    // run under m_integratorCreationMutex: a worker thread waiting for the
+    // loop could pick up an assembly task that blocks on the same mutex.
+    // The arenas are held here until the integrator takes them over.
+    shared_ptr<const GeometricalDataArena<CoordinateType>> testArena,
+        trialArena;
+    if (isTensor)
+      SeparableIntegrator::prepareGeometricalDataCache(
+          testPoints, trialPoints, *m_testGeometryFactory,
+          *m_trialGeometryFactory, *m_testRawGeometry, *m_trialRawGeometry,
+          *m_testTransformations, *m_kernels, *m_trialTransformations,
+          *m_integral, testArena, trialArena);
+
     tbb::mutex::scoped_lock lock(m_integratorCreationMutex);
     it = m_testKernelTrialIntegrators.find(desc);
     if (it == m_testKernelTrialIntegrators.end()) {
       // std::cout << "getIntegrator(" << desc
       //           << "): creating an integrator" << std::endl;
       // Integrator doesn't exist yet and must be created.
-      arma::Mat<CoordinateType> testPoints, trialPoints;
-      std::vector<CoordinateType> testWeights, trialWeights;
-      bool isTensor;
-      m_quadRuleFamily->fillQuadraturePointsAndWeights(
-          desc, testPoints, trialPoints, testWeights, trialWeights, isTensor);
       Integrator *integrator = 0;
       if (isTensor) {
-        typedef SeparableNumericalTestKernelTrialIntegrator<
-            BasisFunctionType, KernelType, ResultType, GeometryFactory>
-        ConcreteIntegrator;
-        integrator = new ConcreteIntegrator(
+        integrator = new SeparableIntegrator(
             testPoints, trialPoints, testWeights, trialWeights,
             *m_testGeometryFactory, *m_trialGeometryFactory, *m_testRawGeometry,
             *m_trialRawGeometry, *m_testTransformations, *m_kernels,
@@ -107,6 +107,8 @@ public:
 
   virtual CoordinateType estimateRelativeScale(CoordinateType minDist) const;
 
+  virtual void hashParameters(std::size_t &seed) const;
+
 private:
   /** \cond PRIVATE */
   typedef KernelTrialIntegrator<BasisFunctionType, KernelType, ResultType>
@@ -301,6 +301,18 @@ DefaultLocalAssemblerForPotentialOperatorsOnSurfaces<
   return m_kernels->estimateRelativeScale(minDist);
 }
 
+template <typename BasisFunctionType, typename KernelType, typename ResultType,
+          typename GeometryFactory>
+void DefaultLocalAssemblerForPotentialOperatorsOnSurfaces<
+    BasisFunctionType, KernelType, ResultType,
+    GeometryFactory>::hashParameters(std::size_t &seed) const {
+  boost::hash_combine(seed, std::string(typeid(*this).name()));
+  m_kernels->hashParameters(seed);
+  boost::hash_combine(seed,
+                      std::string(typeid(*m_trialTransformations).name()));
+  boost::hash_combine(seed, std::string(typeid(*m_integral).name()));
+}
+
 template <typename BasisFunctionType, typename KernelType, typename ResultType,
           typename GeometryFactory>
 const KernelTrialIntegrator<BasisFunctionType, KernelType, ResultType> &
@@ -72,6 +72,29 @@ DefaultQuadratureDescriptorSelectorFactory<BasisFunctionType>::
                                       m_accuracyOptions);
 }
 
+template <typename BasisFunctionType>
+shared_ptr<QuadratureDescriptorSelectorForIntegralOperators<
+    typename DefaultQuadratureDescriptorSelectorFactory<
+        BasisFunctionType>::CoordinateType>>
+DefaultQuadratureDescriptorSelectorFactory<BasisFunctionType>::
+    makeQuadratureDescriptorSelectorForIntegralOperators(
+        const shared_ptr<const RawGridGeometry<CoordinateType>> &
+            testRawGeometry,
+        const shared_ptr<const RawGridGeometry<CoordinateType>> &
+            trialRawGeometry,
+        const shared_ptr<const std::vector<
+            const Shapeset<BasisFunctionType> *>> &testShapesets,
+        const shared_ptr<const std::vector<
+            const Shapeset<BasisFunctionType> *>> &trialShapesets,
+        const std::function<CoordinateType(CoordinateType)> &kernelScale)
+    const {
+  typedef DefaultQuadratureDescriptorSelectorForIntegralOperators<
+      BasisFunctionType> Selector;
+  return boost::make_shared<Selector>(testRawGeometry, trialRawGeometry,
+                                      testShapesets, trialShapesets,
+                                      m_accuracyOptions, kernelScale);
+}
+
 template <typename BasisFunctionType>
 shared_ptr<QuadratureDescriptorSelectorForLocalOperators<
     typename DefaultQuadratureDescriptorSelectorFactory<
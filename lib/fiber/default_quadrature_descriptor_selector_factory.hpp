@@ -54,6 +54,17 @@ public:
       const shared_ptr<const std::vector<const Shapeset<BasisFunctionType> *>> &
           trialShapesets) const;
 
+  virtual shared_ptr<
+      QuadratureDescriptorSelectorForIntegralOperators<CoordinateType>>
+  makeQuadratureDescriptorSelectorForIntegralOperators(
+      const shared_ptr<const RawGridGeometry<CoordinateType>> &testRawGeometry,
+      const shared_ptr<const RawGridGeometry<CoordinateType>> &trialRawGeometry,
+      const shared_ptr<const std::vector<const Shapeset<BasisFunctionType> *>> &
+          testShapesets,
+      const shared_ptr<const std::vector<const Shapeset<BasisFunctionType> *>> &
+          trialShapesets,
+      const std::function<CoordinateType(CoordinateType)> &kernelScale) const;
+
   virtual shared_ptr<
       QuadratureDescriptorSelectorForLocalOperators<CoordinateType>>
   makeQuadratureDescriptorSelectorForLocalOperators(
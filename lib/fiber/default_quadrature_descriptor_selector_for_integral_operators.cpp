@@ -26,6 +26,9 @@
 #include "raw_grid_geometry.hpp"
 #include "shapeset.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 namespace Fiber {
 
 template <typename BasisFunctionType>
@@ -39,15 +42,18 @@ DefaultQuadratureDescriptorSelectorForIntegralOperators<BasisFunctionType>::
             const Shapeset<BasisFunctionType> *>> &testShapesets,
         const shared_ptr<const std::vector<
             const Shapeset<BasisFunctionType> *>> &trialShapesets,
-        const AccuracyOptionsEx &accuracyOptions)
+        const AccuracyOptionsEx &accuracyOptions,
+        const KernelScaleFunction &kernelScale)
     : m_testRawGeometry(testRawGeometry), m_trialRawGeometry(trialRawGeometry),
       m_testShapesets(testShapesets), m_trialShapesets(trialShapesets),
-      m_accuracyOptions(accuracyOptions) {
+      m_accuracyOptions(accuracyOptions), m_kernelScale(kernelScale) {
   Utilities::checkConsistencyOfGeometryAndShapesets(*testRawGeometry,
                                                     *testShapesets);
   Utilities::checkConsistencyOfGeometryAndShapesets(*trialRawGeometry,
                                                     *trialShapesets);
   precalculateElementSizesAndCenters();
+  for (int order = 0; order <= maxRegularOrder; ++order)
+    m_regularOrderQueryCounts[order] = 0;
 }
 
 template <typename BasisFunctionType>
@@ -130,25 +136,96 @@ void DefaultQuadratureDescriptorSelectorForIntegralOperators<
   testQuadOrder = testBasisOrder;
   trialQuadOrder = trialBasisOrder;
 
+  CoordinateType testElementSizeSquared =
+      m_testElementSizesSquared[testElementIndex];
+  CoordinateType trialElementSizeSquared =
+      m_trialElementSizesSquared[trialElementIndex];
+  CoordinateType distance =
+      nominalDistance < 0.
+          ? sqrt(elementDistanceSquared(testElementIndex, trialElementIndex))
+          : nominalDistance;
+
+  const bool toleranceBased = m_accuracyOptions.doubleRegularTolerance() > 0.;
+  if (toleranceBased) {
+    const CoordinateType tolerance = m_accuracyOptions.doubleRegularTolerance();
+    const CoordinateType scale =
+        m_kernelScale ? m_kernelScale(distance) : CoordinateType(1.);
+    testQuadOrder = toleranceBasedRegularOrder(
+        testBasisOrder, sqrt(testElementSizeSquared), distance, tolerance,
+        scale);
+    trialQuadOrder = toleranceBasedRegularOrder(
+        trialBasisOrder, sqrt(trialElementSizeSquared), distance, tolerance,
+        scale);
+    if (testQuadOrder >= 0 && trialQuadOrder >= 0) {
+      ++m_regularOrderQueryCounts[std::min<int>(
+          std::max(testQuadOrder, trialQuadOrder), maxRegularOrder)];
+      return;
+    }
+    // The elements are too close for the error estimate to apply; use the
+    // orders of the near-field table
+    testQuadOrder = testBasisOrder;
+    trialQuadOrder = trialBasisOrder;
+  }
+
   CoordinateType normalisedDistance;
-  if (nominalDistance < 0.) {
-    CoordinateType testElementSizeSquared =
-        m_testElementSizesSquared[testElementIndex];
-    CoordinateType trialElementSizeSquared =
-        m_trialElementSizesSquared[trialElementIndex];
-    CoordinateType distanceSquared =
-        elementDistanceSquared(testElementIndex, trialElementIndex);
-    CoordinateType normalisedDistanceSquared =
-        distanceSquared /
-        std::max(testElementSizeSquared, trialElementSizeSquared);
-    normalisedDistance = sqrt(normalisedDistanceSquared);
-  } else
+  if (nominalDistance < 0.)
+    normalisedDistance =
+        distance / sqrt(std::max(testElementSizeSquared,
+                                 trialElementSizeSquared));
+  else
     normalisedDistance = nominalDistance / m_averageElementSize;
 
   const QuadratureOptions &options =
       m_accuracyOptions.doubleRegular(normalisedDistance);
   testQuadOrder = options.quadratureOrder(testQuadOrder);
   trialQuadOrder = options.quadratureOrder(trialQuadOrder);
+  if (toleranceBased)
+    ++m_regularOrderQueryCounts[std::min<int>(
+        std::max(testQuadOrder, trialQuadOrder), maxRegularOrder)];
+}
+
+template <typename BasisFunctionType>
+int DefaultQuadratureDescriptorSelectorForIntegralOperators<BasisFunctionType>::
+    toleranceBasedRegularOrder(int basisOrder, CoordinateType elementSize,
+                               CoordinateType distance,
+                               CoordinateType tolerance,
+                               CoordinateType scale) {
+  if (scale <= tolerance)
+    return basisOrder; // the kernels have decayed below the tolerance
+  const CoordinateType eta = 2. * distance / elementSize;
+  if (!(eta > 1.)) // the error estimate does not apply
+    return -1;
+  // Parameter of the largest Bernstein ellipse around the element that does
+  // not contain the singularity of the kernels
+  const CoordinateType rho = eta + sqrt(eta * eta - 1.);
+
+  // Smallest k >= 0 such that scale * rho^(-(k + 1)) <= tolerance
+  const int increment = std::max<int>(
+      std::ceil(std::log(scale / tolerance) / std::log(rho)) - 1, 0);
+  if (increment > maxRegularOrder - basisOrder)
+    return std::max<int>(basisOrder, maxRegularOrder);
+  return basisOrder + increment;
+}
+
+template <typename BasisFunctionType>
+void DefaultQuadratureDescriptorSelectorForIntegralOperators<
+    BasisFunctionType>::printStatistics(std::ostream &out) const {
+  const double tolerance = m_accuracyOptions.doubleRegularTolerance();
+  if (tolerance <= 0.)
+    return;
+  size_t totalCount = 0;
+  for (int order = 0; order <= maxRegularOrder; ++order)
+    totalCount += m_regularOrderQueryCounts[order];
+  if (totalCount == 0)
+    return;
+  out << "Regular quadrature orders selected for relative tolerance "
+      << tolerance << " (counted per quadrature descriptor query, "
+                      "not per distinct element pair):\n";
+  for (int order = 0; order <= maxRegularOrder; ++order)
+    if (m_regularOrderQueryCounts[order] > 0)
+      out << "  order " << order << ": " << m_regularOrderQueryCounts[order]
+          << " queries\n";
+  out.flush();
 }
 
 template <typename BasisFunctionType>
@@ -27,6 +27,8 @@
 #include "accuracy_options.hpp"
 #include "scalar_traits.hpp"
 
+#include <tbb/atomic.h>
+
 namespace Fiber {
 
 template <typename BasisFunctionType> class Shapeset;
@@ -38,13 +40,29 @@ class DefaultLocalAssemblerForOperatorsOnSurfacesUtilities;
  *  used during the discretization of boundary integral operators.
  *
  *  The choice of quadrature rule accuracy can be influenced by the
- *  \p accuracyOptions parameter taken by the constructor. */
+ *  \p accuracyOptions parameter taken by the constructor.
+ *
+ *  If AccuracyOptionsEx::doubleRegularTolerance() is positive, the order of
+ *  the regular quadrature rule on each element of a pair is the lowest one
+ *  for which the estimated relative error does not exceed the tolerance.
+ *  The estimate assumes the error of a rule integrating polynomials of
+ *  degree \f$p_0 + k\f$ exactly, where \f$p_0\f$ is the order of the
+ *  shape functions, to behave like \f$s(d) \, \rho^{-(k+1)}\f$ with
+ *  \f$\rho = \eta + \sqrt{\eta^2 - 1}\f$ and \f$\eta = 2d / h\f$. Here
+ *  \f$h\f$ is the size of the element, \f$d\f$ the distance between the
+ *  centres of the two elements and \f$s\f$ the relative scale of the
+ *  kernels (the \p kernelScale parameter of the constructor; a constant 1 if
+ *  it is empty). Orders are capped at 20. For pairs with \f$\eta \le 1\f$,
+ *  to which the estimate does not apply, the orders are taken from
+ *  AccuracyOptionsEx::doubleRegular() as in the default mode. */
 template <typename BasisFunctionType>
 class DefaultQuadratureDescriptorSelectorForIntegralOperators
     : public QuadratureDescriptorSelectorForIntegralOperators<
           typename ScalarTraits<BasisFunctionType>::RealType> {
 public:
   typedef typename ScalarTraits<BasisFunctionType>::RealType CoordinateType;
+  typedef typename QuadratureDescriptorSelectorForIntegralOperators<
+      CoordinateType>::KernelScaleFunction KernelScaleFunction;
 
   DefaultQuadratureDescriptorSelectorForIntegralOperators(
       const shared_ptr<const RawGridGeometry<CoordinateType>> &testRawGeometry,
@@ -53,12 +71,41 @@ public:
           testShapesets,
       const shared_ptr<const std::vector<const Shapeset<BasisFunctionType> *>> &
           trialShapesets,
-      const AccuracyOptionsEx &accuracyOptions);
+      const AccuracyOptionsEx &accuracyOptions,
+      const KernelScaleFunction &kernelScale = KernelScaleFunction());
 
   virtual DoubleQuadratureDescriptor
   quadratureDescriptor(int testElementIndex, int trialElementIndex,
                        CoordinateType nominalDistance) const;
 
+  /** \brief Write the number of times each regular quadrature order was
+   *  selected in the tolerance-based mode to \p out.
+   *
+   *  The counts are per query, not per distinct element pair: each call to
+   *  quadratureDescriptor() for a regular element pair counts once.
+   *  DenseGlobalAssembler queries each regular pair exactly once, so there
+   *  the counts equal the numbers of pairs; the ACA and H-matrix assemblers
+   *  may evaluate a pair several times, which is then counted each time.
+   *  Tracking distinct pairs would need memory proportional to their
+   *  number, i.e. quadratic in the number of elements. */
+  virtual void printStatistics(std::ostream &out) const;
+
+  /** \brief Lowest regular quadrature order for an element of size
+   *  \p elementSize whose estimated relative error does not exceed
+   *  \p tolerance.
+   *
+   *  \p distance is the distance between the centres of the elements of the
+   *  pair and \p kernelScale the relative scale of the kernels at that
+   *  distance. The order is at least \p basisOrder and at most 20, unless
+   *  \p basisOrder is larger. Returns -1 if the element is too large
+   *  compared to the distance (\f$2d / h \le 1\f$) for the estimate to
+   *  apply. */
+  static int toleranceBasedRegularOrder(int basisOrder,
+                                        CoordinateType elementSize,
+                                        CoordinateType distance,
+                                        CoordinateType tolerance,
+                                        CoordinateType kernelScale);
+
 private:
   /** \cond PRIVATE */
   typedef DefaultLocalAssemblerForOperatorsOnSurfacesUtilities<
@@ -69,6 +116,10 @@ private:
     TRIAL
   };
 
+  enum {
+    maxRegularOrder = 20
+  };
+
   bool testAndTrialGridsAreIdentical() const;
   void precalculateElementSizesAndCenters();
   void getRegularOrders(int testElementIndex, int trialElementIndex,
@@ -85,12 +136,17 @@ private:
   shared_ptr<const std::vector<const Shapeset<BasisFunctionType> *>>
   m_trialShapesets;
   AccuracyOptionsEx m_accuracyOptions;
+  KernelScaleFunction m_kernelScale;
 
   std::vector<CoordinateType> m_testElementSizesSquared;
   std::vector<CoordinateType> m_trialElementSizesSquared;
   arma::Mat<CoordinateType> m_testElementCenters;
   arma::Mat<CoordinateType> m_trialElementCenters;
   CoordinateType m_averageElementSize;
+
+  // Number of queries for regular element pairs in which each quadrature
+  // order was selected; only updated in the tolerance-based mode
+  mutable tbb::atomic<size_t> m_regularOrderQueryCounts[maxRegularOrder + 1];
   /** \endcond */
 };
 
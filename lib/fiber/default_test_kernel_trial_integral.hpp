@@ -22,9 +22,29 @@
 #define fiber_default_test_kernel_trial_integral_hpp
 
 #include "test_kernel_trial_integral.hpp"
+#include "separable_integrand_term.hpp"
+
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/scalable_allocator.h>
+#include <vector>
 
 namespace Fiber {
 
+/** \cond PRIVATE */
+// Temporary arrays of the separable evaluation path, kept between calls so
+// that integrating an element pair does not allocate memory
+template <typename CoordinateType, typename KernelType, typename ResultType>
+struct SeparableIntegralWorkspace {
+  typedef std::vector<ResultType, tbb::scalable_allocator<ResultType>>
+  ResultVector;
+
+  std::vector<CoordinateType> testWeights, trialWeights;
+  ResultVector pointFactors, testFactors, trialFactors;
+  ResultVector test, intermediate, trial;
+  std::vector<KernelType, tbb::scalable_allocator<KernelType>> kernel;
+};
+/** \endcond */
+
 /** \ingroup weak_form_elements
  *  \brief Default implementation of the TestKernelTrialIntegral interface.
 
@@ -100,6 +120,51 @@ value of the <em>i</em>th
 trial point.
   \param[in] kernels
     Values of a collection of kernels at the (test point, trial point) pair.
+
+  The functor can also provide the method
+
+  \code{.cpp}
+    bool isInvariantUnderRigidMotions() const;
+  \endcode
+
+  returning true if the integrand is invariant under rigid motions of the
+  test and trial elements (see
+  TestKernelTrialIntegral::isInvariantUnderRigidMotions()). Otherwise the
+  integral is treated as not invariant.
+
+  Optionally, the functor can declare the integrand to be separable, i.e. of
+  the form
+  \f[ I(x, y) = \sum_{t=0}^{T-1} K_{k_t, r_t c_t}(x, y)\, f_t(x)\, g_t(y), \f]
+  where \f$K_{k, rc}\f$ is the component (r, c) of the kernel k and the
+  factors \f$f_t\f$ and \f$g_t\f$ depend only on the test function and the
+  geometry at the test point and on the trial function and the geometry at
+  the trial point, respectively. To do so, it should provide the methods
+
+  \code{.cpp}
+    int separableTermCount() const;
+
+    SeparableIntegrandTerm separableTerm(int term) const;
+
+    void evaluateSeparableTestFactors(
+            const ConstGeometricalDataSlice<CoordinateType>& testGeomData,
+            const CollectionOf1dSlicesOfConst3dArrays<BasisFunctionType>&
+testValues,
+            ResultType* factors) const;
+
+    void evaluateSeparableTrialFactors(
+            const ConstGeometricalDataSlice<CoordinateType>& trialGeomData,
+            const CollectionOf1dSlicesOfConst3dArrays<BasisFunctionType>&
+trialValues,
+            ResultType* factors) const;
+  \endcode
+
+  separableTermCount() returns \f$T\f$, separableTerm() the kernel component
+  \f$(k_t, r_t, c_t)\f$ of term \f$t\f$, and the last two methods store the
+  factors \f$f_t\f$ (including any complex conjugation of the test function)
+  and \f$g_t\f$ of all terms in <tt>factors[t]</tt>. The integrals are then
+  evaluated by dense matrix products instead of a loop over all quadrature
+  point and shape function pairs; evaluate() remains the reference definition
+  of the integrand.
  */
 template <typename IntegrandFunctor>
 class DefaultTestKernelTrialIntegral
@@ -117,12 +182,13 @@ public:
   typedef typename Base::KernelType KernelType;
   typedef typename Base::ResultType ResultType;
 
-  explicit DefaultTestKernelTrialIntegral(const IntegrandFunctor &functor)
-      : m_functor(functor) {}
+  explicit DefaultTestKernelTrialIntegral(const IntegrandFunctor &functor);
 
   virtual void addGeometricalDependencies(size_t &testGeomDeps,
                                           size_t &trialGeomDeps) const;
 
+  virtual bool isInvariantUnderRigidMotions() const;
+
   virtual void evaluateWithTensorQuadratureRule(
       const GeometricalData<CoordinateType> &testGeomData,
       const GeometricalData<CoordinateType> &trialGeomData,
@@ -144,6 +210,11 @@ public:
 
 private:
   IntegrandFunctor m_functor;
+  // Terms of a separable integrand grouped by their kernel components
+  std::vector<SeparableIntegrandTerm> m_separableComponents;
+  std::vector<std::vector<size_t>> m_separableGroups;
+  mutable tbb::enumerable_thread_specific<SeparableIntegralWorkspace<
+      CoordinateType, KernelType, ResultType>> m_separableWorkspace;
 };
 
 } // namespace Fiber
@@ -23,12 +23,329 @@
 
 #include "default_test_kernel_trial_integral.hpp"
 
+#include "collection_of_3d_arrays.hpp"
+#include "collection_of_4d_arrays.hpp"
 #include "geometrical_data.hpp"
+#include "has_mem_func.hpp"
 
+#include <algorithm>
+#include <boost/utility/enable_if.hpp>
 #include <cassert>
+#include <tbb/scalable_allocator.h>
+#include <vector>
 
 namespace Fiber {
 
+FIBER_HAS_MEM_FUNC(separableTermCount, hasSeparableTermCount);
+FIBER_HAS_MEM_FUNC(isInvariantUnderRigidMotions,
+                   hasIntegrandIsInvariantUnderRigidMotions);
+
+template <typename Functor> struct IntegrandFunctorIsSeparable {
+  static bool const value =
+      hasSeparableTermCount<Functor, int (Functor::*)() const>::value;
+};
+
+template <typename Functor>
+typename boost::enable_if<
+    hasIntegrandIsInvariantUnderRigidMotions<Functor,
+                                             bool (Functor::*)() const>,
+    bool>::type
+isIntegrandInvariantUnderRigidMotions(const Functor &functor) {
+  return functor.isInvariantUnderRigidMotions();
+}
+
+template <typename Functor>
+typename boost::disable_if<
+    hasIntegrandIsInvariantUnderRigidMotions<Functor,
+                                             bool (Functor::*)() const>,
+    bool>::type
+isIntegrandInvariantUnderRigidMotions(const Functor &functor) {
+  return false;
+}
+
+// Evaluate the factors of all terms of a separable integrand for all
+// functions and points of an element and multiply them by the point weights.
+// The factor of term t for function dof at point p is stored in
+// factors[dof + dofCount * (t + termCount * p)].
+template <typename Functor, typename Allocator>
+void evaluateSeparableFactors(
+    const Functor &functor, bool test,
+    const GeometricalData<typename Functor::CoordinateType> &geomData,
+    const CollectionOf3dArrays<typename Functor::BasisFunctionType> &values,
+    const std::vector<typename Functor::CoordinateType> &weights,
+    std::vector<typename Functor::ResultType, Allocator> &pointFactors,
+    std::vector<typename Functor::ResultType, Allocator> &factors) {
+  const size_t dofCount = values[0].extent(1);
+  const size_t pointCount = weights.size();
+  const size_t termCount = functor.separableTermCount();
+
+  pointFactors.resize(termCount);
+  factors.resize(dofCount * termCount * pointCount);
+  for (size_t point = 0; point < pointCount; ++point)
+    for (size_t dof = 0; dof < dofCount; ++dof) {
+      if (test)
+        functor.evaluateSeparableTestFactors(geomData.const_slice(point),
+                                             values.const_slice(dof, point),
+                                             &pointFactors[0]);
+      else
+        functor.evaluateSeparableTrialFactors(geomData.const_slice(point),
+                                              values.const_slice(dof, point),
+                                              &pointFactors[0]);
+      for (size_t term = 0; term < termCount; ++term)
+        factors[dof + dofCount * (term + termCount * point)] =
+            pointFactors[term] * weights[point];
+    }
+}
+
+// Group the terms of a separable integrand by their kernel components
+template <typename Functor>
+typename boost::enable_if<IntegrandFunctorIsSeparable<Functor>>::type
+groupSeparableTerms(const Functor &functor,
+                    std::vector<SeparableIntegrandTerm> &components,
+                    std::vector<std::vector<size_t>> &groups) {
+  components.clear();
+  groups.clear();
+  const size_t termCount = functor.separableTermCount();
+  for (size_t term = 0; term < termCount; ++term) {
+    const SeparableIntegrandTerm component = functor.separableTerm(term);
+    const size_t index =
+        std::find(components.begin(), components.end(), component) -
+        components.begin();
+    if (index == components.size()) {
+      components.push_back(component);
+      groups.push_back(std::vector<size_t>());
+    }
+    groups[index].push_back(term);
+  }
+}
+
+template <typename Functor>
+typename boost::disable_if<IntegrandFunctorIsSeparable<Functor>>::type
+groupSeparableTerms(const Functor &functor,
+                    std::vector<SeparableIntegrandTerm> &components,
+                    std::vector<std::vector<size_t>> &groups) {}
+
+// Evaluate the integrals of a separable integrand on a tensor quadrature rule
+// with matrix products. For each kernel component K the contribution of the
+// terms t multiplying it is sum_t F_t * K * G_t^T, where F_t (G_t) is the
+// matrix of weighted test (trial) factors of term t. Returns false if the
+// functor is not separable.
+template <typename Functor>
+typename boost::enable_if<IntegrandFunctorIsSeparable<Functor>, bool>::type
+evaluateSeparableIntegralWithTensorQuadratureRule(
+    const Functor &functor,
+    const std::vector<SeparableIntegrandTerm> &components,
+    const std::vector<std::vector<size_t>> &groups,
+    const GeometricalData<typename Functor::CoordinateType> &testGeomData,
+    const GeometricalData<typename Functor::CoordinateType> &trialGeomData,
+    const CollectionOf3dArrays<typename Functor::BasisFunctionType> &testValues,
+    const CollectionOf3dArrays<typename Functor::BasisFunctionType> &
+        trialValues,
+    const CollectionOf4dArrays<typename Functor::KernelType> &kernelValues,
+    const std::vector<typename Functor::CoordinateType> &testQuadWeights,
+    const std::vector<typename Functor::CoordinateType> &trialQuadWeights,
+    SeparableIntegralWorkspace<typename Functor::CoordinateType,
+                               typename Functor::KernelType,
+                               typename Functor::ResultType> &workspace,
+    arma::Mat<typename Functor::ResultType> &result) {
+  typedef typename Functor::KernelType KernelType;
+  typedef typename Functor::ResultType ResultType;
+
+  const size_t testDofCount = testValues[0].extent(1);
+  const size_t trialDofCount = trialValues[0].extent(1);
+  const size_t testPointCount = testQuadWeights.size();
+  const size_t trialPointCount = trialQuadWeights.size();
+  const size_t termCount = functor.separableTermCount();
+
+  workspace.testWeights.resize(testPointCount);
+  for (size_t point = 0; point < testPointCount; ++point)
+    workspace.testWeights[point] =
+        testGeomData.integrationElements(point) * testQuadWeights[point];
+  workspace.trialWeights.resize(trialPointCount);
+  for (size_t point = 0; point < trialPointCount; ++point)
+    workspace.trialWeights[point] =
+        trialGeomData.integrationElements(point) * trialQuadWeights[point];
+
+  evaluateSeparableFactors(functor, true, testGeomData, testValues,
+                           workspace.testWeights, workspace.pointFactors,
+                           workspace.testFactors);
+  evaluateSeparableFactors(functor, false, trialGeomData, trialValues,
+                           workspace.trialWeights, workspace.pointFactors,
+                           workspace.trialFactors);
+  const ResultType *testFactors = &workspace.testFactors[0];
+  const ResultType *trialFactors = &workspace.trialFactors[0];
+
+  result.fill(0);
+
+  for (size_t c = 0; c < components.size(); ++c) {
+    const SeparableIntegrandTerm &component = components[c];
+    const std::vector<size_t> &terms = groups[c];
+    const size_t groupSize = terms.size();
+
+    // Values of the kernel component at all (test point, trial point) pairs.
+    // Scalar kernels are used in place.
+    const _4dArray<KernelType> &kernel = kernelValues[component.kernelIndex];
+    assert(kernel.extent(2) == testPointCount);
+    assert(kernel.extent(3) == trialPointCount);
+    KernelType *kernelData = const_cast<KernelType *>(kernel.begin());
+    if (kernel.extent(0) != 1 || kernel.extent(1) != 1) {
+      workspace.kernel.resize(testPointCount * trialPointCount);
+      for (size_t trialPoint = 0; trialPoint < trialPointCount; ++trialPoint)
+        for (size_t testPoint = 0; testPoint < testPointCount; ++testPoint)
+          workspace.kernel[testPoint + testPointCount * trialPoint] = kernel(
+              component.row, component.column, testPoint, trialPoint);
+      kernelData = &workspace.kernel[0];
+    }
+    arma::Mat<KernelType> matKernel(kernelData, testPointCount,
+                                    trialPointCount, false /* don't copy */,
+                                    true);
+
+    // Test factors of the group, row dof + testDofCount * j belonging to
+    // term j of the group
+    workspace.test.resize(testDofCount * groupSize * testPointCount);
+    arma::Mat<ResultType> matTest(&workspace.test[0], testDofCount * groupSize,
+                                  testPointCount, false, true);
+    for (size_t point = 0; point < testPointCount; ++point)
+      for (size_t j = 0; j < groupSize; ++j)
+        for (size_t dof = 0; dof < testDofCount; ++dof)
+          matTest(dof + testDofCount * j, point) =
+              testFactors[dof + testDofCount * (terms[j] + termCount * point)];
+
+    // Tmp = Test * Kernel, read afterwards as a matrix with testDofCount
+    // rows and column j + groupSize * trialPoint belonging to term j
+    workspace.intermediate.resize(testDofCount * groupSize * trialPointCount);
+    arma::Mat<ResultType> matTmp(&workspace.intermediate[0],
+                                 testDofCount * groupSize, trialPointCount,
+                                 false, true);
+    matTmp = matTest * matKernel;
+    arma::Mat<ResultType> matTmpByTerm(&workspace.intermediate[0],
+                                       testDofCount,
+                                       groupSize * trialPointCount, false,
+                                       true);
+
+    // Result += Tmp * Trial^T
+    workspace.trial.resize(trialDofCount * groupSize * trialPointCount);
+    arma::Mat<ResultType> matTrial(&workspace.trial[0], trialDofCount,
+                                   groupSize * trialPointCount, false, true);
+    for (size_t point = 0; point < trialPointCount; ++point)
+      for (size_t j = 0; j < groupSize; ++j)
+        for (size_t dof = 0; dof < trialDofCount; ++dof)
+          matTrial(dof, j + groupSize * point) =
+              trialFactors[dof +
+                           trialDofCount * (terms[j] + termCount * point)];
+    result += matTmpByTerm * matTrial.st();
+  }
+  return true;
+}
+
+template <typename Functor>
+typename boost::disable_if<IntegrandFunctorIsSeparable<Functor>, bool>::type
+evaluateSeparableIntegralWithTensorQuadratureRule(
+    const Functor &functor,
+    const std::vector<SeparableIntegrandTerm> &components,
+    const std::vector<std::vector<size_t>> &groups,
+    const GeometricalData<typename Functor::CoordinateType> &testGeomData,
+    const GeometricalData<typename Functor::CoordinateType> &trialGeomData,
+    const CollectionOf3dArrays<typename Functor::BasisFunctionType> &testValues,
+    const CollectionOf3dArrays<typename Functor::BasisFunctionType> &
+        trialValues,
+    const CollectionOf4dArrays<typename Functor::KernelType> &kernelValues,
+    const std::vector<typename Functor::CoordinateType> &testQuadWeights,
+    const std::vector<typename Functor::CoordinateType> &trialQuadWeights,
+    SeparableIntegralWorkspace<typename Functor::CoordinateType,
+                               typename Functor::KernelType,
+                               typename Functor::ResultType> &workspace,
+    arma::Mat<typename Functor::ResultType> &result) {
+  return false;
+}
+
+// Evaluate the integrals of a separable integrand on a nontensor quadrature
+// rule with a single matrix product. Returns false if the functor is not
+// separable.
+template <typename Functor>
+typename boost::enable_if<IntegrandFunctorIsSeparable<Functor>, bool>::type
+evaluateSeparableIntegralWithNontensorQuadratureRule(
+    const Functor &functor,
+    const GeometricalData<typename Functor::CoordinateType> &testGeomData,
+    const GeometricalData<typename Functor::CoordinateType> &trialGeomData,
+    const CollectionOf3dArrays<typename Functor::BasisFunctionType> &testValues,
+    const CollectionOf3dArrays<typename Functor::BasisFunctionType> &
+        trialValues,
+    const CollectionOf3dArrays<typename Functor::KernelType> &kernelValues,
+    const std::vector<typename Functor::CoordinateType> &quadWeights,
+    SeparableIntegralWorkspace<typename Functor::CoordinateType,
+                               typename Functor::KernelType,
+                               typename Functor::ResultType> &workspace,
+    arma::Mat<typename Functor::ResultType> &result) {
+  typedef typename Functor::ResultType ResultType;
+
+  const size_t testDofCount = testValues[0].extent(1);
+  const size_t trialDofCount = trialValues[0].extent(1);
+  const size_t pointCount = quadWeights.size();
+  const size_t termCount = functor.separableTermCount();
+
+  // The test factors carry all weights, the trial factors none
+  workspace.testWeights.resize(pointCount);
+  for (size_t point = 0; point < pointCount; ++point)
+    workspace.testWeights[point] = testGeomData.integrationElements(point) *
+                                   trialGeomData.integrationElements(point) *
+                                   quadWeights[point];
+  workspace.trialWeights.assign(pointCount, 1.);
+
+  evaluateSeparableFactors(functor, true, testGeomData, testValues,
+                           workspace.testWeights, workspace.pointFactors,
+                           workspace.testFactors);
+  evaluateSeparableFactors(functor, false, trialGeomData, trialValues,
+                           workspace.trialWeights, workspace.pointFactors,
+                           workspace.trialFactors);
+
+  // Multiply the test factors by the kernel components of their terms
+  for (size_t term = 0; term < termCount; ++term) {
+    const SeparableIntegrandTerm component = functor.separableTerm(term);
+    for (size_t point = 0; point < pointCount; ++point) {
+      const typename Functor::KernelType kernelValue =
+          kernelValues[component.kernelIndex](component.row, component.column,
+                                              point);
+      ResultType *factors =
+          &workspace.testFactors[testDofCount * (term + termCount * point)];
+      for (size_t dof = 0; dof < testDofCount; ++dof)
+        factors[dof] *= kernelValue;
+    }
+  }
+
+  arma::Mat<ResultType> matTest(&workspace.testFactors[0], testDofCount,
+                                termCount * pointCount, false, true);
+  arma::Mat<ResultType> matTrial(&workspace.trialFactors[0], trialDofCount,
+                                 termCount * pointCount, false, true);
+  result = matTest * matTrial.st();
+  return true;
+}
+
+template <typename Functor>
+typename boost::disable_if<IntegrandFunctorIsSeparable<Functor>, bool>::type
+evaluateSeparableIntegralWithNontensorQuadratureRule(
+    const Functor &functor,
+    const GeometricalData<typename Functor::CoordinateType> &testGeomData,
+    const GeometricalData<typename Functor::CoordinateType> &trialGeomData,
+    const CollectionOf3dArrays<typename Functor::BasisFunctionType> &testValues,
+    const CollectionOf3dArrays<typename Functor::BasisFunctionType> &
+        trialValues,
+    const CollectionOf3dArrays<typename Functor::KernelType> &kernelValues,
+    const std::vector<typename Functor::CoordinateType> &quadWeights,
+    SeparableIntegralWorkspace<typename Functor::CoordinateType,
+                               typename Functor::KernelType,
+                               typename Functor::ResultType> &workspace,
+    arma::Mat<typename Functor::ResultType> &result) {
+  return false;
+}
+
+template <typename IntegrandFunctor>
+DefaultTestKernelTrialIntegral<IntegrandFunctor>::
+    DefaultTestKernelTrialIntegral(const IntegrandFunctor &functor)
+    : m_functor(functor) {
+  groupSeparableTerms(m_functor, m_separableComponents, m_separableGroups);
+}
+
 template <typename IntegrandFunctor>
 void
 DefaultTestKernelTrialIntegral<IntegrandFunctor>::addGeometricalDependencies(
@@ -39,6 +356,12 @@ DefaultTestKernelTrialIntegral<IntegrandFunctor>::addGeometricalDependencies(
   m_functor.addGeometricalDependencies(testGeomDeps, trialGeomDeps);
 }
 
+template <typename IntegrandFunctor>
+bool DefaultTestKernelTrialIntegral<
+    IntegrandFunctor>::isInvariantUnderRigidMotions() const {
+  return isIntegrandInvariantUnderRigidMotions(m_functor);
+}
+
 template <typename IntegrandFunctor>
 void DefaultTestKernelTrialIntegral<IntegrandFunctor>::
     evaluateWithTensorQuadratureRule(
@@ -74,6 +397,13 @@ void DefaultTestKernelTrialIntegral<IntegrandFunctor>::
 
   // Integrate
 
+  if (evaluateSeparableIntegralWithTensorQuadratureRule(
+          m_functor, m_separableComponents, m_separableGroups, testGeomData,
+          trialGeomData, testValues, trialValues, kernelValues,
+          testQuadWeights, trialQuadWeights, m_separableWorkspace.local(),
+          result))
+    return;
+
   for (size_t trialDof = 0; trialDof < trialDofCount; ++trialDof)
     for (size_t testDof = 0; testDof < testDofCount; ++testDof) {
       ResultType sum = 0.;
@@ -128,6 +458,11 @@ void DefaultTestKernelTrialIntegral<IntegrandFunctor>::
 
   // Integrate
 
+  if (evaluateSeparableIntegralWithNontensorQuadratureRule(
+          m_functor, testGeomData, trialGeomData, testValues, trialValues,
+          kernelValues, quadWeights, m_separableWorkspace.local(), result))
+    return;
+
   for (size_t trialDof = 0; trialDof < trialDofCount; ++trialDof)
     for (size_t testDof = 0; testDof < testDofCount; ++testDof) {
       ResultType sum = 0.;
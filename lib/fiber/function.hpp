@@ -86,6 +86,14 @@ public:
    */
   virtual void evaluate(const GeometricalData<CoordinateType> &geomData,
                         arma::Mat<ValueType> &result) const = 0;
+
+  /** \brief Return true if evaluate() may be called concurrently from
+   *  several threads.
+   *
+   *  The default implementation returns true. Functions relying on
+   *  non-reentrant resources, such as callbacks into an interpreter, should
+   *  override it to return false; they are then evaluated serially. */
+  virtual bool isThreadSafe() const { return true; }
 };
 
 } // namespace Fiber
@@ -0,0 +1,408 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef fiber_geometrical_data_arena_hpp
+#define fiber_geometrical_data_arena_hpp
+
+#include "../common/common.hpp"
+
+#include "geometrical_data.hpp"
+#include "shared_ptr.hpp"
+
+#include "../common/armadillo_fwd.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/make_shared.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/weak_ptr.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/cache_aligned_allocator.h>
+#include <tbb/mutex.h>
+#include <tbb/parallel_for.h>
+
+namespace Fiber {
+
+/** \cond FORWARD_DECL */
+template <typename CoordinateType> class RawGridGeometry;
+/** \endcond */
+
+/** \brief Geometrical data of all elements of a grid at a fixed set of
+ *  local points, stored in a single arena.
+ *
+ *  Each type of data (global coordinates, integration elements, normals,
+ *  Jacobians and their inverses) is stored for all elements in a separate
+ *  contiguous, cache-line aligned block of a single array. The data are
+ *  calculated in parallel on construction.
+ *
+ *  Objects of this class are normally obtained from the
+ *  GeometricalDataArenaCache of a RawGridGeometry, so that they are shared
+ *  by all integrators working on the same grid with the same quadrature
+ *  points. */
+template <typename CoordinateType> class GeometricalDataArena {
+public:
+  template <typename GeometryFactory>
+  GeometricalDataArena(const RawGridGeometry<CoordinateType> &rawGeometry,
+                       const GeometryFactory &geometryFactory,
+                       const arma::Mat<CoordinateType> &localPoints,
+                       size_t geomDeps);
+
+  int elementCount() const { return m_elementCount; }
+
+  /** \brief Make \p geomData refer to the data of a given element.
+   *
+   *  On output, the arrays of \p geomData are read-only views of the data
+   *  stored in the arena; they remain valid as long as the arena exists.
+   *  \p geomData must not be resized until it is bound to another element
+   *  or destroyed. */
+  void bindElementData(int elementIndex,
+                       GeometricalData<CoordinateType> &geomData) const;
+
+private:
+  GeometricalDataArena(const GeometricalDataArena &);
+  GeometricalDataArena &operator=(const GeometricalDataArena &);
+
+  enum Field {
+    GLOBALS_FIELD,
+    INTEGRATION_ELEMENTS_FIELD,
+    NORMALS_FIELD,
+    JACOBIANS_TRANSPOSED_FIELD,
+    JACOBIAN_INVERSES_TRANSPOSED_FIELD,
+    fieldCount
+  };
+
+  static void getExtents(const GeometricalData<CoordinateType> &geomData,
+                         size_t extents[fieldCount][3]);
+  static const CoordinateType *
+  fieldData(const GeometricalData<CoordinateType> &geomData, int field);
+  void storeElementData(int elementIndex,
+                        const GeometricalData<CoordinateType> &geomData);
+  CoordinateType *fieldBegin(int field, int elementIndex) const {
+    return const_cast<CoordinateType *>(&m_data[m_fieldOffsets[field]]) +
+           elementIndex * m_fieldSizes[field];
+  }
+
+private:
+  int m_elementCount;
+  bool m_hasDomainIndices;
+  // Shape of the array holding a given type of data for a single element
+  size_t m_extents[fieldCount][3];
+  size_t m_fieldSizes[fieldCount];
+  size_t m_fieldOffsets[fieldCount];
+  std::vector<CoordinateType, tbb::cache_aligned_allocator<CoordinateType>>
+      m_data;
+  std::vector<int> m_domainIndices;
+};
+
+/** \brief Cache of GeometricalDataArena objects of a single grid.
+ *
+ *  Arenas are identified by the local points at which the data are
+ *  evaluated and the types of data requested. The cache only holds weak
+ *  references: an arena lives as long as a caller, typically an integrator,
+ *  holds a shared pointer to it. Entries whose arenas have been released are
+ *  removed on the next insertion.
+ *
+ *  The lookup table is protected by a mutex, but arenas are calculated
+ *  without holding it; if two threads request the same missing arena
+ *  simultaneously, both calculate it and only one of the results is kept. */
+template <typename CoordinateType> class GeometricalDataArenaCache {
+public:
+  GeometricalDataArenaCache() {}
+
+  /** \brief Copy constructor.
+   *
+   *  The copy starts empty. */
+  GeometricalDataArenaCache(const GeometricalDataArenaCache &) {}
+
+  GeometricalDataArenaCache &operator=(const GeometricalDataArenaCache &) {
+    return *this;
+  }
+
+  /** \brief Return the arena with data of type \p geomDeps at the points
+   *  \p localPoints of each element of \p rawGeometry, calculating it if
+   *  necessary. */
+  template <typename GeometryFactory>
+  shared_ptr<const GeometricalDataArena<CoordinateType>>
+  arena(const RawGridGeometry<CoordinateType> &rawGeometry,
+        const GeometryFactory &geometryFactory,
+        const arma::Mat<CoordinateType> &localPoints, size_t geomDeps) {
+    typedef shared_ptr<const GeometricalDataArena<CoordinateType>> ArenaPtr;
+    Key key(localPoints, geomDeps);
+    {
+      tbb::mutex::scoped_lock lock(m_mutex);
+      typename ArenaMap::const_iterator it = m_arenas.find(key);
+      if (it != m_arenas.end()) {
+        ArenaPtr existingArena = it->second.lock();
+        if (existingArena)
+          return existingArena;
+      }
+    }
+    ArenaPtr newArena =
+        boost::make_shared<GeometricalDataArena<CoordinateType>>(
+            rawGeometry, geometryFactory, localPoints, geomDeps);
+
+    tbb::mutex::scoped_lock lock(m_mutex);
+    removeExpiredArenas();
+    WeakArenaPtr &entry = m_arenas[key];
+    ArenaPtr existingArena = entry.lock();
+    if (existingArena)
+      return existingArena; // another thread was faster
+    entry = newArena;
+    return newArena;
+  }
+
+  /** \brief Number of cached arenas still in use. */
+  size_t size() const {
+    tbb::mutex::scoped_lock lock(m_mutex);
+    size_t result = 0;
+    for (typename ArenaMap::const_iterator it = m_arenas.begin();
+         it != m_arenas.end(); ++it)
+      if (!it->second.expired())
+        ++result;
+    return result;
+  }
+
+  /** \brief Forget all cached arenas.
+   *
+   *  Arenas still referenced by integrators stay alive until these are
+   *  destroyed, but are no longer returned by arena(). */
+  void clear() {
+    tbb::mutex::scoped_lock lock(m_mutex);
+    m_arenas.clear();
+  }
+
+private:
+  struct Key {
+    Key(const arma::Mat<CoordinateType> &localPoints, size_t geomDeps_)
+        : pointDim(localPoints.n_rows),
+          points(localPoints.begin(), localPoints.end()),
+          geomDeps(geomDeps_) {}
+
+    bool operator==(const Key &other) const {
+      return pointDim == other.pointDim && geomDeps == other.geomDeps &&
+             points == other.points;
+    }
+
+    size_t pointDim;
+    std::vector<CoordinateType> points;
+    size_t geomDeps;
+  };
+
+  struct KeyHasher {
+    size_t operator()(const Key &key) const {
+      std::hash<CoordinateType> hasher;
+      size_t result = key.geomDeps + 64 * key.pointDim;
+      for (size_t i = 0; i < key.points.size(); ++i)
+        result = 31 * result + hasher(key.points[i]);
+      return result;
+    }
+  };
+
+  typedef boost::weak_ptr<const GeometricalDataArena<CoordinateType>>
+      WeakArenaPtr;
+  typedef boost::unordered_map<Key, WeakArenaPtr, KeyHasher> ArenaMap;
+
+  void removeExpiredArenas() {
+    for (typename ArenaMap::iterator it = m_arenas.begin();
+         it != m_arenas.end();)
+      if (it->second.expired())
+        it = m_arenas.erase(it);
+      else
+        ++it;
+  }
+
+  ArenaMap m_arenas;
+  mutable tbb::mutex m_mutex;
+};
+
+// Implementation
+
+namespace detail {
+
+// Replace an array by a view of external memory. The arrays of
+// GeometricalData cannot be rebound by assignment, which copies the data.
+template <typename Array, typename T>
+inline void bindMatrix(Array &array, T *data, size_t rows, size_t cols) {
+  array.~Array();
+  new (&array) Array(data, rows, cols, false /* copy_aux_mem */,
+                     true /* strict */);
+}
+
+template <typename T>
+inline void bindRow(arma::Row<T> &array, T *data, size_t cols) {
+  typedef arma::Row<T> Array;
+  array.~Array();
+  new (&array) Array(data, cols, false /* copy_aux_mem */, true /* strict */);
+}
+
+template <typename T>
+inline void bind3dArray(_3dArray<T> &array, T *data, const size_t *extents) {
+  typedef _3dArray<T> Array;
+  array.~Array();
+  new (&array) Array(extents[0], extents[1], extents[2], data,
+                     true /* strict */);
+}
+
+} // namespace detail
+
+template <typename CoordinateType>
+template <typename GeometryFactory>
+GeometricalDataArena<CoordinateType>::GeometricalDataArena(
+    const RawGridGeometry<CoordinateType> &rawGeometry,
+    const GeometryFactory &geometryFactory,
+    const arma::Mat<CoordinateType> &localPoints, size_t geomDeps)
+    : m_elementCount(rawGeometry.elementCount()),
+      m_hasDomainIndices(geomDeps & DOMAIN_INDEX) {
+  typedef typename GeometryFactory::Geometry Geometry;
+
+  // The data of the first element determine the layout of the arena
+  GeometricalData<CoordinateType> firstElementData;
+  if (m_elementCount > 0) {
+    std::unique_ptr<Geometry> geometry = geometryFactory.make();
+    rawGeometry.setupGeometry(0, *geometry);
+    geometry->getData(geomDeps, localPoints, firstElementData);
+  }
+  getExtents(firstElementData, m_extents);
+
+  // Blocks of different fields start at cache-line boundaries
+  const size_t alignment = 64 / sizeof(CoordinateType);
+  size_t totalSize = 0;
+  for (int field = 0; field < fieldCount; ++field) {
+    m_fieldSizes[field] =
+        m_extents[field][0] * m_extents[field][1] * m_extents[field][2];
+    m_fieldOffsets[field] = totalSize;
+    totalSize += (m_fieldSizes[field] * m_elementCount + alignment - 1) /
+                 alignment * alignment;
+  }
+  m_data.resize(totalSize);
+  if (m_hasDomainIndices)
+    m_domainIndices = rawGeometry.domainIndices();
+  if (m_elementCount == 0)
+    return;
+  storeElementData(0, firstElementData);
+
+  tbb::parallel_for(tbb::blocked_range<int>(1, m_elementCount),
+                    [&](const tbb::blocked_range<int> &r) {
+    std::unique_ptr<Geometry> geometry = geometryFactory.make();
+    GeometricalData<CoordinateType> geomData;
+    for (int e = r.begin(); e != r.end(); ++e) {
+      rawGeometry.setupGeometry(e, *geometry);
+      geometry->getData(geomDeps, localPoints, geomData);
+      storeElementData(e, geomData);
+    }
+  });
+}
+
+template <typename CoordinateType>
+void GeometricalDataArena<CoordinateType>::getExtents(
+    const GeometricalData<CoordinateType> &geomData,
+    size_t extents[fieldCount][3]) {
+  extents[GLOBALS_FIELD][0] = geomData.globals.n_rows;
+  extents[GLOBALS_FIELD][1] = geomData.globals.n_cols;
+  extents[GLOBALS_FIELD][2] = 1;
+  extents[INTEGRATION_ELEMENTS_FIELD][0] = 1;
+  extents[INTEGRATION_ELEMENTS_FIELD][1] = geomData.integrationElements.n_cols;
+  extents[INTEGRATION_ELEMENTS_FIELD][2] = 1;
+  extents[NORMALS_FIELD][0] = geomData.normals.n_rows;
+  extents[NORMALS_FIELD][1] = geomData.normals.n_cols;
+  extents[NORMALS_FIELD][2] = 1;
+  for (int dim = 0; dim < 3; ++dim) {
+    extents[JACOBIANS_TRANSPOSED_FIELD][dim] =
+        geomData.jacobiansTransposed.extent(dim);
+    extents[JACOBIAN_INVERSES_TRANSPOSED_FIELD][dim] =
+        geomData.jacobianInversesTransposed.extent(dim);
+  }
+}
+
+template <typename CoordinateType>
+const CoordinateType *GeometricalDataArena<CoordinateType>::fieldData(
+    const GeometricalData<CoordinateType> &geomData, int field) {
+  switch (field) {
+  case GLOBALS_FIELD:
+    return geomData.globals.memptr();
+  case INTEGRATION_ELEMENTS_FIELD:
+    return geomData.integrationElements.memptr();
+  case NORMALS_FIELD:
+    return geomData.normals.memptr();
+  case JACOBIANS_TRANSPOSED_FIELD:
+    return geomData.jacobiansTransposed.begin();
+  default:
+    return geomData.jacobianInversesTransposed.begin();
+  }
+}
+
+template <typename CoordinateType>
+void GeometricalDataArena<CoordinateType>::storeElementData(
+    int elementIndex, const GeometricalData<CoordinateType> &geomData) {
+  size_t extents[fieldCount][3];
+  getExtents(geomData, extents);
+  for (int field = 0; field < fieldCount; ++field) {
+    if (!std::equal(extents[field], extents[field] + 3, m_extents[field]))
+      throw std::runtime_error(
+          "GeometricalDataArena::GeometricalDataArena(): "
+          "all elements must provide geometrical data of the same shape");
+    if (m_fieldSizes[field] > 0) {
+      const CoordinateType *source = fieldData(geomData, field);
+      std::copy(source, source + m_fieldSizes[field],
+                fieldBegin(field, elementIndex));
+    }
+  }
+}
+
+template <typename CoordinateType>
+void GeometricalDataArena<CoordinateType>::bindElementData(
+    int elementIndex, GeometricalData<CoordinateType> &geomData) const {
+  assert(elementIndex >= 0 && elementIndex < m_elementCount);
+  if (m_fieldSizes[GLOBALS_FIELD] > 0)
+    detail::bindMatrix(geomData.globals,
+                       fieldBegin(GLOBALS_FIELD, elementIndex),
+                       m_extents[GLOBALS_FIELD][0],
+                       m_extents[GLOBALS_FIELD][1]);
+  if (m_fieldSizes[INTEGRATION_ELEMENTS_FIELD] > 0)
+    detail::bindRow(geomData.integrationElements,
+                    fieldBegin(INTEGRATION_ELEMENTS_FIELD, elementIndex),
+                    m_extents[INTEGRATION_ELEMENTS_FIELD][1]);
+  if (m_fieldSizes[NORMALS_FIELD] > 0)
+    detail::bindMatrix(geomData.normals,
+                       fieldBegin(NORMALS_FIELD, elementIndex),
+                       m_extents[NORMALS_FIELD][0],
+                       m_extents[NORMALS_FIELD][1]);
+  if (m_fieldSizes[JACOBIANS_TRANSPOSED_FIELD] > 0)
+    detail::bind3dArray(geomData.jacobiansTransposed,
+                        fieldBegin(JACOBIANS_TRANSPOSED_FIELD, elementIndex),
+                        m_extents[JACOBIANS_TRANSPOSED_FIELD]);
+  if (m_fieldSizes[JACOBIAN_INVERSES_TRANSPOSED_FIELD] > 0)
+    detail::bind3dArray(
+        geomData.jacobianInversesTransposed,
+        fieldBegin(JACOBIAN_INVERSES_TRANSPOSED_FIELD, elementIndex),
+        m_extents[JACOBIAN_INVERSES_TRANSPOSED_FIELD]);
+  if (m_hasDomainIndices)
+    geomData.domainIndex = m_domainIndices[elementIndex];
+}
+
+} // namespace Fiber
+
+#endif
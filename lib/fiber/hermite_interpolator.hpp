@@ -4,17 +4,22 @@
 #include "../common/common.hpp"
 #include "scalar_traits.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 #include <vector>
 
+#include <tbb/cache_aligned_allocator.h>
+
 namespace Fiber {
 
 template <typename ValueType> class HermiteInterpolator {
 public:
   typedef typename ScalarTraits<ValueType>::RealType CoordinateType;
 
-  HermiteInterpolator() : m_start(0.), m_end(0.), m_n(0), m_interval(0.) {}
+  HermiteInterpolator()
+      : m_start(0.), m_end(0.), m_n(0), m_interval(0.), m_inverseInterval(0.) {
+  }
 
   CoordinateType rangeStart() { return m_start; }
   CoordinateType rangeEnd() { return m_end; }
@@ -36,22 +41,60 @@ public:
     m_end = end;
     m_n = values.size();
     m_interval = (end - start) / (m_n - 1);
-    m_values = values;
-    m_derivatives = derivatives;
+    m_inverseInterval = 1. / m_interval;
+    // Values and derivatives (the latter scaled by the interval length) are
+    // stored interleaved, so that the data needed to interpolate on an
+    // interval occupy four consecutive entries
+    m_table.resize(2 * m_n);
+    for (int i = 0; i < m_n; ++i) {
+      m_table[2 * i] = values[i];
+      m_table[2 * i + 1] = derivatives[i] * m_interval;
+    }
   }
 
   ValueType evaluate(CoordinateType x) const {
     assert(x >= m_start && x <= m_end);
-    CoordinateType fpn;
-    const CoordinateType t = std::modf((x - m_start) / m_interval, &fpn);
-    const int n = int(fpn);
-    assert(n >= 0 && n < m_n);
-    assert(t >= 0 && t <= 1);
-    // Adapted from the chfev routine from SLATEC
-    const ValueType f_1 = m_values[n];
-    const ValueType f_2 = m_values[n + 1];
-    const ValueType d_1 = m_derivatives[n] * m_interval;
-    const ValueType d_2 = m_derivatives[n + 1] * m_interval;
+    const CoordinateType s = (x - m_start) * m_inverseInterval;
+    // The end of the range belongs to the last interval
+    const int n = std::min(static_cast<int>(s), m_n - 2);
+    const int index = 2 * n;
+    return interpolate(m_table[index], m_table[index + 1], m_table[index + 2],
+                       m_table[index + 3], s - n);
+  }
+
+  /** \brief Evaluate the interpolant at the \p count points \p x, storing
+   *  the results in \p result.
+   *
+   *  All points must lie in the interpolation range. The loop over the
+   *  points contains no branches or calls, so it can be vectorized with
+   *  gather loads from the table. */
+  void evaluate(const CoordinateType *x, size_t count,
+                ValueType *result) const {
+    evaluate(&m_table[0], m_start, m_inverseInterval, m_n - 2, x, count,
+             result);
+  }
+
+private:
+  /** \cond PRIVATE */
+  // The restrict qualifiers let the compiler vectorize the loop
+  static void evaluate(const ValueType *__restrict table, CoordinateType start,
+                       CoordinateType inverseInterval, int lastInterval,
+                       const CoordinateType *__restrict x, size_t count,
+                       ValueType *__restrict result) {
+    for (size_t i = 0; i < count; ++i) {
+      const CoordinateType s = (x[i] - start) * inverseInterval;
+      const int n = std::min(static_cast<int>(s), lastInterval);
+      const int index = 2 * n;
+      result[i] = interpolate(table[index], table[index + 1],
+                              table[index + 2], table[index + 3], s - n);
+    }
+  }
+
+  // Value at t in [0, 1] of the cubic with values f_1, f_2 and derivatives
+  // d_1, d_2 (in units of the interval length) at t = 0 and t = 1.
+  // Adapted from the chfev routine from SLATEC
+  static ValueType interpolate(ValueType f_1, ValueType d_1, ValueType f_2,
+                               ValueType d_2, CoordinateType t) {
     const ValueType Delta = f_2 - f_1;
     const ValueType Delta_1 = d_1 - Delta;
     const ValueType Delta_2 = d_2 - Delta;
@@ -60,13 +103,11 @@ public:
     return f_1 + t * (d_1 + t * (c_2 + t * c_3));
   }
 
-private:
-  /** \cond PRIVATE */
   CoordinateType m_start, m_end;
   int m_n;
   CoordinateType m_interval;
-  std::vector<ValueType> m_values;
-  std::vector<ValueType> m_derivatives;
+  CoordinateType m_inverseInterval;
+  std::vector<ValueType, tbb::cache_aligned_allocator<ValueType>> m_table;
   /** \endcond */
 };
 
@@ -21,17 +21,22 @@
 #include "initialize_interpolator_for_modified_helmholtz_3d_kernels.hpp"
 #include "explicit_instantiation.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace Fiber {
 
+namespace {
+
 template <typename ValueType>
-void initializeInterpolatorForModifiedHelmholtz3dKernels(
-    ValueType waveNumber, typename ScalarTraits<ValueType>::RealType maxDist,
-    int interpPtsPerWavelength, HermiteInterpolator<ValueType> &interpolator) {
+void fillInterpolator(ValueType waveNumber,
+                      typename ScalarTraits<ValueType>::RealType maxDist,
+                      int pointCount,
+                      HermiteInterpolator<ValueType> &interpolator) {
   typedef typename ScalarTraits<ValueType>::RealType CoordinateType;
   const CoordinateType minDist = 0.;
-  const CoordinateType wavelength = 2. * M_PI / std::abs(waveNumber);
-  const int pointCount =
-      (maxDist - minDist) / wavelength * interpPtsPerWavelength + 1;
+  pointCount = std::max(pointCount, 2);
   std::vector<ValueType> values(pointCount), derivatives(pointCount);
   for (int i = 0; i < pointCount; ++i) {
     CoordinateType dist =
@@ -43,10 +48,51 @@ void initializeInterpolatorForModifiedHelmholtz3dKernels(
   interpolator.initialize(minDist, maxDist, values, derivatives);
 }
 
+} // namespace
+
+template <typename ValueType>
+void initializeInterpolatorForModifiedHelmholtz3dKernels(
+    ValueType waveNumber, typename ScalarTraits<ValueType>::RealType maxDist,
+    int interpPtsPerWavelength, HermiteInterpolator<ValueType> &interpolator) {
+  typedef typename ScalarTraits<ValueType>::RealType CoordinateType;
+  if (interpPtsPerWavelength <= 0) {
+    initializeInterpolatorForModifiedHelmholtz3dKernels(
+        waveNumber, maxDist, interpolator,
+        100 * std::numeric_limits<CoordinateType>::epsilon());
+    return;
+  }
+  const CoordinateType minDist = 0.;
+  const CoordinateType wavelength = 2. * M_PI / std::abs(waveNumber);
+  const int pointCount =
+      (maxDist - minDist) / wavelength * interpPtsPerWavelength + 1;
+  fillInterpolator(waveNumber, maxDist, pointCount, interpolator);
+}
+
+template <typename ValueType>
+void initializeInterpolatorForModifiedHelmholtz3dKernels(
+    ValueType waveNumber, typename ScalarTraits<ValueType>::RealType maxDist,
+    HermiteInterpolator<ValueType> &interpolator,
+    typename ScalarTraits<ValueType>::RealType relativeAccuracy) {
+  typedef typename ScalarTraits<ValueType>::RealType CoordinateType;
+  if (relativeAccuracy <= 0.)
+    throw std::invalid_argument(
+        "initializeInterpolatorForModifiedHelmholtz3dKernels(): "
+        "relativeAccuracy must be positive");
+  // Largest interval length h with (h |k|)^4 / 384 <= relativeAccuracy
+  const CoordinateType interval =
+      std::pow(384 * relativeAccuracy, CoordinateType(0.25)) /
+      std::abs(waveNumber);
+  const int pointCount = std::ceil(maxDist / interval) + 1;
+  fillInterpolator(waveNumber, maxDist, pointCount, interpolator);
+}
+
 #define INSTANTIATE_FUNCTION(KERNEL)                                           \
   template void initializeInterpolatorForModifiedHelmholtz3dKernels(           \
       KERNEL, ScalarTraits<KERNEL>::RealType, int,                             \
-      HermiteInterpolator<KERNEL> &);
+      HermiteInterpolator<KERNEL> &);                                          \
+  template void initializeInterpolatorForModifiedHelmholtz3dKernels(           \
+      KERNEL, ScalarTraits<KERNEL>::RealType, HermiteInterpolator<KERNEL> &,   \
+      ScalarTraits<KERNEL>::RealType);
 
 FIBER_ITERATE_OVER_KERNEL_TYPES(INSTANTIATE_FUNCTION);
 
@@ -6,11 +6,31 @@
 
 namespace Fiber {
 
+/** \brief Initialize \p interpolator to approximate exp(-waveNumber * r) for
+ *  r in [0, maxDist].
+ *
+ *  The table contains \p interpPtsPerWavelength points per wavelength. If
+ *  \p interpPtsPerWavelength is not positive, the density is chosen
+ *  automatically as in the overload taking a target accuracy, with the
+ *  accuracy set to 100 times the machine epsilon of the coordinate type. */
 template <typename ValueType>
 void initializeInterpolatorForModifiedHelmholtz3dKernels(
     ValueType waveNumber, typename ScalarTraits<ValueType>::RealType maxDist,
     int interpPtsPerWavelength, HermiteInterpolator<ValueType> &interpolator);
 
+/** \brief Initialize \p interpolator to approximate exp(-waveNumber * r) for
+ *  r in [0, maxDist] with the sparsest table whose relative interpolation
+ *  error does not exceed \p relativeAccuracy.
+ *
+ *  The density follows from the error bound \f$h^4 \max |f^{(4)}| / 384\f$ of
+ *  cubic Hermite interpolation on intervals of length \f$h\f$, with
+ *  \f$|f^{(4)}| = |k|^4 |f|\f$ for \f$f(r) = \exp(-kr)\f$. */
+template <typename ValueType>
+void initializeInterpolatorForModifiedHelmholtz3dKernels(
+    ValueType waveNumber, typename ScalarTraits<ValueType>::RealType maxDist,
+    HermiteInterpolator<ValueType> &interpolator,
+    typename ScalarTraits<ValueType>::RealType relativeAccuracy);
+
 } // namespace Fiber
 
 #endif
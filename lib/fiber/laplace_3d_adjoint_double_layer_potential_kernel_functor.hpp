@@ -23,6 +23,7 @@
 
 #include "../common/common.hpp"
 
+#include "batched_geometrical_data.hpp"
 #include "geometrical_data.hpp"
 #include "scalar_traits.hpp"
 
@@ -56,6 +57,8 @@ public:
     trialGeomDeps |= GLOBALS;
   }
 
+  bool isInvariantUnderRigidMotions() const { return true; }
+
   template <template <typename T> class CollectionOf2dSlicesOfNdArrays>
   void evaluate(const ConstGeometricalDataSlice<CoordinateType> &testGeomData,
                 const ConstGeometricalDataSlice<CoordinateType> &trialGeomData,
@@ -75,6 +78,37 @@ public:
     result[0](0, 0) = -numeratorSum / (static_cast<CoordinateType>(4. * M_PI) *
                                        distanceSq * distance);
   }
+
+  void evaluateBatch(
+      const BatchedGeometricalData<CoordinateType> &testGeomData,
+      const ConstGeometricalDataSlice<CoordinateType> &trialGeomData,
+      ValueType *result) const {
+    const size_t pointCount = testGeomData.pointCount();
+    const CoordinateType *testX = testGeomData.global(0);
+    const CoordinateType *testY = testGeomData.global(1);
+    const CoordinateType *testZ = testGeomData.global(2);
+    const CoordinateType trialX = trialGeomData.global(0);
+    const CoordinateType trialY = trialGeomData.global(1);
+    const CoordinateType trialZ = trialGeomData.global(2);
+    const CoordinateType *testNormalX = testGeomData.normal(0);
+    const CoordinateType *testNormalY = testGeomData.normal(1);
+    const CoordinateType *testNormalZ = testGeomData.normal(2);
+
+#pragma ivdep
+    for (size_t i = 0; i < pointCount; ++i) {
+      const CoordinateType diffX = testX[i] - trialX;
+      const CoordinateType diffY = testY[i] - trialY;
+      const CoordinateType diffZ = testZ[i] - trialZ;
+      const CoordinateType distanceSq =
+          diffX * diffX + diffY * diffY + diffZ * diffZ;
+      const CoordinateType distance = sqrt(distanceSq);
+      const CoordinateType numerator = diffX * testNormalX[i] +
+                                       diffY * testNormalY[i] +
+                                       diffZ * testNormalZ[i];
+      result[i] = -numerator / (static_cast<CoordinateType>(4. * M_PI) *
+                                distanceSq * distance);
+    }
+  }
 };
 
 } // namespace Fiber
@@ -23,6 +23,7 @@
 
 #include "../common/common.hpp"
 
+#include "batched_geometrical_data.hpp"
 #include "geometrical_data.hpp"
 #include "scalar_traits.hpp"
 
@@ -55,6 +56,8 @@ public:
     trialGeomDeps |= GLOBALS | NORMALS;
   }
 
+  bool isInvariantUnderRigidMotions() const { return true; }
+
   template <template <typename T> class CollectionOf2dSlicesOfNdArrays>
   void evaluate(const ConstGeometricalDataSlice<CoordinateType> &testGeomData,
                 const ConstGeometricalDataSlice<CoordinateType> &trialGeomData,
@@ -74,6 +77,37 @@ public:
     result[0](0, 0) = -numeratorSum / (static_cast<CoordinateType>(4. * M_PI) *
                                        distance * distanceSq);
   }
+
+  void evaluateBatch(
+      const BatchedGeometricalData<CoordinateType> &testGeomData,
+      const ConstGeometricalDataSlice<CoordinateType> &trialGeomData,
+      ValueType *result) const {
+    const size_t pointCount = testGeomData.pointCount();
+    const CoordinateType *testX = testGeomData.global(0);
+    const CoordinateType *testY = testGeomData.global(1);
+    const CoordinateType *testZ = testGeomData.global(2);
+    const CoordinateType trialX = trialGeomData.global(0);
+    const CoordinateType trialY = trialGeomData.global(1);
+    const CoordinateType trialZ = trialGeomData.global(2);
+    const CoordinateType trialNormalX = trialGeomData.normal(0);
+    const CoordinateType trialNormalY = trialGeomData.normal(1);
+    const CoordinateType trialNormalZ = trialGeomData.normal(2);
+
+#pragma ivdep
+    for (size_t i = 0; i < pointCount; ++i) {
+      const CoordinateType diffX = testX[i] - trialX;
+      const CoordinateType diffY = testY[i] - trialY;
+      const CoordinateType diffZ = testZ[i] - trialZ;
+      const CoordinateType distanceSq =
+          diffX * diffX + diffY * diffY + diffZ * diffZ;
+      const CoordinateType distance = sqrt(distanceSq);
+      // diff points from the trial to the test point, hence the sign
+      const CoordinateType numerator =
+          diffX * trialNormalX + diffY * trialNormalY + diffZ * trialNormalZ;
+      result[i] = numerator / (static_cast<CoordinateType>(4. * M_PI) *
+                               distance * distanceSq);
+    }
+  }
 };
 
 } // namespace Fiber
@@ -24,9 +24,15 @@
 #include "../common/common.hpp"
 
 #include "_2d_array.hpp"
+#include "local_weak_form_tile.hpp"
 #include "scalar_traits.hpp"
 #include "types.hpp"
 
+#include <boost/functional/hash.hpp>
+#include <algorithm>
+#include <iosfwd>
+#include <string>
+#include <typeinfo>
 #include <vector>
 
 namespace Fiber {
@@ -96,6 +102,51 @@ public:
                          Fiber::_2dArray<arma::Mat<ResultType>> &result,
                          CoordinateType nominalDistance = -1.) = 0;
 
+  /** \brief Assemble the local weak forms of a tile of element pairs.
+
+  On exit, \p tile contains the local weak forms corresponding to all pairs
+  (\p testElement, \p trialElement) with \p testElement in \p
+  testElementIndices and \p trialElement in \p trialElementIndices. They are
+  written into the buffer owned by \p tile, which is reused between calls;
+  callers assembling many tiles should therefore keep one tile per thread.
+
+  The default implementation forwards to the overload of
+  evaluateLocalWeakForms() taking a 2D array and copies its results into the
+  tile. Implementations should override it to avoid allocating temporary
+  matrices.
+
+  If \p nominalDistance is nonnegative, it is taken as the distance between
+  all element pairs for the purposes of selecting the quadrature method.
+  Otherwise the interelement distance is calculated separately for each
+  element pair. */
+  virtual void
+  evaluateLocalWeakFormTile(const std::vector<int> &testElementIndices,
+                            const std::vector<int> &trialElementIndices,
+                            LocalWeakFormTile<ResultType> &tile,
+                            CoordinateType nominalDistance = -1.) {
+    Fiber::_2dArray<arma::Mat<ResultType>> localResult;
+    evaluateLocalWeakForms(testElementIndices, trialElementIndices,
+                           localResult, nominalDistance);
+    const int testElementCount = testElementIndices.size();
+    const int trialElementCount = trialElementIndices.size();
+    int maxTestDofCount = 0, maxTrialDofCount = 0;
+    for (int trial = 0; trial < trialElementCount; ++trial)
+      for (int test = 0; test < testElementCount; ++test) {
+        maxTestDofCount = std::max<int>(maxTestDofCount,
+                                        localResult(test, trial).n_rows);
+        maxTrialDofCount = std::max<int>(maxTrialDofCount,
+                                         localResult(test, trial).n_cols);
+      }
+    tile.resize(testElementCount, trialElementCount, maxTestDofCount,
+                maxTrialDofCount);
+    for (int trial = 0; trial < trialElementCount; ++trial)
+      for (int test = 0; test < testElementCount; ++test) {
+        const arma::Mat<ResultType> &local = localResult(test, trial);
+        tile.bindLocalWeakForm(test, trial, local.n_rows, local.n_cols) =
+            local;
+      }
+  }
+
   /** \brief Estimate how fast the entries in the matrix of
    *  this operator decay with interelement distance.
    *
@@ -111,6 +162,21 @@ public:
    *  with 0. */
   virtual CoordinateType
   estimateRelativeScale(CoordinateType minDist) const = 0;
+
+  /** \brief Write statistics of the evaluation of local weak forms, such as
+   *  the quadrature orders used, to \p out.
+   *
+   *  The default implementation does nothing. */
+  virtual void printStatistics(std::ostream & /* out */) const {}
+  /** \brief Combine the parameters of the operator into \p seed.
+   *
+   *  Local assemblers that would produce different local weak forms for the
+   *  same elements should give different hashes; the hash is used to
+   *  identify cached operator matrices on disk. The default implementation
+   *  hashes only the dynamic type of the assembler. */
+  virtual void hashParameters(std::size_t &seed) const {
+    boost::hash_combine(seed, std::string(typeid(*this).name()));
+  }
 };
 
 } // namespace Fiber
@@ -27,6 +27,9 @@
 #include "scalar_traits.hpp"
 #include "types.hpp"
 
+#include <boost/functional/hash.hpp>
+#include <string>
+#include <typeinfo>
 #include <vector>
 
 namespace Fiber {
@@ -97,6 +100,15 @@ public:
 
   virtual CoordinateType
   estimateRelativeScale(CoordinateType minDist) const = 0;
+  /** \brief Combine the parameters of the operator into \p seed.
+   *
+   *  Local assemblers that would produce different local weak forms for the
+   *  same elements should give different hashes; the hash is used to
+   *  identify cached operator matrices on disk. The default implementation
+   *  hashes only the dynamic type of the assembler. */
+  virtual void hashParameters(std::size_t &seed) const {
+    boost::hash_combine(seed, std::string(typeid(*this).name()));
+  }
 };
 
 } // namespace Fiber
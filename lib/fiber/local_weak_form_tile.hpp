@@ -0,0 +1,119 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef fiber_local_weak_form_tile_hpp
+#define fiber_local_weak_form_tile_hpp
+
+#include "../common/common.hpp"
+
+#include "../common/armadillo_fwd.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include <tbb/cache_aligned_allocator.h>
+
+namespace Fiber {
+
+/** \brief Contiguous storage of the local weak forms of a tile of element
+ *  pairs.
+ *
+ *  A tile consists of all pairs (\p testElement, \p trialElement), where
+ *  \p testElement and \p trialElement run over two lists of element indices.
+ *  The local weak forms of all pairs are stored, column by column, in a
+ *  single cache-line aligned buffer owned by the tile. The buffer is only
+ *  reallocated when a tile larger than any previous one is requested, so
+ *  a tile reused across many calls to
+ *  LocalAssemblerForIntegralOperators::evaluateLocalWeakFormTile() does not
+ *  allocate memory in the steady state.
+ *
+ *  \note Tiles are not thread-safe; each thread should use its own tile.
+ */
+template <typename ResultType> class LocalWeakFormTile {
+public:
+  LocalWeakFormTile()
+      : m_testElementCount(0), m_trialElementCount(0), m_blockSize(0) {}
+
+  /** \brief Prepare the tile for testElementCount x trialElementCount
+   *  local weak forms, each with at most maxTestDofCount rows and
+   *  maxTrialDofCount columns. */
+  void resize(int testElementCount, int trialElementCount, int maxTestDofCount,
+              int maxTrialDofCount) {
+    m_testElementCount = testElementCount;
+    m_trialElementCount = trialElementCount;
+    m_blockSize = size_t(maxTestDofCount) * maxTrialDofCount;
+    const size_t pairCount = size_t(testElementCount) * trialElementCount;
+    if (m_data.size() < pairCount * m_blockSize)
+      m_data.resize(pairCount * m_blockSize);
+    if (m_views.size() < pairCount)
+      m_views.resize(pairCount);
+  }
+
+  int testElementCount() const { return m_testElementCount; }
+  int trialElementCount() const { return m_trialElementCount; }
+
+  /** \brief Local weak form of the pair (testIndex, trialIndex), where the
+   *  indices refer to positions in the lists of elements the tile was
+   *  evaluated for. */
+  const arma::Mat<ResultType> &localWeakForm(int testIndex,
+                                             int trialIndex) const {
+    return m_views[pairIndex(testIndex, trialIndex)];
+  }
+
+  /** \brief Bind the local weak form of the pair (testIndex, trialIndex) to
+   *  a testDofCount x trialDofCount block of the buffer and return it.
+   *
+   *  The returned matrix cannot be resized, so integrators write their
+   *  results directly into the buffer. Intended for use by local
+   *  assemblers. */
+  arma::Mat<ResultType> &bindLocalWeakForm(int testIndex, int trialIndex,
+                                           int testDofCount,
+                                           int trialDofCount) {
+    assert(size_t(testDofCount) * trialDofCount <= m_blockSize);
+    typedef arma::Mat<ResultType> Mat;
+    const size_t index = pairIndex(testIndex, trialIndex);
+    // Assignment would copy the data, so reconstruct the matrix in place
+    Mat &view = m_views[index];
+    view.~Mat();
+    new (&view) Mat(&m_data[index * m_blockSize], testDofCount, trialDofCount,
+                    false /* copy_aux_mem */, true /* strict */);
+    return view;
+  }
+
+private:
+  size_t pairIndex(int testIndex, int trialIndex) const {
+    assert(0 <= testIndex && testIndex < m_testElementCount);
+    assert(0 <= trialIndex && trialIndex < m_trialElementCount);
+    return size_t(trialIndex) * m_testElementCount + testIndex;
+  }
+
+private:
+  int m_testElementCount;
+  int m_trialElementCount;
+  size_t m_blockSize;
+  std::vector<ResultType, tbb::cache_aligned_allocator<ResultType>> m_data;
+  std::vector<arma::Mat<ResultType>> m_views;
+};
+
+} // namespace Fiber
+
+#endif
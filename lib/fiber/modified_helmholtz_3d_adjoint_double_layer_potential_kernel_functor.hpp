@@ -23,6 +23,7 @@
 
 #include "../common/common.hpp"
 
+#include "batched_geometrical_data.hpp"
 #include "geometrical_data.hpp"
 #include "scalar_traits.hpp"
 
@@ -64,6 +65,8 @@ public:
     trialGeomDeps |= GLOBALS;
   }
 
+  bool isInvariantUnderRigidMotions() const { return true; }
+
   ValueType waveNumber() const { return m_waveNumber; }
 
   template <template <typename T> class CollectionOf2dSlicesOfNdArrays>
@@ -87,6 +90,39 @@ public:
         exp(-m_waveNumber * distance);
   }
 
+  void evaluateBatch(
+      const BatchedGeometricalData<CoordinateType> &testGeomData,
+      const ConstGeometricalDataSlice<CoordinateType> &trialGeomData,
+      ValueType *result) const {
+    const size_t pointCount = testGeomData.pointCount();
+    const CoordinateType *testX = testGeomData.global(0);
+    const CoordinateType *testY = testGeomData.global(1);
+    const CoordinateType *testZ = testGeomData.global(2);
+    const CoordinateType trialX = trialGeomData.global(0);
+    const CoordinateType trialY = trialGeomData.global(1);
+    const CoordinateType trialZ = trialGeomData.global(2);
+    const CoordinateType *testNormalX = testGeomData.normal(0);
+    const CoordinateType *testNormalY = testGeomData.normal(1);
+    const CoordinateType *testNormalZ = testGeomData.normal(2);
+
+#pragma ivdep
+    for (size_t i = 0; i < pointCount; ++i) {
+      const CoordinateType diffX = testX[i] - trialX;
+      const CoordinateType diffY = testY[i] - trialY;
+      const CoordinateType diffZ = testZ[i] - trialZ;
+      const CoordinateType distanceSq =
+          diffX * diffX + diffY * diffY + diffZ * diffZ;
+      const CoordinateType distance = sqrt(distanceSq);
+      const CoordinateType numerator = diffX * testNormalX[i] +
+                                       diffY * testNormalY[i] +
+                                       diffZ * testNormalZ[i];
+      result[i] = -numerator /
+                  (static_cast<CoordinateType>(4.0 * M_PI) * distanceSq) *
+                  (m_waveNumber + static_cast<CoordinateType>(1.0) / distance) *
+                  expm(m_waveNumber * distance);
+    }
+  }
+
   CoordinateType estimateRelativeScale(CoordinateType distance) const {
     return exp(-realPart(m_waveNumber) * distance);
   }
@@ -23,6 +23,7 @@
 
 #include "../common/common.hpp"
 
+#include "batched_geometrical_data.hpp"
 #include "geometrical_data.hpp"
 #include "hermite_interpolator.hpp"
 #include "initialize_interpolator_for_modified_helmholtz_3d_kernels.hpp"
@@ -30,6 +31,8 @@
 
 #include "../common/complex_aux.hpp"
 
+#include <algorithm>
+
 namespace Fiber {
 
 /** \ingroup modified_helmholtz_3d
@@ -93,6 +96,52 @@ public:
         (m_waveNumber * dist + static_cast<CoordinateType>(1.0)) * v;
   }
 
+  // The distances are computed for chunks of test points, whose
+  // exponentials are then interpolated together
+  void evaluateBatch(
+      const BatchedGeometricalData<CoordinateType> &testGeomData,
+      const ConstGeometricalDataSlice<CoordinateType> &trialGeomData,
+      ValueType *result) const {
+    const size_t pointCount = testGeomData.pointCount();
+    const CoordinateType *testX = testGeomData.global(0);
+    const CoordinateType *testY = testGeomData.global(1);
+    const CoordinateType *testZ = testGeomData.global(2);
+    const CoordinateType trialX = trialGeomData.global(0);
+    const CoordinateType trialY = trialGeomData.global(1);
+    const CoordinateType trialZ = trialGeomData.global(2);
+    const CoordinateType trialNormalX = trialGeomData.normal(0);
+    const CoordinateType trialNormalY = trialGeomData.normal(1);
+    const CoordinateType trialNormalZ = trialGeomData.normal(2);
+
+    CoordinateType distances[batchChunkSize];
+    CoordinateType numerators[batchChunkSize];
+    ValueType exponentials[batchChunkSize];
+    for (size_t start = 0; start < pointCount; start += batchChunkSize) {
+      const size_t count =
+          std::min<size_t>(batchChunkSize, pointCount - start);
+#pragma ivdep
+      for (size_t i = 0; i < count; ++i) {
+        const CoordinateType diffX = testX[start + i] - trialX;
+        const CoordinateType diffY = testY[start + i] - trialY;
+        const CoordinateType diffZ = testZ[start + i] - trialZ;
+        distances[i] = sqrt(diffX * diffX + diffY * diffY + diffZ * diffZ);
+        // diff points from the trial to the test point, hence the sign
+        numerators[i] = diffX * trialNormalX + diffY * trialNormalY +
+                        diffZ * trialNormalZ;
+      }
+      m_interpolator.evaluate(distances, count, exponentials);
+#pragma ivdep
+      for (size_t i = 0; i < count; ++i) {
+        const CoordinateType distance = distances[i];
+        result[start + i] =
+            numerators[i] /
+            (static_cast<CoordinateType>(4.0 * M_PI) * distance * distance) *
+            (m_waveNumber + static_cast<CoordinateType>(1.0) / distance) *
+            exponentials[i];
+      }
+    }
+  }
+
   CoordinateType estimateRelativeScale(CoordinateType distance) const {
     // This function is called rarely, invoking exp() here does little harm.
     return exp(-realPart(m_waveNumber) * distance);
@@ -100,6 +149,10 @@ public:
 
 private:
   /** \cond PRIVATE */
+  enum {
+    batchChunkSize = 64
+  };
+
   ValueType m_waveNumber;
   HermiteInterpolator<ValueType> m_interpolator;
   /** \endcond */
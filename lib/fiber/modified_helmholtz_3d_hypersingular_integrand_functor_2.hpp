@@ -27,6 +27,7 @@
 #include "collection_of_3d_arrays.hpp"
 #include "geometrical_data.hpp"
 #include "conjugate.hpp"
+#include "separable_integrand_term.hpp"
 
 namespace Fiber {
 
@@ -47,6 +48,42 @@ public:
     trialGeomDeps |= NORMALS;
   }
 
+  bool isInvariantUnderRigidMotions() const { return true; }
+
+  // Separable form of the integrand: terms 0 to 2 are the components of
+  // curl u*(x) . curl v(y) multiplied by K_0, terms 3 to 5 the components of
+  // u*(x) n(x) . v(y) n(y) multiplied by K_1.
+
+  int separableTermCount() const { return 6; }
+
+  SeparableIntegrandTerm separableTerm(int term) const {
+    return SeparableIntegrandTerm(term < 3 ? 0 : 1);
+  }
+
+  void evaluateSeparableTestFactors(
+      const ConstGeometricalDataSlice<CoordinateType> &testGeomData,
+      const CollectionOf1dSlicesOfConst3dArrays<BasisFunctionType> &
+          testTransfValues,
+      ResultType *factors) const {
+    const BasisFunctionType value = conjugate(testTransfValues[0](0));
+    for (int dim = 0; dim < 3; ++dim) {
+      factors[dim] = conjugate(testTransfValues[1](dim));
+      factors[3 + dim] = value * testGeomData.normal(dim);
+    }
+  }
+
+  void evaluateSeparableTrialFactors(
+      const ConstGeometricalDataSlice<CoordinateType> &trialGeomData,
+      const CollectionOf1dSlicesOfConst3dArrays<BasisFunctionType> &
+          trialTransfValues,
+      ResultType *factors) const {
+    const BasisFunctionType value = trialTransfValues[0](0);
+    for (int dim = 0; dim < 3; ++dim) {
+      factors[dim] = trialTransfValues[1](dim);
+      factors[3 + dim] = value * trialGeomData.normal(dim);
+    }
+  }
+
   template <template <typename T> class CollectionOf2dSlicesOfConstNdArrays>
   ResultType
   evaluate(const ConstGeometricalDataSlice<CoordinateType> &testGeomData,
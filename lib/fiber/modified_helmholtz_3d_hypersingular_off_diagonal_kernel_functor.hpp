@@ -62,6 +62,8 @@ public:
     trialGeomDeps |= GLOBALS | NORMALS;
   }
 
+  bool isInvariantUnderRigidMotions() const { return true; }
+
   ValueType waveNumber() const { return m_waveNumber; }
 
   template <template <typename T> class CollectionOf2dSlicesOfNdArrays>
@@ -26,6 +26,7 @@
 #include "collection_of_3d_arrays.hpp"
 #include "geometrical_data.hpp"
 #include "conjugate.hpp"
+#include "separable_integrand_term.hpp"
 
 #include <cassert>
 
@@ -45,6 +46,40 @@ public:
     // Do nothing
   }
 
+  bool isInvariantUnderRigidMotions() const { return true; }
+
+  // Separable form of the integrand: terms 2 * i and 2 * i + 1 are the two
+  // products of components of u*(x) and v(y) multiplied by the component i
+  // of the kernel in evaluate().
+
+  int separableTermCount() const { return 6; }
+
+  SeparableIntegrandTerm separableTerm(int term) const {
+    return SeparableIntegrandTerm(0, term / 2, 0);
+  }
+
+  void evaluateSeparableTestFactors(
+      const ConstGeometricalDataSlice<CoordinateType> & /* testGeomData */,
+      const CollectionOf1dSlicesOfConst3dArrays<BasisFunctionType> &
+          testTransfValues,
+      ResultType *factors) const {
+    for (int i = 0; i < 3; ++i) {
+      factors[2 * i] = conjugate(testTransfValues[0]((i + 1) % 3));
+      factors[2 * i + 1] = -conjugate(testTransfValues[0]((i + 2) % 3));
+    }
+  }
+
+  void evaluateSeparableTrialFactors(
+      const ConstGeometricalDataSlice<CoordinateType> & /* trialGeomData */,
+      const CollectionOf1dSlicesOfConst3dArrays<BasisFunctionType> &
+          trialTransfValues,
+      ResultType *factors) const {
+    for (int i = 0; i < 3; ++i) {
+      factors[2 * i] = trialTransfValues[0]((i + 2) % 3);
+      factors[2 * i + 1] = trialTransfValues[0]((i + 1) % 3);
+    }
+  }
+
   template <template <typename T> class CollectionOf2dSlicesOfConstNdArrays>
   ResultType
   evaluate(const ConstGeometricalDataSlice<CoordinateType> &testGeomData,
@@ -26,6 +26,7 @@
 #include "collection_of_3d_arrays.hpp"
 #include "geometrical_data.hpp"
 #include "conjugate.hpp"
+#include "separable_integrand_term.hpp"
 
 #include <cassert>
 
@@ -45,6 +46,38 @@ public:
     // Do nothing
   }
 
+  bool isInvariantUnderRigidMotions() const { return true; }
+
+  // Separable form of the integrand: terms 0 to 2 are the components of
+  // u*(x) . v(y) multiplied by K_0, term 3 is div u*(x) div v(y) multiplied
+  // by K_1.
+
+  int separableTermCount() const { return 4; }
+
+  SeparableIntegrandTerm separableTerm(int term) const {
+    return SeparableIntegrandTerm(term < 3 ? 0 : 1);
+  }
+
+  void evaluateSeparableTestFactors(
+      const ConstGeometricalDataSlice<CoordinateType> & /* testGeomData */,
+      const CollectionOf1dSlicesOfConst3dArrays<BasisFunctionType> &
+          testTransfValues,
+      ResultType *factors) const {
+    for (int dim = 0; dim < 3; ++dim)
+      factors[dim] = conjugate(testTransfValues[0](dim));
+    factors[3] = conjugate(testTransfValues[1](0));
+  }
+
+  void evaluateSeparableTrialFactors(
+      const ConstGeometricalDataSlice<CoordinateType> & /* trialGeomData */,
+      const CollectionOf1dSlicesOfConst3dArrays<BasisFunctionType> &
+          trialTransfValues,
+      ResultType *factors) const {
+    for (int dim = 0; dim < 3; ++dim)
+      factors[dim] = trialTransfValues[0](dim);
+    factors[3] = trialTransfValues[1](0);
+  }
+
   template <template <typename T> class CollectionOf2dSlicesOfConstNdArrays>
   ResultType
   evaluate(const ConstGeometricalDataSlice<CoordinateType> &testGeomData,
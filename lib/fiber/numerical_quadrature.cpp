@@ -21,6 +21,9 @@
 #include "numerical_quadrature.hpp"
 
 #include "bempp/common/config_data_types.hpp"
+#include "shared_ptr.hpp"
+
+#include <tbb/concurrent_unordered_map.h>
 
 // Hyena code
 #include "quadrature/galerkinduffy.hpp"
@@ -242,15 +245,10 @@ inline void reallyFillPointsAndWeightsSingular(
   }
 }
 
-} // namespace
-
-// User-callable functions
-
 template <typename ValueType>
-void fillSingleQuadraturePointsAndWeights(int elementCornerCount,
-                                          int accuracyOrder,
-                                          arma::Mat<ValueType> &points,
-                                          std::vector<ValueType> &weights) {
+void reallyFillSingleQuadraturePointsAndWeights(
+    int elementCornerCount, int accuracyOrder, arma::Mat<ValueType> &points,
+    std::vector<ValueType> &weights) {
   if (elementCornerCount == 3)
     reallyFillPointsAndWeightsRegular<TRIANGLE>(accuracyOrder, points, weights);
   else if (elementCornerCount == 4)
@@ -262,7 +260,7 @@ void fillSingleQuadraturePointsAndWeights(int elementCornerCount,
 }
 
 template <typename ValueType>
-void fillDoubleSingularQuadraturePointsAndWeights(
+void reallyFillDoubleSingularQuadraturePointsAndWeights(
     const DoubleQuadratureDescriptor &desc, arma::Mat<ValueType> &testPoints,
     arma::Mat<ValueType> &trialPoints, std::vector<ValueType> &weights) {
   const ElementPairTopology &topology = desc.topology;
@@ -301,6 +299,111 @@ void fillDoubleSingularQuadraturePointsAndWeights(
         "meshes are not implemented yet.");
 }
 
+// Process-wide registry of quadrature rules
+
+template <typename ValueType> struct SingleQuadratureRule {
+  arma::Mat<ValueType> points;
+  std::vector<ValueType> weights;
+};
+
+template <typename ValueType> struct DoubleSingularQuadratureRule {
+  arma::Mat<ValueType> testPoints;
+  arma::Mat<ValueType> trialPoints;
+  std::vector<ValueType> weights;
+};
+
+/** \brief Map from quadrature descriptors to quadrature rules.
+ *
+ *  Rules are created on first request and are never modified or removed
+ *  afterwards, so references to them stay valid for the lifetime of the
+ *  process. Neither lookups nor insertions take a lock: if several threads
+ *  request the same missing rule at the same time, each of them creates it
+ *  and all but the first inserted copy are discarded. */
+template <typename Descriptor, typename Rule> class QuadratureRuleRegistry {
+public:
+  template <typename RuleCreator>
+  const Rule &rule(const Descriptor &desc, RuleCreator createRule) {
+    typename RuleMap::const_iterator it = m_rules.find(desc);
+    if (it != m_rules.end())
+      return *it->second;
+    shared_ptr<Rule> newRule(new Rule);
+    createRule(desc, *newRule);
+    std::pair<typename RuleMap::iterator, bool> result =
+        m_rules.insert(std::make_pair(desc, shared_ptr<const Rule>(newRule)));
+    return *result.first->second;
+  }
+
+private:
+  typedef tbb::concurrent_unordered_map<Descriptor, shared_ptr<const Rule>>
+      RuleMap;
+  RuleMap m_rules;
+};
+
+template <typename ValueType>
+void createSingleQuadratureRule(const SingleQuadratureDescriptor &desc,
+                                SingleQuadratureRule<ValueType> &rule) {
+  reallyFillSingleQuadraturePointsAndWeights(desc.vertexCount, desc.order,
+                                             rule.points, rule.weights);
+}
+
+template <typename ValueType>
+void createDoubleSingularQuadratureRule(
+    const DoubleQuadratureDescriptor &desc,
+    DoubleSingularQuadratureRule<ValueType> &rule) {
+  reallyFillDoubleSingularQuadraturePointsAndWeights(
+      desc, rule.testPoints, rule.trialPoints, rule.weights);
+}
+
+template <typename ValueType>
+QuadratureRuleRegistry<SingleQuadratureDescriptor,
+                       SingleQuadratureRule<ValueType>> &
+singleQuadratureRuleRegistry() {
+  static QuadratureRuleRegistry<SingleQuadratureDescriptor,
+                                SingleQuadratureRule<ValueType>> registry;
+  return registry;
+}
+
+template <typename ValueType>
+QuadratureRuleRegistry<DoubleQuadratureDescriptor,
+                       DoubleSingularQuadratureRule<ValueType>> &
+doubleSingularQuadratureRuleRegistry() {
+  static QuadratureRuleRegistry<DoubleQuadratureDescriptor,
+                                DoubleSingularQuadratureRule<ValueType>>
+      registry;
+  return registry;
+}
+
+} // namespace
+
+// User-callable functions
+
+template <typename ValueType>
+void fillSingleQuadraturePointsAndWeights(int elementCornerCount,
+                                          int accuracyOrder,
+                                          arma::Mat<ValueType> &points,
+                                          std::vector<ValueType> &weights) {
+  SingleQuadratureDescriptor desc;
+  desc.vertexCount = elementCornerCount;
+  desc.order = accuracyOrder;
+  const SingleQuadratureRule<ValueType> &rule =
+      singleQuadratureRuleRegistry<ValueType>().rule(
+          desc, createSingleQuadratureRule<ValueType>);
+  points = rule.points;
+  weights = rule.weights;
+}
+
+template <typename ValueType>
+void fillDoubleSingularQuadraturePointsAndWeights(
+    const DoubleQuadratureDescriptor &desc, arma::Mat<ValueType> &testPoints,
+    arma::Mat<ValueType> &trialPoints, std::vector<ValueType> &weights) {
+  const DoubleSingularQuadratureRule<ValueType> &rule =
+      doubleSingularQuadratureRuleRegistry<ValueType>().rule(
+          desc, createDoubleSingularQuadratureRule<ValueType>);
+  testPoints = rule.testPoints;
+  trialPoints = rule.trialPoints;
+  weights = rule.weights;
+}
+
 #ifdef ENABLE_SINGLE_PRECISION
 template void fillSingleQuadraturePointsAndWeights<float>(
     int elementCornerCount, int accuracyOrder, arma::Mat<float> &points,
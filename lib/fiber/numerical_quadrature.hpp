@@ -25,7 +25,12 @@
 
 /** \file
  *
- *  Low-level functions filling arrays of quadrature points and weights. */
+ *  Low-level functions filling arrays of quadrature points and weights.
+ *
+ *  Quadrature rules are generated only once per process: the first request
+ *  for a given element topology and accuracy order stores the rule in a
+ *  registry shared by all threads, operators and assemblers, and subsequent
+ *  requests copy it from there. */
 
 #include "double_quadrature_descriptor.hpp"
 #include "single_quadrature_descriptor.hpp"
@@ -50,6 +55,17 @@ void fillSingleQuadraturePointsAndWeights(int elementCornerCount,
                                           arma::Mat<ValueType> &points,
                                           std::vector<ValueType> &weights);
 
+/** \brief Retrieve points and weights for a quadrature over a pair of
+ *  elements sharing at least one vertex.
+ *
+ *  \param[in] desc
+ *    Configuration of the element pair and accuracy orders of the quadrature.
+ *  \param[out] testPoints
+ *    Quadrature points on the test element.
+ *  \param[out] trialPoints
+ *    Quadrature points on the trial element.
+ *  \param[out] weights
+ *    Quadrature weights. */
 template <typename ValueType>
 void fillDoubleSingularQuadraturePointsAndWeights(
     const DoubleQuadratureDescriptor &desc, arma::Mat<ValueType> &testPoints,
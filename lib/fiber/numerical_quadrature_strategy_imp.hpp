@@ -157,7 +157,9 @@ NumericalQuadratureStrategyBase<BasisFunctionType, ResultType, GeometryFactory,
           this->quadratureDescriptorSelectorFactory()
               ->makeQuadratureDescriptorSelectorForIntegralOperators(
                     testRawGeometry, trialRawGeometry, testShapesets,
-                    trialShapesets),
+                    trialShapesets, [kernels](CoordinateType distance) {
+                      return kernels->estimateRelativeScale(distance);
+                    }),
           this->doubleQuadratureRuleFamily()));
 }
 
@@ -383,7 +385,9 @@ NumericalQuadratureStrategy<BasisFunctionType, ResultType, GeometryFactory,
           this->quadratureDescriptorSelectorFactory()
               ->makeQuadratureDescriptorSelectorForIntegralOperators(
                     testRawGeometry, trialRawGeometry, testShapesets,
-                    trialShapesets),
+                    trialShapesets, [kernels](CoordinateType distance) {
+                      return kernels->estimateRelativeScale(distance);
+                    }),
           this->doubleQuadratureRuleFamily()));
 }
 
@@ -26,6 +26,7 @@
 #include "../common/shared_ptr.hpp"
 #include "scalar_traits.hpp"
 
+#include <functional>
 #include <vector>
 
 namespace Fiber {
@@ -96,6 +97,29 @@ public:
       const shared_ptr<const std::vector<const Shapeset<BasisFunctionType> *>> &
           trialShapesets) const = 0;
 
+  /** \brief Create a quadrature descriptor selector used during
+   *  the discretization of the weak form of boundary integral operators.
+   *
+   *  This overload additionally receives the function \p kernelScale
+   *  estimating the magnitude of the kernels of the operator at a given
+   *  distance relative to their magnitude at short distances, which
+   *  selectors may use to adapt quadrature orders to the decay of the
+   *  kernels. The default implementation ignores \p kernelScale and calls
+   *  the overload without this parameter. */
+  virtual shared_ptr<
+      QuadratureDescriptorSelectorForIntegralOperators<CoordinateType>>
+  makeQuadratureDescriptorSelectorForIntegralOperators(
+      const shared_ptr<const RawGridGeometry<CoordinateType>> &testRawGeometry,
+      const shared_ptr<const RawGridGeometry<CoordinateType>> &trialRawGeometry,
+      const shared_ptr<const std::vector<const Shapeset<BasisFunctionType> *>> &
+          testShapesets,
+      const shared_ptr<const std::vector<const Shapeset<BasisFunctionType> *>> &
+          trialShapesets,
+      const std::function<CoordinateType(CoordinateType)> &kernelScale) const {
+    return makeQuadratureDescriptorSelectorForIntegralOperators(
+        testRawGeometry, trialRawGeometry, testShapesets, trialShapesets);
+  }
+
   /** \brief Create a quadrature descriptor selector used during
    *  the discretization of the weak form of local boundary operators.
    *
@@ -25,6 +25,9 @@
 
 #include "double_quadrature_descriptor.hpp"
 
+#include <functional>
+#include <ostream>
+
 namespace Fiber {
 
 /** \ingroup quadrature
@@ -33,6 +36,11 @@ namespace Fiber {
 template <typename CoordinateType>
 class QuadratureDescriptorSelectorForIntegralOperators {
 public:
+  /** \brief Type of functions estimating the magnitude of the integrated
+   *  kernels at a given distance relative to their magnitude at short
+   *  distances (see CollectionOfKernels::estimateRelativeScale()). */
+  typedef std::function<CoordinateType(CoordinateType)> KernelScaleFunction;
+
   /** \brief Destructor */
   virtual ~QuadratureDescriptorSelectorForIntegralOperators() {}
 
@@ -53,6 +61,12 @@ public:
   virtual DoubleQuadratureDescriptor
   quadratureDescriptor(int testElementIndex, int trialElementIndex,
                        CoordinateType nominalDistance) const = 0;
+
+  /** \brief Write statistics of the quadrature descriptors returned so far
+   *  to \p out.
+   *
+   *  The default implementation does nothing. */
+  virtual void printStatistics(std::ostream & /* out */) const {}
 };
 
 } // namespace Fiber
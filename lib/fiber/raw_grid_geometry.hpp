@@ -24,6 +24,7 @@
 #include "../common/common.hpp"
 
 #include "../common/armadillo_fwd.hpp"
+#include "geometrical_data_arena.hpp"
 
 namespace Fiber {
 
@@ -75,6 +76,15 @@ public:
     return m_domainIndices[elementIndex];
   }
 
+  /** \brief Cache of geometrical data of the elements of this grid.
+   *
+   *  The cache is shared by all integrators working on this grid. It must
+   *  only be used once the grid data have been set up. Cached arenas are
+   *  released together with the last integrator using them. */
+  GeometricalDataArenaCache<CoordinateType> &geometricalDataCache() const {
+    return m_geometricalDataCache;
+  }
+
   // Non-const accessors (currently needed for construction)
 
   arma::Mat<CoordinateType> &vertices() { return m_vertices; }
@@ -108,6 +118,7 @@ private:
   arma::Mat<int> m_elementCornerIndices;
   arma::Mat<char> m_auxData;
   std::vector<int> m_domainIndices;
+  mutable GeometricalDataArenaCache<CoordinateType> m_geometricalDataCache;
 };
 
 } // namespace Fiber
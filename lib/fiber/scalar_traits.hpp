@@ -34,12 +34,15 @@ namespace Fiber {
  *  This struct is specialized for the scalar types \c float, \c double,
  *  <tt>std::complex<float></tt> and <tt>std::complex<double></tt>. Each
  *  specialization <tt>ScalarTraits<T></tt> provides the typedefs \c RealType
- *  (denoting the real type of the same precision as \c T) and \c ComplexType
- *  (denoting the complex type of the same precision as \c T). */
+ *  (denoting the real type of the same precision as \c T), \c ComplexType
+ *  (denoting the complex type of the same precision as \c T) and
+ *  \c SinglePrecisionType (denoting the type of the same kind as \c T, but
+ *  in single precision). */
 template <typename T> struct ScalarTraits {
 
   typedef T RealType;
   typedef T ComplexType;
+  typedef T SinglePrecisionType;
 
   ScalarTraits() {
     static_assert(
@@ -51,24 +54,28 @@ template <typename T> struct ScalarTraits {
 template <> struct ScalarTraits<float> {
   typedef float RealType;
   typedef std::complex<float> ComplexType;
+  typedef float SinglePrecisionType;
   enum {NumpyTypeNum = 11 };
 };
 
 template <> struct ScalarTraits<double> {
   typedef double RealType;
   typedef std::complex<double> ComplexType;
+  typedef float SinglePrecisionType;
   enum {NumpyTypeNum = 12 };
 };
 
 template <> struct ScalarTraits<std::complex<float>> {
   typedef float RealType;
   typedef std::complex<float> ComplexType;
+  typedef std::complex<float> SinglePrecisionType;
   enum {NumpyTypeNum = 14 };
 };
 
 template <> struct ScalarTraits<std::complex<double>> {
   typedef double RealType;
   typedef std::complex<double> ComplexType;
+  typedef std::complex<float> SinglePrecisionType;
   enum {NumpyTypeNum = 15 };
 };
 
@@ -0,0 +1,52 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef fiber_separable_integrand_term_hpp
+#define fiber_separable_integrand_term_hpp
+
+namespace Fiber {
+
+/** \brief Kernel component multiplying a single term of a separable
+ *  integrand.
+ *
+ *  See DefaultTestKernelTrialIntegral for the description of separable
+ *  integrand functors. */
+struct SeparableIntegrandTerm {
+  explicit SeparableIntegrandTerm(int kernelIndex_, int row_ = 0,
+                                  int column_ = 0)
+      : kernelIndex(kernelIndex_), row(row_), column(column_) {}
+
+  /** \brief Index of the kernel in the collection of kernels. */
+  int kernelIndex;
+  /** \brief Row of the kernel component. */
+  int row;
+  /** \brief Column of the kernel component. */
+  int column;
+};
+
+inline bool operator==(const SeparableIntegrandTerm &a,
+                       const SeparableIntegrandTerm &b) {
+  return a.kernelIndex == b.kernelIndex && a.row == b.row &&
+         a.column == b.column;
+}
+
+} // namespace Fiber
+
+#endif
@@ -26,6 +26,7 @@
 #include "bempp/common/config_opencl.hpp"
 
 #include "test_kernel_trial_integrator.hpp"
+#include "shared_ptr.hpp"
 
 #include <tbb/enumerable_thread_specific.h>
 
@@ -36,6 +37,7 @@ class OpenClHandler;
 template <typename CoordinateType> class CollectionOfShapesetTransformations;
 template <typename ValueType> class CollectionOfKernels;
 template <typename CoordinateType> class RawGridGeometry;
+template <typename CoordinateType> class GeometricalDataArena;
 template <typename BasisFunctionType, typename KernelType, typename ResultType>
 class TestKernelTrialIntegral;
 /** \endcond */
@@ -72,6 +74,32 @@ public:
 
   virtual ~SeparableNumericalTestKernelTrialIntegrator();
 
+  /** \brief Fill the geometrical data caches of \p testRawGeometry and
+   *  \p trialRawGeometry with the data needed by an integrator constructed
+   *  with the same arguments.
+   *
+   *  The data are calculated in parallel. Callers constructing integrators
+   *  under a lock should call this function before acquiring it; the
+   *  constructor then finds the data in the caches. The caches only hold
+   *  weak references, so the caller must keep the arenas stored in
+   *  \p testArena and \p trialArena until the integrator is constructed. */
+  static void prepareGeometricalDataCache(
+      const arma::Mat<CoordinateType> &localTestQuadPoints,
+      const arma::Mat<CoordinateType> &localTrialQuadPoints,
+      const GeometryFactory &testGeometryFactory,
+      const GeometryFactory &trialGeometryFactory,
+      const RawGridGeometry<CoordinateType> &testRawGeometry,
+      const RawGridGeometry<CoordinateType> &trialRawGeometry,
+      const CollectionOfShapesetTransformations<CoordinateType> &
+          testTransformations,
+      const CollectionOfKernels<KernelType> &kernels,
+      const CollectionOfShapesetTransformations<CoordinateType> &
+          trialTransformations,
+      const TestKernelTrialIntegral<BasisFunctionType, KernelType, ResultType> &
+          integral,
+      shared_ptr<const GeometricalDataArena<CoordinateType>> &testArena,
+      shared_ptr<const GeometricalDataArena<CoordinateType>> &trialArena);
+
   virtual void
   integrate(CallVariant callVariant, const std::vector<int> &elementIndicesA,
             int elementIndexB, const Shapeset<BasisFunctionType> &basisA,
@@ -111,11 +139,16 @@ private:
                    const std::vector<arma::Mat<ResultType> *> &result) const;
 
   void precalculateGeometricalData();
-  void precalculateGeometricalDataOnSingleGrid(
-      const arma::Mat<CoordinateType> &localQuadPoints,
-      const GeometryFactory &geometryFactory,
-      const RawGridGeometry<CoordinateType> &rawGeometry, size_t geomDeps,
-      std::vector<GeometricalData<CoordinateType>> &geomData);
+
+  static void geometricalDependencies(
+      const CollectionOfShapesetTransformations<CoordinateType> &
+          testTransformations,
+      const CollectionOfKernels<KernelType> &kernels,
+      const CollectionOfShapesetTransformations<CoordinateType> &
+          trialTransformations,
+      const TestKernelTrialIntegral<BasisFunctionType, KernelType, ResultType> &
+          integral,
+      size_t &testGeomDeps, size_t &trialGeomDeps);
 
   /**
    * \brief Returns an OpenCL code snippet containing the clIntegrate
@@ -144,8 +177,9 @@ private:
   const OpenClHandler &m_openClHandler;
   bool m_cacheGeometricalData;
 
-  std::vector<GeometricalData<CoordinateType>> m_cachedTestGeomData;
-  std::vector<GeometricalData<CoordinateType>> m_cachedTrialGeomData;
+  // Shared with other integrators working on the same grids
+  shared_ptr<const GeometricalDataArena<CoordinateType>> m_cachedTestGeomData;
+  shared_ptr<const GeometricalDataArena<CoordinateType>> m_cachedTrialGeomData;
   mutable tbb::enumerable_thread_specific<GeometricalData<CoordinateType>>
   m_testGeomData, m_trialGeomData;
 
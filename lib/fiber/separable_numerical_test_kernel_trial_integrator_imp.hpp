@@ -125,43 +125,69 @@ SeparableNumericalTestKernelTrialIntegrator<
 template <typename BasisFunctionType, typename KernelType, typename ResultType,
           typename GeometryFactory>
 void SeparableNumericalTestKernelTrialIntegrator<
-    BasisFunctionType, KernelType, ResultType,
-    GeometryFactory>::precalculateGeometricalData() {
+    BasisFunctionType, KernelType, ResultType, GeometryFactory>::
+    geometricalDependencies(
+        const CollectionOfShapesetTransformations<CoordinateType> &
+            testTransformations,
+        const CollectionOfKernels<KernelType> &kernels,
+        const CollectionOfShapesetTransformations<CoordinateType> &
+            trialTransformations,
+        const TestKernelTrialIntegral<BasisFunctionType, KernelType,
+                                      ResultType> &integral,
+        size_t &testGeomDeps, size_t &trialGeomDeps) {
   size_t testBasisDeps = 0, trialBasisDeps = 0; // ignored in this function
-  size_t testGeomDeps = 0, trialGeomDeps = 0;
-
-  m_testTransformations.addDependencies(testBasisDeps, testGeomDeps);
-  m_trialTransformations.addDependencies(trialBasisDeps, trialGeomDeps);
-  m_kernels.addGeometricalDependencies(testGeomDeps, trialGeomDeps);
-  m_integral.addGeometricalDependencies(testGeomDeps, trialGeomDeps);
-
-  precalculateGeometricalDataOnSingleGrid(
-      m_localTestQuadPoints, m_testGeometryFactory, m_testRawGeometry,
-      testGeomDeps, m_cachedTestGeomData);
-  precalculateGeometricalDataOnSingleGrid(
-      m_localTrialQuadPoints, m_trialGeometryFactory, m_trialRawGeometry,
-      trialGeomDeps, m_cachedTrialGeomData);
+  testTransformations.addDependencies(testBasisDeps, testGeomDeps);
+  trialTransformations.addDependencies(trialBasisDeps, trialGeomDeps);
+  kernels.addGeometricalDependencies(testGeomDeps, trialGeomDeps);
+  integral.addGeometricalDependencies(testGeomDeps, trialGeomDeps);
 }
 
 template <typename BasisFunctionType, typename KernelType, typename ResultType,
           typename GeometryFactory>
-void SeparableNumericalTestKernelTrialIntegrator<BasisFunctionType, KernelType,
-                                                 ResultType, GeometryFactory>::
-    precalculateGeometricalDataOnSingleGrid(
-        const arma::Mat<CoordinateType> &localQuadPoints,
-        const GeometryFactory &geometryFactory,
-        const RawGridGeometry<CoordinateType> &rawGeometry, size_t geomDeps,
-        std::vector<GeometricalData<CoordinateType>> &geomData) {
-  geomData.resize(rawGeometry.elementCount());
+void SeparableNumericalTestKernelTrialIntegrator<
+    BasisFunctionType, KernelType, ResultType, GeometryFactory>::
+    prepareGeometricalDataCache(
+        const arma::Mat<CoordinateType> &localTestQuadPoints,
+        const arma::Mat<CoordinateType> &localTrialQuadPoints,
+        const GeometryFactory &testGeometryFactory,
+        const GeometryFactory &trialGeometryFactory,
+        const RawGridGeometry<CoordinateType> &testRawGeometry,
+        const RawGridGeometry<CoordinateType> &trialRawGeometry,
+        const CollectionOfShapesetTransformations<CoordinateType> &
+            testTransformations,
+        const CollectionOfKernels<KernelType> &kernels,
+        const CollectionOfShapesetTransformations<CoordinateType> &
+            trialTransformations,
+        const TestKernelTrialIntegral<BasisFunctionType, KernelType,
+                                      ResultType> &integral,
+        shared_ptr<const GeometricalDataArena<CoordinateType>> &testArena,
+        shared_ptr<const GeometricalDataArena<CoordinateType>> &trialArena) {
+  size_t testGeomDeps = 0, trialGeomDeps = 0;
+  geometricalDependencies(testTransformations, kernels, trialTransformations,
+                          integral, testGeomDeps, trialGeomDeps);
+  testArena = testRawGeometry.geometricalDataCache().arena(
+      testRawGeometry, testGeometryFactory, localTestQuadPoints, testGeomDeps);
+  trialArena = trialRawGeometry.geometricalDataCache().arena(
+      trialRawGeometry, trialGeometryFactory, localTrialQuadPoints,
+      trialGeomDeps);
+}
 
-  typedef typename GeometryFactory::Geometry Geometry;
-  std::unique_ptr<Geometry> geometry = geometryFactory.make();
-  for (size_t e = 0; e < rawGeometry.elementCount(); ++e) {
-    rawGeometry.setupGeometry(e, *geometry);
-    geometry->getData(geomDeps, localQuadPoints, geomData[e]);
-    if (geomDeps & DOMAIN_INDEX)
-      geomData[e].domainIndex = rawGeometry.domainIndex(e);
-  }
+template <typename BasisFunctionType, typename KernelType, typename ResultType,
+          typename GeometryFactory>
+void SeparableNumericalTestKernelTrialIntegrator<
+    BasisFunctionType, KernelType, ResultType,
+    GeometryFactory>::precalculateGeometricalData() {
+  size_t testGeomDeps = 0, trialGeomDeps = 0;
+  geometricalDependencies(m_testTransformations, m_kernels,
+                          m_trialTransformations, m_integral, testGeomDeps,
+                          trialGeomDeps);
+
+  m_cachedTestGeomData = m_testRawGeometry.geometricalDataCache().arena(
+      m_testRawGeometry, m_testGeometryFactory, m_localTestQuadPoints,
+      testGeomDeps);
+  m_cachedTrialGeomData = m_trialRawGeometry.geometricalDataCache().arena(
+      m_trialRawGeometry, m_trialGeometryFactory, m_localTrialQuadPoints,
+      trialGeomDeps);
 }
 
 template <typename BasisFunctionType, typename KernelType, typename ResultType,
@@ -216,8 +242,14 @@ void SeparableNumericalTestKernelTrialIntegrator<BasisFunctionType, KernelType,
   BasisData<BasisFunctionType> testBasisData, trialBasisData;
   GeometricalData<CoordinateType> *testGeomData = &m_testGeomData.local();
   GeometricalData<CoordinateType> *trialGeomData = &m_trialGeomData.local();
+  // Views of the cached data of individual elements
+  GeometricalData<CoordinateType> cachedTestGeomData, cachedTrialGeomData;
   const GeometricalData<CoordinateType> *constTestGeomData = testGeomData;
   const GeometricalData<CoordinateType> *constTrialGeomData = trialGeomData;
+  if (m_cacheGeometricalData) {
+    constTestGeomData = &cachedTestGeomData;
+    constTrialGeomData = &cachedTrialGeomData;
+  }
 
   size_t testBasisDeps = 0, trialBasisDeps = 0;
   size_t testGeomDeps = 0, trialGeomDeps = 0;
@@ -260,7 +292,8 @@ void SeparableNumericalTestKernelTrialIntegrator<BasisFunctionType, KernelType,
     basisB.evaluate(trialBasisDeps, m_localTrialQuadPoints, localDofIndexB,
                     trialBasisData);
     if (m_cacheGeometricalData)
-      constTrialGeomData = &m_cachedTrialGeomData[elementIndexB];
+      m_cachedTrialGeomData->bindElementData(elementIndexB,
+                                             cachedTrialGeomData);
     else {
       geometryB->getData(trialGeomDeps, m_localTrialQuadPoints, *trialGeomData);
       if (trialGeomDeps & DOMAIN_INDEX)
@@ -274,7 +307,7 @@ void SeparableNumericalTestKernelTrialIntegrator<BasisFunctionType, KernelType,
     basisB.evaluate(testBasisDeps, m_localTestQuadPoints, localDofIndexB,
                     testBasisData);
     if (m_cacheGeometricalData)
-      constTestGeomData = &m_cachedTestGeomData[elementIndexB];
+      m_cachedTestGeomData->bindElementData(elementIndexB, cachedTestGeomData);
     else {
       geometryB->getData(testGeomDeps, m_localTestQuadPoints, *testGeomData);
       if (testGeomDeps & DOMAIN_INDEX)
@@ -291,7 +324,8 @@ void SeparableNumericalTestKernelTrialIntegrator<BasisFunctionType, KernelType,
       rawGeometryA->setupGeometry(elementIndexA, *geometryA);
     if (callVariant == TEST_TRIAL) {
       if (m_cacheGeometricalData)
-        constTestGeomData = &m_cachedTestGeomData[elementIndicesA[indexA]];
+        m_cachedTestGeomData->bindElementData(elementIndexA,
+                                              cachedTestGeomData);
       else {
         geometryA->getData(testGeomDeps, m_localTestQuadPoints, *testGeomData);
         if (testGeomDeps & DOMAIN_INDEX)
@@ -301,7 +335,8 @@ void SeparableNumericalTestKernelTrialIntegrator<BasisFunctionType, KernelType,
                                      testValues);
     } else {
       if (m_cacheGeometricalData)
-        constTrialGeomData = &m_cachedTrialGeomData[elementIndicesA[indexA]];
+        m_cachedTrialGeomData->bindElementData(elementIndexA,
+                                               cachedTrialGeomData);
       else {
         geometryA->getData(trialGeomDeps, m_localTrialQuadPoints,
                            *trialGeomData);
@@ -719,8 +754,14 @@ void SeparableNumericalTestKernelTrialIntegrator<BasisFunctionType, KernelType,
   BasisData<BasisFunctionType> testBasisData, trialBasisData;
   GeometricalData<CoordinateType> *testGeomData = &m_testGeomData.local();
   GeometricalData<CoordinateType> *trialGeomData = &m_trialGeomData.local();
+  // Views of the cached data of individual elements
+  GeometricalData<CoordinateType> cachedTestGeomData, cachedTrialGeomData;
   const GeometricalData<CoordinateType> *constTestGeomData = testGeomData;
   const GeometricalData<CoordinateType> *constTrialGeomData = trialGeomData;
+  if (m_cacheGeometricalData) {
+    constTestGeomData = &cachedTestGeomData;
+    constTrialGeomData = &cachedTrialGeomData;
+  }
 
   size_t testBasisDeps = 0, trialBasisDeps = 0;
   size_t testGeomDeps = 0, trialGeomDeps = 0;
@@ -756,8 +797,10 @@ void SeparableNumericalTestKernelTrialIntegrator<BasisFunctionType, KernelType,
     const int testElementIndex = elementIndexPairs[pairIndex].first;
     const int trialElementIndex = elementIndexPairs[pairIndex].second;
     if (m_cacheGeometricalData) {
-      constTestGeomData = &m_cachedTestGeomData[testElementIndex];
-      constTrialGeomData = &m_cachedTrialGeomData[trialElementIndex];
+      m_cachedTestGeomData->bindElementData(testElementIndex,
+                                            cachedTestGeomData);
+      m_cachedTrialGeomData->bindElementData(trialElementIndex,
+                                             cachedTrialGeomData);
     } else {
       m_testRawGeometry.setupGeometry(testElementIndex, *testGeometry);
       m_trialRawGeometry.setupGeometry(trialElementIndex, *trialGeometry);
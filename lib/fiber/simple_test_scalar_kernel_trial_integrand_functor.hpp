@@ -28,6 +28,7 @@
 #include "geometrical_data.hpp"
 #include "conjugate.hpp"
 #include "scalar_traits.hpp"
+#include "separable_integrand_term.hpp"
 
 namespace Fiber {
 
@@ -48,11 +49,22 @@ public:
   typedef ResultType_ ResultType;
   typedef typename ScalarTraits<ResultType>::RealType CoordinateType;
 
+  // The integrand is invariant under rigid motions only if the test and
+  // trial transformations rotate together with the elements, which this
+  // functor cannot check; callers using such transformations say so here.
+  explicit SimpleTestScalarKernelTrialIntegrandFunctor(
+      bool invariantUnderRigidMotions = false)
+      : m_invariantUnderRigidMotions(invariantUnderRigidMotions) {}
+
   void addGeometricalDependencies(size_t &testGeomDeps,
                                   size_t &trialGeomDeps) const {
     // do nothing
   }
 
+  bool isInvariantUnderRigidMotions() const {
+    return m_invariantUnderRigidMotions;
+  }
+
   // It is possible that this function could be generalised to
   // multiple shapeset transformations or kernels and that the additional
   // loops could be optimised away by the compiler.
@@ -83,6 +95,9 @@ public:
     ResultType result = dotProduct * kernelValues[0](0, 0);
     return result;
   }
+
+private:
+  bool m_invariantUnderRigidMotions;
 };
 
 template <typename BasisFunctionType_, typename KernelType_,
@@ -94,11 +109,46 @@ public:
   typedef ResultType_ ResultType;
   typedef typename ScalarTraits<ResultType>::RealType CoordinateType;
 
+  // See SimpleTestScalarKernelTrialIntegrandFunctor.
+  explicit SimpleTestScalarKernelTrialIntegrandFunctorExt(
+      bool invariantUnderRigidMotions = false)
+      : m_invariantUnderRigidMotions(invariantUnderRigidMotions) {}
+
   void addGeometricalDependencies(size_t &testGeomDeps,
                                   size_t &trialGeomDeps) const {
     // do nothing
   }
 
+  bool isInvariantUnderRigidMotions() const {
+    return m_invariantUnderRigidMotions;
+  }
+
+  // Separable form of the integrand: term i is the product of the
+  // components i of the test and trial function transformations multiplied by
+  // the kernel.
+
+  int separableTermCount() const { return transformationDim; }
+
+  SeparableIntegrandTerm separableTerm(int /* term */) const {
+    return SeparableIntegrandTerm(0);
+  }
+
+  void evaluateSeparableTestFactors(
+      const ConstGeometricalDataSlice<CoordinateType> & /* testGeomData */,
+      const CollectionOf1dSlicesOfConst3dArrays<BasisFunctionType> &testValues,
+      ResultType *factors) const {
+    for (int dim = 0; dim < transformationDim; ++dim)
+      factors[dim] = conjugate(testValues[0](dim));
+  }
+
+  void evaluateSeparableTrialFactors(
+      const ConstGeometricalDataSlice<CoordinateType> & /* trialGeomData */,
+      const CollectionOf1dSlicesOfConst3dArrays<BasisFunctionType> &trialValues,
+      ResultType *factors) const {
+    for (int dim = 0; dim < transformationDim; ++dim)
+      factors[dim] = trialValues[0](dim);
+  }
+
   // It is possible that this function could be generalised to
   // multiple shapeset transformations or kernels and that the additional
   // loops could be optimised away by the compiler.
@@ -129,6 +179,9 @@ public:
     ResultType result = dotProduct * kernelValues[0](0, 0);
     return result;
   }
+
+private:
+  bool m_invariantUnderRigidMotions;
 };
 
 } // namespace Fiber
@@ -107,6 +107,19 @@ public:
   virtual void addGeometricalDependencies(size_t &testGeomDeps,
                                           size_t &trialGeomDeps) const = 0;
 
+  /** \brief Return true if the integral is invariant under rigid motions.
+   *
+   *  The integral is invariant under rigid motions if it does not change
+   *  when the test and trial elements are moved together by a translation
+   *  and a proper rotation, provided that the kernels are invariant in the
+   *  sense of CollectionOfKernels::isInvariantUnderRigidMotions(). The
+   *  answer depends on the shape function transformations the integral is
+   *  used with: vector-valued ones must rotate together with the elements,
+   *  which does not hold e.g. for a fixed Cartesian component. Singular
+   *  integrals over congruent element pairs are then evaluated only once.
+   *  The default implementation returns false. */
+  virtual bool isInvariantUnderRigidMotions() const { return false; }
+
   /** \brief Evaluate the integral using a tensor-product quadrature rule.
    *
    *  This function should evaluate the integral using a quadrature rule of the
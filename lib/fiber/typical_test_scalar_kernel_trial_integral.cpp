@@ -516,8 +516,10 @@ void TypicalTestScalarKernelTrialIntegral<BasisFunctionType_,
 template <typename CoordinateType>
 TypicalTestScalarKernelTrialIntegral<
     std::complex<CoordinateType>, CoordinateType,
-    std::complex<CoordinateType>>::TypicalTestScalarKernelTrialIntegral()
-    : m_standardIntegral(TestScalarKernelTrialIntegrandFunctor<
+    std::complex<CoordinateType>>::
+    TypicalTestScalarKernelTrialIntegral(bool invariantUnderRigidMotions)
+    : Base(invariantUnderRigidMotions),
+      m_standardIntegral(TestScalarKernelTrialIntegrandFunctor<
           BasisFunctionType, KernelType, ResultType>()) {}
 
 template <typename CoordinateType>
@@ -46,6 +46,22 @@ public:
 
   virtual void addGeometricalDependencies(size_t &testGeomDeps,
                                           size_t &trialGeomDeps) const;
+
+  // The integrand is a sum of dot products of test and trial function
+  // transformations multiplied by scalar kernels, which is invariant only if
+  // the transformations rotate together with the elements. Operators using
+  // such transformations declare this on construction.
+  virtual bool isInvariantUnderRigidMotions() const {
+    return m_invariantUnderRigidMotions;
+  }
+
+protected:
+  explicit TypicalTestScalarKernelTrialIntegralBase(
+      bool invariantUnderRigidMotions)
+      : m_invariantUnderRigidMotions(invariantUnderRigidMotions) {}
+
+private:
+  bool m_invariantUnderRigidMotions;
 };
 
 /** \ingroup weak_form_elements
@@ -94,7 +110,9 @@ public:
   typedef typename Base::KernelType KernelType;
   typedef typename Base::ResultType ResultType;
 
-  TypicalTestScalarKernelTrialIntegral() {}
+  explicit TypicalTestScalarKernelTrialIntegral(
+      bool invariantUnderRigidMotions = false)
+      : Base(invariantUnderRigidMotions) {}
 
   virtual void evaluateWithTensorQuadratureRule(
       const GeometricalData<CoordinateType> &testGeomData,
@@ -135,7 +153,9 @@ public:
   typedef typename Base::KernelType KernelType;
   typedef typename Base::ResultType ResultType;
 
-  TypicalTestScalarKernelTrialIntegral() {}
+  explicit TypicalTestScalarKernelTrialIntegral(
+      bool invariantUnderRigidMotions = false)
+      : Base(invariantUnderRigidMotions) {}
 
   virtual void evaluateWithTensorQuadratureRule(
       const GeometricalData<CoordinateType> &testGeomData,
@@ -177,7 +197,8 @@ public:
   typedef typename Base::KernelType KernelType;
   typedef typename Base::ResultType ResultType;
 
-  TypicalTestScalarKernelTrialIntegral();
+  explicit TypicalTestScalarKernelTrialIntegral(
+      bool invariantUnderRigidMotions = false);
 
   // This is the "standard" (non-BLAS-based) implementation
   virtual void evaluateWithTensorQuadratureRule(
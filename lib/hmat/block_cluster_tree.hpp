@@ -40,6 +40,12 @@ public:
                    int maxBlockSize,
                    const AdmissibilityFunction &admissibilityFunction);
 
+  // Block cluster tree with a given structure, e.g. one read from a file. The
+  // nodes must refer to nodes of the given cluster trees.
+  BlockClusterTree(const shared_ptr<const ClusterTree<N>> &rowClusterTree,
+                   const shared_ptr<const ClusterTree<N>> &columnClusterTree,
+                   const shared_ptr<BlockClusterTreeNode<N>> &root);
+
 //  void writeToPdfFile(const std::string &fname, double widthInPoints,
 //                      double heightInPoints) const;
 
@@ -71,6 +77,10 @@ void getBlockClusterTreeNodeDimensions(
     IndexRangeType &rowClusterRange, IndexRangeType &columnClusterRange,
     std::size_t &numberOfRows, std::size_t &numberOfColumns);
 
+template <int N>
+std::size_t
+blockClusterTreeNodeSize(const BlockClusterTreeNode<N> &blockClusterTreeNode);
+
 class StandardAdmissibility {
 public:
   StandardAdmissibility(double eta);
@@ -27,6 +27,14 @@ BlockClusterTree<N>::BlockClusterTree(
   initializeBlockClusterTree(admissibilityFunction, maxBlockSize);
 }
 
+template <int N>
+BlockClusterTree<N>::BlockClusterTree(
+    const shared_ptr<const ClusterTree<N>> &rowClusterTree,
+    const shared_ptr<const ClusterTree<N>> &columnClusterTree,
+    const shared_ptr<BlockClusterTreeNode<N>> &root)
+    : m_rowClusterTree(rowClusterTree), m_columnClusterTree(columnClusterTree),
+      m_root(root) {}
+
 //template <int N>
 //void BlockClusterTree<N>::writeToPdfFile(const std::string &fname,
 //                                         double widthInPoints,
@@ -146,17 +154,16 @@ void BlockClusterTree<N>::initializeBlockClusterTree(
     auto columnBlockSize =
         columnClusterTreeNodeIndexRange[1] - columnClusterTreeNodeIndexRange[0];
 
-    if (columnBlockSize > maxBlockSize || rowBlockSize > maxBlockSize)
+    if (columnBlockSize > maxBlockSize || rowBlockSize > maxBlockSize) {
       nodeData.admissible = false;
+      node->data().admissible = false;
+    }
 
     // If admissible do not refine further
 
     if (nodeData.admissible)
       return;
 
-    auto rowClusterData = nodeData.rowClusterTreeNode->data();
-    auto columnClusterData = nodeData.columnClusterTreeNode->data();
-
     // If row or column cluster is leaf do not refine further
 
     if (nodeData.rowClusterTreeNode->isLeaf() ||
@@ -169,8 +176,8 @@ void BlockClusterTree<N>::initializeBlockClusterTree(
       auto rowChild = nodeData.rowClusterTreeNode->child(rowCount);
       for (int columnCount = 0; columnCount < N; ++columnCount) {
         auto columnChild = nodeData.columnClusterTreeNode->child(columnCount);
-        auto rowBoundingBox = rowClusterData.boundingBox;
-        auto columnBoundingBox = columnClusterData.boundingBox;
+        auto rowBoundingBox = rowChild->data().boundingBox;
+        auto columnBoundingBox = columnChild->data().boundingBox;
         node->addChild(
             BlockClusterTreeNodeData<N>(
                 rowChild, columnChild,
@@ -204,6 +211,21 @@ void getBlockClusterTreeNodeDimensions(
   numberOfColumns = columnClusterRange[1] - columnClusterRange[0];
 }
 
+template <int N>
+std::size_t
+blockClusterTreeNodeSize(const BlockClusterTreeNode<N> &blockClusterTreeNode) {
+
+  IndexRangeType rowClusterRange;
+  IndexRangeType columnClusterRange;
+  std::size_t numberOfRows;
+  std::size_t numberOfColumns;
+
+  getBlockClusterTreeNodeDimensions(blockClusterTreeNode, rowClusterRange,
+                                    columnClusterRange, numberOfRows,
+                                    numberOfColumns);
+  return numberOfRows * numberOfColumns;
+}
+
 inline StandardAdmissibility::StandardAdmissibility(double eta) : m_eta(eta) {}
 
 inline bool StandardAdmissibility::operator()(const BoundingBox &box1,
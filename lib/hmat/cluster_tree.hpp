@@ -20,6 +20,15 @@ struct ClusterTreeNodeData {
   BoundingBox boundingBox;
 };
 
+// Rule by which a cluster is split into two sons
+enum ClusterSplitting {
+  // Halve the bounding box of the cluster along its longest side
+  BOUNDING_BOX_SPLITTING,
+  // Split at the mean of the DOF centers orthogonally to their principal
+  // axis, which adapts to thin or curved geometries
+  PCA_SPLITTING
+};
+
 template <int N> using ClusterTreeNode = SimpleTreeNode<ClusterTreeNodeData, N>;
 
 typedef ClusterTreeNode<2> DefaultClusterTreeNodeType;
@@ -27,7 +36,13 @@ typedef ClusterTreeNode<2> DefaultClusterTreeNodeType;
 template <int N> class ClusterTree {
 
 public:
-  ClusterTree(const Geometry &geometry, int minBlockSize);
+  // The tree is built in parallel. Subtrees are split as separate tasks.
+  ClusterTree(const Geometry &geometry, int minBlockSize,
+              ClusterSplitting clusterSplitting = BOUNDING_BOX_SPLITTING);
+
+  // Cluster tree with a given structure, e.g. one read from a file
+  ClusterTree(const shared_ptr<ClusterTreeNode<N>> &root,
+              const DofPermutation &dofPermutation);
 
   const shared_ptr<const ClusterTreeNode<N>> root() const;
   const shared_ptr<ClusterTreeNode<N>> root();
@@ -48,7 +63,28 @@ private:
   initializeClusterTree(const Geometry &geometry);
   void splitClusterTreeByGeometry(const Geometry &geometry,
                                   DofPermutation &dofPermutation,
-                                  int minBlockSize);
+                                  int minBlockSize,
+                                  ClusterSplitting clusterSplitting);
+
+  // Split the subtree of clusterTreeNode. indices holds the original DOFs in
+  // the order of the H-matrix DOFs; the entries in the index range of the
+  // node are reordered in place.
+  static void
+  splitClusterTreeNode(const Geometry &geometry, IndexSetType &indices,
+                       const shared_ptr<ClusterTreeNode<N>> &clusterTreeNode,
+                       int minBlockSize, ClusterSplitting clusterSplitting);
+
+  // Partition [first, last) into the DOFs of the two sons and return the
+  // start of the second son
+  static IndexSetType::iterator
+  partitionByBoundingBox(const Geometry &geometry, IndexSetType::iterator first,
+                         IndexSetType::iterator last, BoundingBox &boundingBox,
+                         BoundingBox &firstBoundingBox,
+                         BoundingBox &secondBoundingBox);
+  static IndexSetType::iterator
+  partitionByPrincipalAxis(const Geometry &geometry,
+                           IndexSetType::iterator first,
+                           IndexSetType::iterator last);
 
   shared_ptr<ClusterTreeNode<N>> m_root;
   DofPermutation m_dofPermutation;
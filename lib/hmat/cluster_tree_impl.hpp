@@ -11,8 +11,15 @@
 
 #include "cluster_tree.hpp"
 
-#include <functional>
+#include <algorithm>
+#include <armadillo>
 #include <cassert>
+#include <functional>
+#include <stdexcept>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_group.h>
 
 namespace hmat {
 
@@ -21,11 +28,24 @@ inline ClusterTreeNodeData::ClusterTreeNodeData(
     : indexRange(indexRange), boundingBox(boundingBox) {}
 
 template <int N>
-ClusterTree<N>::ClusterTree(const Geometry &geometry, int minBlockSize)
+ClusterTree<N>::ClusterTree(const Geometry &geometry, int minBlockSize,
+                            ClusterSplitting clusterSplitting)
     : m_root(initializeClusterTree(geometry)),
       m_dofPermutation(geometry.size()) {
 
-  splitClusterTreeByGeometry(geometry, m_dofPermutation, minBlockSize);
+  splitClusterTreeByGeometry(geometry, m_dofPermutation, minBlockSize,
+                             clusterSplitting);
+}
+
+template <int N>
+ClusterTree<N>::ClusterTree(const shared_ptr<ClusterTreeNode<N>> &root,
+                            const DofPermutation &dofPermutation)
+    : m_root(root), m_dofPermutation(dofPermutation) {
+
+  if (m_dofPermutation.numberOfDofs() != numberOfDofs())
+    throw std::invalid_argument("ClusterTree::ClusterTree(): Size of the "
+                                "DOF permutation does not match the root "
+                                "cluster.");
 }
 
 template <int N> std::size_t ClusterTree<N>::numberOfDofs() const {
@@ -67,96 +87,163 @@ ClusterTree<N>::originalDofToHMatDofMap() const {
   return m_dofPermutation.originalDofToHMatDofMap();
 }
 
-template <>
-inline void
-ClusterTree<2>::splitClusterTreeByGeometry(const Geometry &geometry,
-                                           DofPermutation &dofPermutation,
-                                           int minBlockSize) {
-
-  std::function<void(const shared_ptr<ClusterTreeNode<2>> & clusterTreeNode,
-                     const IndexSetType & indexSet)> splittingFun;
-
-  splittingFun = [&dofPermutation, &geometry, minBlockSize, &splittingFun](
-      const shared_ptr<ClusterTreeNode<2>> &clusterTreeNode,
-      const IndexSetType &indexSet) {
-
-    std::size_t indexSetSize = indexSet.size();
-
-    assert(indexSetSize == clusterTreeNode->data().indexRange[1] -
-                               clusterTreeNode->data().indexRange[0]);
-
-    if (indexSetSize > minBlockSize) {
-
-      IndexSetType firstIndexSet;
-      IndexSetType secondIndexSet;
-
-      // Figure out the right dim
-
-      assert(clusterTreeNode->data().boundingBox.diameter() != 0);
-
-      auto dim = clusterTreeNode->data().boundingBox.maxDimension();
-
-      auto bounds = clusterTreeNode->data().boundingBox.bounds();
-      auto boxes = clusterTreeNode->data().boundingBox.divide(dim, .5);
-
-      auto firstBoundingBox = boxes.first;
-      auto secondBoundingBox = boxes.second;
-
-      auto ubound = firstBoundingBox.bounds()[2 * dim + 1];
-
-      for (auto index : indexSet) {
-        auto centerValue = geometry[index]->center[dim];
-        if (centerValue < ubound)
-          firstIndexSet.push_back(index);
-        else
-          secondIndexSet.push_back(index);
-      }
-
-      if (secondIndexSet.size() == 0) {
-        clusterTreeNode->data().boundingBox = firstBoundingBox;
-        splittingFun(clusterTreeNode, indexSet);
-        return;
-      }
-      if (firstIndexSet.size() == 0) {
-        clusterTreeNode->data().boundingBox = secondBoundingBox;
-        splittingFun(clusterTreeNode, indexSet);
-        return;
-      }
-
-      auto pivot = firstIndexSet.size();
-
-      IndexRangeType newRangeFirst = clusterTreeNode->data().indexRange;
-      IndexRangeType newRangeSecond = clusterTreeNode->data().indexRange;
+template <int N>
+IndexSetType::iterator ClusterTree<N>::partitionByBoundingBox(
+    const Geometry &geometry, IndexSetType::iterator first,
+    IndexSetType::iterator last, BoundingBox &boundingBox,
+    BoundingBox &firstBoundingBox, BoundingBox &secondBoundingBox) {
+
+  // If all centers lie in one half the box is shrunk to that half and
+  // divided again. Coincident centers are split by count.
+  const int maxTrials = 64;
+
+  for (int trial = 0; trial < maxTrials; ++trial) {
+
+    auto dim = boundingBox.maxDimension();
+    auto boxes = boundingBox.divide(dim, .5);
+    auto ubound = boxes.first.bounds()[2 * dim + 1];
+
+    auto pivot = std::partition(first, last, [&geometry, dim, ubound](
+                                                 std::size_t index) {
+      return geometry[index]->center[dim] < ubound;
+    });
+
+    if (pivot == last)
+      boundingBox = boxes.first;
+    else if (pivot == first)
+      boundingBox = boxes.second;
+    else {
+      firstBoundingBox = boxes.first;
+      secondBoundingBox = boxes.second;
+      return pivot;
+    }
+  }
 
-      newRangeFirst[1] = newRangeSecond[0] = newRangeFirst[0] + pivot;
+  firstBoundingBox = secondBoundingBox = boundingBox;
+  return first + (last - first) / 2;
+}
 
-      clusterTreeNode->addChild(
-          ClusterTreeNodeData(newRangeFirst, firstBoundingBox), 0);
-      clusterTreeNode->addChild(
-          ClusterTreeNodeData(newRangeSecond, secondBoundingBox), 1);
-      splittingFun(clusterTreeNode->child(0), firstIndexSet);
-      splittingFun(clusterTreeNode->child(1), secondIndexSet);
+template <int N>
+IndexSetType::iterator
+ClusterTree<N>::partitionByPrincipalAxis(const Geometry &geometry,
+                                         IndexSetType::iterator first,
+                                         IndexSetType::iterator last) {
+
+  arma::vec3 mean;
+  mean.zeros();
+  for (auto it = first; it != last; ++it)
+    for (int i = 0; i < 3; ++i)
+      mean(i) += geometry[*it]->center[i];
+  mean /= static_cast<double>(last - first);
+
+  arma::mat33 covariance;
+  covariance.zeros();
+  for (auto it = first; it != last; ++it) {
+    arma::vec3 d;
+    for (int i = 0; i < 3; ++i)
+      d(i) = geometry[*it]->center[i] - mean(i);
+    covariance += d * d.t();
+  }
+
+  // Eigenvalues are returned in ascending order
+  arma::vec eigenvalues;
+  arma::mat eigenvectors;
+  arma::eig_sym(eigenvalues, eigenvectors, covariance);
+  const arma::vec3 axis = eigenvectors.col(2);
+
+  auto pivot =
+      std::partition(first, last, [&geometry, &mean, &axis](std::size_t index) {
+        const auto &center = geometry[index]->center;
+        double projection = 0;
+        for (int i = 0; i < 3; ++i)
+          projection += (center[i] - mean(i)) * axis(i);
+        return projection < 0;
+      });
+
+  // Coincident centers are split by count
+  if (pivot == first || pivot == last)
+    pivot = first + (last - first) / 2;
+  return pivot;
+}
 
-      clusterTreeNode->data().boundingBox =
-          clusterTreeNode->child(0)->data().boundingBox;
-      clusterTreeNode->data().boundingBox.merge(
-          clusterTreeNode->child(1)->data().boundingBox);
-    } else {
+template <>
+inline void ClusterTree<2>::splitClusterTreeNode(
+    const Geometry &geometry, IndexSetType &indices,
+    const shared_ptr<ClusterTreeNode<2>> &clusterTreeNode, int minBlockSize,
+    ClusterSplitting clusterSplitting) {
+
+  // Smaller clusters are split in the task of their parent
+  const std::size_t minTaskSize = 4096;
+
+  const IndexRangeType indexRange = clusterTreeNode->data().indexRange;
+  const std::size_t indexRangeSize = indexRange[1] - indexRange[0];
+  const auto first = indices.begin() + indexRange[0];
+  const auto last = indices.begin() + indexRange[1];
+
+  if (indexRangeSize <= static_cast<std::size_t>(minBlockSize)) {
+    BoundingBox b;
+    for (auto it = first; it != last; ++it)
+      b.merge(geometry[*it]->boundingBox);
+    clusterTreeNode->data().boundingBox = b;
+    return;
+  }
+
+  // The bounding boxes of the sons only matter for bounding box splitting.
+  // The final boxes are merged from the leafs below.
+  BoundingBox firstBoundingBox;
+  BoundingBox secondBoundingBox;
+  const auto pivot =
+      (clusterSplitting == PCA_SPLITTING)
+          ? partitionByPrincipalAxis(geometry, first, last)
+          : partitionByBoundingBox(geometry, first, last,
+                                   clusterTreeNode->data().boundingBox,
+                                   firstBoundingBox, secondBoundingBox);
+
+  IndexRangeType newRangeFirst = indexRange;
+  IndexRangeType newRangeSecond = indexRange;
+  newRangeFirst[1] = newRangeSecond[0] = indexRange[0] + (pivot - first);
+
+  clusterTreeNode->addChild(
+      ClusterTreeNodeData(newRangeFirst, firstBoundingBox), 0);
+  clusterTreeNode->addChild(
+      ClusterTreeNodeData(newRangeSecond, secondBoundingBox), 1);
+
+  auto splitChild = [&](int i) {
+    splitClusterTreeNode(geometry, indices, clusterTreeNode->child(i),
+                         minBlockSize, clusterSplitting);
+  };
 
-      BoundingBox b;
-      for (const auto &elem : indexSet)
-        b.merge(geometry[elem]->boundingBox);
+  if (indexRangeSize > minTaskSize) {
+    tbb::task_group taskGroup;
+    taskGroup.run([&splitChild]() { splitChild(0); });
+    splitChild(1);
+    taskGroup.wait();
+  } else {
+    splitChild(0);
+    splitChild(1);
+  }
+
+  clusterTreeNode->data().boundingBox =
+      clusterTreeNode->child(0)->data().boundingBox;
+  clusterTreeNode->data().boundingBox.merge(
+      clusterTreeNode->child(1)->data().boundingBox);
+}
 
-      clusterTreeNode->data().boundingBox = b;
-      int originalIndexCount = 0;
-      const auto &indexRange = clusterTreeNode->data().indexRange;
-      for (int hMatDof = indexRange[0]; hMatDof < indexRange[1]; ++hMatDof) {
-        dofPermutation.addDofIndexPair(indexSet[originalIndexCount], hMatDof);
-        ++originalIndexCount;
-      }
-    }
-  };
-  splittingFun(m_root, fillIndexRange(0, geometry.size()));
+template <>
+inline void ClusterTree<2>::splitClusterTreeByGeometry(
+    const Geometry &geometry, DofPermutation &dofPermutation,
+    int minBlockSize, ClusterSplitting clusterSplitting) {
+
+  IndexSetType indices = fillIndexRange(0, geometry.size());
+  splitClusterTreeNode(geometry, indices, m_root, minBlockSize,
+                       clusterSplitting);
+
+  tbb::parallel_for(tbb::blocked_range<std::size_t>(0, indices.size()),
+                    [&dofPermutation, &indices](
+                        const tbb::blocked_range<std::size_t> &r) {
+    for (std::size_t hMatDof = r.begin(); hMatDof != r.end(); ++hMatDof)
+      dofPermutation.addDofIndexPair(indices[hMatDof], hMatDof);
+  });
 }
 
 template <int N>
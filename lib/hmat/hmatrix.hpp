@@ -8,8 +8,16 @@
 #include "hmatrix_compressor.hpp"
 #include "data_accessor.hpp"
 #include "compressed_matrix.hpp"
+#include "hmatrix_dense_data.hpp"
+#include "hmatrix_low_rank_data.hpp"
 #include <armadillo>
 #include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <tbb/concurrent_queue.h>
+#include <tbb/concurrent_unordered_map.h>
+#include <tbb/concurrent_vector.h>
 
 namespace hmat {
 
@@ -18,20 +26,72 @@ template <typename ValueType, int N> class HMatrix;
 
 template <typename ValueType> using DefaultHMatrixType = HMatrix<ValueType, 2>;
 
+template <typename ValueType, int N> struct HMatrixLeaf {
+  const BlockClusterTreeNode<N> *node;
+  const HMatrixData<ValueType> *data;
+};
+
+// Type and dimensions of the data of a leaf. Dense leafs have rank zero.
+struct HMatrixLeafLayout {
+  DataBlockType type;
+  std::size_t rows;
+  std::size_t columns;
+  std::size_t rank;
+};
+
 template <typename ValueType, int N>
 class HMatrix : public CompressedMatrix<ValueType> {
 public:
   HMatrix(const shared_ptr<BlockClusterTree<N>> &blockClusterTree);
   HMatrix(const shared_ptr<BlockClusterTree<N>> &blockClusterTree,
-          const HMatrixCompressor<ValueType, N> &hMatrixCompressor);
+          const HMatrixCompressor<ValueType, N> &hMatrixCompressor,
+          bool symmetric = false);
+
+  // Leafs reference the storage of the matrix and cannot be copied
+  HMatrix(const HMatrix &other) = delete;
+  HMatrix &operator=(const HMatrix &other) = delete;
 
   std::size_t rows() const override;
   std::size_t columns() const override;
 
-  void initialize(const HMatrixCompressor<ValueType, N> &hMatrixCompressor);
+  // If symmetric is true only the leafs on and above the block diagonal are
+  // compressed and the remaining leafs are obtained by transposition. This
+  // requires that the row and column cluster trees are identical.
+  void initialize(const HMatrixCompressor<ValueType, N> &hMatrixCompressor,
+                  bool symmetric = false);
+
+  // Initialize from leaf data stored in arena. The leafs are given in tree
+  // order; dense leafs occupy rows * columns elements of the arena and
+  // low-rank leafs the factors A and B in this order, both column-major. The
+  // arena may be shared with other owners, e.g. a memory-mapped file.
+  void initialize(const std::vector<HMatrixLeafLayout> &leafLayouts,
+                  const shared_ptr<ValueType> &arena, std::size_t arenaSize);
+
   bool isInitialized() const;
   void reset();
 
+  shared_ptr<const BlockClusterTree<N>> blockClusterTree() const;
+
+  // Leaf blocks in tree order, i.e. in Morton order of the block index
+  // ranges. Leaf data is read only; its memory is owned by the H-matrix.
+  std::size_t numberOfLeafs() const;
+  const HMatrixLeaf<ValueType, N> &leaf(std::size_t index) const;
+  const std::vector<HMatrixLeaf<ValueType, N>> &leafs() const;
+
+  double memSizeKb() const;
+
+  // Recompress all low-rank leafs to the smallest rank that approximates the
+  // current factors up to the relative tolerance eps. Returns the amount of
+  // memory saved in kB.
+  double recompress(double eps);
+
+  // Merge sibling low-rank leafs bottom-up into a single low-rank leaf of
+  // their parent block whenever the merged factors, truncated to the relative
+  // tolerance eps, need less memory than the children. The block cluster
+  // tree is copied before it is modified, so trees shared with other
+  // H-matrices are left intact. Returns the amount of memory saved in kB.
+  double coarsen(double eps);
+
   void apply(const arma::Mat<ValueType> &X, arma::Mat<ValueType> &Y,
              TransposeMode trans, ValueType alpha, ValueType beta) const
       override;
@@ -44,9 +104,76 @@ public:
                            RowColSelector rowOrColumn) const override;
 
 private:
+  // Indices of the leaf blocks whose output range is given by a specific
+  // cluster tree node
+  typedef std::unordered_map<const ClusterTreeNode<N> *,
+                             std::vector<std::size_t>> ApplySchedule;
+
+  typedef tbb::concurrent_unordered_map<
+      const BlockClusterTreeNode<N> *,
+      shared_ptr<const HMatrixData<ValueType>>> LeafDataMap;
+
+  struct ApplyBuffers {
+    arma::Mat<ValueType> xPermuted;
+    arma::Mat<ValueType> yPermuted;
+  };
+
+  void packLeafData(
+      const std::vector<shared_ptr<BlockClusterTreeNode<N>>> &leafNodes,
+      const std::vector<shared_ptr<const HMatrixData<ValueType>>> &leafData);
+
+  void attachLeafData(
+      const std::vector<shared_ptr<BlockClusterTreeNode<N>>> &leafNodes,
+      const std::vector<HMatrixLeafLayout> &leafLayouts,
+      const shared_ptr<ValueType> &arena, std::size_t arenaSize);
+
+  void initializeApplySchedules();
+
+  // Adds copies of the children of node to copy, recursively, and inserts the
+  // data of the leafs of node in leafData into copiedLeafData under the
+  // corresponding leafs of the copy.
+  void copyBlockClusterTreeNode(const BlockClusterTreeNode<N> &node,
+                                const shared_ptr<BlockClusterTreeNode<N>> &copy,
+                                const LeafDataMap &leafData,
+                                LeafDataMap &copiedLeafData) const;
+
+  // Returns the data of node if it is a low-rank leaf after coarsening its
+  // subtree, and a null pointer otherwise. Removed subtrees are kept alive in
+  // removedNodes, as their addresses are used as keys of leafData.
+  shared_ptr<const HMatrixData<ValueType>> coarsenBlockClusterTreeNode(
+      const shared_ptr<BlockClusterTreeNode<N>> &node, double eps,
+      LeafDataMap &leafData,
+      tbb::concurrent_vector<shared_ptr<BlockClusterTreeNode<N>>> &
+          removedNodes) const;
+
+  void applyOnClusterTreeNode(const ClusterTreeNode<N> &outputNode,
+                              const ApplySchedule &applySchedule,
+                              const arma::Mat<ValueType> &xPermuted,
+                              arma::Mat<ValueType> &yPermuted,
+                              TransposeMode trans, ValueType alpha) const;
+
+  void permuteToHMatDofs(const arma::Mat<ValueType> &mat,
+                         const ClusterTree<N> &clusterTree,
+                         arma::Mat<ValueType> &permutedMat) const;
+
   shared_ptr<BlockClusterTree<N>> m_blockClusterTree;
-  std::unordered_map<shared_ptr<BlockClusterTreeNode<N>>,
-                     shared_ptr<HMatrixData<ValueType>>> m_hMatrixData;
+
+  std::vector<HMatrixLeaf<ValueType, N>> m_leafs;
+
+  // Data of all leafs. The matrices of the data objects are views into a
+  // single arena allocation.
+  std::vector<HMatrixDenseData<ValueType>> m_denseData;
+  std::vector<HMatrixLowRankData<ValueType>> m_lowRankData;
+  shared_ptr<ValueType> m_arena;
+  std::size_t m_arenaSize;
+
+  // Leaf blocks grouped by the row (resp. column) cluster they write to.
+  // Blocks belonging to disjoint clusters can be applied concurrently.
+  ApplySchedule m_rowApplySchedule;
+  ApplySchedule m_columnApplySchedule;
+
+  // Permutation buffers that are reused between calls to apply
+  mutable tbb::concurrent_queue<shared_ptr<ApplyBuffers>> m_applyBuffers;
 };
 }
 
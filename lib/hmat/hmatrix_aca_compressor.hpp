@@ -14,9 +14,14 @@ namespace hmat {
 template <typename ValueType, int N>
 class HMatrixAcaCompressor : public HMatrixCompressor<ValueType, N> {
 public:
+  // If adaptiveRank is true the ACA stops as soon as the error estimate
+  // is below eps, and a block is stored dense if its low-rank representation
+  // would need more memory. Otherwise each admissible block is approximated
+  // with rank maxRank.
   HMatrixAcaCompressor(const DataAccessor<ValueType, N> &dataAccessor,
                        double eps, unsigned int maxRank,
-                       unsigned int resizeThreshold = 10);
+                       unsigned int resizeThreshold = 10,
+                       bool adaptiveRank = true);
 
   void compressBlock(const BlockClusterTreeNode<N> &blockClusterTreeNode,
                      shared_ptr<HMatrixData<ValueType>> &hMatrixData) const
@@ -36,6 +41,7 @@ private:
   double m_eps;
   unsigned int m_maxRank;
   unsigned int m_resizeThreshold;
+  bool m_adaptiveRank;
   HMatrixDenseCompressor<ValueType, N> m_hMatrixDenseCompressor;
 };
 }
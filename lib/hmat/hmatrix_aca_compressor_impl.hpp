@@ -91,6 +91,16 @@ void HMatrixAcaCompressor<ValueType, N>::compressBlock(
     evaluateMatMinusLowRank(blockClusterTreeNode, rowIndexRange,
                             columnIndexRange, newCol, A, B);
 
+    if (m_adaptiveRank &&
+        (rankCount + 1) * (numberOfRows + numberOfColumns) >=
+            numberOfRows * numberOfColumns) {
+      // The low-rank representation would be more expensive than the dense
+      // block
+      m_hMatrixDenseCompressor.compressBlock(blockClusterTreeNode,
+                                             hMatrixData);
+      return;
+    }
+
     auto frobeniousNorm = hMatrixData->frobeniusNorm();
 
     if (rankCount == A.n_cols) {
@@ -104,7 +114,8 @@ void HMatrixAcaCompressor<ValueType, N>::compressBlock(
 
     rankCount++;
 
-    if (arma::norm(newCol, 2) * arma::norm(newRow, 2) < m_eps * frobeniousNorm)
+    if (m_adaptiveRank &&
+        arma::norm(newCol, 2) * arma::norm(newRow, 2) < m_eps * frobeniousNorm)
       break;
   }
   if (A.n_cols - rankCount > 0) {
@@ -116,9 +127,9 @@ void HMatrixAcaCompressor<ValueType, N>::compressBlock(
 template <typename ValueType, int N>
 HMatrixAcaCompressor<ValueType, N>::HMatrixAcaCompressor(
     const DataAccessor<ValueType, N> &dataAccessor, double eps,
-    unsigned int maxRank, unsigned int resizeThreshold)
+    unsigned int maxRank, unsigned int resizeThreshold, bool adaptiveRank)
     : m_dataAccessor(dataAccessor), m_eps(eps), m_maxRank(maxRank),
-      m_resizeThreshold(resizeThreshold),
+      m_resizeThreshold(resizeThreshold), m_adaptiveRank(adaptiveRank),
       m_hMatrixDenseCompressor(dataAccessor) {}
 
 template <typename ValueType, int N>
@@ -152,7 +163,9 @@ std::size_t HMatrixAcaCompressor<ValueType, N>::randomIndex(
 
   std::size_t numberOfPossibleIndices =
       range[1] - range[0] - previousIndices.size();
-  static std::random_device generator;
+  // compressBlock is called concurrently for different leaf blocks, so each
+  // thread needs its own generator.
+  static thread_local std::mt19937 generator{std::random_device()()};
   std::uniform_int_distribution<std::size_t> distribution(
       0, numberOfPossibleIndices - 1);
 
@@ -0,0 +1,65 @@
+// vi: set et ts=4 sw=2 sts=2:
+
+#ifndef HMAT_HMATRIX_ACA_PLUS_COMPRESSOR_HPP
+#define HMAT_HMATRIX_ACA_PLUS_COMPRESSOR_HPP
+
+#include "common.hpp"
+#include "hmatrix_compressor.hpp"
+#include "hmatrix_dense_compressor.hpp"
+#include "data_accessor.hpp"
+#include "scalar_traits.hpp"
+#include <vector>
+
+namespace hmat {
+
+// Partially pivoted ACA+ (Grasedyck, Computing 74 (2005)). Pivots are taken
+// from a reference row and a reference column of the residual, which are
+// updated with every cross and replaced once they are exhausted, so that the
+// pivot sequence is deterministic. The Frobenius norm of the approximation is
+// updated incrementally and the low-rank factors are allocated only once.
+template <typename ValueType, int N>
+class HMatrixAcaPlusCompressor : public HMatrixCompressor<ValueType, N> {
+public:
+  // adaptiveRank has the same meaning as for HMatrixAcaCompressor.
+  HMatrixAcaPlusCompressor(const DataAccessor<ValueType, N> &dataAccessor,
+                           double eps, unsigned int maxRank,
+                           bool adaptiveRank = true);
+
+  void compressBlock(const BlockClusterTreeNode<N> &blockClusterTreeNode,
+                     shared_ptr<HMatrixData<ValueType>> &hMatrixData) const
+      override;
+
+private:
+  typedef typename ScalarTraits<ValueType>::RealType RealType;
+
+  // Evaluate row (column) index of the residual M - A * B, where only the
+  // first rank columns of A (rows of B) are used. Indices are local to the
+  // block.
+  void evaluateResidualRow(const BlockClusterTreeNode<N> &blockClusterTreeNode,
+                           std::size_t index, std::size_t rank,
+                           const arma::Mat<ValueType> &A,
+                           const arma::Mat<ValueType> &B,
+                           arma::Mat<ValueType> &row) const;
+
+  void
+  evaluateResidualColumn(const BlockClusterTreeNode<N> &blockClusterTreeNode,
+                         std::size_t index, std::size_t rank,
+                         const arma::Mat<ValueType> &A,
+                         const arma::Mat<ValueType> &B,
+                         arma::Mat<ValueType> &column) const;
+
+  // Largest absolute value among the entries not marked as used.
+  static RealType maxAbs(const arma::Mat<ValueType> &data,
+                         const std::vector<bool> &used, std::size_t &index);
+
+  const DataAccessor<ValueType, N> &m_dataAccessor;
+  double m_eps;
+  unsigned int m_maxRank;
+  bool m_adaptiveRank;
+  HMatrixDenseCompressor<ValueType, N> m_hMatrixDenseCompressor;
+};
+}
+
+#include "hmatrix_aca_plus_compressor_impl.hpp"
+
+#endif
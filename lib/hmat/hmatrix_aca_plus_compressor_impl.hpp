@@ -0,0 +1,276 @@
+// vi: set et ts=4 sw=2 sts=2:
+
+#ifndef HMAT_HMATRIX_ACA_PLUS_COMPRESSOR_IMPL_HPP
+#define HMAT_HMATRIX_ACA_PLUS_COMPRESSOR_IMPL_HPP
+
+#include "hmatrix_aca_plus_compressor.hpp"
+#include "hmatrix_low_rank_data.hpp"
+#include <complex>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+namespace hmat {
+
+template <typename ValueType, int N>
+HMatrixAcaPlusCompressor<ValueType, N>::HMatrixAcaPlusCompressor(
+    const DataAccessor<ValueType, N> &dataAccessor, double eps,
+    unsigned int maxRank, bool adaptiveRank)
+    : m_dataAccessor(dataAccessor), m_eps(eps), m_maxRank(maxRank),
+      m_adaptiveRank(adaptiveRank), m_hMatrixDenseCompressor(dataAccessor) {}
+
+template <typename ValueType, int N>
+void HMatrixAcaPlusCompressor<ValueType, N>::compressBlock(
+    const BlockClusterTreeNode<N> &blockClusterTreeNode,
+    shared_ptr<HMatrixData<ValueType>> &hMatrixData) const {
+
+  if (!blockClusterTreeNode.data().admissible) {
+    m_hMatrixDenseCompressor.compressBlock(blockClusterTreeNode, hMatrixData);
+    return;
+  }
+
+  IndexRangeType rowClusterRange;
+  IndexRangeType columnClusterRange;
+  std::size_t numberOfRows;
+  std::size_t numberOfColumns;
+
+  getBlockClusterTreeNodeDimensions(blockClusterTreeNode, rowClusterRange,
+                                    columnClusterRange, numberOfRows,
+                                    numberOfColumns);
+
+  const std::size_t rankLimit =
+      std::min(static_cast<std::size_t>(m_maxRank),
+               std::min(numberOfRows, numberOfColumns));
+
+  // All buffers are allocated up front. The factors are copied only once,
+  // into blocks of the final rank, after the iteration has finished.
+  arma::Mat<ValueType> A(numberOfRows, rankLimit);
+  arma::Mat<ValueType> B(rankLimit, numberOfColumns);
+  arma::Mat<ValueType> row(1, numberOfColumns);
+  arma::Mat<ValueType> column(numberOfRows, 1);
+  arma::Mat<ValueType> referenceRow(1, numberOfColumns);
+  arma::Mat<ValueType> referenceColumn(numberOfRows, 1);
+
+  std::vector<bool> usedRows(numberOfRows, false);
+  std::vector<bool> usedColumns(numberOfColumns, false);
+
+  std::size_t rank = 0;
+  std::size_t index;
+
+  // Residual entries below zeroTolerance are treated as zero. It is zero
+  // until the first reference row and column have been found and is then
+  // set relative to their entries.
+  RealType zeroTolerance = 0;
+  const std::size_t maxReferenceTrials = 10;
+
+  // Reference rows and columns are taken in increasing order among the
+  // indices that have not been used as pivots. A candidate with a vanishing
+  // residual is already approximated and is marked as used.
+  std::size_t referenceRowIndex = 0;
+  std::size_t referenceColumnIndex = 0;
+  std::size_t nextReferenceRowIndex = 0;
+  std::size_t nextReferenceColumnIndex = 0;
+  bool haveReferenceRow = false;
+  bool haveReferenceColumn = false;
+
+  auto findReferenceRow = [&]() {
+    haveReferenceRow = false;
+    for (std::size_t trial = 0; trial < maxReferenceTrials; ++trial) {
+      while (nextReferenceRowIndex < numberOfRows &&
+             usedRows[nextReferenceRowIndex])
+        ++nextReferenceRowIndex;
+      if (nextReferenceRowIndex == numberOfRows)
+        return;
+      referenceRowIndex = nextReferenceRowIndex++;
+      evaluateResidualRow(blockClusterTreeNode, referenceRowIndex, rank, A, B,
+                          referenceRow);
+      if (maxAbs(referenceRow, usedColumns, index) > zeroTolerance) {
+        haveReferenceRow = true;
+        return;
+      }
+      usedRows[referenceRowIndex] = true;
+    }
+  };
+
+  auto findReferenceColumn = [&]() {
+    haveReferenceColumn = false;
+    for (std::size_t trial = 0; trial < maxReferenceTrials; ++trial) {
+      while (nextReferenceColumnIndex < numberOfColumns &&
+             usedColumns[nextReferenceColumnIndex])
+        ++nextReferenceColumnIndex;
+      if (nextReferenceColumnIndex == numberOfColumns)
+        return;
+      referenceColumnIndex = nextReferenceColumnIndex++;
+      evaluateResidualColumn(blockClusterTreeNode, referenceColumnIndex, rank,
+                             A, B, referenceColumn);
+      if (maxAbs(referenceColumn, usedRows, index) > zeroTolerance) {
+        haveReferenceColumn = true;
+        return;
+      }
+      usedColumns[referenceColumnIndex] = true;
+    }
+  };
+
+  findReferenceRow();
+  findReferenceColumn();
+  {
+    RealType scale = 0;
+    if (haveReferenceRow)
+      scale = std::max(scale, maxAbs(referenceRow, usedColumns, index));
+    if (haveReferenceColumn)
+      scale = std::max(scale, maxAbs(referenceColumn, usedRows, index));
+    zeroTolerance = 100 * std::numeric_limits<RealType>::epsilon() * scale;
+  }
+
+  // Squared Frobenius norm of A * B
+  RealType squaredNorm = 0;
+
+  while (rank < rankLimit) {
+
+    std::size_t rowPivot = 0;
+    std::size_t columnPivot = 0;
+
+    if (haveReferenceRow && (usedRows[referenceRowIndex] ||
+                             maxAbs(referenceRow, usedColumns, index) <=
+                                 zeroTolerance))
+      findReferenceRow();
+    if (haveReferenceColumn && (usedColumns[referenceColumnIndex] ||
+                                maxAbs(referenceColumn, usedRows, index) <=
+                                    zeroTolerance))
+      findReferenceColumn();
+
+    if (!haveReferenceRow && !haveReferenceColumn)
+      break; // No residual entries left to pivot on
+
+    const RealType referenceColumnMax =
+        haveReferenceColumn ? maxAbs(referenceColumn, usedRows, rowPivot) : 0;
+    const RealType referenceRowMax =
+        haveReferenceRow ? maxAbs(referenceRow, usedColumns, columnPivot) : 0;
+
+    if (referenceColumnMax > referenceRowMax) {
+      evaluateResidualRow(blockClusterTreeNode, rowPivot, rank, A, B, row);
+      if (maxAbs(row, usedColumns, columnPivot) <= zeroTolerance) {
+        usedRows[rowPivot] = true; // Row is already approximated
+        continue;
+      }
+      evaluateResidualColumn(blockClusterTreeNode, columnPivot, rank, A, B,
+                             column);
+    } else {
+      evaluateResidualColumn(blockClusterTreeNode, columnPivot, rank, A, B,
+                             column);
+      if (maxAbs(column, usedRows, rowPivot) <= zeroTolerance) {
+        usedColumns[columnPivot] = true; // Column is already approximated
+        continue;
+      }
+      evaluateResidualRow(blockClusterTreeNode, rowPivot, rank, A, B, row);
+    }
+
+    usedRows[rowPivot] = true;
+    usedColumns[columnPivot] = true;
+
+    const ValueType pivot = column(rowPivot, 0);
+    A.col(rank) = column / pivot;
+    B.row(rank) = row;
+
+    // ||S + a * b||^2 = ||S||^2 + 2 Re sum_l (a_l^H a)(b_l^H b) + ||a||^2||b||^2
+    const RealType crossNorm =
+        arma::norm(A.col(rank), 2) * arma::norm(B.row(rank), 2);
+    ValueType mixedTerms = 0;
+    for (std::size_t l = 0; l < rank; ++l)
+      mixedTerms += arma::cdot(A.col(l), A.col(rank)) *
+                    arma::cdot(B.row(l), B.row(rank));
+    squaredNorm += 2 * std::real(mixedTerms) + crossNorm * crossNorm;
+
+    if (haveReferenceColumn)
+      referenceColumn -= B(rank, referenceColumnIndex) * A.col(rank);
+    if (haveReferenceRow)
+      referenceRow -= A(referenceRowIndex, rank) * B.row(rank);
+
+    rank++;
+
+    if (m_adaptiveRank) {
+      if (rank * (numberOfRows + numberOfColumns) >=
+          numberOfRows * numberOfColumns) {
+        // The low-rank representation would be more expensive than the dense
+        // block
+        m_hMatrixDenseCompressor.compressBlock(blockClusterTreeNode,
+                                               hMatrixData);
+        return;
+      }
+      if (crossNorm <=
+          m_eps * std::sqrt(std::max(squaredNorm, RealType(0))))
+        break;
+    }
+  }
+
+  hMatrixData.reset(new HMatrixLowRankData<ValueType>());
+  auto lowRankData =
+      static_cast<HMatrixLowRankData<ValueType> *>(hMatrixData.get());
+  lowRankData->A() = A.head_cols(rank);
+  lowRankData->B() = B.head_rows(rank);
+}
+
+template <typename ValueType, int N>
+void HMatrixAcaPlusCompressor<ValueType, N>::evaluateResidualRow(
+    const BlockClusterTreeNode<N> &blockClusterTreeNode, std::size_t index,
+    std::size_t rank, const arma::Mat<ValueType> &A,
+    const arma::Mat<ValueType> &B, arma::Mat<ValueType> &row) const {
+
+  const IndexRangeType &rowClusterRange =
+      blockClusterTreeNode.data().rowClusterTreeNode->data().indexRange;
+  const IndexRangeType &columnClusterRange =
+      blockClusterTreeNode.data().columnClusterTreeNode->data().indexRange;
+
+  IndexRangeType rowIndexRange = {
+      {rowClusterRange[0] + index, rowClusterRange[0] + index + 1}};
+
+  m_dataAccessor.computeMatrixBlock(rowIndexRange, columnClusterRange,
+                                    blockClusterTreeNode, row);
+
+  for (std::size_t l = 0; l < rank; ++l)
+    row -= A(index, l) * B.row(l);
+}
+
+template <typename ValueType, int N>
+void HMatrixAcaPlusCompressor<ValueType, N>::evaluateResidualColumn(
+    const BlockClusterTreeNode<N> &blockClusterTreeNode, std::size_t index,
+    std::size_t rank, const arma::Mat<ValueType> &A,
+    const arma::Mat<ValueType> &B, arma::Mat<ValueType> &column) const {
+
+  const IndexRangeType &rowClusterRange =
+      blockClusterTreeNode.data().rowClusterTreeNode->data().indexRange;
+  const IndexRangeType &columnClusterRange =
+      blockClusterTreeNode.data().columnClusterTreeNode->data().indexRange;
+
+  IndexRangeType columnIndexRange = {
+      {columnClusterRange[0] + index, columnClusterRange[0] + index + 1}};
+
+  m_dataAccessor.computeMatrixBlock(rowClusterRange, columnIndexRange,
+                                    blockClusterTreeNode, column);
+
+  for (std::size_t l = 0; l < rank; ++l)
+    column -= B(l, index) * A.col(l);
+}
+
+template <typename ValueType, int N>
+typename HMatrixAcaPlusCompressor<ValueType, N>::RealType
+HMatrixAcaPlusCompressor<ValueType, N>::maxAbs(const arma::Mat<ValueType> &data,
+                                               const std::vector<bool> &used,
+                                               std::size_t &index) {
+
+  RealType result = 0;
+  index = 0;
+  for (std::size_t i = 0; i < data.n_elem; ++i) {
+    if (used[i])
+      continue;
+    const RealType value = std::abs(data[i]);
+    if (value > result) {
+      result = value;
+      index = i;
+    }
+  }
+  return result;
+}
+}
+
+#endif
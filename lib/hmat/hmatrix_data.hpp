@@ -9,8 +9,15 @@
 
 namespace hmat {
 
+enum DataBlockType {
+  DENSE,
+  LOW_RANK
+};
+
 template <typename ValueType> class HMatrixData {
 public:
+  virtual ~HMatrixData() {}
+
   virtual void apply(const arma::Mat<ValueType> &X, arma::Mat<ValueType> &Y,
                      TransposeMode trans, ValueType alpha,
                      ValueType beta) const = 0;
@@ -23,6 +30,11 @@ public:
   virtual int cols() const = 0;
   virtual int rank() const = 0;
 
+  virtual DataBlockType type() const = 0;
+
+  // Number of scalars needed to store the data of the block
+  virtual std::size_t numberOfElements() const = 0;
+
   virtual typename ScalarTraits<ValueType>::RealType frobeniusNorm() const = 0;
 
   virtual double memSizeKb() const = 0;
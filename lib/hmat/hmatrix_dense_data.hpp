@@ -12,6 +12,12 @@ namespace hmat {
 template <typename ValueType>
 class HMatrixDenseData : public HMatrixData<ValueType> {
 public:
+  HMatrixDenseData();
+
+  // Block whose matrix is stored in externally owned memory of size
+  // rows * cols
+  HMatrixDenseData(ValueType *memory, int rows, int cols);
+
   void apply(const arma::Mat<ValueType> &X, arma::Mat<ValueType> &Y,
              TransposeMode trans, ValueType alpha, ValueType beta) const
       override;
@@ -27,6 +33,9 @@ public:
   int cols() const override;
   int rank() const override;
 
+  DataBlockType type() const override;
+  std::size_t numberOfElements() const override;
+
   typename ScalarTraits<ValueType>::RealType frobeniusNorm() const override;
 
   double memSizeKb() const override;
@@ -10,6 +10,13 @@
 
 namespace hmat {
 
+template <typename ValueType> HMatrixDenseData<ValueType>::HMatrixDenseData() {}
+
+template <typename ValueType>
+HMatrixDenseData<ValueType>::HMatrixDenseData(ValueType *memory, int rows,
+                                              int cols)
+    : m_A(memory, rows, cols, false, true) {}
+
 template <typename ValueType>
 void HMatrixDenseData<ValueType>::apply(const arma::Mat<ValueType> &X,
                                         arma::Mat<ValueType> &Y,
@@ -66,6 +73,16 @@ template <typename ValueType> int HMatrixDenseData<ValueType>::rank() const {
   return m_A.n_cols;
 }
 
+template <typename ValueType>
+DataBlockType HMatrixDenseData<ValueType>::type() const {
+  return DENSE;
+}
+
+template <typename ValueType>
+std::size_t HMatrixDenseData<ValueType>::numberOfElements() const {
+  return m_A.n_elem;
+}
+
 template <typename ValueType>
 typename ScalarTraits<ValueType>::RealType
 HMatrixDenseData<ValueType>::frobeniusNorm() const {
@@ -6,22 +6,35 @@
 #include "hmatrix.hpp"
 #include "hmatrix_data.hpp"
 #include "hmatrix_dense_data.hpp"
+#include "hmatrix_low_rank_data.hpp"
+#include "low_rank_truncation.hpp"
+
+#include <boost/checked_delete.hpp>
 
 #include <algorithm>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+
+#include <tbb/parallel_for.h>
+#include <tbb/concurrent_queue.h>
+#include <tbb/concurrent_unordered_map.h>
+#include <tbb/concurrent_vector.h>
+#include <tbb/task_group.h>
 
 namespace hmat {
 
 template <typename ValueType, int N>
 HMatrix<ValueType, N>::HMatrix(
     const shared_ptr<BlockClusterTree<N>> &blockClusterTree)
-    : m_blockClusterTree(blockClusterTree) {}
+    : m_blockClusterTree(blockClusterTree), m_arenaSize(0) {}
 
 template <typename ValueType, int N>
 HMatrix<ValueType, N>::HMatrix(
     const shared_ptr<BlockClusterTree<N>> &blockClusterTree,
-    const HMatrixCompressor<ValueType, N> &hMatrixCompressor)
+    const HMatrixCompressor<ValueType, N> &hMatrixCompressor, bool symmetric)
     : HMatrix<ValueType, N>(blockClusterTree) {
-  initialize(hMatrixCompressor);
+  initialize(hMatrixCompressor, symmetric);
 }
 
 template <typename ValueType, int N>
@@ -36,23 +49,486 @@ std::size_t HMatrix<ValueType, N>::columns() const {
 
 template <typename ValueType, int N>
 void HMatrix<ValueType, N>::initialize(
-    const HMatrixCompressor<ValueType, N> &hMatrixCompressor) {
+    const HMatrixCompressor<ValueType, N> &hMatrixCompressor, bool symmetric) {
+
+  reset();
+
+  if (symmetric &&
+      m_blockClusterTree->rowClusterTree() !=
+          m_blockClusterTree->columnClusterTree())
+    throw std::invalid_argument("HMatrix::initialize(): Symmetric "
+                                "H-matrices require identical row and "
+                                "column cluster trees.");
+
+  // Leaf nodes are returned in tree order, which is also the storage order
+  auto leafNodes = m_blockClusterTree->leafNodes();
+
+  // In the symmetric case blocks below the diagonal are copied from their
+  // mirror blocks above the diagonal after compression.
+
+  std::vector<std::size_t> compressionOrder;
+  std::vector<std::pair<std::size_t, std::size_t>> mirroredLeafs;
+  if (symmetric) {
+    std::map<BlockIndexRangeType, std::size_t> upperLeafIndices;
+    for (std::size_t i = 0; i < leafNodes.size(); ++i) {
+      const auto &rowRange =
+          leafNodes[i]->data().rowClusterTreeNode->data().indexRange;
+      const auto &columnRange =
+          leafNodes[i]->data().columnClusterTreeNode->data().indexRange;
+      if (rowRange[0] <= columnRange[0])
+        upperLeafIndices[BlockIndexRangeType{{rowRange[0], rowRange[1],
+                                              columnRange[0],
+                                              columnRange[1]}}] = i;
+    }
+    for (std::size_t i = 0; i < leafNodes.size(); ++i) {
+      const auto &rowRange =
+          leafNodes[i]->data().rowClusterTreeNode->data().indexRange;
+      const auto &columnRange =
+          leafNodes[i]->data().columnClusterTreeNode->data().indexRange;
+      if (rowRange[0] <= columnRange[0]) {
+        compressionOrder.push_back(i);
+        continue;
+      }
+      auto it = upperLeafIndices.find(BlockIndexRangeType{
+          {columnRange[0], columnRange[1], rowRange[0], rowRange[1]}});
+      if (it == upperLeafIndices.end())
+        compressionOrder.push_back(i); // no mirror block, compress directly
+      else
+        mirroredLeafs.push_back(std::make_pair(i, it->second));
+    }
+  } else {
+    compressionOrder.resize(leafNodes.size());
+    std::iota(begin(compressionOrder), end(compressionOrder), 0);
+  }
+
+  // Compress the largest blocks first so that expensive blocks do not end up
+  // at the tail of the parallel loop while the other threads are idle.
+
+  std::stable_sort(begin(compressionOrder), end(compressionOrder),
+                   [&leafNodes](std::size_t i, std::size_t j) {
+    return blockClusterTreeNodeSize(*leafNodes[i]) >
+           blockClusterTreeNodeSize(*leafNodes[j]);
+  });
+
+  std::vector<shared_ptr<HMatrixData<ValueType>>> leafData(leafNodes.size());
+
+  // The parallel loop only determines how many leaf blocks each thread
+  // processes. The actual block is taken from the queue, which preserves
+  // the ordering by size while TBB balances the load by work stealing.
+
+  tbb::concurrent_queue<std::size_t> leafIndexQueue;
+  for (auto leafIndex : compressionOrder)
+    leafIndexQueue.push(leafIndex);
+
+  tbb::parallel_for(
+      tbb::blocked_range<std::size_t>(0, compressionOrder.size(), 1),
+      [&leafNodes, &leafData, &leafIndexQueue, &hMatrixCompressor](
+          const tbb::blocked_range<std::size_t> &r) {
+        for (std::size_t i = r.begin(); i != r.end(); ++i) {
+          std::size_t leafIndex;
+          if (!leafIndexQueue.try_pop(leafIndex))
+            throw std::runtime_error("HMatrix::initialize(): "
+                                     "Leaf index queue is empty.");
+          hMatrixCompressor.compressBlock(*leafNodes[leafIndex],
+                                          leafData[leafIndex]);
+        }
+      });
+
+  for (const auto &mirroredLeaf : mirroredLeafs) {
+    const HMatrixData<ValueType> &mirrorData = *leafData[mirroredLeaf.second];
+    if (mirrorData.type() == DENSE) {
+      shared_ptr<HMatrixDenseData<ValueType>> data(
+          new HMatrixDenseData<ValueType>());
+      data->A() =
+          static_cast<const HMatrixDenseData<ValueType> &>(mirrorData).A().st();
+      leafData[mirroredLeaf.first] = data;
+    } else {
+      const auto &lowRankMirrorData =
+          static_cast<const HMatrixLowRankData<ValueType> &>(mirrorData);
+      shared_ptr<HMatrixLowRankData<ValueType>> data(
+          new HMatrixLowRankData<ValueType>());
+      data->A() = lowRankMirrorData.B().st();
+      data->B() = lowRankMirrorData.A().st();
+      leafData[mirroredLeaf.first] = data;
+    }
+  }
+
+  packLeafData(leafNodes,
+               std::vector<shared_ptr<const HMatrixData<ValueType>>>(
+                   begin(leafData), end(leafData)));
+}
+
+template <typename ValueType, int N>
+double HMatrix<ValueType, N>::recompress(double eps) {
+
+  if (!isInitialized())
+    return 0;
+
+  const double oldMemSizeKb = memSizeKb();
+
+  // Dense leafs and leafs that cannot be improved are passed on to
+  // packLeafData without taking ownership of them.
+  std::vector<shared_ptr<const HMatrixData<ValueType>>> leafData(
+      m_leafs.size());
+  for (std::size_t i = 0; i < m_leafs.size(); ++i)
+    leafData[i].reset(m_leafs[i].data, [](const HMatrixData<ValueType> *) {});
+
+  tbb::parallel_for(
+      tbb::blocked_range<std::size_t>(0, m_leafs.size()),
+      [this, eps, &leafData](const tbb::blocked_range<std::size_t> &r) {
+        for (std::size_t i = r.begin(); i != r.end(); ++i) {
+          if (m_leafs[i].data->type() != LOW_RANK)
+            continue;
+          const auto &data =
+              static_cast<const HMatrixLowRankData<ValueType> &>(
+                  *m_leafs[i].data);
+          shared_ptr<HMatrixLowRankData<ValueType>> recompressedData(
+              new HMatrixLowRankData<ValueType>());
+          if (truncateLowRankFactors(data.A(), data.B(), eps,
+                                     recompressedData->A(),
+                                     recompressedData->B()) < data.rank())
+            leafData[i] = recompressedData;
+        }
+      });
+
+  packLeafData(m_blockClusterTree->leafNodes(), leafData);
+
+  return oldMemSizeKb - memSizeKb();
+}
+
+template <typename ValueType, int N>
+double HMatrix<ValueType, N>::coarsen(double eps) {
+
+  if (!isInitialized())
+    return 0;
+
+  const double oldMemSizeKb = memSizeKb();
+
+  LeafDataMap originalLeafData;
+  for (const auto &leaf : m_leafs)
+    originalLeafData.insert(std::make_pair(
+        leaf.node, shared_ptr<const HMatrixData<ValueType>>(
+                       leaf.data, [](const HMatrixData<ValueType> *) {})));
+
+  // The tree may be shared, e.g. by an assembler that reuses it for several
+  // H-matrices, so only a copy is coarsened. The original tree is kept alive
+  // until the leafs referencing it have been replaced.
+  const shared_ptr<BlockClusterTree<N>> originalTree = m_blockClusterTree;
+  auto root =
+      make_shared<BlockClusterTreeNode<N>>(originalTree->root()->data());
+  LeafDataMap leafData;
+  copyBlockClusterTreeNode(*originalTree->root(), root, originalLeafData,
+                           leafData);
+  m_blockClusterTree = make_shared<BlockClusterTree<N>>(
+      originalTree->rowClusterTree(), originalTree->columnClusterTree(), root);
+
+  tbb::concurrent_vector<shared_ptr<BlockClusterTreeNode<N>>> removedNodes;
+  coarsenBlockClusterTreeNode(m_blockClusterTree->root(), eps, leafData,
+                              removedNodes);
+
+  auto leafNodes = m_blockClusterTree->leafNodes();
+  std::vector<shared_ptr<const HMatrixData<ValueType>>> newLeafData;
+  newLeafData.reserve(leafNodes.size());
+  for (const auto &node : leafNodes)
+    newLeafData.push_back(leafData.find(node.get())->second);
+
+  packLeafData(leafNodes, newLeafData);
+
+  return oldMemSizeKb - memSizeKb();
+}
+
+template <typename ValueType, int N>
+void HMatrix<ValueType, N>::copyBlockClusterTreeNode(
+    const BlockClusterTreeNode<N> &node,
+    const shared_ptr<BlockClusterTreeNode<N>> &copy,
+    const LeafDataMap &leafData, LeafDataMap &copiedLeafData) const {
+
+  if (node.isLeaf()) {
+    copiedLeafData.insert(std::make_pair(
+        static_cast<const BlockClusterTreeNode<N> *>(copy.get()),
+        leafData.find(&node)->second));
+    return;
+  }
+
+  for (int i = 0; i < N * N; ++i) {
+    copy->addChild(node.child(i)->data(), i);
+    copyBlockClusterTreeNode(*node.child(i), copy->child(i), leafData,
+                             copiedLeafData);
+  }
+}
+
+template <typename ValueType, int N>
+shared_ptr<const HMatrixData<ValueType>>
+HMatrix<ValueType, N>::coarsenBlockClusterTreeNode(
+    const shared_ptr<BlockClusterTreeNode<N>> &node, double eps,
+    LeafDataMap &leafData,
+    tbb::concurrent_vector<shared_ptr<BlockClusterTreeNode<N>>> &removedNodes)
+    const {
+
+  if (node->isLeaf()) {
+    const auto &data = leafData.find(node.get())->second;
+    if (data->type() == LOW_RANK)
+      return data;
+    return shared_ptr<const HMatrixData<ValueType>>();
+  }
+
+  std::array<shared_ptr<const HMatrixData<ValueType>>, N * N> childData;
+
+  tbb::task_group group;
+  for (int i = 0; i < N * N; ++i) {
+    const shared_ptr<BlockClusterTreeNode<N>> child = node->child(i);
+    group.run([this, i, child, eps, &childData, &leafData, &removedNodes]() {
+      childData[i] =
+          coarsenBlockClusterTreeNode(child, eps, leafData, removedNodes);
+    });
+  }
+  group.wait();
+
+  for (const auto &data : childData)
+    if (!data)
+      return shared_ptr<const HMatrixData<ValueType>>();
+
+  // Embed the factors of the children into factors of the whole block
+
+  IndexRangeType rowClusterRange;
+  IndexRangeType columnClusterRange;
+  std::size_t numberOfRows;
+  std::size_t numberOfColumns;
+
+  getBlockClusterTreeNodeDimensions(*node, rowClusterRange, columnClusterRange,
+                                    numberOfRows, numberOfColumns);
+
+  std::size_t totalRank = 0;
+  std::size_t childElements = 0;
+  for (const auto &data : childData) {
+    totalRank += data->rank();
+    childElements += data->numberOfElements();
+  }
+
+  arma::Mat<ValueType> A;
+  arma::Mat<ValueType> B;
+  A.zeros(numberOfRows, totalRank);
+  B.zeros(totalRank, numberOfColumns);
+
+  std::size_t offset = 0;
+  for (int i = 0; i < N * N; ++i) {
+    const auto &lowRankData =
+        static_cast<const HMatrixLowRankData<ValueType> &>(*childData[i]);
+    const std::size_t rank = lowRankData.rank();
+    if (rank == 0)
+      continue;
+    const auto &childNodeData = node->child(i)->data();
+    const std::size_t rowStart =
+        childNodeData.rowClusterTreeNode->data().indexRange[0] -
+        rowClusterRange[0];
+    const std::size_t columnStart =
+        childNodeData.columnClusterTreeNode->data().indexRange[0] -
+        columnClusterRange[0];
+    A.submat(rowStart, offset, rowStart + lowRankData.rows() - 1,
+             offset + rank - 1) = lowRankData.A();
+    B.submat(offset, columnStart, offset + rank - 1,
+             columnStart + lowRankData.cols() - 1) = lowRankData.B();
+    offset += rank;
+  }
+
+  shared_ptr<HMatrixLowRankData<ValueType>> mergedData(
+      new HMatrixLowRankData<ValueType>());
+  truncateLowRankFactors(A, B, eps, mergedData->A(), mergedData->B());
+
+  if (mergedData->numberOfElements() >= childElements)
+    return shared_ptr<const HMatrixData<ValueType>>();
+
+  for (int i = 0; i < N * N; ++i)
+    removedNodes.push_back(node->child(i));
+  node->removeChildren();
+  node->data().admissible = true;
+  leafData.insert(std::make_pair(
+      static_cast<const BlockClusterTreeNode<N> *>(node.get()),
+      shared_ptr<const HMatrixData<ValueType>>(mergedData)));
+
+  return mergedData;
+}
+
+template <typename ValueType, int N>
+void HMatrix<ValueType, N>::initialize(
+    const std::vector<HMatrixLeafLayout> &leafLayouts,
+    const shared_ptr<ValueType> &arena, std::size_t arenaSize) {
+
+  auto leafNodes = m_blockClusterTree->leafNodes();
+  if (leafLayouts.size() != leafNodes.size())
+    throw std::invalid_argument("HMatrix::initialize(): Number of leaf "
+                                "layouts does not match the number of leafs "
+                                "of the block cluster tree.");
+
+  std::size_t requiredSize = 0;
+  for (std::size_t i = 0; i < leafNodes.size(); ++i) {
+    const auto &layout = leafLayouts[i];
+    IndexRangeType rowClusterRange;
+    IndexRangeType columnClusterRange;
+    std::size_t numberOfRows;
+    std::size_t numberOfColumns;
+    getBlockClusterTreeNodeDimensions(*leafNodes[i], rowClusterRange,
+                                      columnClusterRange, numberOfRows,
+                                      numberOfColumns);
+    if (layout.rows != numberOfRows || layout.columns != numberOfColumns ||
+        (layout.type == DENSE && layout.rank != 0) ||
+        (layout.type != DENSE && layout.type != LOW_RANK))
+      throw std::invalid_argument("HMatrix::initialize(): Leaf layout does "
+                                  "not match the block cluster tree.");
+    requiredSize += (layout.type == DENSE)
+                        ? layout.rows * layout.columns
+                        : (layout.rows + layout.columns) * layout.rank;
+  }
+  if (requiredSize != arenaSize)
+    throw std::invalid_argument("HMatrix::initialize(): Size of the arena "
+                                "does not match the leaf layouts.");
+
+  attachLeafData(leafNodes, leafLayouts, arena, arenaSize);
+}
+
+template <typename ValueType, int N>
+void HMatrix<ValueType, N>::packLeafData(
+    const std::vector<shared_ptr<BlockClusterTreeNode<N>>> &leafNodes,
+    const std::vector<shared_ptr<const HMatrixData<ValueType>>> &leafData) {
+
+  std::vector<HMatrixLeafLayout> leafLayouts;
+  leafLayouts.reserve(leafData.size());
+  std::size_t arenaSize = 0;
+
+  for (const auto &data : leafData) {
+    const std::size_t rank = (data->type() == DENSE) ? 0 : data->rank();
+    leafLayouts.push_back(
+        HMatrixLeafLayout{data->type(), static_cast<std::size_t>(data->rows()),
+                          static_cast<std::size_t>(data->cols()), rank});
+    arenaSize += data->numberOfElements();
+  }
+
+  // Copy into the new storage before releasing the old one, as leafData may
+  // refer to the current leafs.
+
+  shared_ptr<ValueType> arena(new ValueType[arenaSize],
+                              boost::checked_array_deleter<ValueType>());
+
+  ValueType *memory = arena.get();
+  for (const auto &data : leafData) {
+    if (data->type() == DENSE) {
+      const auto &A =
+          static_cast<const HMatrixDenseData<ValueType> &>(*data).A();
+      memory = std::copy(A.memptr(), A.memptr() + A.n_elem, memory);
+    } else {
+      const auto &lowRankData =
+          static_cast<const HMatrixLowRankData<ValueType> &>(*data);
+      const auto &A = lowRankData.A();
+      const auto &B = lowRankData.B();
+      memory = std::copy(A.memptr(), A.memptr() + A.n_elem, memory);
+      memory = std::copy(B.memptr(), B.memptr() + B.n_elem, memory);
+    }
+  }
+
+  attachLeafData(leafNodes, leafLayouts, arena, arenaSize);
+}
+
+template <typename ValueType, int N>
+void HMatrix<ValueType, N>::attachLeafData(
+    const std::vector<shared_ptr<BlockClusterTreeNode<N>>> &leafNodes,
+    const std::vector<HMatrixLeafLayout> &leafLayouts,
+    const shared_ptr<ValueType> &arena, std::size_t arenaSize) {
+
+  std::size_t denseCount = 0;
+  for (const auto &layout : leafLayouts)
+    if (layout.type == DENSE)
+      ++denseCount;
+
+  std::vector<HMatrixDenseData<ValueType>> denseData;
+  std::vector<HMatrixLowRankData<ValueType>> lowRankData;
+  std::vector<HMatrixLeaf<ValueType, N>> leafs;
+
+  // No reallocation may happen after reserving, as the leafs point into
+  // the data vectors.
+  denseData.reserve(denseCount);
+  lowRankData.reserve(leafLayouts.size() - denseCount);
+  leafs.reserve(leafLayouts.size());
+
+  ValueType *memory = arena.get();
+  for (std::size_t i = 0; i < leafLayouts.size(); ++i) {
+    const auto &layout = leafLayouts[i];
+    const HMatrixData<ValueType> *data;
+    if (layout.type == DENSE) {
+      denseData.emplace_back(memory, layout.rows, layout.columns);
+      data = &denseData.back();
+    } else {
+      lowRankData.emplace_back(memory, layout.rows, layout.columns,
+                               layout.rank);
+      data = &lowRankData.back();
+    }
+    memory += data->numberOfElements();
+    leafs.push_back(HMatrixLeaf<ValueType, N>{leafNodes[i].get(), data});
+  }
 
   reset();
+  m_arena = arena;
+  m_arenaSize = arenaSize;
+  m_denseData.swap(denseData);
+  m_lowRankData.swap(lowRankData);
+  m_leafs.swap(leafs);
+
+  initializeApplySchedules();
+}
+
+template <typename ValueType, int N>
+void HMatrix<ValueType, N>::initializeApplySchedules() {
 
-  for (auto node : m_blockClusterTree->leafNodes()) {
-    shared_ptr<HMatrixData<ValueType>> nodeData;
-    hMatrixCompressor.compressBlock(*node, nodeData);
-    m_hMatrixData[node] = nodeData;
+  // Leafs are stored in tree order, so the blocks written by one cluster
+  // are traversed in increasing memory order in every call to apply.
+
+  for (std::size_t i = 0; i < m_leafs.size(); ++i) {
+    const auto &nodeData = m_leafs[i].node->data();
+    m_rowApplySchedule[nodeData.rowClusterTreeNode.get()].push_back(i);
+    m_columnApplySchedule[nodeData.columnClusterTreeNode.get()].push_back(i);
   }
 }
+
 template <typename ValueType, int N> void HMatrix<ValueType, N>::reset() {
-  m_hMatrixData.clear();
+  m_leafs.clear();
+  m_denseData.clear();
+  m_lowRankData.clear();
+  m_arena.reset();
+  m_arenaSize = 0;
+  m_rowApplySchedule.clear();
+  m_columnApplySchedule.clear();
 }
 
 template <typename ValueType, int N>
 bool HMatrix<ValueType, N>::isInitialized() const {
-  return (!m_hMatrixData.empty());
+  return (!m_leafs.empty());
+}
+
+template <typename ValueType, int N>
+shared_ptr<const BlockClusterTree<N>>
+HMatrix<ValueType, N>::blockClusterTree() const {
+  return m_blockClusterTree;
+}
+
+template <typename ValueType, int N>
+std::size_t HMatrix<ValueType, N>::numberOfLeafs() const {
+  return m_leafs.size();
+}
+
+template <typename ValueType, int N>
+const HMatrixLeaf<ValueType, N> &
+HMatrix<ValueType, N>::leaf(std::size_t index) const {
+  return m_leafs[index];
+}
+
+template <typename ValueType, int N>
+const std::vector<HMatrixLeaf<ValueType, N>> &
+HMatrix<ValueType, N>::leafs() const {
+  return m_leafs;
+}
+
+template <typename ValueType, int N>
+double HMatrix<ValueType, N>::memSizeKb() const {
+  return sizeof(ValueType) * m_arenaSize / (1.0 * 1024);
 }
 
 template <typename ValueType, int N>
@@ -108,52 +584,117 @@ arma::Mat<ValueType> HMatrix<ValueType, N>::permuteMatToOriginalDofs(
   return originalDofs;
 }
 
+template <typename ValueType, int N>
+void HMatrix<ValueType, N>::permuteToHMatDofs(
+    const arma::Mat<ValueType> &mat, const ClusterTree<N> &clusterTree,
+    arma::Mat<ValueType> &permutedMat) const {
+
+  if (clusterTree.numberOfDofs() != mat.n_rows)
+    throw std::runtime_error("HMatrix::permuteToHMatDofs: "
+                             "Input matrix has wrong number of rows.");
+
+  const auto &hMatDofToOriginalDofMap = clusterTree.hMatDofToOriginalDofMap();
+
+  // set_size does not reallocate if the buffer already has the right shape
+  permutedMat.set_size(mat.n_rows, mat.n_cols);
+  for (std::size_t j = 0; j < mat.n_cols; ++j)
+    for (std::size_t i = 0; i < mat.n_rows; ++i)
+      permutedMat(i, j) = mat(hMatDofToOriginalDofMap[i], j);
+}
+
+template <typename ValueType, int N>
+void HMatrix<ValueType, N>::applyOnClusterTreeNode(
+    const ClusterTreeNode<N> &outputNode, const ApplySchedule &applySchedule,
+    const arma::Mat<ValueType> &xPermuted, arma::Mat<ValueType> &yPermuted,
+    TransposeMode trans, ValueType alpha) const {
+
+  // First apply all blocks writing to the whole output cluster, then descend
+  // into the children, which write to disjoint index ranges.
+
+  auto it = applySchedule.find(&outputNode);
+  if (it != applySchedule.end()) {
+    for (auto leafIndex : it->second) {
+      const HMatrixLeaf<ValueType, N> &leaf = m_leafs[leafIndex];
+      IndexRangeType inputRange;
+      IndexRangeType outputRange;
+      if (trans == TransposeMode::NOTRANS || trans == TransposeMode::CONJ) {
+        inputRange = leaf.node->data().columnClusterTreeNode->data().indexRange;
+        outputRange = leaf.node->data().rowClusterTreeNode->data().indexRange;
+      } else {
+        inputRange = leaf.node->data().rowClusterTreeNode->data().indexRange;
+        outputRange = leaf.node->data().columnClusterTreeNode->data().indexRange;
+      }
+
+      const arma::subview<ValueType> xData =
+          xPermuted.rows(inputRange[0], inputRange[1] - 1);
+      arma::subview<ValueType> yData =
+          yPermuted.rows(outputRange[0], outputRange[1] - 1);
+      leaf.data->apply(xData, yData, trans, alpha, 1);
+    }
+  }
+
+  if (outputNode.isLeaf())
+    return;
+
+  tbb::task_group group;
+  for (int i = 0; i < N; ++i) {
+    const ClusterTreeNode<N> *child = outputNode.child(i).get();
+    group.run([this, child, &applySchedule, &xPermuted, &yPermuted, trans,
+               alpha]() {
+      applyOnClusterTreeNode(*child, applySchedule, xPermuted, yPermuted,
+                             trans, alpha);
+    });
+  }
+  group.wait();
+}
+
 template <typename ValueType, int N>
 void HMatrix<ValueType, N>::apply(const arma::Mat<ValueType> &X,
                                   arma::Mat<ValueType> &Y, TransposeMode trans,
                                   ValueType alpha, ValueType beta) const {
 
-  if (beta == ValueType(0))
-    Y.zeros();
-  else
-    Y *= beta;
+  const bool transposed =
+      (trans == TransposeMode::TRANS || trans == TransposeMode::CONJTRANS);
 
-  arma::Mat<ValueType> xPermuted;
-  arma::Mat<ValueType> yPermuted;
+  const ClusterTree<N> &inputClusterTree =
+      transposed ? *m_blockClusterTree->rowClusterTree()
+                 : *m_blockClusterTree->columnClusterTree();
+  const ClusterTree<N> &outputClusterTree =
+      transposed ? *m_blockClusterTree->columnClusterTree()
+                 : *m_blockClusterTree->rowClusterTree();
+  const ApplySchedule &applySchedule =
+      transposed ? m_columnApplySchedule : m_rowApplySchedule;
 
-  if (trans == TransposeMode::NOTRANS) {
+  if (outputClusterTree.numberOfDofs() != Y.n_rows)
+    throw std::runtime_error("HMatrix::apply: "
+                             "Output matrix has wrong number of rows.");
+  if (X.n_cols != Y.n_cols)
+    throw std::runtime_error("HMatrix::apply: "
+                             "Input and output matrices must have the same "
+                             "number of columns.");
 
-    xPermuted = permuteMatToHMatDofs(X, COL);
-    yPermuted = permuteMatToHMatDofs(Y, ROW);
-  } else {
-    xPermuted = permuteMatToHMatDofs(X, ROW);
-    yPermuted = permuteMatToHMatDofs(Y, COL);
-  }
+  shared_ptr<ApplyBuffers> buffers;
+  if (!m_applyBuffers.try_pop(buffers))
+    buffers.reset(new ApplyBuffers());
 
-  std::for_each(begin(m_hMatrixData), end(m_hMatrixData),
-                [trans, alpha, beta, &xPermuted, &yPermuted, this](
-                    const std::pair<shared_ptr<BlockClusterTreeNode<N>>,
-                                    shared_ptr<HMatrixData<ValueType>>>
-                        elem) {
+  permuteToHMatDofs(X, inputClusterTree, buffers->xPermuted);
+  buffers->yPermuted.zeros(outputClusterTree.numberOfDofs(), X.n_cols);
 
-    IndexRangeType inputRange;
-    IndexRangeType outputRange;
-    if (trans == TransposeMode::NOTRANS) {
-      inputRange = elem.first->data().columnClusterTreeNode->data().indexRange;
-      outputRange = elem.first->data().rowClusterTreeNode->data().indexRange;
-    } else {
-      inputRange = elem.first->data().rowClusterTreeNode->data().indexRange;
-      outputRange = elem.first->data().columnClusterTreeNode->data().indexRange;
-    }
+  applyOnClusterTreeNode(*outputClusterTree.root(), applySchedule,
+                         buffers->xPermuted, buffers->yPermuted, trans, alpha);
 
-    arma::subview<ValueType> xData =
-        xPermuted.rows(inputRange[0], inputRange[1] - 1);
-    arma::subview<ValueType> yData =
-        yPermuted.rows(outputRange[0], outputRange[1] - 1);
-    elem.second->apply(xData, yData, trans, alpha, 1);
-  });
+  if (beta == ValueType(0))
+    Y.zeros();
+  else
+    Y *= beta;
+
+  const auto &hMatDofToOriginalDofMap =
+      outputClusterTree.hMatDofToOriginalDofMap();
+  for (std::size_t j = 0; j < Y.n_cols; ++j)
+    for (std::size_t i = 0; i < Y.n_rows; ++i)
+      Y(hMatDofToOriginalDofMap[i], j) += buffers->yPermuted(i, j);
 
-  Y = this->permuteMatToOriginalDofs(yPermuted, ROW);
+  m_applyBuffers.push(buffers);
 }
 }
 
@@ -13,6 +13,12 @@ template <typename ValueType>
 class HMatrixLowRankData : public HMatrixData<ValueType> {
 
 public:
+  HMatrixLowRankData();
+
+  // Block whose factors are stored in externally owned memory of size
+  // (rows + cols) * rank, A followed by B
+  HMatrixLowRankData(ValueType *memory, int rows, int cols, int rank);
+
   void apply(const arma::Mat<ValueType> &X, arma::Mat<ValueType> &Y,
              TransposeMode trans, ValueType alpha, ValueType beta) const
       override;
@@ -31,6 +37,9 @@ public:
   int cols() const override;
   int rank() const override;
 
+  DataBlockType type() const override;
+  std::size_t numberOfElements() const override;
+
   typename ScalarTraits<ValueType>::RealType frobeniusNorm() const override;
 
   double memSizeKb() const override;
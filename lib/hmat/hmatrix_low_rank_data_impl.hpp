@@ -7,6 +7,16 @@
 
 namespace hmat {
 
+template <typename ValueType>
+HMatrixLowRankData<ValueType>::HMatrixLowRankData() {}
+
+template <typename ValueType>
+HMatrixLowRankData<ValueType>::HMatrixLowRankData(ValueType *memory,
+                                                  int rows, int cols, int rank)
+    : m_A(memory, rows, rank, false, true),
+      m_B(memory + static_cast<std::size_t>(rows) * rank, rank, cols, false,
+          true) {}
+
 template <typename ValueType>
 const arma::Mat<ValueType> &HMatrixLowRankData<ValueType>::A() const {
   return m_A;
@@ -41,13 +51,24 @@ template <typename ValueType> int HMatrixLowRankData<ValueType>::rank() const {
   return m_A.n_cols;
 }
 
+template <typename ValueType>
+DataBlockType HMatrixLowRankData<ValueType>::type() const {
+  return LOW_RANK;
+}
+
+template <typename ValueType>
+std::size_t HMatrixLowRankData<ValueType>::numberOfElements() const {
+  return m_A.n_elem + m_B.n_elem;
+}
+
 template <typename ValueType>
 typename ScalarTraits<ValueType>::RealType
 HMatrixLowRankData<ValueType>::frobeniusNorm() const {
 
   auto aHa = m_A.t() * m_A;
 
-  arma::Mat<ValueType> result(1, 1);
+  arma::Mat<ValueType> result;
+  result.zeros(1, 1);
 
   for (int i = 0; i < m_B.n_cols; ++i) {
     auto col = m_B.col(i);
@@ -0,0 +1,139 @@
+// vi: set et ts=4 sw=2 sts=2:
+
+#ifndef HMAT_HMATRIX_LU_HPP
+#define HMAT_HMATRIX_LU_HPP
+
+#include "common.hpp"
+#include "hmatrix.hpp"
+#include "hmatrix_data.hpp"
+#include <armadillo>
+#include <array>
+#include <complex>
+#include <unordered_map>
+#include <vector>
+
+namespace hmat {
+
+// Approximate LU factorization A = L * U of a square H-matrix computed with
+// H-arithmetic. Low-rank blocks of the factors are truncated to the relative
+// tolerance eps. Dense diagonal leafs are factorized with partial pivoting
+// local to the leaf.
+//
+// If cholesky is true the symmetric factorization A = L * L^T (without
+// complex conjugation) is computed instead, which requires A to be symmetric.
+// For real matrices it is the Cholesky factorization and requires A to be
+// positive definite.
+//
+// The row and column cluster trees of the H-matrix must be identical.
+// Subtrees of the block cluster tree are processed as parallel tasks.
+template <typename ValueType, int N> class HMatrixLu {
+public:
+  HMatrixLu(const HMatrix<ValueType, N> &hMatrix, double eps,
+            bool cholesky = false);
+
+  HMatrixLu(const HMatrixLu &other) = delete;
+  HMatrixLu &operator=(const HMatrixLu &other) = delete;
+
+  std::size_t rows() const;
+  std::size_t columns() const;
+
+  bool isCholesky() const;
+
+  double memSizeKb() const;
+
+  // Overwrite X by A^{-1} X. The rows of X are given in the original ordering
+  // of the degrees of freedom.
+  void solve(arma::Mat<ValueType> &X) const;
+
+private:
+  // A block of the factors. Leaf blocks are either dense (stored in A) or
+  // low-rank (stored as A * B). Factorized diagonal leafs store the lower
+  // factor in A, the upper factor in B and the row pivoting in permutation,
+  // such that the original block is P^T * A * B with P the permutation.
+  // In a factorized subdivided diagonal block the children below the
+  // diagonal belong to the lower factor and those above to the upper factor.
+  struct Block {
+    IndexRangeType rowRange;
+    IndexRangeType columnRange;
+    DataBlockType type;
+    arma::Mat<ValueType> A;
+    arma::Mat<ValueType> B;
+    std::vector<arma::uword> permutation;
+    std::array<shared_ptr<Block>, N * N> children;
+
+    bool isLeaf() const;
+    std::size_t rows() const;
+    std::size_t columns() const;
+  };
+
+  typedef std::unordered_map<const BlockClusterTreeNode<N> *,
+                             const HMatrixData<ValueType> *> LeafDataMap;
+
+  static shared_ptr<Block> copyBlock(const BlockClusterTreeNode<N> &node,
+                                     const LeafDataMap &leafData);
+
+  // In-place factorization of a diagonal block
+  void factorize(Block &M) const;
+  void factorizeCholesky(Block &M) const;
+
+  // X := L^{-1} * X and X := X * U^{-1} for the lower (upper) factor stored in
+  // the factorized diagonal block L (U)
+  void solveLower(const Block &L, Block &X) const;
+  void solveUpper(const Block &U, Block &X) const;
+
+  // Dense versions of the triangular solves. solveLowerDense and
+  // solveUpperLeftDense act on the rows of X, solveUpperDense on its columns.
+  static void solveLowerDense(const Block &L, arma::Mat<ValueType> &X);
+  static void solveUpperLeftDense(const Block &U, arma::Mat<ValueType> &X);
+  static void solveUpperDense(const Block &U, arma::Mat<ValueType> &X);
+
+  // C := C - A * B
+  void multiplyAdd(Block &C, const Block &A, const Block &B) const;
+
+  // C := C + P and C := C + U * V
+  void addDense(Block &C, const arma::Mat<ValueType> &P) const;
+  void addLowRank(Block &C, const arma::Mat<ValueType> &U,
+                  const arma::Mat<ValueType> &V) const;
+
+  // Y += alpha * M * X, where row i of X corresponds to column
+  // i + xOffset of the matrix and row i of Y to row i + yOffset.
+  static void multiplyLeft(const Block &M, const arma::Mat<ValueType> &X,
+                           std::size_t xOffset, arma::Mat<ValueType> &Y,
+                           std::size_t yOffset, ValueType alpha);
+
+  // Y += alpha * X * M, where column i of X corresponds to row i + xOffset of
+  // the matrix and column i of Y to column i + yOffset.
+  static void multiplyRight(const arma::Mat<ValueType> &X, std::size_t xOffset,
+                            const Block &M, arma::Mat<ValueType> &Y,
+                            std::size_t yOffset, ValueType alpha);
+
+  // Split the leaf C according to the row blocks of A and the column blocks
+  // of B, and merge the children of C back into a leaf of the given type.
+  static void subdivide(Block &C, const Block &A, const Block &B);
+  void collapse(Block &C, DataBlockType type) const;
+
+  void lowRankApproximation(const arma::Mat<ValueType> &P,
+                            arma::Mat<ValueType> &A,
+                            arma::Mat<ValueType> &B) const;
+
+  static void convertToDense(Block &M);
+  static arma::Mat<ValueType> denseMatrix(const Block &M);
+  static shared_ptr<Block> transposedCopy(const Block &M);
+  static std::size_t numberOfElements(const Block &M);
+
+  template <typename T>
+  static arma::Mat<T> symmetricCholeskyFactor(const arma::Mat<T> &M);
+  template <typename T> static bool isValidCholeskyPivot(T pivot);
+  template <typename T>
+  static bool isValidCholeskyPivot(const std::complex<T> &pivot);
+
+  shared_ptr<const BlockClusterTree<N>> m_blockClusterTree;
+  shared_ptr<Block> m_root;
+  double m_eps;
+  bool m_cholesky;
+};
+}
+
+#include "hmatrix_lu_impl.hpp"
+
+#endif
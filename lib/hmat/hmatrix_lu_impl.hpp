@@ -0,0 +1,710 @@
+// vi: set et ts=4 sw=2 sts=2:
+
+#ifndef HMAT_HMATRIX_LU_IMPL_HPP
+#define HMAT_HMATRIX_LU_IMPL_HPP
+
+#include "hmatrix_lu.hpp"
+#include "hmatrix_dense_data.hpp"
+#include "hmatrix_low_rank_data.hpp"
+#include "low_rank_truncation.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+#include <tbb/task_group.h>
+
+namespace hmat {
+
+template <typename ValueType, int N>
+bool HMatrixLu<ValueType, N>::Block::isLeaf() const {
+  return !children[0];
+}
+
+template <typename ValueType, int N>
+std::size_t HMatrixLu<ValueType, N>::Block::rows() const {
+  return rowRange[1] - rowRange[0];
+}
+
+template <typename ValueType, int N>
+std::size_t HMatrixLu<ValueType, N>::Block::columns() const {
+  return columnRange[1] - columnRange[0];
+}
+
+template <typename ValueType, int N>
+HMatrixLu<ValueType, N>::HMatrixLu(const HMatrix<ValueType, N> &hMatrix,
+                                   double eps, bool cholesky)
+    : m_blockClusterTree(hMatrix.blockClusterTree()), m_eps(eps),
+      m_cholesky(cholesky) {
+
+  if (!hMatrix.isInitialized())
+    throw std::invalid_argument("HMatrixLu::HMatrixLu(): "
+                                "H-matrix is not initialized.");
+
+  if (m_blockClusterTree->rowClusterTree() !=
+      m_blockClusterTree->columnClusterTree())
+    throw std::invalid_argument("HMatrixLu::HMatrixLu(): "
+                                "Row and column cluster trees of the "
+                                "H-matrix must be identical.");
+
+  LeafDataMap leafData;
+  for (const auto &leaf : hMatrix.leafs())
+    leafData[leaf.node] = leaf.data;
+
+  m_root = copyBlock(*m_blockClusterTree->root(), leafData);
+
+  if (m_cholesky)
+    factorizeCholesky(*m_root);
+  else
+    factorize(*m_root);
+}
+
+template <typename ValueType, int N>
+std::size_t HMatrixLu<ValueType, N>::rows() const {
+  return m_blockClusterTree->rows();
+}
+
+template <typename ValueType, int N>
+std::size_t HMatrixLu<ValueType, N>::columns() const {
+  return m_blockClusterTree->columns();
+}
+
+template <typename ValueType, int N>
+bool HMatrixLu<ValueType, N>::isCholesky() const {
+  return m_cholesky;
+}
+
+template <typename ValueType, int N>
+double HMatrixLu<ValueType, N>::memSizeKb() const {
+  return sizeof(ValueType) * numberOfElements(*m_root) / (1.0 * 1024);
+}
+
+template <typename ValueType, int N>
+void HMatrixLu<ValueType, N>::solve(arma::Mat<ValueType> &X) const {
+
+  if (X.n_rows != rows())
+    throw std::invalid_argument("HMatrixLu::solve(): "
+                                "Input matrix has wrong number of rows.");
+
+  const auto &hMatDofToOriginalDofMap =
+      m_blockClusterTree->rowClusterTree()->hMatDofToOriginalDofMap();
+
+  arma::Mat<ValueType> permuted(X.n_rows, X.n_cols);
+  for (std::size_t j = 0; j < X.n_cols; ++j)
+    for (std::size_t i = 0; i < X.n_rows; ++i)
+      permuted(i, j) = X(hMatDofToOriginalDofMap[i], j);
+
+  solveLowerDense(*m_root, permuted);
+  solveUpperLeftDense(*m_root, permuted);
+
+  for (std::size_t j = 0; j < X.n_cols; ++j)
+    for (std::size_t i = 0; i < X.n_rows; ++i)
+      X(hMatDofToOriginalDofMap[i], j) = permuted(i, j);
+}
+
+template <typename ValueType, int N>
+shared_ptr<typename HMatrixLu<ValueType, N>::Block>
+HMatrixLu<ValueType, N>::copyBlock(const BlockClusterTreeNode<N> &node,
+                                   const LeafDataMap &leafData) {
+
+  shared_ptr<Block> block(new Block());
+  block->rowRange = node.data().rowClusterTreeNode->data().indexRange;
+  block->columnRange = node.data().columnClusterTreeNode->data().indexRange;
+  block->type = DENSE;
+
+  if (!node.isLeaf()) {
+    for (int i = 0; i < N * N; ++i)
+      block->children[i] = copyBlock(*node.child(i), leafData);
+    return block;
+  }
+
+  const HMatrixData<ValueType> &data = *leafData.at(&node);
+  block->type = data.type();
+  if (block->type == DENSE) {
+    block->A = static_cast<const HMatrixDenseData<ValueType> &>(data).A();
+  } else {
+    const auto &lowRankData =
+        static_cast<const HMatrixLowRankData<ValueType> &>(data);
+    block->A = lowRankData.A();
+    block->B = lowRankData.B();
+  }
+  return block;
+}
+
+template <typename ValueType, int N>
+void HMatrixLu<ValueType, N>::factorize(Block &M) const {
+
+  if (M.isLeaf()) {
+    if (M.type != DENSE)
+      throw std::runtime_error("HMatrixLu::factorize(): "
+                               "Diagonal blocks must be dense.");
+    arma::Mat<ValueType> L, U, P;
+    if (!arma::lu(L, U, P, M.A))
+      throw std::runtime_error("HMatrixLu::factorize(): "
+                               "LU decomposition of a diagonal block failed.");
+    for (std::size_t i = 0; i < U.n_rows; ++i)
+      if (U(i, i) == ValueType(0))
+        throw std::runtime_error("HMatrixLu::factorize(): "
+                                 "Matrix is singular.");
+    // P * M = L * U
+    M.permutation.resize(P.n_rows);
+    for (std::size_t i = 0; i < P.n_rows; ++i)
+      for (std::size_t j = 0; j < P.n_cols; ++j)
+        if (P(i, j) != ValueType(0))
+          M.permutation[i] = j;
+    M.A.swap(L);
+    M.B.swap(U);
+    return;
+  }
+
+  for (int k = 0; k < N; ++k) {
+    Block &Mkk = *M.children[N * k + k];
+    factorize(Mkk);
+
+    tbb::task_group group;
+    for (int j = k + 1; j < N; ++j) {
+      Block &Mkj = *M.children[N * k + j];
+      group.run([this, &Mkk, &Mkj]() { solveLower(Mkk, Mkj); });
+    }
+    for (int i = k + 1; i < N; ++i) {
+      Block &Mik = *M.children[N * i + k];
+      group.run([this, &Mkk, &Mik]() { solveUpper(Mkk, Mik); });
+    }
+    group.wait();
+
+    for (int i = k + 1; i < N; ++i)
+      for (int j = k + 1; j < N; ++j) {
+        Block &Mij = *M.children[N * i + j];
+        const Block &Mik = *M.children[N * i + k];
+        const Block &Mkj = *M.children[N * k + j];
+        group.run([this, &Mij, &Mik, &Mkj]() { multiplyAdd(Mij, Mik, Mkj); });
+      }
+    group.wait();
+  }
+}
+
+template <typename ValueType, int N>
+void HMatrixLu<ValueType, N>::factorizeCholesky(Block &M) const {
+
+  if (M.isLeaf()) {
+    if (M.type != DENSE)
+      throw std::runtime_error("HMatrixLu::factorizeCholesky(): "
+                               "Diagonal blocks must be dense.");
+    M.A = symmetricCholeskyFactor(M.A);
+    M.B = M.A.st();
+    return;
+  }
+
+  // Only the lower triangle is updated. The blocks above the diagonal are
+  // replaced by the transposes of the computed lower blocks, so that the
+  // solves can treat the result like an LU factorization.
+
+  for (int k = 0; k < N; ++k) {
+    Block &Mkk = *M.children[N * k + k];
+    factorizeCholesky(Mkk);
+
+    tbb::task_group group;
+    for (int i = k + 1; i < N; ++i) {
+      Block &Mik = *M.children[N * i + k];
+      group.run([this, &Mkk, &Mik]() { solveUpper(Mkk, Mik); });
+    }
+    group.wait();
+
+    for (int j = k + 1; j < N; ++j)
+      M.children[N * k + j] = transposedCopy(*M.children[N * j + k]);
+
+    for (int i = k + 1; i < N; ++i)
+      for (int j = k + 1; j <= i; ++j) {
+        Block &Mij = *M.children[N * i + j];
+        const Block &Mik = *M.children[N * i + k];
+        const Block &Mkj = *M.children[N * k + j];
+        group.run([this, &Mij, &Mik, &Mkj]() { multiplyAdd(Mij, Mik, Mkj); });
+      }
+    group.wait();
+  }
+}
+
+template <typename ValueType, int N>
+void HMatrixLu<ValueType, N>::solveLower(const Block &L, Block &X) const {
+
+  if (X.isLeaf()) {
+    // For low-rank blocks only the left factor is affected
+    solveLowerDense(L, X.A);
+    return;
+  }
+
+  if (L.isLeaf()) {
+    convertToDense(X);
+    solveLowerDense(L, X.A);
+    return;
+  }
+
+  // The block columns of X are independent of each other
+  tbb::task_group group;
+  for (int j = 0; j < N; ++j)
+    group.run([this, &L, &X, j]() {
+      for (int i = 0; i < N; ++i) {
+        Block &Xij = *X.children[N * i + j];
+        for (int k = 0; k < i; ++k)
+          multiplyAdd(Xij, *L.children[N * i + k], *X.children[N * k + j]);
+        solveLower(*L.children[N * i + i], Xij);
+      }
+    });
+  group.wait();
+}
+
+template <typename ValueType, int N>
+void HMatrixLu<ValueType, N>::solveUpper(const Block &U, Block &X) const {
+
+  if (X.isLeaf()) {
+    // For low-rank blocks only the right factor is affected
+    if (X.type == DENSE)
+      solveUpperDense(U, X.A);
+    else
+      solveUpperDense(U, X.B);
+    return;
+  }
+
+  if (U.isLeaf()) {
+    convertToDense(X);
+    solveUpperDense(U, X.A);
+    return;
+  }
+
+  // The block rows of X are independent of each other
+  tbb::task_group group;
+  for (int i = 0; i < N; ++i)
+    group.run([this, &U, &X, i]() {
+      for (int j = 0; j < N; ++j) {
+        Block &Xij = *X.children[N * i + j];
+        for (int k = 0; k < j; ++k)
+          multiplyAdd(Xij, *X.children[N * i + k], *U.children[N * k + j]);
+        solveUpper(*U.children[N * j + j], Xij);
+      }
+    });
+  group.wait();
+}
+
+template <typename ValueType, int N>
+void HMatrixLu<ValueType, N>::solveLowerDense(const Block &L,
+                                              arma::Mat<ValueType> &X) {
+
+  if (X.n_cols == 0)
+    return;
+
+  if (L.isLeaf()) {
+    if (L.permutation.empty()) {
+      X = arma::solve(arma::trimatl(L.A), X);
+    } else {
+      arma::Mat<ValueType> permuted(X.n_rows, X.n_cols);
+      for (std::size_t i = 0; i < X.n_rows; ++i)
+        permuted.row(i) = X.row(L.permutation[i]);
+      X = arma::solve(arma::trimatl(L.A), permuted);
+    }
+    return;
+  }
+
+  for (int i = 0; i < N; ++i) {
+    const Block &Lii = *L.children[N * i + i];
+    const std::size_t start = Lii.rowRange[0] - L.rowRange[0];
+    const std::size_t end = Lii.rowRange[1] - L.rowRange[0] - 1;
+    arma::Mat<ValueType> Xi = X.rows(start, end);
+    for (int j = 0; j < i; ++j)
+      multiplyLeft(*L.children[N * i + j], X, L.rowRange[0], Xi,
+                   Lii.rowRange[0], -1);
+    solveLowerDense(Lii, Xi);
+    X.rows(start, end) = Xi;
+  }
+}
+
+template <typename ValueType, int N>
+void HMatrixLu<ValueType, N>::solveUpperLeftDense(const Block &U,
+                                                  arma::Mat<ValueType> &X) {
+
+  if (X.n_cols == 0)
+    return;
+
+  if (U.isLeaf()) {
+    X = arma::solve(arma::trimatu(U.B), X);
+    return;
+  }
+
+  for (int i = N - 1; i >= 0; --i) {
+    const Block &Uii = *U.children[N * i + i];
+    const std::size_t start = Uii.rowRange[0] - U.rowRange[0];
+    const std::size_t end = Uii.rowRange[1] - U.rowRange[0] - 1;
+    arma::Mat<ValueType> Xi = X.rows(start, end);
+    for (int j = i + 1; j < N; ++j)
+      multiplyLeft(*U.children[N * i + j], X, U.rowRange[0], Xi,
+                   Uii.rowRange[0], -1);
+    solveUpperLeftDense(Uii, Xi);
+    X.rows(start, end) = Xi;
+  }
+}
+
+template <typename ValueType, int N>
+void HMatrixLu<ValueType, N>::solveUpperDense(const Block &U,
+                                              arma::Mat<ValueType> &X) {
+
+  if (X.n_rows == 0)
+    return;
+
+  if (U.isLeaf()) {
+    // X * U^{-1} = (U^{-T} * X^T)^T
+    arma::Mat<ValueType> Ut = U.B.st();
+    X = arma::solve(arma::trimatl(Ut), arma::Mat<ValueType>(X.st())).st();
+    return;
+  }
+
+  for (int j = 0; j < N; ++j) {
+    const Block &Ujj = *U.children[N * j + j];
+    const std::size_t start = Ujj.columnRange[0] - U.columnRange[0];
+    const std::size_t end = Ujj.columnRange[1] - U.columnRange[0] - 1;
+    arma::Mat<ValueType> Xj = X.cols(start, end);
+    for (int i = 0; i < j; ++i)
+      multiplyRight(X, U.columnRange[0], *U.children[N * i + j], Xj,
+                    Ujj.columnRange[0], -1);
+    solveUpperDense(Ujj, Xj);
+    X.cols(start, end) = Xj;
+  }
+}
+
+template <typename ValueType, int N>
+void HMatrixLu<ValueType, N>::multiplyAdd(Block &C, const Block &A,
+                                          const Block &B) const {
+
+  if (A.isLeaf() && A.type == LOW_RANK) {
+    arma::Mat<ValueType> T;
+    T.zeros(A.B.n_rows, B.columns());
+    multiplyRight(A.B, B.rowRange[0], B, T, B.columnRange[0], -1);
+    addLowRank(C, A.A, T);
+  } else if (B.isLeaf() && B.type == LOW_RANK) {
+    arma::Mat<ValueType> T;
+    T.zeros(A.rows(), B.A.n_cols);
+    multiplyLeft(A, B.A, A.columnRange[0], T, A.rowRange[0], -1);
+    addLowRank(C, T, B.B);
+  } else if (A.isLeaf() || B.isLeaf()) {
+    arma::Mat<ValueType> P;
+    P.zeros(A.rows(), B.columns());
+    if (A.isLeaf())
+      multiplyRight(A.A, B.rowRange[0], B, P, B.columnRange[0], -1);
+    else
+      multiplyLeft(A, B.A, A.columnRange[0], P, A.rowRange[0], -1);
+    addDense(C, P);
+  } else {
+    // Both factors are subdivided. A leaf C is split temporarily so that the
+    // product can be formed blockwise.
+    const bool isLeaf = C.isLeaf();
+    const DataBlockType type = C.type;
+    if (isLeaf)
+      subdivide(C, A, B);
+
+    tbb::task_group group;
+    for (int i = 0; i < N; ++i)
+      for (int j = 0; j < N; ++j)
+        group.run([this, &A, &B, &C, i, j]() {
+          for (int k = 0; k < N; ++k)
+            multiplyAdd(*C.children[N * i + j], *A.children[N * i + k],
+                        *B.children[N * k + j]);
+        });
+    group.wait();
+
+    if (isLeaf)
+      collapse(C, type);
+  }
+}
+
+template <typename ValueType, int N>
+void HMatrixLu<ValueType, N>::addDense(Block &C,
+                                       const arma::Mat<ValueType> &P) const {
+
+  if (!C.isLeaf()) {
+    for (const auto &child : C.children) {
+      const std::size_t rowStart = child->rowRange[0] - C.rowRange[0];
+      const std::size_t columnStart = child->columnRange[0] - C.columnRange[0];
+      addDense(*child, arma::Mat<ValueType>(P.submat(
+                           rowStart, columnStart, rowStart + child->rows() - 1,
+                           columnStart + child->columns() - 1)));
+    }
+  } else if (C.type == DENSE) {
+    C.A += P;
+  } else {
+    arma::Mat<ValueType> sum = C.A * C.B + P;
+    lowRankApproximation(sum, C.A, C.B);
+  }
+}
+
+template <typename ValueType, int N>
+void HMatrixLu<ValueType, N>::addLowRank(Block &C,
+                                         const arma::Mat<ValueType> &U,
+                                         const arma::Mat<ValueType> &V) const {
+
+  if (U.n_cols == 0)
+    return;
+
+  if (!C.isLeaf()) {
+    for (const auto &child : C.children) {
+      const std::size_t rowStart = child->rowRange[0] - C.rowRange[0];
+      const std::size_t columnStart = child->columnRange[0] - C.columnRange[0];
+      addLowRank(
+          *child,
+          arma::Mat<ValueType>(U.rows(rowStart, rowStart + child->rows() - 1)),
+          arma::Mat<ValueType>(
+              V.cols(columnStart, columnStart + child->columns() - 1)));
+    }
+  } else if (C.type == DENSE) {
+    C.A += U * V;
+  } else {
+    arma::Mat<ValueType> A = arma::join_rows(C.A, U);
+    arma::Mat<ValueType> B = arma::join_cols(C.B, V);
+    truncateLowRankFactors(A, B, m_eps, C.A, C.B);
+  }
+}
+
+template <typename ValueType, int N>
+void HMatrixLu<ValueType, N>::multiplyLeft(const Block &M,
+                                           const arma::Mat<ValueType> &X,
+                                           std::size_t xOffset,
+                                           arma::Mat<ValueType> &Y,
+                                           std::size_t yOffset,
+                                           ValueType alpha) {
+
+  if (!M.isLeaf()) {
+    for (const auto &child : M.children)
+      multiplyLeft(*child, X, xOffset, Y, yOffset, alpha);
+    return;
+  }
+
+  const std::size_t xStart = M.columnRange[0] - xOffset;
+  const std::size_t xEnd = M.columnRange[1] - xOffset - 1;
+  const std::size_t yStart = M.rowRange[0] - yOffset;
+  const std::size_t yEnd = M.rowRange[1] - yOffset - 1;
+
+  if (M.type == DENSE)
+    Y.rows(yStart, yEnd) += alpha * M.A * X.rows(xStart, xEnd);
+  else
+    Y.rows(yStart, yEnd) += alpha * M.A * (M.B * X.rows(xStart, xEnd));
+}
+
+template <typename ValueType, int N>
+void HMatrixLu<ValueType, N>::multiplyRight(const arma::Mat<ValueType> &X,
+                                            std::size_t xOffset,
+                                            const Block &M,
+                                            arma::Mat<ValueType> &Y,
+                                            std::size_t yOffset,
+                                            ValueType alpha) {
+
+  if (!M.isLeaf()) {
+    for (const auto &child : M.children)
+      multiplyRight(X, xOffset, *child, Y, yOffset, alpha);
+    return;
+  }
+
+  const std::size_t xStart = M.rowRange[0] - xOffset;
+  const std::size_t xEnd = M.rowRange[1] - xOffset - 1;
+  const std::size_t yStart = M.columnRange[0] - yOffset;
+  const std::size_t yEnd = M.columnRange[1] - yOffset - 1;
+
+  if (M.type == DENSE)
+    Y.cols(yStart, yEnd) += alpha * X.cols(xStart, xEnd) * M.A;
+  else
+    Y.cols(yStart, yEnd) += alpha * (X.cols(xStart, xEnd) * M.A) * M.B;
+}
+
+template <typename ValueType, int N>
+void HMatrixLu<ValueType, N>::subdivide(Block &C, const Block &A,
+                                        const Block &B) {
+
+  for (int i = 0; i < N; ++i)
+    for (int j = 0; j < N; ++j) {
+      shared_ptr<Block> child(new Block());
+      child->rowRange = A.children[N * i]->rowRange;
+      child->columnRange = B.children[j]->columnRange;
+      child->type = C.type;
+
+      const std::size_t rowStart = child->rowRange[0] - C.rowRange[0];
+      const std::size_t rowEnd = rowStart + child->rows() - 1;
+      const std::size_t columnStart = child->columnRange[0] - C.columnRange[0];
+      const std::size_t columnEnd = columnStart + child->columns() - 1;
+
+      if (C.type == DENSE) {
+        child->A = C.A.submat(rowStart, columnStart, rowEnd, columnEnd);
+      } else {
+        child->A = C.A.rows(rowStart, rowEnd);
+        child->B = C.B.cols(columnStart, columnEnd);
+      }
+      C.children[N * i + j] = child;
+    }
+  C.A.reset();
+  C.B.reset();
+}
+
+template <typename ValueType, int N>
+void HMatrixLu<ValueType, N>::collapse(Block &C, DataBlockType type) const {
+
+  if (type == DENSE) {
+    C.A = denseMatrix(C);
+  } else {
+    std::array<arma::Mat<ValueType>, N * N> childA;
+    std::array<arma::Mat<ValueType>, N * N> childB;
+    std::size_t totalRank = 0;
+    for (int i = 0; i < N * N; ++i) {
+      const Block &child = *C.children[i];
+      if (child.isLeaf() && child.type == LOW_RANK) {
+        childA[i] = child.A;
+        childB[i] = child.B;
+      } else {
+        lowRankApproximation(denseMatrix(child), childA[i], childB[i]);
+      }
+      totalRank += childA[i].n_cols;
+    }
+
+    arma::Mat<ValueType> A;
+    arma::Mat<ValueType> B;
+    A.zeros(C.rows(), totalRank);
+    B.zeros(totalRank, C.columns());
+
+    std::size_t offset = 0;
+    for (int i = 0; i < N * N; ++i) {
+      const std::size_t rank = childA[i].n_cols;
+      if (rank == 0)
+        continue;
+      const Block &child = *C.children[i];
+      const std::size_t rowStart = child.rowRange[0] - C.rowRange[0];
+      const std::size_t columnStart = child.columnRange[0] - C.columnRange[0];
+      A.submat(rowStart, offset, rowStart + child.rows() - 1,
+               offset + rank - 1) = childA[i];
+      B.submat(offset, columnStart, offset + rank - 1,
+               columnStart + child.columns() - 1) = childB[i];
+      offset += rank;
+    }
+    truncateLowRankFactors(A, B, m_eps, C.A, C.B);
+  }
+
+  C.type = type;
+  for (auto &child : C.children)
+    child.reset();
+}
+
+template <typename ValueType, int N>
+void HMatrixLu<ValueType, N>::lowRankApproximation(
+    const arma::Mat<ValueType> &P, arma::Mat<ValueType> &A,
+    arma::Mat<ValueType> &B) const {
+
+  // Factorize the smaller identity so that the QR decompositions stay cheap
+  if (P.n_rows <= P.n_cols)
+    truncateLowRankFactors(
+        arma::Mat<ValueType>(arma::eye<arma::Mat<ValueType>>(P.n_rows,
+                                                             P.n_rows)),
+        P, m_eps, A, B);
+  else
+    truncateLowRankFactors(
+        P, arma::Mat<ValueType>(
+               arma::eye<arma::Mat<ValueType>>(P.n_cols, P.n_cols)),
+        m_eps, A, B);
+}
+
+template <typename ValueType, int N>
+void HMatrixLu<ValueType, N>::convertToDense(Block &M) {
+
+  M.A = denseMatrix(M);
+  M.B.reset();
+  M.type = DENSE;
+  for (auto &child : M.children)
+    child.reset();
+}
+
+template <typename ValueType, int N>
+arma::Mat<ValueType> HMatrixLu<ValueType, N>::denseMatrix(const Block &M) {
+
+  if (M.isLeaf()) {
+    if (M.type == DENSE)
+      return M.A;
+    return M.A * M.B;
+  }
+
+  arma::Mat<ValueType> result(M.rows(), M.columns());
+  for (const auto &child : M.children) {
+    const std::size_t rowStart = child->rowRange[0] - M.rowRange[0];
+    const std::size_t columnStart = child->columnRange[0] - M.columnRange[0];
+    result.submat(rowStart, columnStart, rowStart + child->rows() - 1,
+                  columnStart + child->columns() - 1) = denseMatrix(*child);
+  }
+  return result;
+}
+
+template <typename ValueType, int N>
+shared_ptr<typename HMatrixLu<ValueType, N>::Block>
+HMatrixLu<ValueType, N>::transposedCopy(const Block &M) {
+
+  shared_ptr<Block> block(new Block());
+  block->rowRange = M.columnRange;
+  block->columnRange = M.rowRange;
+  block->type = M.type;
+
+  if (!M.isLeaf()) {
+    for (int i = 0; i < N; ++i)
+      for (int j = 0; j < N; ++j)
+        block->children[N * i + j] = transposedCopy(*M.children[N * j + i]);
+  } else if (M.type == DENSE) {
+    block->A = M.A.st();
+  } else {
+    block->A = M.B.st();
+    block->B = M.A.st();
+  }
+  return block;
+}
+
+template <typename ValueType, int N>
+std::size_t HMatrixLu<ValueType, N>::numberOfElements(const Block &M) {
+
+  std::size_t result = M.A.n_elem + M.B.n_elem;
+  if (!M.isLeaf())
+    for (const auto &child : M.children)
+      result += numberOfElements(*child);
+  return result;
+}
+
+template <typename ValueType, int N>
+template <typename T>
+arma::Mat<T>
+HMatrixLu<ValueType, N>::symmetricCholeskyFactor(const arma::Mat<T> &M) {
+
+  // L * L^T = M without complex conjugation, so that complex symmetric
+  // matrices can be factorized as well
+  const std::size_t n = M.n_rows;
+  arma::Mat<T> L;
+  L.zeros(n, n);
+  for (std::size_t j = 0; j < n; ++j) {
+    T pivot = M(j, j);
+    for (std::size_t k = 0; k < j; ++k)
+      pivot -= L(j, k) * L(j, k);
+    if (!isValidCholeskyPivot(pivot))
+      throw std::runtime_error("HMatrixLu::factorizeCholesky(): "
+                               "Symmetric factorization of a diagonal "
+                               "block failed.");
+    L(j, j) = std::sqrt(pivot);
+    for (std::size_t i = j + 1; i < n; ++i) {
+      T value = M(i, j);
+      for (std::size_t k = 0; k < j; ++k)
+        value -= L(i, k) * L(j, k);
+      L(i, j) = value / L(j, j);
+    }
+  }
+  return L;
+}
+
+template <typename ValueType, int N>
+template <typename T>
+bool HMatrixLu<ValueType, N>::isValidCholeskyPivot(T pivot) {
+  return pivot > 0;
+}
+
+template <typename ValueType, int N>
+template <typename T>
+bool HMatrixLu<ValueType, N>::isValidCholeskyPivot(
+    const std::complex<T> &pivot) {
+  return std::abs(pivot) > 0;
+}
+}
+
+#endif
@@ -0,0 +1,47 @@
+// vi: set et ts=4 sw=2 sts=2:
+
+#ifndef HMAT_HMATRIX_SERIALIZATION_HPP
+#define HMAT_HMATRIX_SERIALIZATION_HPP
+
+#include "common.hpp"
+#include "hmatrix.hpp"
+#include <string>
+
+namespace hmat {
+
+// Binary file format of initialized H-matrices. A file consists of
+//
+//   - a header with a magic string, the format version, a byte order mark,
+//     the value type and N,
+//   - the row cluster tree and, unless both trees are identical, the column
+//     cluster tree, each given by its DOF permutation and its nodes in
+//     preorder,
+//   - the nodes of the block cluster tree in preorder,
+//   - the layouts of the leafs in tree order,
+//   - the leaf data in tree order, starting at an offset aligned to
+//     HMATRIX_FILE_ALIGNMENT bytes.
+//
+// The leaf data has the layout of the arena of HMatrix, so loading a file
+// maps it into memory without copying the leaf data. Files are written in
+// the native byte order and are only read on machines with the same byte
+// order.
+
+const unsigned int HMATRIX_FILE_VERSION = 1;
+const std::size_t HMATRIX_FILE_ALIGNMENT = 64;
+
+// Write hMatrix to fileName. The file is written under a temporary name and
+// renamed afterwards, so concurrent readers never see a partial file.
+template <typename ValueType, int N>
+void saveHMatrix(const HMatrix<ValueType, N> &hMatrix,
+                 const std::string &fileName);
+
+// Read an H-matrix written by saveHMatrix. The file is memory-mapped and the
+// leaf data of the returned H-matrix refers to the mapping, which stays
+// alive as long as the H-matrix does.
+template <typename ValueType, int N>
+shared_ptr<HMatrix<ValueType, N>> loadHMatrix(const std::string &fileName);
+}
+
+#include "hmatrix_serialization_impl.hpp"
+
+#endif
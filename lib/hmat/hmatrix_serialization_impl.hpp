@@ -0,0 +1,387 @@
+// vi: set et ts=4 sw=2 sts=2:
+
+#ifndef HMAT_HMATRIX_SERIALIZATION_IMPL_HPP
+#define HMAT_HMATRIX_SERIALIZATION_IMPL_HPP
+
+#include "hmatrix_serialization.hpp"
+#include "hmatrix_dense_data.hpp"
+#include "hmatrix_low_rank_data.hpp"
+
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace hmat {
+
+namespace detail {
+
+const char hMatrixFileMagic[8] = {'B', 'E', 'M', 'P', 'P', 'H', 'M', '\0'};
+const std::uint32_t hMatrixFileByteOrderMark = 0x01020304;
+
+template <typename ValueType> struct HMatrixFileValueType;
+
+template <> struct HMatrixFileValueType<float> {
+  static std::uint32_t code() { return 1; }
+};
+
+template <> struct HMatrixFileValueType<double> {
+  static std::uint32_t code() { return 2; }
+};
+
+template <> struct HMatrixFileValueType<std::complex<float>> {
+  static std::uint32_t code() { return 3; }
+};
+
+template <> struct HMatrixFileValueType<std::complex<double>> {
+  static std::uint32_t code() { return 4; }
+};
+
+template <typename T> void writeBinary(std::ostream &stream, const T &value) {
+  stream.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+// Sequential reader of a file mapped into memory
+class BinaryReader {
+public:
+  BinaryReader(const char *begin, const char *end)
+      : m_begin(begin), m_cursor(begin), m_end(end) {}
+
+  template <typename T> T read() {
+    if (remaining() < sizeof(T))
+      throw std::runtime_error("loadHMatrix(): Unexpected end of file.");
+    T value;
+    std::memcpy(&value, m_cursor, sizeof(T));
+    m_cursor += sizeof(T);
+    return value;
+  }
+
+  std::size_t position() const { return m_cursor - m_begin; }
+  std::size_t remaining() const { return m_end - m_cursor; }
+
+private:
+  const char *m_begin;
+  const char *m_cursor;
+  const char *m_end;
+};
+
+template <int N>
+void writeClusterTreeNode(std::ostream &stream,
+                          const ClusterTreeNode<N> &node) {
+
+  const auto &data = node.data();
+  writeBinary<std::uint64_t>(stream, data.indexRange[0]);
+  writeBinary<std::uint64_t>(stream, data.indexRange[1]);
+  for (double bound : data.boundingBox.bounds())
+    writeBinary(stream, bound);
+  writeBinary<std::uint8_t>(stream, node.isLeaf());
+
+  if (!node.isLeaf())
+    for (int i = 0; i < N; ++i)
+      writeClusterTreeNode<N>(stream, *node.child(i));
+}
+
+template <int N>
+void writeClusterTree(std::ostream &stream,
+                      const ClusterTree<N> &clusterTree) {
+
+  const auto &hMatDofToOriginalDofMap = clusterTree.hMatDofToOriginalDofMap();
+  writeBinary<std::uint64_t>(stream, hMatDofToOriginalDofMap.size());
+  for (auto originalDof : hMatDofToOriginalDofMap)
+    writeBinary<std::uint64_t>(stream, originalDof);
+
+  writeClusterTreeNode<N>(stream, *clusterTree.root());
+}
+
+template <int N>
+void writeBlockClusterTreeNode(std::ostream &stream,
+                               const BlockClusterTreeNode<N> &node) {
+
+  writeBinary<std::uint8_t>(stream, node.isLeaf());
+  writeBinary<std::uint8_t>(stream, node.data().admissible);
+
+  if (!node.isLeaf())
+    for (int i = 0; i < N * N; ++i)
+      writeBlockClusterTreeNode<N>(stream, *node.child(i));
+}
+
+inline ClusterTreeNodeData readClusterTreeNodeData(BinaryReader &reader,
+                                                   bool &isLeaf) {
+
+  IndexRangeType indexRange;
+  indexRange[0] = reader.read<std::uint64_t>();
+  indexRange[1] = reader.read<std::uint64_t>();
+  std::array<double, 6> bounds;
+  for (auto &bound : bounds)
+    bound = reader.read<double>();
+  isLeaf = (reader.read<std::uint8_t>() != 0);
+
+  if (indexRange[0] > indexRange[1])
+    throw std::runtime_error("loadHMatrix(): Invalid cluster index range.");
+
+  return ClusterTreeNodeData(indexRange, BoundingBox(bounds));
+}
+
+template <int N>
+void readClusterTreeChildren(BinaryReader &reader, ClusterTreeNode<N> &node) {
+
+  for (int i = 0; i < N; ++i) {
+    bool isLeaf;
+    node.addChild(readClusterTreeNodeData(reader, isLeaf), i);
+    if (!isLeaf)
+      readClusterTreeChildren<N>(reader, *node.child(i));
+  }
+}
+
+template <int N>
+shared_ptr<const ClusterTree<N>> readClusterTree(BinaryReader &reader) {
+
+  const std::size_t numberOfDofs = reader.read<std::uint64_t>();
+  if (reader.remaining() / sizeof(std::uint64_t) < numberOfDofs)
+    throw std::runtime_error("loadHMatrix(): Unexpected end of file.");
+
+  DofPermutation dofPermutation(numberOfDofs);
+  std::vector<bool> isMapped(numberOfDofs, false);
+  for (std::size_t hMatDof = 0; hMatDof < numberOfDofs; ++hMatDof) {
+    const std::size_t originalDof = reader.read<std::uint64_t>();
+    if (originalDof >= numberOfDofs || isMapped[originalDof])
+      throw std::runtime_error("loadHMatrix(): Invalid DOF permutation.");
+    isMapped[originalDof] = true;
+    dofPermutation.addDofIndexPair(originalDof, hMatDof);
+  }
+
+  bool isLeaf;
+  auto root =
+      make_shared<ClusterTreeNode<N>>(readClusterTreeNodeData(reader, isLeaf));
+  if (!isLeaf)
+    readClusterTreeChildren<N>(reader, *root);
+
+  if (root->data().indexRange[0] != 0 ||
+      root->data().indexRange[1] != numberOfDofs)
+    throw std::runtime_error("loadHMatrix(): Root cluster does not match the "
+                             "DOF permutation.");
+
+  return make_shared<ClusterTree<N>>(root, dofPermutation);
+}
+
+template <int N>
+void readBlockClusterTreeChildren(BinaryReader &reader,
+                                  BlockClusterTreeNode<N> &node) {
+
+  const auto rowClusterTreeNode = node.data().rowClusterTreeNode;
+  const auto columnClusterTreeNode = node.data().columnClusterTreeNode;
+
+  if (rowClusterTreeNode->isLeaf() || columnClusterTreeNode->isLeaf())
+    throw std::runtime_error("loadHMatrix(): Block cluster tree does not "
+                             "match the cluster trees.");
+
+  for (int rowCount = 0; rowCount < N; ++rowCount)
+    for (int columnCount = 0; columnCount < N; ++columnCount) {
+      const bool isLeaf = (reader.read<std::uint8_t>() != 0);
+      const bool admissible = (reader.read<std::uint8_t>() != 0);
+      node.addChild(BlockClusterTreeNodeData<N>(
+                        rowClusterTreeNode->child(rowCount),
+                        columnClusterTreeNode->child(columnCount), admissible),
+                    N * rowCount + columnCount);
+      if (!isLeaf)
+        readBlockClusterTreeChildren<N>(
+            reader, *node.child(N * rowCount + columnCount));
+    }
+}
+}
+
+template <typename ValueType, int N>
+void saveHMatrix(const HMatrix<ValueType, N> &hMatrix,
+                 const std::string &fileName) {
+
+  if (!hMatrix.isInitialized())
+    throw std::invalid_argument("saveHMatrix(): H-matrix is not initialized.");
+
+  const auto blockClusterTree = hMatrix.blockClusterTree();
+  const auto rowClusterTree = blockClusterTree->rowClusterTree();
+  const auto columnClusterTree = blockClusterTree->columnClusterTree();
+  const bool identicalClusterTrees = (rowClusterTree == columnClusterTree);
+
+  std::ostringstream temporaryFileNameStream;
+  temporaryFileNameStream << fileName << ".tmp." << getpid();
+  const std::string temporaryFileName = temporaryFileNameStream.str();
+
+  std::ofstream stream(temporaryFileName.c_str(),
+                       std::ios::binary | std::ios::trunc);
+  if (!stream)
+    throw std::runtime_error("saveHMatrix(): Could not open file " +
+                             temporaryFileName + " for writing.");
+
+  stream.write(detail::hMatrixFileMagic, sizeof(detail::hMatrixFileMagic));
+  detail::writeBinary<std::uint32_t>(stream, HMATRIX_FILE_VERSION);
+  detail::writeBinary<std::uint32_t>(stream,
+                                     detail::hMatrixFileByteOrderMark);
+  detail::writeBinary<std::uint32_t>(
+      stream, detail::HMatrixFileValueType<ValueType>::code());
+  detail::writeBinary<std::uint32_t>(stream, N);
+  detail::writeBinary<std::uint8_t>(stream, identicalClusterTrees);
+
+  detail::writeClusterTree<N>(stream, *rowClusterTree);
+  if (!identicalClusterTrees)
+    detail::writeClusterTree<N>(stream, *columnClusterTree);
+
+  detail::writeBlockClusterTreeNode<N>(stream, *blockClusterTree->root());
+
+  std::size_t arenaSize = 0;
+  detail::writeBinary<std::uint64_t>(stream, hMatrix.numberOfLeafs());
+  for (const auto &leaf : hMatrix.leafs()) {
+    const auto &data = *leaf.data;
+    detail::writeBinary<std::uint32_t>(stream, data.type());
+    detail::writeBinary<std::uint64_t>(stream, data.rows());
+    detail::writeBinary<std::uint64_t>(stream, data.cols());
+    detail::writeBinary<std::uint64_t>(stream,
+                                       data.type() == DENSE ? 0 : data.rank());
+    arenaSize += data.numberOfElements();
+  }
+  detail::writeBinary<std::uint64_t>(stream, arenaSize);
+
+  const std::size_t position =
+      static_cast<std::streamoff>(stream.tellp());
+  const std::size_t padding =
+      (HMATRIX_FILE_ALIGNMENT - position % HMATRIX_FILE_ALIGNMENT) %
+      HMATRIX_FILE_ALIGNMENT;
+  for (std::size_t i = 0; i < padding; ++i)
+    stream.put('\0');
+
+  auto writeMatrix = [&stream](const arma::Mat<ValueType> &matrix) {
+    stream.write(reinterpret_cast<const char *>(matrix.memptr()),
+                 matrix.n_elem * sizeof(ValueType));
+  };
+
+  for (const auto &leaf : hMatrix.leafs()) {
+    if (leaf.data->type() == DENSE) {
+      writeMatrix(
+          static_cast<const HMatrixDenseData<ValueType> &>(*leaf.data).A());
+    } else {
+      const auto &lowRankData =
+          static_cast<const HMatrixLowRankData<ValueType> &>(*leaf.data);
+      writeMatrix(lowRankData.A());
+      writeMatrix(lowRankData.B());
+    }
+  }
+
+  stream.close();
+  if (!stream) {
+    std::remove(temporaryFileName.c_str());
+    throw std::runtime_error("saveHMatrix(): Could not write file " +
+                             temporaryFileName + ".");
+  }
+  if (std::rename(temporaryFileName.c_str(), fileName.c_str()) != 0) {
+    std::remove(temporaryFileName.c_str());
+    throw std::runtime_error("saveHMatrix(): Could not rename " +
+                             temporaryFileName + " to " + fileName + ".");
+  }
+}
+
+template <typename ValueType, int N>
+shared_ptr<HMatrix<ValueType, N>> loadHMatrix(const std::string &fileName) {
+
+  const int fileDescriptor = open(fileName.c_str(), O_RDONLY);
+  if (fileDescriptor == -1)
+    throw std::runtime_error("loadHMatrix(): Could not open file " + fileName +
+                             ".");
+
+  struct stat fileStatus;
+  if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0) {
+    close(fileDescriptor);
+    throw std::runtime_error("loadHMatrix(): Could not read file " + fileName +
+                             ".");
+  }
+  const std::size_t fileSize = fileStatus.st_size;
+
+  // The mapping is private and writable since the leaf matrices are views
+  // with non-const element pointers. Writes never reach the file.
+  void *address = mmap(0, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                       fileDescriptor, 0);
+  close(fileDescriptor);
+  if (address == MAP_FAILED)
+    throw std::runtime_error("loadHMatrix(): Could not map file " + fileName +
+                             " into memory.");
+
+  shared_ptr<char> mapping(static_cast<char *>(address),
+                           [fileSize](char *p) { munmap(p, fileSize); });
+
+  detail::BinaryReader reader(mapping.get(), mapping.get() + fileSize);
+
+  char magic[sizeof(detail::hMatrixFileMagic)];
+  for (auto &c : magic)
+    c = reader.read<char>();
+  if (std::memcmp(magic, detail::hMatrixFileMagic, sizeof(magic)) != 0)
+    throw std::runtime_error("loadHMatrix(): " + fileName +
+                             " is not an H-matrix file.");
+  if (reader.read<std::uint32_t>() != HMATRIX_FILE_VERSION)
+    throw std::runtime_error("loadHMatrix(): Unsupported version of file " +
+                             fileName + ".");
+  if (reader.read<std::uint32_t>() != detail::hMatrixFileByteOrderMark)
+    throw std::runtime_error("loadHMatrix(): File " + fileName +
+                             " was written with a different byte order.");
+  if (reader.read<std::uint32_t>() !=
+      detail::HMatrixFileValueType<ValueType>::code())
+    throw std::runtime_error("loadHMatrix(): Value type of file " + fileName +
+                             " does not match.");
+  if (reader.read<std::uint32_t>() != static_cast<std::uint32_t>(N))
+    throw std::runtime_error("loadHMatrix(): Tree order of file " + fileName +
+                             " does not match.");
+  const bool identicalClusterTrees = (reader.read<std::uint8_t>() != 0);
+
+  auto rowClusterTree = detail::readClusterTree<N>(reader);
+  auto columnClusterTree = identicalClusterTrees
+                               ? rowClusterTree
+                               : detail::readClusterTree<N>(reader);
+
+  const bool isLeaf = (reader.read<std::uint8_t>() != 0);
+  const bool admissible = (reader.read<std::uint8_t>() != 0);
+  shared_ptr<BlockClusterTreeNode<N>> root(
+      new BlockClusterTreeNode<N>(BlockClusterTreeNodeData<N>(
+          rowClusterTree->root(), columnClusterTree->root(), admissible)));
+  if (!isLeaf)
+    detail::readBlockClusterTreeChildren<N>(reader, *root);
+
+  auto blockClusterTree = make_shared<BlockClusterTree<N>>(
+      rowClusterTree, columnClusterTree, root);
+
+  const std::size_t numberOfLeafs = reader.read<std::uint64_t>();
+  if (reader.remaining() / (sizeof(std::uint32_t) +
+                            3 * sizeof(std::uint64_t)) < numberOfLeafs)
+    throw std::runtime_error("loadHMatrix(): Unexpected end of file.");
+
+  std::vector<HMatrixLeafLayout> leafLayouts(numberOfLeafs);
+  for (auto &layout : leafLayouts) {
+    layout.type = static_cast<DataBlockType>(reader.read<std::uint32_t>());
+    layout.rows = reader.read<std::uint64_t>();
+    layout.columns = reader.read<std::uint64_t>();
+    layout.rank = reader.read<std::uint64_t>();
+  }
+  const std::size_t arenaSize = reader.read<std::uint64_t>();
+
+  const std::size_t arenaOffset =
+      (reader.position() + HMATRIX_FILE_ALIGNMENT - 1) /
+      HMATRIX_FILE_ALIGNMENT * HMATRIX_FILE_ALIGNMENT;
+  if (arenaOffset > fileSize ||
+      (fileSize - arenaOffset) / sizeof(ValueType) < arenaSize)
+    throw std::runtime_error("loadHMatrix(): Unexpected end of file.");
+
+  // The arena shares ownership of the mapping
+  shared_ptr<ValueType> arena(
+      mapping, reinterpret_cast<ValueType *>(mapping.get() + arenaOffset));
+
+  auto hMatrix = make_shared<HMatrix<ValueType, N>>(blockClusterTree);
+  hMatrix->initialize(leafLayouts, arena, arenaSize);
+  return hMatrix;
+}
+}
+
+#endif
@@ -0,0 +1,25 @@
+// vi: set et ts=4 sw=2 sts=2:
+
+#ifndef HMAT_LOW_RANK_TRUNCATION_HPP
+#define HMAT_LOW_RANK_TRUNCATION_HPP
+
+#include "common.hpp"
+#include <armadillo>
+
+namespace hmat {
+
+// Replace the factorization A * B by one of the smallest rank r such that the
+// Frobenius norm of the error is at most eps times the Frobenius norm of
+// A * B. The rank is computed from QR decompositions of A and B^T and an SVD
+// of the small core matrix. The output factors may alias the input factors.
+// Returns the new rank.
+template <typename ValueType>
+std::size_t truncateLowRankFactors(const arma::Mat<ValueType> &A,
+                                   const arma::Mat<ValueType> &B, double eps,
+                                   arma::Mat<ValueType> &truncatedA,
+                                   arma::Mat<ValueType> &truncatedB);
+}
+
+#include "low_rank_truncation_impl.hpp"
+
+#endif
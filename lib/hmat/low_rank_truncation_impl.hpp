@@ -0,0 +1,72 @@
+// vi: set et ts=4 sw=2 sts=2:
+
+#ifndef HMAT_LOW_RANK_TRUNCATION_IMPL_HPP
+#define HMAT_LOW_RANK_TRUNCATION_IMPL_HPP
+
+#include "low_rank_truncation.hpp"
+#include "scalar_traits.hpp"
+#include <stdexcept>
+
+namespace hmat {
+
+template <typename ValueType>
+std::size_t truncateLowRankFactors(const arma::Mat<ValueType> &A,
+                                   const arma::Mat<ValueType> &B, double eps,
+                                   arma::Mat<ValueType> &truncatedA,
+                                   arma::Mat<ValueType> &truncatedB) {
+
+  typedef typename ScalarTraits<ValueType>::RealType RealType;
+
+  if (A.n_cols != B.n_rows)
+    throw std::invalid_argument("truncateLowRankFactors(): "
+                                "Factors have incompatible dimensions.");
+
+  if (A.n_cols == 0) {
+    truncatedA.set_size(A.n_rows, 0);
+    truncatedB.set_size(0, B.n_cols);
+    return 0;
+  }
+
+  // A * B = Qa * (Ra * Rb^T) * Qb^T
+  arma::Mat<ValueType> Qa, Ra, Qb, Rb;
+  if (!arma::qr_econ(Qa, Ra, A) || !arma::qr_econ(Qb, Rb, B.st()))
+    throw std::runtime_error("truncateLowRankFactors(): "
+                             "QR decomposition failed.");
+
+  arma::Mat<ValueType> U, V;
+  arma::Col<RealType> s;
+  if (!arma::svd_econ(U, s, V, arma::Mat<ValueType>(Ra * Rb.st())))
+    throw std::runtime_error("truncateLowRankFactors(): "
+                             "SVD of core matrix failed.");
+
+  // The singular values are sorted in decreasing order. Keep the smallest
+  // number of them such that the discarded part is below the tolerance.
+  const RealType squaredNorm = arma::accu(arma::square(s));
+  const RealType squaredTolerance = eps * eps * squaredNorm;
+  std::size_t rank = s.n_elem;
+  RealType discarded = 0;
+  while (rank > 0) {
+    discarded += s(rank - 1) * s(rank - 1);
+    if (discarded > squaredTolerance)
+      break;
+    --rank;
+  }
+
+  if (rank == 0) {
+    truncatedA.set_size(A.n_rows, 0);
+    truncatedB.set_size(0, B.n_cols);
+    return 0;
+  }
+
+  arma::Mat<ValueType> newA = Qa * U.head_cols(rank);
+  for (std::size_t i = 0; i < rank; ++i)
+    newA.col(i) *= s(i);
+  arma::Mat<ValueType> newB = V.head_cols(rank).t() * Qb.st();
+
+  truncatedA.swap(newA);
+  truncatedB.swap(newB);
+  return rank;
+}
+}
+
+#endif
@@ -23,6 +23,9 @@ public:
   void addChild(const T &child, int i);
   void addSubTree(shared_ptr<SimpleTreeNode<T, N>> &subTree, int i);
 
+  // Detach all children, which turns the node into a leaf
+  void removeChildren();
+
   bool isLeaf() const;
 
   const std::vector<shared_ptr<const SimpleTreeNode<T, N>>> leafNodes() const;
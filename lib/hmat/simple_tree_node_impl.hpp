@@ -67,6 +67,12 @@ void SimpleTreeNode<T, N>::addSubTree(shared_ptr<SimpleTreeNode<T, N>> &subTree,
   m_children[i] = subTree;
 }
 
+template <typename T, int N> void SimpleTreeNode<T, N>::removeChildren() {
+
+  for (auto &child : m_children)
+    child.reset();
+}
+
 template <typename T, int N> bool SimpleTreeNode<T, N>::isLeaf() const {
 
   for (auto child : m_children)
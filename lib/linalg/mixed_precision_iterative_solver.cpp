@@ -0,0 +1,241 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "bempp/common/config_trilinos.hpp"
+
+#ifdef WITH_TRILINOS
+
+#include "mixed_precision_iterative_solver.hpp"
+
+#include "belos_solver_wrapper.hpp"
+#include "solution.hpp"
+#include "blocked_solution.hpp"
+#include "../assembly/boundary_operator.hpp"
+#include "../assembly/context.hpp"
+#include "../assembly/discrete_boundary_operator.hpp"
+#include "../assembly/mixed_precision_discrete_boundary_operator.hpp"
+#include "../assembly/vector.hpp"
+#include "../common/to_string.hpp"
+#include "../fiber/explicit_instantiation.hpp"
+#include "../space/space.hpp"
+
+#include <Teuchos_ParameterList.hpp>
+#include <Teuchos_RCPBoostSharedPtrConversions.hpp>
+#include <Thyra_SolveSupportTypes.hpp>
+
+#include <boost/make_shared.hpp>
+
+#include <tbb/task_scheduler_init.h>
+
+namespace Bempp {
+
+/** \cond HIDDEN_INTERNAL */
+
+template <typename BasisFunctionType, typename ResultType>
+struct MixedPrecisionIterativeSolver<BasisFunctionType, ResultType>::Impl {
+  typedef BoundaryOperator<SingleBasisFunctionType, SingleResultType>
+  SingleBoundaryOp;
+
+  Impl(const BoundaryOperator<BasisFunctionType, ResultType> &op_,
+       const SingleBoundaryOp &singleOp_)
+      : op(op_), singleOp(singleOp_), tolerance(1e-10),
+        maxRefinementCount(20) {
+    if (!op.isInitialized() || !singleOp.isInitialized())
+      throw std::invalid_argument(
+          "MixedPrecisionIterativeSolver::Impl::Impl(): "
+          "boundary operators must be initialized");
+    if (op.domain()->globalDofCount() != op.dualToRange()->globalDofCount())
+      throw std::invalid_argument(
+          "MixedPrecisionIterativeSolver::Impl::Impl(): "
+          "non-square system provided");
+    if (op.domain()->globalDofCount() !=
+            singleOp.domain()->globalDofCount() ||
+        op.dualToRange()->globalDofCount() !=
+            singleOp.dualToRange()->globalDofCount())
+      throw std::invalid_argument(
+          "MixedPrecisionIterativeSolver::Impl::Impl(): "
+          "the single-precision operator acts on spaces of different "
+          "dimensions");
+
+    shared_ptr<const DiscreteBoundaryOperator<SingleResultType>> weakForm =
+        singleOp.weakForm();
+    residualOp = boost::make_shared<
+        MixedPrecisionDiscreteBoundaryOperator<ResultType>>(weakForm);
+    solverWrapper.reset(new BelosSolverWrapper<SingleResultType>(
+        Teuchos::rcp<const Thyra::LinearOpBase<SingleResultType>>(weakForm)));
+  }
+
+  BoundaryOperator<BasisFunctionType, ResultType> op;
+  SingleBoundaryOp singleOp;
+  shared_ptr<const DiscreteBoundaryOperator<ResultType>> residualOp;
+  boost::scoped_ptr<BelosSolverWrapper<SingleResultType>> solverWrapper;
+  MagnitudeType tolerance;
+  int maxRefinementCount;
+};
+
+/** \endcond */
+
+template <typename BasisFunctionType, typename ResultType>
+MixedPrecisionIterativeSolver<BasisFunctionType, ResultType>::
+    MixedPrecisionIterativeSolver(
+        const BoundaryOperator<BasisFunctionType, ResultType> &boundaryOp,
+        const BoundaryOperator<SingleBasisFunctionType, SingleResultType> &
+            singlePrecisionOp)
+    : m_impl(new Impl(boundaryOp, singlePrecisionOp)) {}
+
+template <typename BasisFunctionType, typename ResultType>
+MixedPrecisionIterativeSolver<BasisFunctionType,
+                              ResultType>::~MixedPrecisionIterativeSolver() {}
+
+template <typename BasisFunctionType, typename ResultType>
+void MixedPrecisionIterativeSolver<BasisFunctionType, ResultType>::
+    initializeSolver(const Teuchos::RCP<Teuchos::ParameterList> &paramList) {
+  m_impl->solverWrapper->initializeSolver(paramList);
+}
+
+template <typename BasisFunctionType, typename ResultType>
+void MixedPrecisionIterativeSolver<BasisFunctionType, ResultType>::
+    initializeSolver(const Teuchos::RCP<Teuchos::ParameterList> &paramList,
+                     const Preconditioner<SingleResultType> &preconditioner) {
+  m_impl->solverWrapper->setPreconditioner(preconditioner.get());
+  m_impl->solverWrapper->initializeSolver(paramList);
+}
+
+template <typename BasisFunctionType, typename ResultType>
+void MixedPrecisionIterativeSolver<BasisFunctionType, ResultType>::
+    setRefinementParameters(MagnitudeType tolerance, int maxRefinementCount) {
+  if (tolerance <= 0 || maxRefinementCount < 1)
+    throw std::invalid_argument(
+        "MixedPrecisionIterativeSolver::setRefinementParameters(): "
+        "tolerance and maximum refinement count must be positive");
+  m_impl->tolerance = tolerance;
+  m_impl->maxRefinementCount = maxRefinementCount;
+}
+
+template <typename BasisFunctionType, typename ResultType>
+Solution<BasisFunctionType, ResultType>
+MixedPrecisionIterativeSolver<BasisFunctionType, ResultType>::
+    solveImplNonblocked(
+        const GridFunction<BasisFunctionType, ResultType> &rhs) const {
+  typedef typename ScalarTraits<SingleResultType>::RealType
+  SingleMagnitudeType;
+  typedef Thyra::MultiVectorBase<SingleResultType> SingleTrilinosVector;
+
+  const BoundaryOperator<BasisFunctionType, ResultType> &boundaryOp =
+      m_impl->op;
+  Solver<BasisFunctionType, ResultType>::checkConsistency(
+      boundaryOp, rhs, ConvergenceTestMode::TEST_CONVERGENCE_IN_DUAL_TO_RANGE);
+
+  const arma::Col<ResultType> b = rhs.projections(boundaryOp.dualToRange());
+  const MagnitudeType bNorm = arma::norm(b, 2);
+  arma::Col<ResultType> x(boundaryOp.domain()->globalDofCount());
+  x.fill(static_cast<ResultType>(0.));
+  arma::Col<ResultType> r = b;
+  MagnitudeType rNorm = bNorm;
+
+  // Get number of threads
+  Fiber::ParallelizationOptions parallelOptions =
+      boundaryOp.context()->assemblyOptions().parallelizationOptions();
+  int maxThreadCount = 1;
+  if (!parallelOptions.isOpenClEnabled()) {
+    if (parallelOptions.maxThreadCount() == ParallelizationOptions::AUTO)
+      maxThreadCount = tbb::task_scheduler_init::automatic;
+    else
+      maxThreadCount = parallelOptions.maxThreadCount();
+  }
+
+  int refinementCount = 0;
+  int iterationCount = 0;
+  {
+    // Initialize TBB threads here (to prevent their construction and
+    // destruction on every matrix-vector multiplication)
+    tbb::task_scheduler_init scheduler(maxThreadCount);
+    while (rNorm > m_impl->tolerance * bNorm &&
+           refinementCount < m_impl->maxRefinementCount) {
+      // Solve the correction equation for the residual scaled to unit norm,
+      // so that its entries stay well within the range of single precision
+      Vector<SingleResultType> residualVector(
+          arma::conv_to<arma::Col<SingleResultType>>::from(
+              r / static_cast<ResultType>(rNorm)));
+      arma::Col<SingleResultType> zero(x.n_rows);
+      zero.fill(static_cast<SingleResultType>(0.));
+      Vector<SingleResultType> correctionVector(zero);
+      Thyra::SolveStatus<SingleMagnitudeType> innerStatus =
+          m_impl->solverWrapper->solve(
+              Thyra::NOTRANS, residualVector,
+              Teuchos::ptr<SingleTrilinosVector>(&correctionVector));
+      if (!innerStatus.extraParameters.is_null())
+        iterationCount += innerStatus.extraParameters->template get<int>(
+            "Iteration Count", 0);
+
+      x += static_cast<ResultType>(rNorm) *
+           arma::conv_to<arma::Col<ResultType>>::from(
+               correctionVector.asArmadilloVector());
+      r = b;
+      m_impl->residualOp->apply(NO_TRANSPOSE, x, r,
+                                static_cast<ResultType>(-1.),
+                                static_cast<ResultType>(1.));
+      const MagnitudeType newRNorm = arma::norm(r, 2);
+      ++refinementCount;
+      // Stop if the refinement has stagnated
+      const bool stagnated = !(newRNorm < rNorm);
+      rNorm = newRNorm;
+      if (stagnated)
+        break;
+    }
+  }
+
+  Thyra::SolveStatus<MagnitudeType> status;
+  status.achievedTol = bNorm > 0 ? rNorm / bNorm : MagnitudeType(0.);
+  status.solveStatus = rNorm <= m_impl->tolerance * bNorm
+                           ? Thyra::SOLVE_STATUS_CONVERGED
+                           : Thyra::SOLVE_STATUS_UNCONVERGED;
+  status.message = "Mixed-precision iterative refinement performed " +
+                   toString(refinementCount) + " refinement step(s)";
+  status.extraParameters = Teuchos::parameterList();
+  status.extraParameters->set("Iteration Count", iterationCount);
+  status.extraParameters->set("Refinement Count", refinementCount);
+
+  return Solution<BasisFunctionType, ResultType>(
+      GridFunction<BasisFunctionType, ResultType>(boundaryOp.context(),
+                                                  boundaryOp.domain(), x),
+      status);
+}
+
+template <typename BasisFunctionType, typename ResultType>
+BlockedSolution<BasisFunctionType, ResultType>
+MixedPrecisionIterativeSolver<BasisFunctionType, ResultType>::solveImplBlocked(
+    const std::vector<GridFunction<BasisFunctionType, ResultType>> &rhs) const {
+  throw std::logic_error("MixedPrecisionIterativeSolver::solve(): "
+                         "blocked operators are not supported");
+}
+
+#if defined(ENABLE_SINGLE_PRECISION)
+FIBER_INSTANTIATE_CLASS_TEMPLATED_ON_BASIS_AND_RESULT_DP_REAL_REAL(
+    MixedPrecisionIterativeSolver);
+FIBER_INSTANTIATE_CLASS_TEMPLATED_ON_BASIS_AND_RESULT_DP_REAL_COMPLEX(
+    MixedPrecisionIterativeSolver);
+FIBER_INSTANTIATE_CLASS_TEMPLATED_ON_BASIS_AND_RESULT_DP_COMPLEX_COMPLEX(
+    MixedPrecisionIterativeSolver);
+#endif
+
+} // namespace Bempp
+
+#endif // WITH_TRILINOS
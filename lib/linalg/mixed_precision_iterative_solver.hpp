@@ -0,0 +1,136 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef bempp_mixed_precision_iterative_solver_hpp
+#define bempp_mixed_precision_iterative_solver_hpp
+
+#include "../common/common.hpp"
+#include "bempp/common/config_trilinos.hpp"
+
+#ifdef WITH_TRILINOS
+
+#include "solver.hpp"
+
+#include "belos_solver_wrapper_fwd.hpp" // for default parameter lists
+#include "preconditioner.hpp"
+
+#include "../common/scalar_traits.hpp"
+
+#include <boost/scoped_ptr.hpp>
+
+namespace Bempp {
+
+/** \ingroup linalg
+  * \brief Iterative solver working with an operator stored in single
+  * precision.
+  *
+  * This solver is intended for problems whose operator is too large to be
+  * stored in double precision. The operator is assembled and stored in
+  * single precision and the solution is obtained by iterative refinement:
+  *
+  * -# compute the residual \f$r = b - Ax\f$ in double precision;
+  * -# solve the correction equation \f$Ad = r\f$ approximately with a Belos
+  *    solver working in single precision;
+  * -# update \f$x := x + d\f$ in double precision
+  *
+  * until \f$\|r\| \le \epsilon \|b\|\f$. The residual is evaluated with a
+  * MixedPrecisionDiscreteBoundaryOperator wrapping the single-precision weak
+  * form. For dense operators the residual is thus computed to double
+  * precision with respect to the stored matrix; for H-matrices the matrix-
+  * vector product itself is evaluated in single precision, so the attainable
+  * tolerance is limited by the accuracy of the H-matrix approximation.
+  *
+  * Convergence is tested in the space dual to the range of the operator.
+  * Only non-blocked operators are supported: solve() must be called with a
+  * single GridFunction, and the overload taking a vector of grid functions
+  * throws std::logic_error.
+  */
+template <typename BasisFunctionType, typename ResultType>
+class MixedPrecisionIterativeSolver
+    : public Solver<BasisFunctionType, ResultType> {
+public:
+  typedef Solver<BasisFunctionType, ResultType> Base;
+  typedef typename ScalarTraits<ResultType>::RealType MagnitudeType;
+  typedef typename ScalarTraits<BasisFunctionType>::SinglePrecisionType
+  SingleBasisFunctionType;
+  typedef typename ScalarTraits<ResultType>::SinglePrecisionType
+  SingleResultType;
+
+  /** \brief Constructor.
+    *
+    * \param[in] boundaryOp
+    *   Double-precision boundary operator defining the equation to be
+    *   solved. Only its spaces and context are used; its weak form is never
+    *   assembled.
+    * \param[in] singlePrecisionOp
+    *   The same operator, defined on single-precision spaces with a
+    *   single-precision context. Its weak form is assembled by the
+    *   constructor.
+    */
+  MixedPrecisionIterativeSolver(
+      const BoundaryOperator<BasisFunctionType, ResultType> &boundaryOp,
+      const BoundaryOperator<SingleBasisFunctionType, SingleResultType> &
+          singlePrecisionOp);
+
+  virtual ~MixedPrecisionIterativeSolver();
+
+  /** \brief Initialize the single-precision Belos solver used to solve the
+    * correction equations.
+    *
+    * \param[in] paramList
+    *   Parameters of the inner solver. Use defaultGmresParameterList() with
+    *   a \c float tolerance to construct a default parameter list. A
+    *   moderate inner tolerance, such as 1e-4, is usually sufficient.
+    */
+  void initializeSolver(const Teuchos::RCP<Teuchos::ParameterList> &paramList);
+
+  /** \brief Initialize the single-precision Belos solver used to solve the
+    * correction equations with a single-precision preconditioner.
+    */
+  void initializeSolver(const Teuchos::RCP<Teuchos::ParameterList> &paramList,
+                        const Preconditioner<SingleResultType> &preconditioner);
+
+  /** \brief Set the parameters of the outer refinement loop.
+    *
+    * \param[in] tolerance
+    *   Relative tolerance of the double-precision residual. Default: 1e-10.
+    * \param[in] maxRefinementCount
+    *   Maximum number of refinement steps. Default: 20.
+    */
+  void setRefinementParameters(MagnitudeType tolerance,
+                               int maxRefinementCount = 20);
+
+private:
+  virtual Solution<BasisFunctionType, ResultType> solveImplNonblocked(
+      const GridFunction<BasisFunctionType, ResultType> &rhs) const;
+  virtual BlockedSolution<BasisFunctionType, ResultType> solveImplBlocked(
+      const std::vector<GridFunction<BasisFunctionType, ResultType>> &rhs)
+      const;
+
+private:
+  struct Impl;
+  boost::scoped_ptr<Impl> m_impl;
+};
+
+} // namespace Bempp
+
+#endif // WITH_TRILINOS
+
+#endif
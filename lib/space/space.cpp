@@ -152,6 +152,9 @@ operator=(const Space<BasisFunctionType> &other) {
   m_grid = other.m_grid;
   m_view = m_grid->levelView(m_level);
   m_elementGeometryFactory = other.m_elementGeometryFactory;
+  tbb::mutex::scoped_lock lock(m_globalDofsOfAllElementsMutex);
+  m_globalDofsOfAllElements.reset();
+  m_localDofWeightsOfAllElements.reset();
   return *this;
 }
 
@@ -215,6 +218,35 @@ void Space<BasisFunctionType>::getGlobalDofs(
   localDofWeights.resize(dofs.size(), 1.);
 }
 
+template <typename BasisFunctionType>
+void Space<BasisFunctionType>::getGlobalDofsOfAllElements(
+    shared_ptr<const std::vector<std::vector<GlobalDofIndex>>> &dofs,
+    shared_ptr<const std::vector<std::vector<BasisFunctionType>>> &
+        localDofWeights) const {
+  tbb::mutex::scoped_lock lock(m_globalDofsOfAllElementsMutex);
+  if (!m_globalDofsOfAllElements) {
+    const GridView &view = gridView();
+    const size_t elementCount = view.entityCount(0);
+    shared_ptr<std::vector<std::vector<GlobalDofIndex>>> newDofs(
+        new std::vector<std::vector<GlobalDofIndex>>(elementCount));
+    shared_ptr<std::vector<std::vector<BasisFunctionType>>> newWeights(
+        new std::vector<std::vector<BasisFunctionType>>(elementCount));
+    const Mapper &mapper = view.elementMapper();
+    std::unique_ptr<EntityIterator<0>> it = view.entityIterator<0>();
+    while (!it->finished()) {
+      const Entity<0> &element = it->entity();
+      const int elementIndex = mapper.entityIndex(element);
+      getGlobalDofs(element, (*newDofs)[elementIndex],
+                    (*newWeights)[elementIndex]);
+      it->next();
+    }
+    m_globalDofsOfAllElements = newDofs;
+    m_localDofWeightsOfAllElements = newWeights;
+  }
+  dofs = m_globalDofsOfAllElements;
+  localDofWeights = m_localDofWeightsOfAllElements;
+}
+
 template <typename BasisFunctionType>
 void Space<BasisFunctionType>::global2localDofs(
     const std::vector<GlobalDofIndex> &globalDofs,
@@ -36,6 +36,7 @@
 #include "../fiber/scalar_traits.hpp"
 
 #include "../common/armadillo_fwd.hpp"
+#include <tbb/mutex.h>
 #include <vector>
 
 namespace Fiber {
@@ -343,6 +344,26 @@ public:
                                std::vector<GlobalDofIndex>& dofs,
                                std::vector<BasisFunctionType>& localDofWeights) const;
 
+    /** \brief Map local degrees of freedom residing on all elements to global
+     *  degrees of freedom.
+     *
+     *  \param[out] dofs
+     *    Vector whose <em>e</em>th element is the list of global degrees of
+     *    freedom of the element with index <em>e</em> in the element mapper
+     *    of gridView(), as returned by getGlobalDofs().
+     *  \param[out] localDofWeights
+     *    Vector whose <em>e</em>th element is the list of the corresponding
+     *    local degree of freedom weights.
+     *
+     *  The lists are gathered on the first call and shared by all subsequent
+     *  calls, which makes this function cheaper than looping over the
+     *  elements and calling getGlobalDofs() in assembly routines. This
+     *  function is thread-safe. */
+    void getGlobalDofsOfAllElements(
+            shared_ptr<const std::vector<std::vector<GlobalDofIndex> > >& dofs,
+            shared_ptr<const std::vector<std::vector<BasisFunctionType> > >&
+            localDofWeights) const;
+
     /** \brief Return true if both spaces act on the same grid. */
     virtual bool gridIsIdentical(const Space<BasisFunctionType>& other) const;
 
@@ -599,6 +620,11 @@ private:
   shared_ptr<GeometryFactory> m_elementGeometryFactory;
   unsigned int m_level;
   std::unique_ptr<GridView> m_view;
+  mutable shared_ptr<const std::vector<std::vector<GlobalDofIndex> > >
+  m_globalDofsOfAllElements;
+  mutable shared_ptr<const std::vector<std::vector<BasisFunctionType> > >
+  m_localDofWeightsOfAllElements;
+  mutable tbb::mutex m_globalDofsOfAllElementsMutex;
   /** \endcond */
 };
 
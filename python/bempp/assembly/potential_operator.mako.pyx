@@ -32,6 +32,23 @@ cdef class PotentialOperator:
 
         return res.reshape(self._component_count,-1,order='F')
 
+    def evaluate_batch(self, grid_functions):
+        """Evaluate the potentials of a sequence of grid functions.
+
+        The coefficients of all grid functions are multiplied with the
+        discrete operator at once. The result has the shape
+        (component_count, number_of_points, len(grid_functions)).
+
+        """
+
+        coefficients = np.column_stack(
+                [g.coefficients for g in grid_functions])
+
+        res = self._op*coefficients
+
+        return res.reshape(self._component_count,-1,len(grid_functions),
+                order='F')
+
     def __is_compatible(self,PotentialOperator other):
 
         return (self.component_count==other.component_count and
@@ -102,13 +102,26 @@ private:
 };
 
 
+// Python callbacks share the argument arrays of their functor and must hold
+// the interpreter lock, so they are never evaluated concurrently.
+template <typename ValueType>
+class PythonFunction :
+    public Fiber::SurfaceNormalAndDomainIndexDependentFunction<PythonFunctor<ValueType>>
+{
+public:
+    PythonFunction(const PythonFunctor<ValueType>& functor) :
+        Fiber::SurfaceNormalAndDomainIndexDependentFunction<PythonFunctor<ValueType>>(functor) {}
+
+    virtual bool isThreadSafe() const { return false; }
+};
+
 template <typename ValueType>
 shared_ptr<Fiber::Function<ValueType>> _py_surface_normal_dependent_function(
         typename PythonFunctor<ValueType>::pyFunc_t pyFunc,PyObject* callable, 
         int argumentDimension, int resultDimension)
 {
     return shared_ptr<Fiber::Function<ValueType>>(
-        new Fiber::SurfaceNormalAndDomainIndexDependentFunction<PythonFunctor<ValueType>>(
+        new PythonFunction<ValueType>(
             PythonFunctor<ValueType>(pyFunc,callable,argumentDimension,resultDimension)));
 }
 } // namespace Bempp
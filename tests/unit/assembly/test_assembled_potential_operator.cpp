@@ -0,0 +1,156 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "../random_arrays.hpp"
+
+#include "create_regular_grid.hpp"
+
+#include "assembly/assembled_potential_operator.hpp"
+#include "assembly/discrete_boundary_operator.hpp"
+#include "assembly/grid_function.hpp"
+#include "assembly/laplace_3d_single_layer_potential_operator.hpp"
+
+#include "common/global_parameters.hpp"
+
+#include "grid/grid.hpp"
+
+#include "space/piecewise_constant_scalar_space.hpp"
+
+#include "common/armadillo_fwd.hpp"
+#include <boost/test/unit_test.hpp>
+#include <string>
+
+// Tests
+
+using namespace Bempp;
+
+namespace
+{
+
+typedef double BFT;
+typedef double RT;
+
+struct AssembledPotentialOperatorFixture
+{
+    AssembledPotentialOperatorFixture()
+    {
+        grid = createRegularTriangularGrid(16, 16);
+        space.reset(new PiecewiseConstantScalarSpace<BFT>(grid));
+
+        // A square of points above the grid, which lies in the plane z = 0
+        const int pointsPerSide = 20;
+        arma::Mat<double>* evaluationPoints =
+                new arma::Mat<double>(3, pointsPerSide * pointsPerSide);
+        for (int i = 0; i < pointsPerSide; ++i)
+            for (int j = 0; j < pointsPerSide; ++j) {
+                (*evaluationPoints)(0, i * pointsPerSide + j) =
+                        -0.5 + 2. * i / (pointsPerSide - 1);
+                (*evaluationPoints)(1, i * pointsPerSide + j) =
+                        -0.5 + 2. * j / (pointsPerSide - 1);
+                (*evaluationPoints)(2, i * pointsPerSide + j) = 0.5;
+            }
+        points.reset(evaluationPoints);
+
+        parameters = GlobalParameters::parameterList();
+        parameters.set("verbosityLevel", -5);
+        ParameterList& hMatParameters = parameters.sublist("HMatParameters");
+        hMatParameters.set("minBlockSize", 16);
+        hMatParameters.set("eps", 1e-6);
+    }
+
+    shared_ptr<Grid> grid;
+    shared_ptr<Space<BFT> > space;
+    shared_ptr<const arma::Mat<double> > points;
+    ParameterList parameters;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(AssembledPotentialOperatorTests)
+
+BOOST_FIXTURE_TEST_CASE(hmat_potential_agrees_with_dense_potential,
+                        AssembledPotentialOperatorFixture)
+{
+    Laplace3dSingleLayerPotentialOperator<BFT, RT> op;
+
+    parameters.set("potentialOperatorAssemblyType", std::string("dense"));
+    arma::Mat<RT> denseMatrix =
+            op.assemble(space, points, parameters).discreteOperator()
+            ->asMatrix();
+
+    parameters.set("potentialOperatorAssemblyType", std::string("hmat"));
+    arma::Mat<RT> hMatMatrix =
+            op.assemble(space, points, parameters).discreteOperator()
+            ->asMatrix();
+
+    BOOST_CHECK_EQUAL(hMatMatrix.n_rows, denseMatrix.n_rows);
+    BOOST_CHECK_EQUAL(hMatMatrix.n_cols, denseMatrix.n_cols);
+    BOOST_CHECK_SMALL(arma::norm(hMatMatrix - denseMatrix, "fro") /
+                      arma::norm(denseMatrix, "fro"), 1e-5);
+}
+
+BOOST_FIXTURE_TEST_CASE(hmat_potential_accepts_partial_parameter_list,
+                        AssembledPotentialOperatorFixture)
+{
+    Laplace3dSingleLayerPotentialOperator<BFT, RT> op;
+
+    // Missing parameters are taken from the global parameter list
+    ParameterList partialParameters;
+    partialParameters.set("potentialOperatorAssemblyType",
+                          std::string("hmat"));
+    partialParameters.set("verbosityLevel", -5);
+    BOOST_CHECK_NO_THROW(op.assemble(space, points, partialParameters));
+}
+
+BOOST_FIXTURE_TEST_CASE(apply_to_matrix_agrees_with_apply_to_grid_functions,
+                        AssembledPotentialOperatorFixture)
+{
+    Laplace3dSingleLayerPotentialOperator<BFT, RT> op;
+    const size_t functionCount = 5;
+    arma::Mat<RT> coefficients(space->globalDofCount(), functionCount);
+    for (size_t j = 0; j < functionCount; ++j)
+        coefficients.col(j) = generateRandomVector<RT>(space->globalDofCount());
+
+    const char* assemblyTypes[] = {"dense", "hmat"};
+    for (size_t t = 0; t < 2; ++t) {
+        parameters.set("potentialOperatorAssemblyType",
+                       std::string(assemblyTypes[t]));
+        AssembledPotentialOperator<BFT, RT> assembledOp =
+                op.assemble(space, points, parameters);
+
+        arma::Mat<RT> batchResult = assembledOp.apply(coefficients);
+        BOOST_CHECK_EQUAL(batchResult.n_rows, points->n_cols);
+        BOOST_CHECK_EQUAL(batchResult.n_cols, functionCount);
+
+        for (size_t j = 0; j < functionCount; ++j) {
+            GridFunction<BFT, RT> function(
+                        parameters, space,
+                        arma::Col<RT>(coefficients.col(j)));
+            arma::Mat<RT> columnResult = assembledOp.apply(function);
+            BOOST_CHECK_SMALL(
+                        arma::norm(batchResult.col(j) -
+                                   arma::vectorise(columnResult), 2) /
+                        arma::norm(arma::vectorise(columnResult), 2),
+                        1e-12);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
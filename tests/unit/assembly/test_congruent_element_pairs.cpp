@@ -0,0 +1,149 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "../check_arrays_are_close.hpp"
+
+#include "create_regular_grid.hpp"
+
+#include "assembly/assembly_options.hpp"
+#include "assembly/boundary_operator.hpp"
+#include "assembly/context.hpp"
+#include "assembly/discrete_boundary_operator.hpp"
+#include "assembly/general_elementary_singular_integral_operator_imp.hpp"
+#include "assembly/numerical_quadrature_strategy.hpp"
+#include "assembly/symmetry.hpp"
+
+#include "fiber/default_test_kernel_trial_integral.hpp"
+#include "fiber/laplace_3d_double_layer_potential_kernel_functor.hpp"
+#include "fiber/laplace_3d_single_layer_potential_kernel_functor.hpp"
+#include "fiber/scalar_function_value_functor.hpp"
+#include "fiber/simple_test_scalar_kernel_trial_integrand_functor.hpp"
+#include "fiber/typical_test_scalar_kernel_trial_integral.hpp"
+
+#include "grid/grid.hpp"
+
+#include "space/piecewise_constant_scalar_space.hpp"
+#include "space/piecewise_linear_continuous_scalar_space.hpp"
+
+#include "common/armadillo_fwd.hpp"
+#include <boost/test/unit_test.hpp>
+#include <limits>
+
+// Tests
+
+using namespace Bempp;
+
+namespace
+{
+
+typedef double BFT;
+typedef double RT;
+typedef double KT;
+
+// Weak form of an operator with the given kernel, assembled in dense mode
+// with singular integral caching. The integral declares itself invariant under
+// rigid motions only if reuseCongruentPairs is set, so that the singular
+// integrals of congruent element pairs are shared only in that case.
+template <typename KernelFunctor>
+arma::Mat<RT> assembleWeakForm(const shared_ptr<Space<BFT> >& domain,
+                               const shared_ptr<Space<BFT> >& dualToRange,
+                               bool useBlas, bool reuseCongruentPairs)
+{
+    typedef Fiber::ScalarFunctionValueFunctor<double> TransformationFunctor;
+    typedef Fiber::SimpleTestScalarKernelTrialIntegrandFunctorExt<
+        BFT, KT, RT, 1> IntegrandFunctor;
+    typedef GeneralElementarySingularIntegralOperator<BFT, KT, RT> Op;
+
+    AssemblyOptions assemblyOptions;
+    assemblyOptions.setVerbosityLevel(VerbosityLevel::LOW);
+    assemblyOptions.enableSingularIntegralCaching(true);
+    shared_ptr<NumericalQuadratureStrategy<BFT, RT> > quadStrategy(
+        new NumericalQuadratureStrategy<BFT, RT>);
+    shared_ptr<Context<BFT, RT> > context(
+        new Context<BFT, RT>(quadStrategy, assemblyOptions));
+
+    shared_ptr<Fiber::TestKernelTrialIntegral<BFT, KT, RT> > integral;
+    if (useBlas)
+        integral.reset(new Fiber::TypicalTestScalarKernelTrialIntegral<
+                       BFT, KT, RT>(reuseCongruentPairs));
+    else
+        integral.reset(new Fiber::DefaultTestKernelTrialIntegral<
+                       IntegrandFunctor>(
+                           IntegrandFunctor(reuseCongruentPairs)));
+    shared_ptr<Op> op(new Op(domain, domain, dualToRange, "", NO_SYMMETRY,
+                             KernelFunctor(), TransformationFunctor(),
+                             TransformationFunctor(), integral));
+    BoundaryOperator<BFT, RT> bop(context, op);
+    return bop.weakForm()->asMatrix();
+}
+
+template <typename KernelFunctor>
+void checkReuseOfCongruentPairs(const shared_ptr<Space<BFT> >& domain,
+                                const shared_ptr<Space<BFT> >& dualToRange)
+{
+    for (int useBlas = 0; useBlas < 2; ++useBlas) {
+        arma::Mat<RT> expected = assembleWeakForm<KernelFunctor>(
+            domain, dualToRange, useBlas, false);
+        arma::Mat<RT> actual = assembleWeakForm<KernelFunctor>(
+            domain, dualToRange, useBlas, true);
+        BOOST_CHECK(check_arrays_are_close<RT>(
+                        actual, expected,
+                        1000. * std::numeric_limits<RT>::epsilon()));
+    }
+}
+
+// Every interior element pair of a regular grid is congruent to many others
+struct CongruentElementPairsFixture
+{
+    CongruentElementPairsFixture()
+    {
+        grid = createRegularTriangularGrid(6, 5, 1.5, 1.);
+        pwiseConstants.reset(new PiecewiseConstantScalarSpace<BFT>(grid));
+        pwiseLinears.reset(new PiecewiseLinearContinuousScalarSpace<BFT>(grid));
+    }
+
+    shared_ptr<Grid> grid;
+    shared_ptr<Space<BFT> > pwiseConstants;
+    shared_ptr<Space<BFT> > pwiseLinears;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(CongruentElementPairs)
+
+BOOST_AUTO_TEST_CASE(reuse_of_singular_integrals_does_not_change_single_layer_weak_form)
+{
+    CongruentElementPairsFixture fixture;
+    typedef Fiber::Laplace3dSingleLayerPotentialKernelFunctor<KT> Kernel;
+    checkReuseOfCongruentPairs<Kernel>(fixture.pwiseConstants,
+                                       fixture.pwiseConstants);
+    checkReuseOfCongruentPairs<Kernel>(fixture.pwiseLinears,
+                                       fixture.pwiseConstants);
+}
+
+BOOST_AUTO_TEST_CASE(reuse_of_singular_integrals_does_not_change_double_layer_weak_form)
+{
+    CongruentElementPairsFixture fixture;
+    typedef Fiber::Laplace3dDoubleLayerPotentialKernelFunctor<KT> Kernel;
+    checkReuseOfCongruentPairs<Kernel>(fixture.pwiseLinears,
+                                       fixture.pwiseLinears);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,129 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "../check_arrays_are_close.hpp"
+
+#include "create_regular_grid.hpp"
+
+#include "assembly/assembly_options.hpp"
+#include "assembly/boundary_operator.hpp"
+#include "assembly/context.hpp"
+#include "assembly/discrete_boundary_operator.hpp"
+#include "assembly/laplace_3d_single_layer_boundary_operator.hpp"
+#include "assembly/numerical_quadrature_strategy.hpp"
+
+#include "grid/grid.hpp"
+
+#include "space/piecewise_constant_scalar_space.hpp"
+#include "space/piecewise_linear_continuous_scalar_space.hpp"
+
+#include "common/armadillo_fwd.hpp"
+#include <boost/test/unit_test.hpp>
+#include <limits>
+
+// Tests
+
+using namespace Bempp;
+
+namespace
+{
+
+typedef double BFT;
+typedef double RT;
+
+// Weak form of the single-layer operator assembled in dense mode with the
+// given number of threads. Continuous piecewise linear functions share DOFs
+// between elements, so the trial elements are assembled in several colors.
+arma::Mat<RT> assembleSingleLayer(const shared_ptr<Space<BFT> >& domain,
+                                  const shared_ptr<Space<BFT> >& dualToRange,
+                                  int maxThreadCount)
+{
+    AssemblyOptions assemblyOptions;
+    assemblyOptions.setVerbosityLevel(VerbosityLevel::LOW);
+    assemblyOptions.setMaxThreadCount(maxThreadCount);
+    shared_ptr<NumericalQuadratureStrategy<BFT, RT> > quadStrategy(
+        new NumericalQuadratureStrategy<BFT, RT>);
+    shared_ptr<Context<BFT, RT> > context(
+        new Context<BFT, RT>(quadStrategy, assemblyOptions));
+
+    BoundaryOperator<BFT, RT> op =
+        laplace3dSingleLayerBoundaryOperator<BFT, RT>(
+            context, domain, dualToRange, dualToRange);
+    return op.weakForm()->asMatrix();
+}
+
+struct DenseGlobalAssemblerFixture
+{
+    DenseGlobalAssemblerFixture()
+    {
+        grid = createRegularTriangularGrid(8, 8);
+        pwiseConstants.reset(new PiecewiseConstantScalarSpace<BFT>(grid));
+        pwiseLinears.reset(new PiecewiseLinearContinuousScalarSpace<BFT>(grid));
+    }
+
+    shared_ptr<Grid> grid;
+    shared_ptr<Space<BFT> > pwiseConstants;
+    shared_ptr<Space<BFT> > pwiseLinears;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(DenseGlobalAssembler)
+
+BOOST_AUTO_TEST_CASE(parallel_assembly_agrees_with_serial_assembly_for_continuous_trial_space)
+{
+    DenseGlobalAssemblerFixture fixture;
+    arma::Mat<RT> serial = assembleSingleLayer(
+        fixture.pwiseLinears, fixture.pwiseConstants, 1);
+    arma::Mat<RT> parallel = assembleSingleLayer(
+        fixture.pwiseLinears, fixture.pwiseConstants, 4);
+
+    BOOST_CHECK(check_arrays_are_close<RT>(
+                    parallel, serial,
+                    100. * std::numeric_limits<RT>::epsilon()));
+}
+
+BOOST_AUTO_TEST_CASE(parallel_assembly_agrees_with_serial_assembly_for_continuous_test_and_trial_spaces)
+{
+    DenseGlobalAssemblerFixture fixture;
+    arma::Mat<RT> serial = assembleSingleLayer(
+        fixture.pwiseLinears, fixture.pwiseLinears, 1);
+    arma::Mat<RT> parallel = assembleSingleLayer(
+        fixture.pwiseLinears, fixture.pwiseLinears, 4);
+
+    BOOST_CHECK(check_arrays_are_close<RT>(
+                    parallel, serial,
+                    100. * std::numeric_limits<RT>::epsilon()));
+}
+
+BOOST_AUTO_TEST_CASE(parallel_assembly_agrees_with_serial_assembly_for_discontinuous_spaces)
+{
+    DenseGlobalAssemblerFixture fixture;
+    arma::Mat<RT> serial = assembleSingleLayer(
+        fixture.pwiseConstants, fixture.pwiseConstants, 1);
+    arma::Mat<RT> parallel = assembleSingleLayer(
+        fixture.pwiseConstants, fixture.pwiseConstants, 4);
+
+    BOOST_CHECK(check_arrays_are_close<RT>(
+                    parallel, serial,
+                    100. * std::numeric_limits<RT>::epsilon()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
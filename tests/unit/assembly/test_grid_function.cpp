@@ -35,9 +35,12 @@
 #include "grid/grid_factory.hpp"
 
 #include "space/piecewise_linear_continuous_scalar_space.hpp"
+#include "space/piecewise_constant_dual_grid_scalar_space.hpp"
 #include "space/piecewise_constant_scalar_space.hpp"
 
 #include <boost/test/floating_point_comparison.hpp>
+#include <limits>
+#include <vector>
 
 using namespace Bempp;
 
@@ -187,4 +190,94 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(L2Norm_works_for_exponential_function_and_piecewis
     BOOST_CHECK_CLOSE(norm, expectedNorm, 1 /* percent */);
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(calculateProjections_agrees_with_projections_of_individual_functions, ResultType, result_types)
+{
+    typedef ResultType RT;
+    typedef typename ScalarTraits<RT>::RealType BFT;
+    typedef typename ScalarTraits<RT>::RealType CT;
+
+    GridParameters params;
+    params.topology = GridParameters::TRIANGULAR;
+    shared_ptr<Grid> grid = GridFactory::importGmshGrid(
+        params, "../../meshes/sphere-h-0.4.msh", false /* verbose */);
+
+    shared_ptr<const Space<BFT> > space(
+        new PiecewiseConstantScalarSpace<BFT>(grid));
+    shared_ptr<const Space<BFT> > dualSpace(
+        new PiecewiseLinearContinuousScalarSpace<BFT>(grid));
+
+    AccuracyOptions accuracyOptions;
+    shared_ptr<NumericalQuadratureStrategy<BFT, RT> > quadStrategy(
+                new NumericalQuadratureStrategy<BFT, RT>(accuracyOptions));
+    AssemblyOptions assemblyOptions;
+    assemblyOptions.setVerbosityLevel(VerbosityLevel::LOW);
+    shared_ptr<const Context<BFT, RT> > context(
+        new Context<BFT, RT>(quadStrategy, assemblyOptions));
+
+    typedef SurfaceNormalIndependentFunction<ConstantFunction<RT> >
+        ConstantFun;
+    typedef SurfaceNormalIndependentFunction<SinusoidalFunction<RT> >
+        SinusoidalFun;
+    ConstantFun constant = surfaceNormalIndependentFunction(
+        ConstantFunction<RT>());
+    SinusoidalFun sinusoidal = surfaceNormalIndependentFunction(
+        SinusoidalFunction<RT>());
+    std::vector<const Function<RT>*> functions;
+    functions.push_back(&constant);
+    functions.push_back(&sinusoidal);
+
+    arma::Mat<RT> projections =
+        calculateProjections(context, functions, space, dualSpace);
+
+    BOOST_REQUIRE_EQUAL(projections.n_cols, functions.size());
+    for (size_t f = 0; f < functions.size(); ++f) {
+        Bempp::GridFunction<BFT, RT> fun(context, space, dualSpace,
+                                         *functions[f]);
+        arma::Mat<RT> expected = fun.projections(fun.dualSpace());
+        arma::Mat<RT> actual = projections.col(f);
+        BOOST_CHECK(check_arrays_are_close<RT>(
+                        actual, expected,
+                        100. * std::numeric_limits<CT>::epsilon()));
+    }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(calculateProjections_uses_barycentric_dual_space_for_barycentric_primal_space, ResultType, result_types)
+{
+    typedef ResultType RT;
+    typedef typename ScalarTraits<RT>::RealType BFT;
+    typedef typename ScalarTraits<RT>::RealType CT;
+
+    GridParameters params;
+    params.topology = GridParameters::TRIANGULAR;
+    shared_ptr<Grid> grid = GridFactory::importGmshGrid(
+        params, "../../meshes/sphere-h-0.4.msh", false /* verbose */);
+
+    shared_ptr<const Space<BFT> > space(
+        new PiecewiseConstantDualGridScalarSpace<BFT>(grid));
+    shared_ptr<const Space<BFT> > dualSpace(
+        new PiecewiseLinearContinuousScalarSpace<BFT>(grid));
+
+    AccuracyOptions accuracyOptions;
+    shared_ptr<NumericalQuadratureStrategy<BFT, RT> > quadStrategy(
+                new NumericalQuadratureStrategy<BFT, RT>(accuracyOptions));
+    AssemblyOptions assemblyOptions;
+    assemblyOptions.setVerbosityLevel(VerbosityLevel::LOW);
+    shared_ptr<const Context<BFT, RT> > context(
+        new Context<BFT, RT>(quadStrategy, assemblyOptions));
+
+    SurfaceNormalIndependentFunction<SinusoidalFunction<RT> > sinusoidal =
+        surfaceNormalIndependentFunction(SinusoidalFunction<RT>());
+    std::vector<const Function<RT>*> functions(1, &sinusoidal);
+
+    arma::Mat<RT> projections =
+        calculateProjections(context, functions, space, dualSpace);
+
+    Bempp::GridFunction<BFT, RT> fun(context, space, dualSpace, sinusoidal);
+    BOOST_CHECK(fun.dualSpace()->isBarycentric());
+    arma::Mat<RT> expected = fun.projections(fun.dualSpace());
+    BOOST_CHECK(check_arrays_are_close<RT>(
+                    projections, expected,
+                    100. * std::numeric_limits<CT>::epsilon()));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,207 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "../check_arrays_are_close.hpp"
+#include "../random_arrays.hpp"
+
+#include "create_regular_grid.hpp"
+
+#include "assembly/boundary_operator.hpp"
+#include "assembly/context.hpp"
+#include "assembly/discrete_boundary_operator.hpp"
+#include "assembly/laplace_3d_double_layer_boundary_operator.hpp"
+#include "assembly/laplace_3d_single_layer_boundary_operator.hpp"
+#include "assembly/modified_helmholtz_3d_single_layer_boundary_operator.hpp"
+
+#include "common/global_parameters.hpp"
+
+#include "grid/grid.hpp"
+
+#include "space/piecewise_constant_scalar_space.hpp"
+
+#include "common/armadillo_fwd.hpp"
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Tests
+
+using namespace Bempp;
+
+namespace
+{
+
+typedef double BFT;
+typedef double RT;
+
+struct HMatCacheFixture
+{
+    HMatCacheFixture()
+    {
+        char directoryTemplate[] = "/tmp/bempp_hmat_cache_XXXXXX";
+        if (!mkdtemp(directoryTemplate))
+            throw std::runtime_error("HMatCacheFixture: "
+                                     "cannot create a temporary directory");
+        cacheDirectory = directoryTemplate;
+
+        grid = createRegularTriangularGrid(16, 16);
+        space.reset(new PiecewiseConstantScalarSpace<BFT>(grid));
+
+        parameters = GlobalParameters::parameterList();
+        parameters.set("boundaryOperatorAssemblyType", std::string("hmat"));
+        parameters.set("verbosityLevel", -5);
+        ParameterList& hMatParameters = parameters.sublist("HMatParameters");
+        hMatParameters.set("minBlockSize", 16);
+        hMatParameters.set("eps", 1e-6);
+        hMatParameters.set("cacheDirectory", cacheDirectory);
+    }
+
+    ~HMatCacheFixture()
+    {
+        std::vector<std::string> files = cacheFiles();
+        for (size_t i = 0; i < files.size(); ++i)
+            std::remove((cacheDirectory + "/" + files[i]).c_str());
+        rmdir(cacheDirectory.c_str());
+    }
+
+    std::vector<std::string> cacheFiles() const
+    {
+        std::vector<std::string> result;
+        DIR* directory = opendir(cacheDirectory.c_str());
+        if (!directory)
+            return result;
+        while (dirent* entry = readdir(directory)) {
+            std::string name(entry->d_name);
+            if (name.compare(0, 5, "hmat_") == 0)
+                result.push_back(name);
+        }
+        closedir(directory);
+        return result;
+    }
+
+    shared_ptr<const Context<BFT, RT> > context() const
+    {
+        return shared_ptr<const Context<BFT, RT> >(
+            new Context<BFT, RT>(parameters));
+    }
+
+    shared_ptr<const DiscreteBoundaryOperator<RT> > weakForm() const
+    {
+        return laplace3dSingleLayerBoundaryOperator<BFT, RT>(
+            context(), space, space, space).weakForm();
+    }
+
+    shared_ptr<const DiscreteBoundaryOperator<RT> > doubleLayerWeakForm() const
+    {
+        return laplace3dDoubleLayerBoundaryOperator<BFT, RT>(
+            context(), space, space, space).weakForm();
+    }
+
+    shared_ptr<const DiscreteBoundaryOperator<RT> >
+    modifiedHelmholtzWeakForm(RT waveNumber) const
+    {
+        return modifiedHelmholtz3dSingleLayerBoundaryOperator<BFT, RT, RT>(
+            context(), space, space, space, waveNumber).weakForm();
+    }
+
+    std::string cacheDirectory;
+    shared_ptr<Grid> grid;
+    shared_ptr<Space<BFT> > space;
+    ParameterList parameters;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(HMatCache)
+
+BOOST_AUTO_TEST_CASE(loaded_hmatrix_agrees_with_assembled_one)
+{
+    std::srand(1);
+    HMatCacheFixture fixture;
+
+    shared_ptr<const DiscreteBoundaryOperator<RT> > assembled =
+        fixture.weakForm();
+    BOOST_CHECK_EQUAL(fixture.cacheFiles().size(), 1u);
+
+    shared_ptr<const DiscreteBoundaryOperator<RT> > loaded =
+        fixture.weakForm();
+    BOOST_CHECK_EQUAL(fixture.cacheFiles().size(), 1u);
+
+    arma::Col<RT> x = generateRandomVector<RT>(assembled->columnCount());
+    arma::Col<RT> expected(assembled->rowCount());
+    arma::Col<RT> y(loaded->rowCount());
+    assembled->apply(NO_TRANSPOSE, x, expected, 1., 0.);
+    loaded->apply(NO_TRANSPOSE, x, y, 1., 0.);
+
+    BOOST_CHECK(check_arrays_are_close<RT>(
+                    y, expected, 10. * std::numeric_limits<RT>::epsilon()));
+}
+
+BOOST_AUTO_TEST_CASE(different_cache_keys_give_different_cache_files)
+{
+    HMatCacheFixture fixture;
+
+    fixture.weakForm();
+    fixture.parameters.sublist("HMatParameters").set(
+        "cacheKey", std::string("finer_quadrature"));
+    fixture.weakForm();
+
+    BOOST_CHECK_EQUAL(fixture.cacheFiles().size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(different_operators_give_different_cache_files)
+{
+    HMatCacheFixture fixture;
+
+    fixture.weakForm();
+    fixture.doubleLayerWeakForm();
+    BOOST_CHECK_EQUAL(fixture.cacheFiles().size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(different_wave_numbers_give_different_cache_files)
+{
+    HMatCacheFixture fixture;
+
+    shared_ptr<const DiscreteBoundaryOperator<RT> > first =
+        fixture.modifiedHelmholtzWeakForm(1.);
+    shared_ptr<const DiscreteBoundaryOperator<RT> > second =
+        fixture.modifiedHelmholtzWeakForm(2.);
+    BOOST_CHECK_EQUAL(fixture.cacheFiles().size(), 2u);
+
+    shared_ptr<const DiscreteBoundaryOperator<RT> > loaded =
+        fixture.modifiedHelmholtzWeakForm(1.);
+    BOOST_CHECK_EQUAL(fixture.cacheFiles().size(), 2u);
+
+    arma::Col<RT> x = generateRandomVector<RT>(first->columnCount());
+    arma::Col<RT> expected(first->rowCount());
+    arma::Col<RT> y(loaded->rowCount());
+    first->apply(NO_TRANSPOSE, x, expected, 1., 0.);
+    loaded->apply(NO_TRANSPOSE, x, y, 1., 0.);
+
+    BOOST_CHECK(check_arrays_are_close<RT>(
+                    y, expected, 10. * std::numeric_limits<RT>::epsilon()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
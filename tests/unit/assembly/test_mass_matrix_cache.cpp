@@ -0,0 +1,138 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "create_regular_grid.hpp"
+
+#include "assembly/assembly_options.hpp"
+#include "assembly/context.hpp"
+#include "assembly/discrete_boundary_operator.hpp"
+#include "assembly/mass_matrix_cache.hpp"
+#include "assembly/numerical_quadrature_strategy.hpp"
+
+#include "grid/grid.hpp"
+
+#include "space/piecewise_constant_scalar_space.hpp"
+#include "space/piecewise_linear_continuous_scalar_space.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/weak_ptr.hpp>
+
+// Tests
+
+using namespace Bempp;
+
+namespace
+{
+
+typedef double BFT;
+typedef double RT;
+
+struct MassMatrixCacheFixture
+{
+    MassMatrixCacheFixture()
+    {
+        grid = createRegularTriangularGrid();
+        pwiseConstants.reset(new PiecewiseConstantScalarSpace<BFT>(grid));
+        pwiseLinears.reset(new PiecewiseLinearContinuousScalarSpace<BFT>(grid));
+
+        AssemblyOptions assemblyOptions;
+        assemblyOptions.setVerbosityLevel(VerbosityLevel::LOW);
+        shared_ptr<NumericalQuadratureStrategy<BFT, RT> > quadStrategy(
+            new NumericalQuadratureStrategy<BFT, RT>);
+        context.reset(new Context<BFT, RT>(quadStrategy, assemblyOptions));
+    }
+
+    const MassMatrixCache<BFT, RT>& cache() const
+    {
+        return context->massMatrixCache();
+    }
+
+    shared_ptr<Grid> grid;
+    shared_ptr<const Space<BFT> > pwiseConstants;
+    shared_ptr<const Space<BFT> > pwiseLinears;
+    shared_ptr<const Context<BFT, RT> > context;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(MassMatrixCacheTests)
+
+BOOST_AUTO_TEST_CASE(massMatrix_returns_the_same_operator_for_the_same_spaces)
+{
+    MassMatrixCacheFixture fixture;
+    shared_ptr<const DiscreteBoundaryOperator<RT> > first =
+        fixture.cache().massMatrix(fixture.context, fixture.pwiseLinears,
+                                   fixture.pwiseLinears, fixture.pwiseLinears);
+    shared_ptr<const DiscreteBoundaryOperator<RT> > second =
+        fixture.cache().massMatrix(fixture.context, fixture.pwiseLinears,
+                                   fixture.pwiseLinears, fixture.pwiseLinears);
+    BOOST_CHECK(first);
+    BOOST_CHECK_EQUAL(first.get(), second.get());
+    BOOST_CHECK_EQUAL(first->rowCount(),
+                      fixture.pwiseLinears->globalDofCount());
+}
+
+BOOST_AUTO_TEST_CASE(massMatrix_distinguishes_spaces)
+{
+    MassMatrixCacheFixture fixture;
+    shared_ptr<const DiscreteBoundaryOperator<RT> > linear =
+        fixture.cache().massMatrix(fixture.context, fixture.pwiseLinears,
+                                   fixture.pwiseLinears, fixture.pwiseLinears);
+    shared_ptr<const DiscreteBoundaryOperator<RT> > constant =
+        fixture.cache().massMatrix(fixture.context, fixture.pwiseConstants,
+                                   fixture.pwiseConstants,
+                                   fixture.pwiseConstants);
+    BOOST_CHECK(linear.get() != constant.get());
+    BOOST_CHECK_EQUAL(constant->rowCount(),
+                      fixture.pwiseConstants->globalDofCount());
+}
+
+BOOST_AUTO_TEST_CASE(inverseMassMatrix_returns_the_same_operator_for_the_same_spaces)
+{
+    MassMatrixCacheFixture fixture;
+    shared_ptr<const DiscreteBoundaryOperator<RT> > first =
+        fixture.cache().inverseMassMatrix(
+            fixture.context, fixture.pwiseLinears, fixture.pwiseLinears,
+            fixture.pwiseLinears);
+    shared_ptr<const DiscreteBoundaryOperator<RT> > second =
+        fixture.cache().inverseMassMatrix(
+            fixture.context, fixture.pwiseLinears, fixture.pwiseLinears,
+            fixture.pwiseLinears);
+    BOOST_CHECK(first);
+    BOOST_CHECK_EQUAL(first.get(), second.get());
+}
+
+BOOST_AUTO_TEST_CASE(entry_is_evicted_after_its_space_is_destroyed)
+{
+    MassMatrixCacheFixture fixture;
+    boost::weak_ptr<const DiscreteBoundaryOperator<RT> > cached =
+        fixture.cache().massMatrix(fixture.context, fixture.pwiseLinears,
+                                   fixture.pwiseLinears, fixture.pwiseLinears);
+    BOOST_CHECK(!cached.expired());
+
+    fixture.pwiseLinears.reset();
+    // Expired entries are evicted on the next access to the cache
+    fixture.cache().massMatrix(fixture.context, fixture.pwiseConstants,
+                               fixture.pwiseConstants,
+                               fixture.pwiseConstants);
+    BOOST_CHECK(cached.expired());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
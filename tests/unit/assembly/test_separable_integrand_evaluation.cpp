@@ -0,0 +1,247 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "../type_template.hpp"
+#include "../check_arrays_are_close.hpp"
+
+#include "assembly/assembly_options.hpp"
+#include "assembly/boundary_operator.hpp"
+#include "assembly/context.hpp"
+#include "assembly/discrete_boundary_operator.hpp"
+#include "assembly/general_elementary_singular_integral_operator_imp.hpp"
+#include "assembly/numerical_quadrature_strategy.hpp"
+#include "assembly/symmetry.hpp"
+
+#include "fiber/collection_of_3d_arrays.hpp"
+#include "fiber/geometrical_data.hpp"
+#include "fiber/hdiv_function_value_functor.hpp"
+#include "fiber/laplace_3d_single_layer_potential_kernel_functor.hpp"
+#include "fiber/modified_helmholtz_3d_hypersingular_integrand_functor_2.hpp"
+#include "fiber/modified_helmholtz_3d_hypersingular_kernel_functor.hpp"
+#include "fiber/modified_helmholtz_3d_hypersingular_transformation_functor.hpp"
+#include "fiber/modified_maxwell_3d_double_layer_boundary_operator_integrand_functor.hpp"
+#include "fiber/modified_maxwell_3d_double_layer_operators_kernel_functor.hpp"
+#include "fiber/modified_maxwell_3d_single_layer_boundary_operator_integrand_functor.hpp"
+#include "fiber/modified_maxwell_3d_single_layer_boundary_operator_kernel_functor.hpp"
+#include "fiber/modified_maxwell_3d_single_layer_operators_transformation_functor.hpp"
+#include "fiber/scalar_function_value_functor.hpp"
+#include "fiber/simple_test_scalar_kernel_trial_integrand_functor.hpp"
+#include "fiber/surface_curl_3d_functor.hpp"
+
+#include "grid/grid_factory.hpp"
+
+#include "space/piecewise_linear_continuous_scalar_space.hpp"
+#include "space/raviart_thomas_0_vector_space.hpp"
+
+#include "common/armadillo_fwd.hpp"
+#include <boost/make_shared.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_case_template.hpp>
+#include <complex>
+#include <limits>
+
+// Tests
+
+using namespace Bempp;
+
+namespace
+{
+
+// Integrand functor hiding the separable form of another one, so that
+// DefaultTestKernelTrialIntegral falls back to evaluating it point by point
+template <typename Functor>
+class ScalarEvaluationOnly
+{
+public:
+    typedef typename Functor::BasisFunctionType BasisFunctionType;
+    typedef typename Functor::KernelType KernelType;
+    typedef typename Functor::ResultType ResultType;
+    typedef typename Functor::CoordinateType CoordinateType;
+
+    explicit ScalarEvaluationOnly(const Functor& functor) :
+        m_functor(functor)
+    {}
+
+    void addGeometricalDependencies(size_t& testGeomDeps,
+                                    size_t& trialGeomDeps) const
+    {
+        m_functor.addGeometricalDependencies(testGeomDeps, trialGeomDeps);
+    }
+
+    template <template <typename T> class CollectionOf2dSlicesOfConstNdArrays>
+    ResultType evaluate(
+            const Fiber::ConstGeometricalDataSlice<CoordinateType>& testGeomData,
+            const Fiber::ConstGeometricalDataSlice<CoordinateType>& trialGeomData,
+            const Fiber::CollectionOf1dSlicesOfConst3dArrays<BasisFunctionType>&
+            testValues,
+            const Fiber::CollectionOf1dSlicesOfConst3dArrays<BasisFunctionType>&
+            trialValues,
+            const CollectionOf2dSlicesOfConstNdArrays<KernelType>& kernelValues)
+    const
+    {
+        return m_functor.evaluate(testGeomData, trialGeomData,
+                                  testValues, trialValues, kernelValues);
+    }
+
+private:
+    Functor m_functor;
+};
+
+template <typename BFT, typename KT, typename RT,
+          typename KernelFunctor, typename TransformationFunctor,
+          typename IntegrandFunctor>
+arma::Mat<RT> assembleWeakForm(const shared_ptr<Space<BFT> >& domain,
+                               const shared_ptr<Space<BFT> >& dualToRange,
+                               const KernelFunctor& kernel,
+                               const TransformationFunctor& transformation,
+                               const IntegrandFunctor& integrand)
+{
+    AssemblyOptions assemblyOptions;
+    assemblyOptions.setVerbosityLevel(VerbosityLevel::LOW);
+    shared_ptr<NumericalQuadratureStrategy<BFT, RT> > quadStrategy(
+        new NumericalQuadratureStrategy<BFT, RT>);
+    shared_ptr<Context<BFT, RT> > context(
+        new Context<BFT, RT>(quadStrategy, assemblyOptions));
+
+    typedef GeneralElementarySingularIntegralOperator<BFT, KT, RT> Op;
+    BoundaryOperator<BFT, RT> op(
+        context, boost::make_shared<Op>(domain, domain, dualToRange, "",
+                                        NO_SYMMETRY, kernel, transformation,
+                                        transformation, integrand));
+    return op.weakForm()->asMatrix();
+}
+
+// Compare the weak form assembled with the separable evaluation path of
+// an integrand with the one assembled by evaluating it point by point. Both
+// regular (tensor) and singular (nontensor) quadrature rules are exercised.
+template <typename BFT, typename KT, typename RT,
+          typename KernelFunctor, typename TransformationFunctor,
+          typename IntegrandFunctor>
+void checkSeparableEvaluation(const shared_ptr<Space<BFT> >& space,
+                              const KernelFunctor& kernel,
+                              const TransformationFunctor& transformation,
+                              const IntegrandFunctor& integrand)
+{
+    typedef typename ScalarTraits<RT>::RealType RealType;
+    arma::Mat<RT> separable = assembleWeakForm<BFT, KT, RT>(
+        space, space, kernel, transformation, integrand);
+    arma::Mat<RT> scalar = assembleWeakForm<BFT, KT, RT>(
+        space, space, kernel, transformation,
+        ScalarEvaluationOnly<IntegrandFunctor>(integrand));
+    BOOST_CHECK(check_arrays_are_close<RT>(
+                    separable, scalar,
+                    100 * std::numeric_limits<RealType>::epsilon()));
+}
+
+shared_ptr<Grid> createSphere()
+{
+    GridParameters params;
+    params.topology = GridParameters::TRIANGULAR;
+    return GridFactory::importGmshGrid(
+        params, "meshes/sphere-ico-1.msh", false /* verbose */);
+}
+
+template <typename CT> std::complex<CT> waveNumber()
+{
+    return std::complex<CT>(1.2, 0.7);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(SeparableIntegrandEvaluation)
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(separable_evaluation_agrees_with_scalar_evaluation_for_simple_scalar_integrand,
+                              BFT, basis_function_types)
+{
+    typedef typename ScalarTraits<BFT>::RealType CT;
+    typedef CT KT;
+    typedef BFT RT;
+
+    shared_ptr<Space<BFT> > pwiseLinears(
+        new PiecewiseLinearContinuousScalarSpace<BFT>(createSphere()));
+    checkSeparableEvaluation<BFT, KT, RT>(
+        pwiseLinears,
+        Fiber::Laplace3dSingleLayerPotentialKernelFunctor<KT>(),
+        Fiber::ScalarFunctionValueFunctor<CT>(),
+        Fiber::SimpleTestScalarKernelTrialIntegrandFunctorExt<
+            BFT, KT, RT, 1>());
+    checkSeparableEvaluation<BFT, KT, RT>(
+        pwiseLinears,
+        Fiber::Laplace3dSingleLayerPotentialKernelFunctor<KT>(),
+        Fiber::SurfaceCurl3dFunctor<CT>(),
+        Fiber::SimpleTestScalarKernelTrialIntegrandFunctorExt<
+            BFT, KT, RT, 3>());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(separable_evaluation_agrees_with_scalar_evaluation_for_modified_helmholtz_hypersingular_integrand,
+                              BFT, basis_function_types)
+{
+    typedef typename ScalarTraits<BFT>::RealType CT;
+    typedef std::complex<CT> KT;
+    typedef std::complex<CT> RT;
+
+    shared_ptr<Space<BFT> > pwiseLinears(
+        new PiecewiseLinearContinuousScalarSpace<BFT>(createSphere()));
+    checkSeparableEvaluation<BFT, KT, RT>(
+        pwiseLinears,
+        Fiber::ModifiedHelmholtz3dHypersingularKernelFunctor<KT>(
+            waveNumber<CT>()),
+        Fiber::ModifiedHelmholtz3dHypersingularTransformationFunctor<CT>(),
+        Fiber::ModifiedHelmholtz3dHypersingularIntegrandFunctor2<
+            BFT, KT, RT>());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(separable_evaluation_agrees_with_scalar_evaluation_for_maxwell_single_layer_integrand,
+                              BFT, basis_function_types)
+{
+    typedef typename ScalarTraits<BFT>::RealType CT;
+    typedef std::complex<CT> KT;
+    typedef std::complex<CT> RT;
+
+    shared_ptr<Space<BFT> > rt0(
+        new RaviartThomas0VectorSpace<BFT>(createSphere()));
+    checkSeparableEvaluation<BFT, KT, RT>(
+        rt0,
+        Fiber::ModifiedMaxwell3dSingleLayerBoundaryOperatorKernelFunctor<KT>(
+            waveNumber<CT>() / KT(0., 1.)),
+        Fiber::ModifiedMaxwell3dSingleLayerOperatorsTransformationFunctor<CT>(),
+        Fiber::ModifiedMaxwell3dSingleLayerBoundaryOperatorIntegrandFunctor<
+            BFT, KT, RT>());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(separable_evaluation_agrees_with_scalar_evaluation_for_maxwell_double_layer_integrand,
+                              BFT, basis_function_types)
+{
+    typedef typename ScalarTraits<BFT>::RealType CT;
+    typedef std::complex<CT> KT;
+    typedef std::complex<CT> RT;
+
+    shared_ptr<Space<BFT> > rt0(
+        new RaviartThomas0VectorSpace<BFT>(createSphere()));
+    checkSeparableEvaluation<BFT, KT, RT>(
+        rt0,
+        Fiber::ModifiedMaxwell3dDoubleLayerOperatorsKernelFunctor<KT>(
+            waveNumber<CT>() / KT(0., 1.)),
+        Fiber::HdivFunctionValueFunctor<CT>(),
+        Fiber::ModifiedMaxwell3dDoubleLayerBoundaryOperatorIntegrandFunctor<
+            BFT, KT, RT>());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -232,4 +232,14 @@ BOOST_AUTO_TEST_CASE(quadratureOrder_agrees_with_setDoubleRegular_for_three_rela
     BOOST_CHECK_EQUAL(orderFar, defaultOrder + order3);
 }
 
+BOOST_AUTO_TEST_CASE(doubleRegularTolerance_is_disabled_by_default_and_can_be_set)
+{
+    Fiber::AccuracyOptionsEx opts;
+    BOOST_CHECK_EQUAL(opts.doubleRegularTolerance(), 0.);
+
+    const double tolerance = 1e-6;
+    opts.setDoubleRegularTolerance(tolerance);
+    BOOST_CHECK_EQUAL(opts.doubleRegularTolerance(), tolerance);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -28,6 +28,7 @@
 #include "common/scalar_traits.hpp"
 #include "fiber/geometrical_data.hpp"
 #include "fiber/local_assembler_for_integral_operators.hpp"
+#include "fiber/local_weak_form_tile.hpp"
 #include "grid/grid.hpp"
 #include "grid/grid_factory.hpp"
 #include "grid/grid_view.hpp"
@@ -43,6 +44,7 @@
 #include <boost/test/test_case_template.hpp>
 #include <boost/test/floating_point_comparison.hpp>
 #include <boost/version.hpp>
+#include <cmath>
 #include <complex>
 
 using namespace Bempp;
@@ -62,15 +64,24 @@ public:
     typedef Fiber::RawGridGeometry<CT> RawGridGeometry;
 
     DefaultLocalAssemblerForIntegralOperatorsOnSurfacesManager(
-            bool cacheSingularIntegrals)
+            bool cacheSingularIntegrals,
+            bool distanceDependentRegularOrders = false,
+            shared_ptr<Grid> grid = shared_ptr<Grid>())
     {
         // Create a Bempp grid
-        shared_ptr<Grid> grid = createGrid();
+        if (!grid)
+            grid = createGrid();
 
         // Create context
         Fiber::AccuracyOptions options;
         options.doubleRegular.setRelativeQuadratureOrder(1);
-        quadStrategy.reset(new QuadratureStrategy);
+        if (distanceDependentRegularOrders) {
+            // Nearby and distant regular pairs use different integrators
+            Fiber::AccuracyOptionsEx accuracyOptions;
+            accuracyOptions.setDoubleRegular(1.5, 3, 1);
+            quadStrategy.reset(new QuadratureStrategy(accuracyOptions));
+        } else
+            quadStrategy.reset(new QuadratureStrategy);
 
         AssemblyOptions assemblyOptions;
         assemblyOptions.setVerbosityLevel(VerbosityLevel::LOW);
@@ -129,6 +140,47 @@ public:
     std::unique_ptr<typename Operator::LocalAssembler> assembler;
 };
 
+const int FAN_SECTOR_COUNT = 16;
+
+/** \brief Planar grid consisting of a fan of FAN_SECTOR_COUNT triangles
+ *  around a vertex, surrounded by a ring of quadrilaterals split into two
+ *  triangles each. The inner ring has radii varying between sectors, so that
+ *  only some of the element pairs are congruent to each other. */
+shared_ptr<Grid> createFanGrid()
+{
+    const int n = FAN_SECTOR_COUNT;
+    arma::Mat<double> vertices(3, 1 + 2 * n);
+    vertices.fill(0.);
+    for (int i = 0; i < n; ++i) {
+        const double angle = 2. * M_PI * i / n;
+        const double innerRadius = 1. + 0.1 * (i % 3);
+        const double outerRadius = 2.;
+        vertices(0, 1 + i) = innerRadius * cos(angle);
+        vertices(1, 1 + i) = innerRadius * sin(angle);
+        vertices(0, 1 + n + i) = outerRadius * cos(angle);
+        vertices(1, 1 + n + i) = outerRadius * sin(angle);
+    }
+    arma::Mat<int> elementCorners(3, 3 * n);
+    for (int i = 0; i < n; ++i) {
+        const int innerA = 1 + i, innerB = 1 + (i + 1) % n;
+        const int outerA = 1 + n + i, outerB = 1 + n + (i + 1) % n;
+        elementCorners(0, i) = 0;
+        elementCorners(1, i) = innerA;
+        elementCorners(2, i) = innerB;
+        elementCorners(0, n + 2 * i) = innerA;
+        elementCorners(1, n + 2 * i) = outerA;
+        elementCorners(2, n + 2 * i) = outerB;
+        elementCorners(0, n + 2 * i + 1) = innerA;
+        elementCorners(1, n + 2 * i + 1) = outerB;
+        elementCorners(2, n + 2 * i + 1) = innerB;
+    }
+
+    GridParameters params;
+    params.topology = GridParameters::TRIANGULAR;
+    return GridFactory::createGridFromConnectivityArrays(
+                params, vertices, elementCorners);
+}
+
 // Tests
 
 BOOST_AUTO_TEST_SUITE(DefaultLocalAssemblerForIntegralOperatorsOnSurfaces)
@@ -391,4 +443,120 @@ evaluateLocalWeakForms_with_and_without_singular_integral_caching_gives_same_res
                     resultWithCaching, resultWithoutCaching, 1e-6));
 }
 
+template <typename ResultType>
+void
+evaluateLocalWeakFormTile_agrees_with_evaluateLocalWeakForms_for_cacheSingularIntegrals(
+        bool cacheSingularIntegrals)
+{
+    // Singular pairs are either cached or integrated by several integrators,
+    // regular pairs are integrated by two
+    DefaultLocalAssemblerForIntegralOperatorsOnSurfacesManager<
+            typename ScalarTraits<ResultType>::RealType, ResultType> mgr(
+                cacheSingularIntegrals, true);
+
+    const int elementCount = N_ELEMENTS_X * N_ELEMENTS_Y * 2;
+    std::vector<int> elementIndices(elementCount);
+    for (int i = 0; i < elementCount; ++i)
+        elementIndices[i] = i;
+
+    Fiber::_2dArray<arma::Mat<ResultType> > expected;
+    mgr.assembler->evaluateLocalWeakForms(elementIndices, elementIndices,
+                                          expected);
+
+    // Cover the element pairs with tiles reusing the same buffer. The tile
+    // size does not divide the element count, so the last tiles in each
+    // direction are smaller than the others.
+    const int tileSize = 5;
+    Fiber::LocalWeakFormTile<ResultType> tile;
+    Fiber::_2dArray<arma::Mat<ResultType> > result(elementCount, elementCount);
+    std::vector<int> tileTestIndices, tileTrialIndices;
+    for (int trialBegin = 0; trialBegin < elementCount; trialBegin += tileSize) {
+        const int trialEnd = std::min(trialBegin + tileSize, elementCount);
+        tileTrialIndices.assign(elementIndices.begin() + trialBegin,
+                                elementIndices.begin() + trialEnd);
+        for (int testBegin = 0; testBegin < elementCount; testBegin += tileSize) {
+            const int testEnd = std::min(testBegin + tileSize, elementCount);
+            tileTestIndices.assign(elementIndices.begin() + testBegin,
+                                   elementIndices.begin() + testEnd);
+            mgr.assembler->evaluateLocalWeakFormTile(
+                        tileTestIndices, tileTrialIndices, tile);
+            BOOST_REQUIRE_EQUAL(tile.testElementCount(), testEnd - testBegin);
+            BOOST_REQUIRE_EQUAL(tile.trialElementCount(), trialEnd - trialBegin);
+            for (int trialI = trialBegin; trialI < trialEnd; ++trialI)
+                for (int testI = testBegin; testI < testEnd; ++testI)
+                    result(testI, trialI) = tile.localWeakForm(
+                                testI - testBegin, trialI - trialBegin);
+        }
+    }
+
+    BOOST_CHECK(check_arrays_are_close<ResultType>(
+                    result, expected, 1e-6));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(
+        evaluateLocalWeakFormTile_agrees_with_evaluateLocalWeakForms_for_cacheSingularIntegrals_false,
+        ResultType, result_types)
+{
+    evaluateLocalWeakFormTile_agrees_with_evaluateLocalWeakForms_for_cacheSingularIntegrals<
+            ResultType>(false);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(
+        evaluateLocalWeakFormTile_agrees_with_evaluateLocalWeakForms_for_cacheSingularIntegrals_true,
+        ResultType, result_types)
+{
+    evaluateLocalWeakFormTile_agrees_with_evaluateLocalWeakForms_for_cacheSingularIntegrals<
+            ResultType>(true);
+}
+
+template <typename ResultType>
+void
+cached_singular_integrals_agree_with_recalculated_ones_on_grid_with_high_valence_vertex()
+{
+    // On the fan grid, all pairs of elements touching the central vertex
+    // are singular and therefore cached
+    shared_ptr<Grid> grid = createFanGrid();
+    const int elementCount = 3 * FAN_SECTOR_COUNT;
+    std::vector<int> elementIndices(elementCount);
+    for (int i = 0; i < elementCount; ++i)
+        elementIndices[i] = i;
+
+    Fiber::_2dArray<arma::Mat<ResultType> > resultWithCaching;
+    Fiber::_2dArray<arma::Mat<ResultType> > resultWithoutCaching;
+    std::vector<arma::Mat<ResultType> > colWithCaching, colWithoutCaching;
+    {
+        DefaultLocalAssemblerForIntegralOperatorsOnSurfacesManager<
+                typename ScalarTraits<ResultType>::RealType, ResultType> mgr(
+                    true, false, grid);
+        mgr.assembler->evaluateLocalWeakForms(elementIndices, elementIndices,
+                                              resultWithCaching);
+        mgr.assembler->evaluateLocalWeakForms(Fiber::TRIAL_TEST, elementIndices,
+                                              0, Fiber::ALL_DOFS,
+                                              colWithCaching);
+    }
+    {
+        DefaultLocalAssemblerForIntegralOperatorsOnSurfacesManager<
+                typename ScalarTraits<ResultType>::RealType, ResultType> mgr(
+                    false, false, grid);
+        mgr.assembler->evaluateLocalWeakForms(elementIndices, elementIndices,
+                                              resultWithoutCaching);
+        mgr.assembler->evaluateLocalWeakForms(Fiber::TRIAL_TEST, elementIndices,
+                                              0, Fiber::ALL_DOFS,
+                                              colWithoutCaching);
+    }
+
+    BOOST_CHECK(check_arrays_are_close<ResultType>(
+                    resultWithCaching, resultWithoutCaching, 1e-6));
+    BOOST_CHECK(check_arrays_are_close<ResultType>(
+                    colWithCaching, colWithoutCaching, 1e-6));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(
+        cached_singular_integrals_agree_with_recalculated_ones_on_grid_with_high_valence_vertex,
+        ResultType, result_types)
+{
+    cached_singular_integrals_agree_with_recalculated_ones_on_grid_with_high_valence_vertex<
+            ResultType>();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
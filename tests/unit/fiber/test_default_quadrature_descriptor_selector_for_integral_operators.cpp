@@ -0,0 +1,98 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "fiber/default_quadrature_descriptor_selector_for_integral_operators.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+// Tests
+
+using namespace Fiber;
+
+namespace
+{
+
+typedef DefaultQuadratureDescriptorSelectorForIntegralOperators<double>
+Selector;
+
+int order(double elementSize, double distance, double tolerance,
+          double kernelScale = 1.)
+{
+    const int basisOrder = 0;
+    return Selector::toleranceBasedRegularOrder(
+                basisOrder, elementSize, distance, tolerance, kernelScale);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(DefaultQuadratureDescriptorSelectorForIntegralOperatorsTests)
+
+BOOST_AUTO_TEST_CASE(toleranceBasedRegularOrder_increases_with_element_size)
+{
+    const double distance = 1.;
+    const double tolerance = 1e-6;
+    for (double size = 0.05; size < 1.; size += 0.05)
+        BOOST_CHECK_LE(order(size, distance, tolerance),
+                       order(size + 0.05, distance, tolerance));
+    BOOST_CHECK_LT(order(0.1, distance, tolerance),
+                   order(0.5, distance, tolerance));
+}
+
+BOOST_AUTO_TEST_CASE(toleranceBasedRegularOrder_decreases_with_distance)
+{
+    const double size = 0.1;
+    const double tolerance = 1e-6;
+    for (double distance = 0.1; distance < 2.; distance += 0.1)
+        BOOST_CHECK_GE(order(size, distance, tolerance),
+                       order(size, distance + 0.1, tolerance));
+    BOOST_CHECK_GT(order(size, 0.2, tolerance), order(size, 1., tolerance));
+}
+
+BOOST_AUTO_TEST_CASE(toleranceBasedRegularOrder_decreases_with_tolerance)
+{
+    const double size = 0.1;
+    const double distance = 0.2;
+    for (double tolerance = 1e-12; tolerance < 1e-1; tolerance *= 10.)
+        BOOST_CHECK_GE(order(size, distance, tolerance),
+                       order(size, distance, 10. * tolerance));
+    BOOST_CHECK_GT(order(size, distance, 1e-6), order(size, distance, 1e-3));
+}
+
+BOOST_AUTO_TEST_CASE(toleranceBasedRegularOrder_is_basis_order_for_negligible_kernels)
+{
+    const int basisOrder = 1;
+    BOOST_CHECK_EQUAL(Selector::toleranceBasedRegularOrder(
+                          basisOrder, 0.1, 0.2, 1e-6, 1e-7),
+                      basisOrder);
+}
+
+BOOST_AUTO_TEST_CASE(toleranceBasedRegularOrder_is_capped)
+{
+    BOOST_CHECK_LE(order(0.1, 0.051, 1e-15), 20);
+}
+
+BOOST_AUTO_TEST_CASE(toleranceBasedRegularOrder_is_negative_if_estimate_does_not_apply)
+{
+    // Element larger than twice the distance
+    BOOST_CHECK_LT(order(1., 0.4, 1e-6), 0);
+    BOOST_CHECK_LT(order(1., 0.5, 1e-6), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,144 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "../check_arrays_are_close.hpp"
+
+#include "fiber/geometrical_data.hpp"
+#include "fiber/geometrical_data_arena.hpp"
+#include "fiber/raw_grid_geometry.hpp"
+#include "grid/geometry.hpp"
+#include "grid/geometry_factory.hpp"
+#include "grid/grid.hpp"
+#include "grid/grid_factory.hpp"
+#include "grid/grid_view.hpp"
+
+#include "common/armadillo_fwd.hpp"
+#include <boost/test/unit_test.hpp>
+#include <limits>
+#include <memory>
+
+using namespace Bempp;
+
+// Tests
+
+namespace
+{
+
+typedef double CT;
+typedef Fiber::GeometricalDataArena<CT> Arena;
+
+struct SphereGeometry
+{
+    SphereGeometry() : rawGeometry(2, 3) {
+        GridParameters params;
+        params.topology = GridParameters::TRIANGULAR;
+        grid = GridFactory::importGmshGrid(
+            params, "meshes/sphere-ico-1.msh", false /* verbose */);
+        std::unique_ptr<GridView> view = grid->leafView();
+        view->getRawElementData(
+            rawGeometry.vertices(), rawGeometry.elementCornerIndices(),
+            rawGeometry.auxData(), rawGeometry.domainIndices());
+        geometryFactory = grid->elementGeometryFactory();
+    }
+
+    shared_ptr<Grid> grid;
+    Fiber::RawGridGeometry<CT> rawGeometry;
+    std::unique_ptr<GeometryFactory> geometryFactory;
+};
+
+arma::Mat<CT> localPoints()
+{
+    arma::Mat<CT> points(2, 3);
+    points(0, 0) = 1. / 6.; points(1, 0) = 1. / 6.;
+    points(0, 1) = 2. / 3.; points(1, 1) = 1. / 6.;
+    points(0, 2) = 1. / 6.; points(1, 2) = 2. / 3.;
+    return points;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(GeometricalDataArenaTests)
+
+BOOST_AUTO_TEST_CASE(arena_data_agree_with_data_calculated_per_element)
+{
+    SphereGeometry sphere;
+    const arma::Mat<CT> points = localPoints();
+    const size_t geomDeps = Fiber::GLOBALS | Fiber::INTEGRATION_ELEMENTS |
+            Fiber::NORMALS | Fiber::JACOBIANS_TRANSPOSED |
+            Fiber::JACOBIAN_INVERSES_TRANSPOSED;
+    shared_ptr<const Arena> arena =
+            sphere.rawGeometry.geometricalDataCache().arena(
+                sphere.rawGeometry, *sphere.geometryFactory, points, geomDeps);
+    BOOST_REQUIRE_EQUAL(arena->elementCount(),
+                        sphere.rawGeometry.elementCount());
+
+    // Integrators not using the cache calculate the data element by element
+    const CT tolerance = 10 * std::numeric_limits<CT>::epsilon();
+    std::unique_ptr<Geometry> geometry = sphere.geometryFactory->make();
+    for (int e = 0; e < arena->elementCount(); ++e) {
+        Fiber::GeometricalData<CT> expected, fromArena;
+        sphere.rawGeometry.setupGeometry(e, *geometry);
+        geometry->getData(geomDeps, points, expected);
+        arena->bindElementData(e, fromArena);
+        BOOST_CHECK(check_arrays_are_close<CT>(
+                        fromArena.globals, expected.globals, tolerance));
+        BOOST_CHECK(check_arrays_are_close<CT>(
+                        fromArena.integrationElements,
+                        expected.integrationElements, tolerance));
+        BOOST_CHECK(check_arrays_are_close<CT>(
+                        fromArena.normals, expected.normals, tolerance));
+        BOOST_CHECK(check_arrays_are_close<CT>(
+                        fromArena.jacobiansTransposed,
+                        expected.jacobiansTransposed, tolerance));
+        BOOST_CHECK(check_arrays_are_close<CT>(
+                        fromArena.jacobianInversesTransposed,
+                        expected.jacobianInversesTransposed, tolerance));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(arenas_are_shared_while_in_use_and_released_afterwards)
+{
+    SphereGeometry sphere;
+    Fiber::GeometricalDataArenaCache<CT>& cache =
+            sphere.rawGeometry.geometricalDataCache();
+    const arma::Mat<CT> points = localPoints();
+    const size_t geomDeps = Fiber::GLOBALS | Fiber::INTEGRATION_ELEMENTS;
+
+    shared_ptr<const Arena> first = cache.arena(
+                sphere.rawGeometry, *sphere.geometryFactory, points, geomDeps);
+    shared_ptr<const Arena> second = cache.arena(
+                sphere.rawGeometry, *sphere.geometryFactory, points, geomDeps);
+    BOOST_CHECK_EQUAL(first.get(), second.get());
+    BOOST_CHECK_EQUAL(cache.size(), 1u);
+
+    // Once no one uses the arena any more, the cache lets it go
+    boost::weak_ptr<const Arena> released = first;
+    first.reset();
+    second.reset();
+    BOOST_CHECK(released.expired());
+    BOOST_CHECK_EQUAL(cache.size(), 0u);
+
+    shared_ptr<const Arena> other = cache.arena(
+                sphere.rawGeometry, *sphere.geometryFactory, points,
+                geomDeps | Fiber::NORMALS);
+    BOOST_CHECK_EQUAL(cache.size(), 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
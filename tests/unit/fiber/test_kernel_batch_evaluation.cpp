@@ -0,0 +1,194 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "fiber/batched_geometrical_data.hpp"
+#include "fiber/collection_of_3d_arrays.hpp"
+#include "fiber/collection_of_4d_arrays.hpp"
+#include "fiber/default_collection_of_kernels.hpp"
+#include "fiber/geometrical_data.hpp"
+#include "fiber/laplace_3d_adjoint_double_layer_potential_kernel_functor.hpp"
+#include "fiber/laplace_3d_double_layer_potential_kernel_functor.hpp"
+#include "fiber/laplace_3d_single_layer_potential_kernel_functor.hpp"
+#include "fiber/modified_helmholtz_3d_adjoint_double_layer_potential_kernel_functor.hpp"
+#include "fiber/modified_helmholtz_3d_double_layer_potential_kernel_functor.hpp"
+#include "fiber/modified_helmholtz_3d_single_layer_potential_kernel_functor.hpp"
+
+#include "../type_template.hpp"
+#include "../check_arrays_are_close.hpp"
+#include "../random_arrays.hpp"
+
+#include "common/armadillo_fwd.hpp"
+#include <boost/static_assert.hpp>
+#include <boost/test/unit_test.hpp>
+#include <complex>
+#include <limits>
+
+// Tests
+
+namespace
+{
+
+// Random points in [-1, 1]^3 with random unit normals
+template <typename CoordinateType>
+void generateRandomGeometricalData(
+        int pointCount, Fiber::GeometricalData<CoordinateType>& geomData)
+{
+    const int worldDim = 3;
+    geomData.globals = 2. *
+            generateRandomMatrix<CoordinateType>(worldDim, pointCount) - 1.;
+    geomData.normals = 2. *
+            generateRandomMatrix<CoordinateType>(worldDim, pointCount) - 1.;
+    for (int p = 0; p < pointCount; ++p)
+        geomData.normals.col(p) /= arma::norm(geomData.normals.col(p), 2);
+}
+
+// Kernel values at all (test point, trial point) pairs obtained from the
+// scalar evaluate() of the functor, stored as a testPointCount x
+// trialPointCount matrix
+template <typename Functor>
+arma::Mat<typename Functor::ValueType> evaluateOnGridWithScalarEvaluation(
+        const Fiber::DefaultCollectionOfKernels<Functor>& kernels,
+        const Fiber::GeometricalData<typename Functor::CoordinateType>& testGeomData,
+        const Fiber::GeometricalData<typename Functor::CoordinateType>& trialGeomData)
+{
+    typedef typename Functor::ValueType ValueType;
+    typedef typename Functor::CoordinateType CoordinateType;
+
+    const int testPointCount = testGeomData.pointCount();
+    const int trialPointCount = trialGeomData.pointCount();
+    arma::Mat<ValueType> values(testPointCount, trialPointCount);
+
+    // evaluateAtPointPairs() calls evaluate() for each pair; pair all test
+    // points with one trial point at a time
+    Fiber::GeometricalData<CoordinateType> pairedTrialGeomData;
+    Fiber::CollectionOf3dArrays<ValueType> pairValues;
+    for (int trialIndex = 0; trialIndex < trialPointCount; ++trialIndex) {
+        pairedTrialGeomData.globals = arma::repmat(
+                    trialGeomData.globals.col(trialIndex), 1, testPointCount);
+        pairedTrialGeomData.normals = arma::repmat(
+                    trialGeomData.normals.col(trialIndex), 1, testPointCount);
+        kernels.evaluateAtPointPairs(testGeomData, pairedTrialGeomData,
+                                     pairValues);
+        for (int testIndex = 0; testIndex < testPointCount; ++testIndex)
+            values(testIndex, trialIndex) = pairValues[0](0, 0, testIndex);
+    }
+    return values;
+}
+
+// Compares evaluateBatch() and evaluateOnGrid(), which uses evaluateBatch(),
+// with the scalar evaluate() of the same functor. Both the test and the trial
+// points carry normals, so that the sign conventions of the double-layer and
+// adjoint double-layer kernels are checked as well.
+template <typename Functor>
+void checkBatchAgreesWithScalarEvaluation(const Functor& functor)
+{
+    typedef typename Functor::ValueType ValueType;
+    typedef typename Functor::CoordinateType CoordinateType;
+
+    BOOST_STATIC_ASSERT(Fiber::FunctorHasEvaluateBatch<Functor>::value);
+
+    Fiber::DefaultCollectionOfKernels<Functor> kernels(functor);
+    const CoordinateType eps = std::numeric_limits<CoordinateType>::epsilon();
+
+    // The larger test point set does not fit in a single chunk of
+    // evaluateBatch(); the smaller one, evaluated afterwards, checks that
+    // the test point data kept by evaluateOnGrid() between calls are reset
+    const int testPointCounts[] = {150, 7};
+    const int trialPointCount = 5;
+    Fiber::GeometricalData<CoordinateType> trialGeomData;
+    generateRandomGeometricalData(trialPointCount, trialGeomData);
+
+    for (int i = 0; i < 2; ++i) {
+        const int testPointCount = testPointCounts[i];
+        Fiber::GeometricalData<CoordinateType> testGeomData;
+        generateRandomGeometricalData(testPointCount, testGeomData);
+
+        const arma::Mat<ValueType> expected =
+                evaluateOnGridWithScalarEvaluation(kernels, testGeomData,
+                                                   trialGeomData);
+
+        arma::Mat<ValueType> batchResult(testPointCount, trialPointCount);
+        const Fiber::BatchedGeometricalData<CoordinateType>
+                batchedTestGeomData(testGeomData);
+        for (int trialIndex = 0; trialIndex < trialPointCount; ++trialIndex)
+            functor.evaluateBatch(batchedTestGeomData,
+                                  trialGeomData.const_slice(trialIndex),
+                                  batchResult.colptr(trialIndex));
+        BOOST_CHECK(check_arrays_are_close<ValueType>(batchResult, expected,
+                                                      10 * eps));
+
+        Fiber::CollectionOf4dArrays<ValueType> gridValues;
+        kernels.evaluateOnGrid(testGeomData, trialGeomData, gridValues);
+        BOOST_REQUIRE_EQUAL(gridValues.size(), 1u);
+        arma::Mat<ValueType> gridResult(testPointCount, trialPointCount);
+        for (int trialIndex = 0; trialIndex < trialPointCount; ++trialIndex)
+            for (int testIndex = 0; testIndex < testPointCount; ++testIndex)
+                gridResult(testIndex, trialIndex) =
+                        gridValues[0](0, 0, testIndex, trialIndex);
+        BOOST_CHECK(check_arrays_are_close<ValueType>(gridResult, expected,
+                                                      10 * eps));
+    }
+}
+
+template <typename ValueType>
+void checkModifiedHelmholtzBatchAgreesWithScalarEvaluation(
+        ValueType waveNumber)
+{
+    checkBatchAgreesWithScalarEvaluation(
+            Fiber::ModifiedHelmholtz3dSingleLayerPotentialKernelFunctor<ValueType>(
+                waveNumber));
+    checkBatchAgreesWithScalarEvaluation(
+            Fiber::ModifiedHelmholtz3dDoubleLayerPotentialKernelFunctor<ValueType>(
+                waveNumber));
+    checkBatchAgreesWithScalarEvaluation(
+            Fiber::ModifiedHelmholtz3dAdjointDoubleLayerPotentialKernelFunctor<ValueType>(
+                waveNumber));
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(KernelBatchEvaluation)
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(evaluateBatch_agrees_with_evaluate_for_laplace_3d_kernels,
+                              ValueType, kernel_types)
+{
+    checkBatchAgreesWithScalarEvaluation(
+            Fiber::Laplace3dSingleLayerPotentialKernelFunctor<ValueType>());
+    checkBatchAgreesWithScalarEvaluation(
+            Fiber::Laplace3dDoubleLayerPotentialKernelFunctor<ValueType>());
+    checkBatchAgreesWithScalarEvaluation(
+            Fiber::Laplace3dAdjointDoubleLayerPotentialKernelFunctor<ValueType>());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(evaluateBatch_agrees_with_evaluate_for_modified_helmholtz_3d_kernels_with_real_wave_number,
+                              ValueType, kernel_types)
+{
+    checkModifiedHelmholtzBatchAgreesWithScalarEvaluation<ValueType>(
+                ValueType(1.5));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(evaluateBatch_agrees_with_evaluate_for_modified_helmholtz_3d_kernels_with_complex_wave_number,
+                              ValueType, complex_kernel_types)
+{
+    checkModifiedHelmholtzBatchAgreesWithScalarEvaluation<ValueType>(
+                ValueType(0.5, 2.));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
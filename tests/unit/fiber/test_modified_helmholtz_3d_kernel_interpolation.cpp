@@ -0,0 +1,193 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "fiber/batched_geometrical_data.hpp"
+#include "fiber/collection_of_3d_arrays.hpp"
+#include "fiber/default_collection_of_kernels.hpp"
+#include "fiber/geometrical_data.hpp"
+#include "fiber/hermite_interpolator.hpp"
+#include "fiber/initialize_interpolator_for_modified_helmholtz_3d_kernels.hpp"
+#include "fiber/modified_helmholtz_3d_adjoint_double_layer_potential_kernel_functor.hpp"
+#include "fiber/modified_helmholtz_3d_adjoint_double_layer_potential_kernel_interpolated_functor.hpp"
+#include "fiber/modified_helmholtz_3d_double_layer_potential_kernel_functor.hpp"
+#include "fiber/modified_helmholtz_3d_double_layer_potential_kernel_interpolated_functor.hpp"
+#include "fiber/modified_helmholtz_3d_single_layer_potential_kernel_functor.hpp"
+#include "fiber/modified_helmholtz_3d_single_layer_potential_kernel_interpolated_functor.hpp"
+
+#include "../type_template.hpp"
+#include "../check_arrays_are_close.hpp"
+#include "../random_arrays.hpp"
+
+#include "common/armadillo_fwd.hpp"
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <complex>
+#include <limits>
+
+// Tests
+
+namespace
+{
+
+const double maxDist = 20.;
+
+// Compares evaluateBatch() of an interpolated functor with the scalar
+// evaluate() of the same functor and with the noninterpolated functor
+template <typename InterpolatedFunctor, typename NoninterpolatedFunctor>
+void checkBatchAgreesWithScalarEvaluation(
+        typename InterpolatedFunctor::ValueType waveNumber,
+        int interpPtsPerWavelength)
+{
+    typedef typename InterpolatedFunctor::ValueType ValueType;
+    typedef typename InterpolatedFunctor::CoordinateType CoordinateType;
+
+    InterpolatedFunctor interpFunctor(waveNumber, maxDist,
+                                      interpPtsPerWavelength);
+    Fiber::DefaultCollectionOfKernels<InterpolatedFunctor>
+            interpKernels(interpFunctor);
+    Fiber::DefaultCollectionOfKernels<NoninterpolatedFunctor>
+            noninterpKernels((NoninterpolatedFunctor(waveNumber)));
+
+    // More test points than fit in a single chunk of evaluateBatch()
+    const int worldDim = 3;
+    const int testPointCount = 150;
+    Fiber::GeometricalData<CoordinateType> testGeomData, trialGeomData;
+    testGeomData.globals = 0.5 * maxDist *
+            generateRandomMatrix<CoordinateType>(worldDim, testPointCount);
+    testGeomData.globals.cols(0, 9) *= 0.01; // to test well the area near 0
+    testGeomData.normals =
+            generateRandomMatrix<CoordinateType>(worldDim, testPointCount);
+    // The same trial point paired with each test point
+    trialGeomData.globals.set_size(worldDim, testPointCount);
+    trialGeomData.globals.fill(-0.1);
+    trialGeomData.normals.set_size(worldDim, testPointCount);
+    trialGeomData.normals.fill(1. / std::sqrt(3.));
+
+    arma::Mat<ValueType> batchResult(1, testPointCount);
+    interpFunctor.evaluateBatch(
+                Fiber::BatchedGeometricalData<CoordinateType>(testGeomData),
+                trialGeomData.const_slice(0), batchResult.memptr());
+
+    // evaluateAtPointPairs() calls the scalar evaluate() for each pair
+    Fiber::CollectionOf3dArrays<ValueType> interpResult, noninterpResult;
+    interpKernels.evaluateAtPointPairs(testGeomData, trialGeomData,
+                                       interpResult);
+    noninterpKernels.evaluateAtPointPairs(testGeomData, trialGeomData,
+                                          noninterpResult);
+    arma::Mat<ValueType> scalarResult(1, testPointCount);
+    arma::Mat<ValueType> exactResult(1, testPointCount);
+    for (int i = 0; i < testPointCount; ++i) {
+        scalarResult(0, i) = interpResult[0](0, 0, i);
+        exactResult(0, i) = noninterpResult[0](0, 0, i);
+    }
+
+    const CoordinateType eps = std::numeric_limits<CoordinateType>::epsilon();
+    BOOST_CHECK(check_arrays_are_close<ValueType>(batchResult, scalarResult,
+                                                  10 * eps));
+    BOOST_CHECK(check_arrays_are_close<ValueType>(batchResult, exactResult,
+                                                  1000 * eps));
+}
+
+template <typename ValueType>
+void checkBatchAgreesWithScalarEvaluationForAllKernels(
+        ValueType waveNumber, int interpPtsPerWavelength)
+{
+    checkBatchAgreesWithScalarEvaluation<
+            Fiber::ModifiedHelmholtz3dSingleLayerPotentialKernelInterpolatedFunctor<ValueType>,
+            Fiber::ModifiedHelmholtz3dSingleLayerPotentialKernelFunctor<ValueType> >(
+                waveNumber, interpPtsPerWavelength);
+    checkBatchAgreesWithScalarEvaluation<
+            Fiber::ModifiedHelmholtz3dDoubleLayerPotentialKernelInterpolatedFunctor<ValueType>,
+            Fiber::ModifiedHelmholtz3dDoubleLayerPotentialKernelFunctor<ValueType> >(
+                waveNumber, interpPtsPerWavelength);
+    checkBatchAgreesWithScalarEvaluation<
+            Fiber::ModifiedHelmholtz3dAdjointDoubleLayerPotentialKernelInterpolatedFunctor<ValueType>,
+            Fiber::ModifiedHelmholtz3dAdjointDoubleLayerPotentialKernelFunctor<ValueType> >(
+                waveNumber, interpPtsPerWavelength);
+}
+
+// Largest relative error of the interpolant of exp(-waveNumber * r) on
+// [0, maxDist]
+template <typename ValueType>
+typename Fiber::ScalarTraits<ValueType>::RealType
+maxRelativeInterpolationError(
+        const Fiber::HermiteInterpolator<ValueType>& interpolator,
+        ValueType waveNumber)
+{
+    typedef typename Fiber::ScalarTraits<ValueType>::RealType CoordinateType;
+    const int sampleCount = 10000;
+    CoordinateType maxError = 0.;
+    for (int i = 0; i <= sampleCount; ++i) {
+        const CoordinateType r = maxDist * i / sampleCount;
+        const ValueType exact = std::exp(-waveNumber * r);
+        maxError = std::max(maxError,
+                            std::abs(interpolator.evaluate(r) - exact) /
+                            std::abs(exact));
+    }
+    return maxError;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(ModifiedHelmholtz3dKernelInterpolation)
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(evaluateBatch_agrees_with_evaluate_for_real_wave_number,
+                              ValueType, kernel_types)
+{
+    checkBatchAgreesWithScalarEvaluationForAllKernels<ValueType>(
+                ValueType(1.), 0 /* automatic density */);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(evaluateBatch_agrees_with_evaluate_for_complex_wave_number,
+                              ValueType, complex_kernel_types)
+{
+    checkBatchAgreesWithScalarEvaluationForAllKernels<ValueType>(
+                ValueType(0.5, 1.), 0 /* automatic density */);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(relativeAccuracy_is_attained_for_real_wave_number,
+                              ValueType, kernel_types)
+{
+    typedef typename Fiber::ScalarTraits<ValueType>::RealType CoordinateType;
+    const CoordinateType eps = std::numeric_limits<CoordinateType>::epsilon();
+    const CoordinateType accuracy = 1e4 * eps;
+    const ValueType waveNumber(1.);
+    Fiber::HermiteInterpolator<ValueType> interpolator;
+    Fiber::initializeInterpolatorForModifiedHelmholtz3dKernels(
+                waveNumber, CoordinateType(maxDist), interpolator, accuracy);
+    BOOST_CHECK_LE(maxRelativeInterpolationError(interpolator, waveNumber),
+                   2 * accuracy);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(relativeAccuracy_is_attained_for_complex_wave_number,
+                              ValueType, complex_kernel_types)
+{
+    typedef typename Fiber::ScalarTraits<ValueType>::RealType CoordinateType;
+    const CoordinateType eps = std::numeric_limits<CoordinateType>::epsilon();
+    const CoordinateType accuracy = 1e4 * eps;
+    const ValueType waveNumber(0.5, 1.);
+    Fiber::HermiteInterpolator<ValueType> interpolator;
+    Fiber::initializeInterpolatorForModifiedHelmholtz3dKernels(
+                waveNumber, CoordinateType(maxDist), interpolator, accuracy);
+    BOOST_CHECK_LE(maxRelativeInterpolationError(interpolator, waveNumber),
+                   2 * accuracy);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
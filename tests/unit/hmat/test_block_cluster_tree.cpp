@@ -0,0 +1,138 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "hmat/block_cluster_tree.hpp"
+#include "hmat/cluster_tree.hpp"
+#include "hmat/geometry.hpp"
+#include "hmat/geometry_data_type.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// Tests
+
+using namespace hmat;
+
+namespace
+{
+
+// Clusters of equidistant points on a segment of the x axis
+shared_ptr<const ClusterTree<2> > createClusterTree(std::size_t pointCount,
+                                                    int minBlockSize)
+{
+    Geometry geometry;
+    for (std::size_t i = 0; i < pointCount; ++i) {
+        const double x = double(i) / pointCount;
+        std::array<double, 3> center = {{x, 0., 0.}};
+        geometry.push_back(shared_ptr<const GeometryDataType>(
+            new GeometryDataType(BoundingBox(x, x, 0., 0., 0., 0.), center)));
+    }
+    return shared_ptr<const ClusterTree<2> >(
+        new ClusterTree<2>(geometry, minBlockSize));
+}
+
+std::size_t blockRows(const BlockClusterTreeNode<2>& node)
+{
+    const IndexRangeType& range =
+        node.data().rowClusterTreeNode->data().indexRange;
+    return range[1] - range[0];
+}
+
+std::size_t blockColumns(const BlockClusterTreeNode<2>& node)
+{
+    const IndexRangeType& range =
+        node.data().columnClusterTreeNode->data().indexRange;
+    return range[1] - range[0];
+}
+
+void collectNodes(const shared_ptr<const BlockClusterTreeNode<2> >& node,
+                  std::vector<shared_ptr<const BlockClusterTreeNode<2> > >& nodes)
+{
+    nodes.push_back(node);
+    if (node->isLeaf())
+        return;
+    for (int i = 0; i < 4; ++i)
+        collectNodes(node->child(i), nodes);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(HMatBlockClusterTree)
+
+BOOST_AUTO_TEST_CASE(admissible_blocks_exist_below_the_root)
+{
+    shared_ptr<const ClusterTree<2> > clusterTree = createClusterTree(256, 8);
+    BlockClusterTree<2> tree(clusterTree, clusterTree, 1024,
+                             StandardAdmissibility(1.));
+
+    BOOST_CHECK(!tree.root()->data().admissible);
+    std::size_t admissibleLeafCount = 0;
+    std::vector<shared_ptr<const BlockClusterTreeNode<2> > > leafs =
+        tree.leafNodes();
+    for (std::size_t i = 0; i < leafs.size(); ++i)
+        if (leafs[i]->data().admissible)
+            ++admissibleLeafCount;
+    BOOST_CHECK_GT(admissibleLeafCount, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(admissibility_of_blocks_is_evaluated_on_their_own_clusters)
+{
+    const int maxBlockSize = 1024;
+    const StandardAdmissibility admissibility(1.);
+    shared_ptr<const ClusterTree<2> > clusterTree = createClusterTree(256, 8);
+    BlockClusterTree<2> tree(clusterTree, clusterTree, maxBlockSize,
+                             admissibility);
+
+    std::vector<shared_ptr<const BlockClusterTreeNode<2> > > leafs =
+        tree.leafNodes();
+    for (std::size_t i = 0; i < leafs.size(); ++i) {
+        const BlockClusterTreeNodeData<2>& data = leafs[i]->data();
+        BOOST_CHECK_EQUAL(
+            data.admissible,
+            admissibility(data.rowClusterTreeNode->data().boundingBox,
+                          data.columnClusterTreeNode->data().boundingBox));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(blocks_larger_than_max_block_size_are_not_admissible)
+{
+    const std::size_t maxBlockSize = 32;
+    shared_ptr<const ClusterTree<2> > clusterTree = createClusterTree(256, 8);
+    BlockClusterTree<2> tree(clusterTree, clusterTree, maxBlockSize,
+                             StandardAdmissibility(1.));
+
+    std::vector<shared_ptr<const BlockClusterTreeNode<2> > > nodes;
+    collectNodes(tree.root(), nodes);
+    bool admissibleLeafFound = false;
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        const BlockClusterTreeNode<2>& node = *nodes[i];
+        if (!node.data().admissible)
+            continue;
+        BOOST_CHECK(node.isLeaf());
+        BOOST_CHECK_LE(blockRows(node), maxBlockSize);
+        BOOST_CHECK_LE(blockColumns(node), maxBlockSize);
+        admissibleLeafFound = true;
+    }
+    BOOST_CHECK(admissibleLeafFound);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,186 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "hmat/block_cluster_tree.hpp"
+#include "hmat/cluster_tree.hpp"
+#include "hmat/data_accessor.hpp"
+#include "hmat/geometry.hpp"
+#include "hmat/geometry_data_type.hpp"
+#include "hmat/hmatrix_aca_plus_compressor.hpp"
+#include "hmat/hmatrix_data.hpp"
+#include "hmat/hmatrix_dense_data.hpp"
+#include "hmat/hmatrix_low_rank_data.hpp"
+
+#include <armadillo>
+#include <boost/test/unit_test.hpp>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Tests
+
+using namespace hmat;
+
+namespace
+{
+
+// Asymptotically smooth kernel 1 / (|x - y| + delta) evaluated at points on a
+// segment
+class InverseDistanceAccessor : public DataAccessor<double, 2>
+{
+public:
+    InverseDistanceAccessor(const std::vector<double>& points,
+                            const shared_ptr<const ClusterTree<2> >& clusterTree) :
+        m_points(points), m_clusterTree(clusterTree)
+    {
+    }
+
+    virtual void computeMatrixBlock(
+            const IndexRangeType& rowIndexRange,
+            const IndexRangeType& columnIndexRange,
+            const BlockClusterTreeNode<2>& blockClusterTreeNode,
+            arma::Mat<double>& data) const
+    {
+        data.set_size(rowIndexRange[1] - rowIndexRange[0],
+                      columnIndexRange[1] - columnIndexRange[0]);
+        for (std::size_t j = 0; j < data.n_cols; ++j)
+            for (std::size_t i = 0; i < data.n_rows; ++i) {
+                const double x = m_points[m_clusterTree->mapHMatDofToOriginalDof(
+                    rowIndexRange[0] + i)];
+                const double y = m_points[m_clusterTree->mapHMatDofToOriginalDof(
+                    columnIndexRange[0] + j)];
+                data(i, j) = 1. / (std::abs(x - y) + 1e-2);
+            }
+    }
+
+private:
+    std::vector<double> m_points;
+    shared_ptr<const ClusterTree<2> > m_clusterTree;
+};
+
+struct AcaPlusFixture
+{
+    AcaPlusFixture()
+    {
+        const std::size_t pointCount = 512;
+        std::vector<double> points(pointCount);
+        Geometry geometry;
+        for (std::size_t i = 0; i < pointCount; ++i) {
+            points[i] = double(i) / pointCount;
+            std::array<double, 3> center = {{points[i], 0., 0.}};
+            geometry.push_back(shared_ptr<const GeometryDataType>(
+                new GeometryDataType(BoundingBox(points[i], points[i],
+                                                 0., 0., 0., 0.),
+                                     center)));
+        }
+        clusterTree.reset(new ClusterTree<2>(geometry, 16));
+        blockClusterTree.reset(new BlockClusterTree<2>(
+            clusterTree, clusterTree, 1024, StandardAdmissibility(1.)));
+        accessor.reset(new InverseDistanceAccessor(points, clusterTree));
+    }
+
+    // Largest relative error of the compressed admissible blocks
+    double maxRelativeError(const HMatrixCompressor<double, 2>& compressor,
+                            std::size_t& lowRankBlockCount) const
+    {
+        double result = 0.;
+        lowRankBlockCount = 0;
+        std::vector<shared_ptr<const BlockClusterTreeNode<2> > > leafs =
+            blockClusterTree->leafNodes();
+        for (std::size_t i = 0; i < leafs.size(); ++i) {
+            const BlockClusterTreeNode<2>& node = *leafs[i];
+            if (!node.data().admissible)
+                continue;
+            arma::Mat<double> expected;
+            accessor->computeMatrixBlock(
+                node.data().rowClusterTreeNode->data().indexRange,
+                node.data().columnClusterTreeNode->data().indexRange,
+                node, expected);
+
+            shared_ptr<HMatrixData<double> > data;
+            compressor.compressBlock(node, data);
+            arma::Mat<double> actual;
+            if (data->type() == LOW_RANK) {
+                const HMatrixLowRankData<double>& lowRankData =
+                    static_cast<const HMatrixLowRankData<double>&>(*data);
+                actual = lowRankData.A() * lowRankData.B();
+                ++lowRankBlockCount;
+            } else
+                actual = static_cast<const HMatrixDenseData<double>&>(
+                    *data).A();
+            result = std::max(result, arma::norm(actual - expected, "fro") /
+                                          arma::norm(expected, "fro"));
+        }
+        return result;
+    }
+
+    shared_ptr<const ClusterTree<2> > clusterTree;
+    shared_ptr<BlockClusterTree<2> > blockClusterTree;
+    shared_ptr<InverseDistanceAccessor> accessor;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(HMatrixAcaPlusCompression)
+
+BOOST_AUTO_TEST_CASE(compressed_blocks_agree_with_dense_blocks_for_eps_1e_4)
+{
+    AcaPlusFixture fixture;
+    const double eps = 1e-4;
+    hmat::HMatrixAcaPlusCompressor<double, 2> compressor(
+        *fixture.accessor, eps, 100);
+    std::size_t lowRankBlockCount;
+    BOOST_CHECK_LT(fixture.maxRelativeError(compressor, lowRankBlockCount),
+                   10. * eps);
+    BOOST_CHECK_GT(lowRankBlockCount, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(compressed_blocks_agree_with_dense_blocks_for_eps_1e_8)
+{
+    AcaPlusFixture fixture;
+    const double eps = 1e-8;
+    hmat::HMatrixAcaPlusCompressor<double, 2> compressor(
+        *fixture.accessor, eps, 100);
+    std::size_t lowRankBlockCount;
+    BOOST_CHECK_LT(fixture.maxRelativeError(compressor, lowRankBlockCount),
+                   10. * eps);
+    BOOST_CHECK_GT(lowRankBlockCount, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(fixed_rank_mode_uses_max_rank)
+{
+    AcaPlusFixture fixture;
+    const unsigned int maxRank = 4;
+    hmat::HMatrixAcaPlusCompressor<double, 2> compressor(
+        *fixture.accessor, 1e-12, maxRank, false);
+    std::vector<shared_ptr<const BlockClusterTreeNode<2> > > leafs =
+        fixture.blockClusterTree->leafNodes();
+    for (std::size_t i = 0; i < leafs.size(); ++i) {
+        if (!leafs[i]->data().admissible)
+            continue;
+        shared_ptr<HMatrixData<double> > data;
+        compressor.compressBlock(*leafs[i], data);
+        BOOST_CHECK_EQUAL(data->type(), LOW_RANK);
+        BOOST_CHECK_LE(data->rank(), int(maxRank));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,141 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+#include "hmat/block_cluster_tree.hpp"
+#include "hmat/cluster_tree.hpp"
+#include "hmat/data_accessor.hpp"
+#include "hmat/geometry.hpp"
+#include "hmat/geometry_data_type.hpp"
+#include "hmat/hmatrix.hpp"
+#include "hmat/hmatrix_aca_plus_compressor.hpp"
+
+#include <armadillo>
+#include <boost/test/unit_test.hpp>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Tests
+
+using namespace hmat;
+
+namespace
+{
+
+// Asymptotically smooth kernel 1 / (|x - y| + delta) evaluated at points on a
+// segment
+class InverseDistanceAccessor : public DataAccessor<double, 2>
+{
+public:
+    InverseDistanceAccessor(const std::vector<double>& points,
+                            const shared_ptr<const ClusterTree<2> >& clusterTree) :
+        m_points(points), m_clusterTree(clusterTree)
+    {
+    }
+
+    virtual void computeMatrixBlock(
+            const IndexRangeType& rowIndexRange,
+            const IndexRangeType& columnIndexRange,
+            const BlockClusterTreeNode<2>& blockClusterTreeNode,
+            arma::Mat<double>& data) const
+    {
+        data.set_size(rowIndexRange[1] - rowIndexRange[0],
+                      columnIndexRange[1] - columnIndexRange[0]);
+        for (std::size_t j = 0; j < data.n_cols; ++j)
+            for (std::size_t i = 0; i < data.n_rows; ++i) {
+                const double x = m_points[m_clusterTree->mapHMatDofToOriginalDof(
+                    rowIndexRange[0] + i)];
+                const double y = m_points[m_clusterTree->mapHMatDofToOriginalDof(
+                    columnIndexRange[0] + j)];
+                data(i, j) = 1. / (std::abs(x - y) + 1e-2);
+            }
+    }
+
+private:
+    std::vector<double> m_points;
+    shared_ptr<const ClusterTree<2> > m_clusterTree;
+};
+
+struct CoarseningFixture
+{
+    CoarseningFixture()
+    {
+        const std::size_t pointCount = 512;
+        std::vector<double> points(pointCount);
+        Geometry geometry;
+        for (std::size_t i = 0; i < pointCount; ++i) {
+            points[i] = double(i) / pointCount;
+            std::array<double, 3> center = {{points[i], 0., 0.}};
+            geometry.push_back(shared_ptr<const GeometryDataType>(
+                new GeometryDataType(BoundingBox(points[i], points[i],
+                                                 0., 0., 0., 0.),
+                                     center)));
+        }
+        clusterTree.reset(new ClusterTree<2>(geometry, 16));
+        blockClusterTree.reset(new BlockClusterTree<2>(
+            clusterTree, clusterTree, 1024, StandardAdmissibility(1.)));
+        accessor.reset(new InverseDistanceAccessor(points, clusterTree));
+    }
+
+    shared_ptr<HMatrix<double, 2> > hMatrix(double eps) const
+    {
+        HMatrixAcaPlusCompressor<double, 2> compressor(*accessor, eps, 100);
+        return shared_ptr<HMatrix<double, 2> >(
+            new HMatrix<double, 2>(blockClusterTree, compressor));
+    }
+
+    shared_ptr<const ClusterTree<2> > clusterTree;
+    shared_ptr<BlockClusterTree<2> > blockClusterTree;
+    shared_ptr<InverseDistanceAccessor> accessor;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(HMatrixCoarsening)
+
+BOOST_AUTO_TEST_CASE(coarsening_leaves_a_shared_block_cluster_tree_intact)
+{
+    CoarseningFixture fixture;
+    const double eps = 1e-6;
+    shared_ptr<HMatrix<double, 2> > coarsened = fixture.hMatrix(eps);
+    shared_ptr<HMatrix<double, 2> > original = fixture.hMatrix(eps);
+    const std::size_t leafCount = fixture.blockClusterTree->leafNodes().size();
+    BOOST_REQUIRE_EQUAL(original->numberOfLeafs(), leafCount);
+
+    coarsened->coarsen(eps);
+
+    BOOST_CHECK_LT(coarsened->numberOfLeafs(), leafCount);
+    BOOST_CHECK_EQUAL(fixture.blockClusterTree->leafNodes().size(), leafCount);
+    BOOST_CHECK_EQUAL(original->numberOfLeafs(), leafCount);
+    BOOST_CHECK(original->blockClusterTree() == fixture.blockClusterTree);
+    BOOST_CHECK(coarsened->blockClusterTree() != fixture.blockClusterTree);
+
+    // Both matrices remain usable and agree up to the tolerance
+    arma::Mat<double> x = arma::randu<arma::Mat<double> >(
+        original->columns(), 1);
+    arma::Mat<double> expected(original->rows(), 1);
+    arma::Mat<double> y(coarsened->rows(), 1);
+    original->apply(x, expected, NOTRANS, 1., 0.);
+    coarsened->apply(x, y, NOTRANS, 1., 0.);
+    BOOST_CHECK_LT(arma::norm(y - expected, 2) / arma::norm(expected, 2),
+                   100. * eps);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
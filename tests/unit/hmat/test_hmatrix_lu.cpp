@@ -0,0 +1,178 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "hmat/block_cluster_tree.hpp"
+#include "hmat/cluster_tree.hpp"
+#include "hmat/data_accessor.hpp"
+#include "hmat/geometry.hpp"
+#include "hmat/geometry_data_type.hpp"
+#include "hmat/hmatrix.hpp"
+#include "hmat/hmatrix_aca_plus_compressor.hpp"
+#include "hmat/hmatrix_data.hpp"
+#include "hmat/hmatrix_lu.hpp"
+
+#include <armadillo>
+#include <boost/test/unit_test.hpp>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+
+// Tests
+
+using namespace hmat;
+
+namespace
+{
+
+// Matrix K + I, where K is the Gaussian kernel evaluated at equidistant
+// points on a segment. It is symmetric positive definite and its
+// off-diagonal blocks have low numerical rank.
+class GaussianKernelAccessor : public DataAccessor<double, 2>
+{
+public:
+    GaussianKernelAccessor(const std::vector<double>& points,
+                           const shared_ptr<const ClusterTree<2> >& clusterTree) :
+        m_points(points), m_clusterTree(clusterTree)
+    {
+    }
+
+    double entry(std::size_t row, std::size_t column) const
+    {
+        const double d = m_points[row] - m_points[column];
+        return std::exp(-4. * d * d) + (row == column ? 1. : 0.);
+    }
+
+    arma::Mat<double> denseMatrix() const
+    {
+        arma::Mat<double> result(m_points.size(), m_points.size());
+        for (std::size_t j = 0; j < m_points.size(); ++j)
+            for (std::size_t i = 0; i < m_points.size(); ++i)
+                result(i, j) = entry(i, j);
+        return result;
+    }
+
+    virtual void computeMatrixBlock(
+            const IndexRangeType& rowIndexRange,
+            const IndexRangeType& columnIndexRange,
+            const BlockClusterTreeNode<2>& blockClusterTreeNode,
+            arma::Mat<double>& data) const
+    {
+        data.set_size(rowIndexRange[1] - rowIndexRange[0],
+                      columnIndexRange[1] - columnIndexRange[0]);
+        for (std::size_t j = 0; j < data.n_cols; ++j)
+            for (std::size_t i = 0; i < data.n_rows; ++i)
+                data(i, j) = entry(
+                    m_clusterTree->mapHMatDofToOriginalDof(rowIndexRange[0] + i),
+                    m_clusterTree->mapHMatDofToOriginalDof(
+                        columnIndexRange[0] + j));
+    }
+
+private:
+    std::vector<double> m_points;
+    shared_ptr<const ClusterTree<2> > m_clusterTree;
+};
+
+struct HMatrixLuFixture
+{
+    HMatrixLuFixture()
+    {
+        const std::size_t pointCount = 256;
+        std::vector<double> points(pointCount);
+        Geometry geometry;
+        for (std::size_t i = 0; i < pointCount; ++i) {
+            // Scramble the points so that the cluster tree permutes the DOFs
+            points[i] = double((37 * i) % pointCount) / pointCount;
+            std::array<double, 3> center = {{points[i], 0., 0.}};
+            geometry.push_back(shared_ptr<const GeometryDataType>(
+                new GeometryDataType(BoundingBox(points[i], points[i],
+                                                 0., 0., 0., 0.),
+                                     center)));
+        }
+        shared_ptr<const ClusterTree<2> > clusterTree(
+            new ClusterTree<2>(geometry, 16));
+        shared_ptr<BlockClusterTree<2> > blockClusterTree(
+            new BlockClusterTree<2>(clusterTree, clusterTree, 1024,
+                                    StandardAdmissibility(1.)));
+
+        GaussianKernelAccessor accessor(points, clusterTree);
+        HMatrixAcaPlusCompressor<double, 2> compressor(accessor, 1e-12, 100);
+        hMatrix.reset(new HMatrix<double, 2>(blockClusterTree, compressor));
+        denseMatrix = accessor.denseMatrix();
+    }
+
+    shared_ptr<HMatrix<double, 2> > hMatrix;
+    arma::Mat<double> denseMatrix;
+};
+
+double relativeError(const arma::Mat<double>& actual,
+                     const arma::Mat<double>& expected)
+{
+    return arma::norm(actual - expected, "fro") /
+        arma::norm(expected, "fro");
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(HMatrixLuFactorization)
+
+BOOST_AUTO_TEST_CASE(matrix_has_low_rank_blocks)
+{
+    HMatrixLuFixture fixture;
+    bool lowRankLeafFound = false;
+    for (std::size_t i = 0; i < fixture.hMatrix->numberOfLeafs(); ++i)
+        if (fixture.hMatrix->leaf(i).data->type() == LOW_RANK)
+            lowRankLeafFound = true;
+    BOOST_CHECK(lowRankLeafFound);
+}
+
+BOOST_AUTO_TEST_CASE(lu_solve_agrees_with_dense_solve)
+{
+    std::srand(1);
+    HMatrixLuFixture fixture;
+    arma::Mat<double> b = arma::randu<arma::Mat<double> >(
+        fixture.denseMatrix.n_rows, 3);
+    arma::Mat<double> expected = arma::solve(fixture.denseMatrix, b);
+
+    hmat::HMatrixLu<double, 2> lu(*fixture.hMatrix, 1e-12);
+    arma::Mat<double> x = b;
+    lu.solve(x);
+
+    BOOST_CHECK_LT(relativeError(x, expected), 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE(cholesky_solve_agrees_with_dense_solve)
+{
+    std::srand(1);
+    HMatrixLuFixture fixture;
+    arma::Mat<double> b = arma::randu<arma::Mat<double> >(
+        fixture.denseMatrix.n_rows, 3);
+    arma::Mat<double> expected = arma::solve(fixture.denseMatrix, b);
+
+    hmat::HMatrixLu<double, 2> cholesky(*fixture.hMatrix, 1e-12, true);
+    arma::Mat<double> x = b;
+    cholesky.solve(x);
+
+    BOOST_CHECK(cholesky.isCholesky());
+    BOOST_CHECK_LT(relativeError(x, expected), 1e-8);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,90 @@
+// Copyright (C) 2011-2014 by the BEM++ Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "bempp/common/config_data_types.hpp"
+#include "bempp/common/config_trilinos.hpp"
+
+#if defined(WITH_TRILINOS) && defined(ENABLE_SINGLE_PRECISION) && \
+    defined(ENABLE_DOUBLE_PRECISION)
+
+#include "../check_arrays_are_close.hpp"
+
+#include "laplace_3d_dirichlet_fixture.hpp"
+
+#include "linalg/default_iterative_solver.hpp"
+#include "linalg/mixed_precision_iterative_solver.hpp"
+#include "linalg/solver.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include <stdexcept>
+#include <vector>
+
+using namespace Bempp;
+
+// Tests
+
+BOOST_AUTO_TEST_SUITE(MixedPrecisionIterativeSolverTests)
+
+BOOST_AUTO_TEST_CASE(converges_to_double_precision_tolerance_for_laplace_single_layer)
+{
+    typedef double BFT;
+    typedef double RT;
+    const double tolerance = 1e-10;
+
+    Laplace3dDirichletFixture<BFT, RT> fixture;
+    Laplace3dDirichletFixture<float, float> singleFixture;
+
+    MixedPrecisionIterativeSolver<BFT, RT> solver(fixture.lhsOp,
+                                                  singleFixture.lhsOp);
+    solver.initializeSolver(defaultGmresParameterList(1e-4f));
+    solver.setRefinementParameters(tolerance);
+    Solution<BFT, RT> solution = solver.solve(fixture.rhs);
+
+    BOOST_CHECK_EQUAL(solution.status(), SolutionStatus::CONVERGED);
+    BOOST_CHECK_LE(solution.achievedTolerance(), tolerance);
+
+    // Reference solution computed entirely in double precision. The two
+    // solutions differ by the effect of rounding the matrix to single
+    // precision, not by the tolerance of the refinement.
+    DefaultIterativeSolver<BFT, RT> referenceSolver(
+        fixture.lhsOp, ConvergenceTestMode::TEST_CONVERGENCE_IN_DUAL_TO_RANGE);
+    referenceSolver.initializeSolver(defaultGmresParameterList(1e-12));
+    Solution<BFT, RT> referenceSolution = referenceSolver.solve(fixture.rhs);
+
+    BOOST_CHECK(check_arrays_are_close<RT>(
+                    solution.gridFunction().coefficients(),
+                    referenceSolution.gridFunction().coefficients(), 1e-4));
+}
+
+BOOST_AUTO_TEST_CASE(blocked_solve_throws)
+{
+    Laplace3dDirichletFixture<double, double> fixture;
+    Laplace3dDirichletFixture<float, float> singleFixture;
+
+    MixedPrecisionIterativeSolver<double, double> solver(fixture.lhsOp,
+                                                         singleFixture.lhsOp);
+    solver.initializeSolver(defaultGmresParameterList(1e-4f));
+    std::vector<GridFunction<double, double> > rhs(1, fixture.rhs);
+    BOOST_CHECK_THROW(solver.solve(rhs), std::logic_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif // WITH_TRILINOS && ENABLE_SINGLE_PRECISION && ENABLE_DOUBLE_PRECISION